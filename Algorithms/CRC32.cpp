@@ -31,8 +31,16 @@ CRC32::CRC32() : crc(0) {
     crcFunction = detectBestCRC32C();
 }
 
-unsigned CRC32::SoftwareBasedCRC32(char *str, unsigned len, unsigned ) {
-    boost::crc_optimal<32, 0x1EDC6F41, 0x0, 0x0, true, true> CRC32_Processor;
+unsigned CRC32::SoftwareBasedCRC32(char *str, unsigned len, unsigned crc) {
+    // continue from the previous checksum like the hardware instruction does.
+    // the processor expects its initial remainder in unreflected form.
+    unsigned initial_remainder = 0;
+    for(unsigned bit = 0; bit < 32; ++bit) {
+        if(crc & (1u << bit)) {
+            initial_remainder |= 1u << (31 - bit);
+        }
+    }
+    my_crc_32_type CRC32_Processor(initial_remainder);
     CRC32_Processor.process_bytes( str, len);
     return CRC32_Processor.checksum();
 }
@@ -52,12 +60,14 @@ unsigned CRC32::SSEBasedCRC32( char *str, unsigned len, unsigned crc) {
         ++p;
     }
 
+    //the remaining bytes one at a time, a 32 bit step would read the
+    //sign-extended char and the checksum would depend on the chunking
     str=(char*)p;
     while (r--) {
         __asm__ __volatile__(
-                ".byte 0xf2, 0xf, 0x38, 0xf1, 0xf1;"
+                ".byte 0xf2, 0xf, 0x38, 0xf0, 0xf1;"
                 :"=S"(crc)
-                 :"0"(crc), "c"(*str)
+                 :"0"(crc), "c"((unsigned char)*str)
         );
         ++str;
     }
@@ -86,6 +96,10 @@ unsigned CRC32::cpuid(unsigned functionInput) {
     return ecx;
 }
 
+void CRC32::Reset() {
+    crc = 0;
+}
+
 unsigned CRC32::operator()(char *str, unsigned len){
     crc =((*this).*(crcFunction))(str, len, crc);
     return crc;
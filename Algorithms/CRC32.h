@@ -48,6 +48,7 @@ private:
 public:
     CRC32();
     unsigned operator()(char *str, unsigned len);
+    void Reset();
     virtual ~CRC32() {};
 };
 
@@ -0,0 +1,489 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef PARALLEL_SCC_H_
+#define PARALLEL_SCC_H_
+
+#include "../Util/OpenMPWrapper.h"
+#include "../Util/SimpleLogger.h"
+#include "../Util/TimingUtil.h"
+#include "../typedefs.h"
+
+#include <boost/assert.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/foreach.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <climits>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// Strongly connected components of a directed graph, computed in parallel.
+// Nodes without incoming or outgoing arcs are trimmed off as single node
+// components first. The giant component is then found as the intersection
+// of a forward and a backward search from a well-connected pivot, with the
+// levels of both searches expanded in parallel. After trimming once more,
+// the rest falls apart into many small weakly connected pieces, which run
+// Tarjan's algorithm in parallel.
+class ParallelSCC : boost::noncopyable {
+public:
+    // Copies the arcs of graph, which needs the interface of DynamicGraph.
+    // Blocked nodes, like barriers, may be entered but not left. An empty
+    // vector blocks no node.
+    template<class GraphT>
+    ParallelSCC(
+        const GraphT & graph,
+        const std::vector<bool> & blocked_nodes
+    ) :
+        number_of_nodes(graph.GetNumberOfNodes()),
+        forward_begin(number_of_nodes+1, 0),
+        backward_begin(number_of_nodes+1, 0),
+        component_ids(number_of_nodes, UINT_MAX)
+    {
+        const int number_of_nodes_int = number_of_nodes;
+#pragma omp parallel for schedule ( guided )
+        for(int node = 0; node < number_of_nodes_int; ++node) {
+            if(!blocked_nodes.empty() && blocked_nodes[node]) {
+                continue;
+            }
+            unsigned degree = 0;
+            for(
+                typename GraphT::EdgeIterator edge = graph.BeginEdges(node);
+                edge < graph.EndEdges(node);
+                ++edge
+            ) {
+                degree += (graph.GetTarget(edge) != (NodeID)node);
+            }
+            forward_begin[node+1] = degree;
+        }
+        for(unsigned node = 0; node < number_of_nodes; ++node) {
+            forward_begin[node+1] += forward_begin[node];
+        }
+
+        forward_targets.resize(forward_begin.back());
+#pragma omp parallel for schedule ( guided )
+        for(int node = 0; node < number_of_nodes_int; ++node) {
+            unsigned position = forward_begin[node];
+            if(position == forward_begin[node+1]) {
+                continue;
+            }
+            for(
+                typename GraphT::EdgeIterator edge = graph.BeginEdges(node);
+                edge < graph.EndEdges(node);
+                ++edge
+            ) {
+                const NodeID target = graph.GetTarget(edge);
+                if(target != (NodeID)node) {
+                    forward_targets[position++] = target;
+                }
+            }
+        }
+
+        //scattering by target does not parallelize without atomics
+        BOOST_FOREACH(const NodeID target, forward_targets) {
+            ++backward_begin[target+1];
+        }
+        for(unsigned node = 0; node < number_of_nodes; ++node) {
+            backward_begin[node+1] += backward_begin[node];
+        }
+        backward_targets.resize(forward_targets.size());
+        std::vector<unsigned> position(backward_begin.begin(), backward_begin.end()-1);
+        for(unsigned node = 0; node < number_of_nodes; ++node) {
+            for(unsigned arc = forward_begin[node]; arc < forward_begin[node+1]; ++arc) {
+                backward_targets[position[forward_targets[arc]]++] = node;
+            }
+        }
+    }
+
+    void Run() {
+        double phase_start = get_timestamp();
+        number_of_components = 0;
+        std::vector<NodeID> candidates(number_of_nodes);
+        for(unsigned node = 0; node < number_of_nodes; ++node) {
+            candidates[node] = node;
+        }
+        const unsigned trimmed = Trim(candidates);
+        const double trim_duration = get_timestamp() - phase_start;
+
+        phase_start = get_timestamp();
+        const unsigned size_of_giant_component = FindGiantComponent();
+        const double giant_duration = get_timestamp() - phase_start;
+
+        phase_start = get_timestamp();
+        candidates.clear();
+        for(unsigned node = 0; node < number_of_nodes; ++node) {
+            if(UINT_MAX == component_ids[node]) {
+                candidates.push_back(node);
+            }
+        }
+        const unsigned trimmed_again = Trim(candidates);
+        const unsigned number_of_pieces = DecomposeRest();
+        const double rest_duration = get_timestamp() - phase_start;
+
+        component_sizes.clear();
+        component_sizes.resize(number_of_components, 0);
+        BOOST_FOREACH(const unsigned component, component_ids) {
+            BOOST_ASSERT(component < number_of_components);
+            ++component_sizes[component];
+        }
+
+        SimpleLogger().Write() <<
+            "SCC: trimmed " << trimmed << "+" << trimmed_again << " nodes, " <<
+            "giant component of " << size_of_giant_component << " nodes, " <<
+            number_of_pieces << " weakly connected pieces left";
+        SimpleLogger().Write() <<
+            "Timing: trimming " << trim_duration << " sec, " <<
+            "giant component " << giant_duration << " sec, " <<
+            "rest " << rest_duration << " sec using " <<
+            omp_get_max_threads() << " threads";
+    }
+
+    unsigned GetNumberOfComponents() const {
+        return number_of_components;
+    }
+
+    unsigned GetComponentID(const NodeID node) const {
+        return component_ids[node];
+    }
+
+    unsigned GetComponentSize(const unsigned component) const {
+        return component_sizes[component];
+    }
+
+private:
+    //a node of Tarjan's algorithm and the next of its arcs to visit
+    struct TarjanFrame {
+        TarjanFrame(const NodeID node, const unsigned arc) : node(node), arc(arc) { }
+        NodeID node;
+        unsigned arc;
+    };
+
+    bool IsActive(const NodeID node) const {
+        return UINT_MAX == component_ids[node];
+    }
+
+    bool HasActiveArc(const std::vector<unsigned> & begin, const std::vector<NodeID> & targets, const NodeID node) const {
+        for(unsigned arc = begin[node]; arc < begin[node+1]; ++arc) {
+            if(IsActive(targets[arc])) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Removes nodes without active incoming or outgoing arcs, round by
+    // round. Only the neighbors of removed nodes are checked again.
+    unsigned Trim(std::vector<NodeID> & candidates) {
+        unsigned number_of_trimmed_nodes = 0;
+        std::vector<std::vector<NodeID> > trimmed_per_thread(omp_get_max_threads());
+        while(!candidates.empty()) {
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+            const int number_of_candidates = candidates.size();
+#pragma omp parallel for schedule ( guided )
+            for(int i = 0; i < number_of_candidates; ++i) {
+                const NodeID node = candidates[i];
+                if(
+                    IsActive(node) && (
+                        !HasActiveArc(forward_begin, forward_targets, node) ||
+                        !HasActiveArc(backward_begin, backward_targets, node)
+                    )
+                ) {
+                    trimmed_per_thread[omp_get_thread_num()].push_back(node);
+                }
+            }
+
+            candidates.clear();
+            BOOST_FOREACH(std::vector<NodeID> & trimmed, trimmed_per_thread) {
+                BOOST_FOREACH(const NodeID node, trimmed) {
+                    component_ids[node] = number_of_components++;
+                }
+            }
+            BOOST_FOREACH(std::vector<NodeID> & trimmed, trimmed_per_thread) {
+                BOOST_FOREACH(const NodeID node, trimmed) {
+                    AppendActiveNeighbors(forward_begin, forward_targets, node, candidates);
+                    AppendActiveNeighbors(backward_begin, backward_targets, node, candidates);
+                }
+                number_of_trimmed_nodes += trimmed.size();
+                trimmed.clear();
+            }
+        }
+        return number_of_trimmed_nodes;
+    }
+
+    void AppendActiveNeighbors(const std::vector<unsigned> & begin, const std::vector<NodeID> & targets, const NodeID node, std::vector<NodeID> & neighbors) const {
+        for(unsigned arc = begin[node]; arc < begin[node+1]; ++arc) {
+            if(IsActive(targets[arc])) {
+                neighbors.push_back(targets[arc]);
+            }
+        }
+    }
+
+    // The component of the active node with the most paths through it is
+    // the intersection of its forward and backward reachable sets.
+    unsigned FindGiantComponent() {
+        const int number_of_nodes_int = number_of_nodes;
+        std::vector<std::pair<boost::uint64_t, NodeID> > pivot_per_thread(
+            omp_get_max_threads(),
+            std::make_pair(0, UINT_MAX)
+        );
+#pragma omp parallel for schedule ( guided )
+        for(int node = 0; node < number_of_nodes_int; ++node) {
+            if(!IsActive(node)) {
+                continue;
+            }
+            const boost::uint64_t paths =
+                boost::uint64_t(forward_begin[node+1] - forward_begin[node]) *
+                (backward_begin[node+1] - backward_begin[node]);
+            std::pair<boost::uint64_t, NodeID> & pivot = pivot_per_thread[omp_get_thread_num()];
+            if(UINT_MAX == pivot.second || paths > pivot.first) {
+                pivot = std::make_pair(paths, (NodeID)node);
+            }
+        }
+        NodeID pivot = UINT_MAX;
+        boost::uint64_t most_paths = 0;
+        for(unsigned i = 0; i < pivot_per_thread.size(); ++i) {
+            if(
+                UINT_MAX != pivot_per_thread[i].second &&
+                (UINT_MAX == pivot || pivot_per_thread[i].first > most_paths)
+            ) {
+                pivot = pivot_per_thread[i].second;
+                most_paths = pivot_per_thread[i].first;
+            }
+        }
+        if(UINT_MAX == pivot) {
+            return 0;
+        }
+
+        std::vector<char> reached_forward(number_of_nodes, false);
+        std::vector<char> reached_backward(number_of_nodes, false);
+        Reach(forward_begin, forward_targets, pivot, reached_forward);
+        Reach(backward_begin, backward_targets, pivot, reached_backward);
+
+        unsigned size_of_giant_component = 0;
+        for(unsigned node = 0; node < number_of_nodes; ++node) {
+            if(reached_forward[node] && reached_backward[node]) {
+                component_ids[node] = number_of_components;
+                ++size_of_giant_component;
+            }
+        }
+        ++number_of_components;
+        return size_of_giant_component;
+    }
+
+    // Breadth-first search over active nodes. A level is expanded in
+    // parallel into per-thread candidate lists, which are merged into the
+    // next level afterwards, so that no thread writes a shared flag.
+    void Reach(const std::vector<unsigned> & begin, const std::vector<NodeID> & targets, const NodeID start, std::vector<char> & reached) const {
+        std::vector<std::vector<NodeID> > candidates_per_thread(omp_get_max_threads());
+        std::vector<NodeID> level(1, start);
+        reached[start] = true;
+        while(!level.empty()) {
+            const int size_of_level = level.size();
+#pragma omp parallel for schedule ( guided )
+            for(int i = 0; i < size_of_level; ++i) {
+                std::vector<NodeID> & candidates = candidates_per_thread[omp_get_thread_num()];
+                const NodeID node = level[i];
+                for(unsigned arc = begin[node]; arc < begin[node+1]; ++arc) {
+                    const NodeID target = targets[arc];
+                    if(!reached[target] && IsActive(target)) {
+                        candidates.push_back(target);
+                    }
+                }
+            }
+            level.clear();
+            BOOST_FOREACH(std::vector<NodeID> & candidates, candidates_per_thread) {
+                BOOST_FOREACH(const NodeID node, candidates) {
+                    if(!reached[node]) {
+                        reached[node] = true;
+                        level.push_back(node);
+                    }
+                }
+                candidates.clear();
+            }
+        }
+    }
+
+    // Splits the remaining nodes into weakly connected pieces and runs
+    // Tarjan's algorithm on each piece. No arc connects two pieces, so the
+    // pieces share no state and are searched in parallel.
+    unsigned DecomposeRest() {
+        std::vector<NodeID> parents(number_of_nodes);
+        for(unsigned node = 0; node < number_of_nodes; ++node) {
+            parents[node] = node;
+        }
+        for(unsigned node = 0; node < number_of_nodes; ++node) {
+            if(!IsActive(node)) {
+                continue;
+            }
+            for(unsigned arc = forward_begin[node]; arc < forward_begin[node+1]; ++arc) {
+                if(IsActive(forward_targets[arc])) {
+                    const NodeID root = FindRoot(parents, node);
+                    const NodeID other_root = FindRoot(parents, forward_targets[arc]);
+                    parents[std::max(root, other_root)] = std::min(root, other_root);
+                }
+            }
+        }
+
+        //group the active nodes by piece
+        std::vector<unsigned> piece_begin(1, 0);
+        std::vector<unsigned> piece_of_root(number_of_nodes, UINT_MAX);
+        for(unsigned node = 0; node < number_of_nodes; ++node) {
+            if(!IsActive(node)) {
+                continue;
+            }
+            const NodeID root = FindRoot(parents, node);
+            if(UINT_MAX == piece_of_root[root]) {
+                piece_of_root[root] = piece_begin.size()-1;
+                piece_begin.push_back(0);
+            }
+            ++piece_begin[piece_of_root[root]+1];
+        }
+        const unsigned number_of_pieces = piece_begin.size()-1;
+        for(unsigned piece = 0; piece < number_of_pieces; ++piece) {
+            piece_begin[piece+1] += piece_begin[piece];
+        }
+        std::vector<NodeID> piece_nodes(piece_begin.back());
+        std::vector<unsigned> position(piece_begin.begin(), piece_begin.end()-1);
+        for(unsigned node = 0; node < number_of_nodes; ++node) {
+            if(IsActive(node)) {
+                piece_nodes[position[piece_of_root[FindRoot(parents, node)]]++] = node;
+            }
+        }
+        std::vector<unsigned>().swap(piece_of_root);
+        std::vector<NodeID>().swap(parents);
+
+        //components are numbered within their piece first
+        std::vector<unsigned> tarjan_index(number_of_nodes, UINT_MAX);
+        std::vector<unsigned> tarjan_lowlink(number_of_nodes, UINT_MAX);
+        std::vector<unsigned> local_ids(number_of_nodes, UINT_MAX);
+        std::vector<unsigned> components_per_piece(number_of_pieces+1, 0);
+        const int number_of_pieces_int = number_of_pieces;
+#pragma omp parallel for schedule ( dynamic )
+        for(int piece = 0; piece < number_of_pieces_int; ++piece) {
+            components_per_piece[piece+1] = Tarjan(
+                piece_nodes.begin() + piece_begin[piece],
+                piece_nodes.begin() + piece_begin[piece+1],
+                tarjan_index,
+                tarjan_lowlink,
+                local_ids
+            );
+        }
+        for(unsigned piece = 0; piece < number_of_pieces; ++piece) {
+            components_per_piece[piece+1] += components_per_piece[piece];
+        }
+#pragma omp parallel for schedule ( guided )
+        for(int piece = 0; piece < number_of_pieces_int; ++piece) {
+            for(unsigned i = piece_begin[piece]; i < piece_begin[piece+1]; ++i) {
+                const NodeID node = piece_nodes[i];
+                component_ids[node] = number_of_components + components_per_piece[piece] + local_ids[node];
+            }
+        }
+        number_of_components += components_per_piece.back();
+        return number_of_pieces;
+    }
+
+    static NodeID FindRoot(std::vector<NodeID> & parents, NodeID node) {
+        while(parents[node] != node) {
+            parents[node] = parents[parents[node]];
+            node = parents[node];
+        }
+        return node;
+    }
+
+    // Iterative Tarjan on the active nodes of one piece. Writes the piece
+    // local component of each node to local_ids, returns their number.
+    unsigned Tarjan(
+        std::vector<NodeID>::const_iterator nodes_begin,
+        std::vector<NodeID>::const_iterator nodes_end,
+        std::vector<unsigned> & tarjan_index,
+        std::vector<unsigned> & tarjan_lowlink,
+        std::vector<unsigned> & local_ids
+    ) const {
+        unsigned index = 0, number_of_local_components = 0;
+        std::vector<TarjanFrame> recursion_stack;
+        std::vector<NodeID> tarjan_stack;
+        for(std::vector<NodeID>::const_iterator it = nodes_begin; it != nodes_end; ++it) {
+            if(UINT_MAX != tarjan_index[*it]) {
+                continue;
+            }
+            recursion_stack.push_back(TarjanFrame(*it, forward_begin[*it]));
+            tarjan_index[*it] = tarjan_lowlink[*it] = index++;
+            tarjan_stack.push_back(*it);
+
+            while(!recursion_stack.empty()) {
+                TarjanFrame & frame = recursion_stack.back();
+                const NodeID v = frame.node;
+                if(frame.arc < forward_begin[v+1]) {
+                    const NodeID w = forward_targets[frame.arc++];
+                    if(!IsActive(w)) {
+                        continue;
+                    }
+                    if(UINT_MAX == tarjan_index[w]) {
+                        tarjan_index[w] = tarjan_lowlink[w] = index++;
+                        tarjan_stack.push_back(w);
+                        recursion_stack.push_back(TarjanFrame(w, forward_begin[w]));
+                    } else if(UINT_MAX == local_ids[w]) {
+                        //w is still on the stack
+                        tarjan_lowlink[v] = std::min(tarjan_lowlink[v], tarjan_index[w]);
+                    }
+                    continue;
+                }
+
+                recursion_stack.pop_back();
+                if(!recursion_stack.empty()) {
+                    const NodeID parent = recursion_stack.back().node;
+                    tarjan_lowlink[parent] = std::min(tarjan_lowlink[parent], tarjan_lowlink[v]);
+                }
+                if(tarjan_lowlink[v] == tarjan_index[v]) {
+                    NodeID w;
+                    do {
+                        w = tarjan_stack.back();
+                        tarjan_stack.pop_back();
+                        local_ids[w] = number_of_local_components;
+                    } while(w != v);
+                    ++number_of_local_components;
+                }
+            }
+        }
+        return number_of_local_components;
+    }
+
+    const unsigned number_of_nodes;
+    std::vector<unsigned> forward_begin;
+    std::vector<NodeID> forward_targets;
+    std::vector<unsigned> backward_begin;
+    std::vector<NodeID> backward_targets;
+    std::vector<unsigned> component_ids;
+    std::vector<unsigned> component_sizes;
+    unsigned number_of_components;
+};
+
+#endif /* PARALLEL_SCC_H_ */
@@ -35,7 +35,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 class PolylineCompressor {
 private:
-	inline void encodeVectorSignedNumber(std::vector<int> & numbers, std::string & output) const {
+	template<class OutputT>
+	inline void encodeVectorSignedNumber(std::vector<int> & numbers, OutputT & output) const {
 		for(unsigned i = 0; i < numbers.size(); ++i) {
 			numbers[i] <<= 1;
 			if (numbers[i] < 0) {
@@ -47,7 +48,8 @@ private:
 		}
 	}
 
-	inline void encodeNumber(int numberToEncode, std::string & output) const {
+	template<class OutputT>
+	inline void encodeNumber(int numberToEncode, OutputT & output) const {
 		while (numberToEncode >= 0x20) {
 			int nextValue = (0x20 | (numberToEncode & 0x1f)) + 63;
 			output += (static_cast<char> (nextValue));
@@ -63,9 +65,11 @@ private:
 	}
 
 public:
+    // OutputT may be a std::string or an OutputBuffer, anything supporting += char
+    template<class OutputT>
     inline void printEncodedString(
         const std::vector<SegmentInformation> & polyline,
-        std::string & output
+        OutputT & output
     ) const {
     	std::vector<int> deltaNumbers;
         output += "\"";
@@ -86,7 +90,8 @@ public:
 
     }
 
-	inline void printEncodedString(const std::vector<FixedPointCoordinate>& polyline, std::string &output) const {
+	template<class OutputT>
+	inline void printEncodedString(const std::vector<FixedPointCoordinate>& polyline, OutputT &output) const {
 		std::vector<int> deltaNumbers(2*polyline.size());
 		output += "\"";
 		if(!polyline.empty()) {
@@ -101,7 +106,8 @@ public:
 		output += "\"";
 	}
 
-    inline void printUnencodedString(std::vector<FixedPointCoordinate> & polyline, std::string & output) const {
+    template<class OutputT>
+    inline void printUnencodedString(std::vector<FixedPointCoordinate> & polyline, OutputT & output) const {
         output += "[";
         std::string tmp;
         for(unsigned i = 0; i < polyline.size(); i++) {
@@ -119,7 +125,8 @@ public:
         output += "]";
     }
 
-    inline void printUnencodedString(std::vector<SegmentInformation> & polyline, std::string & output) const {
+    template<class OutputT>
+    inline void printUnencodedString(std::vector<SegmentInformation> & polyline, OutputT & output) const {
         output += "[";
         std::string tmp;
         for(unsigned i = 0; i < polyline.size(); i++) {
@@ -36,6 +36,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../DataStructures/Percent.h"
 #include "../DataStructures/Restriction.h"
 #include "../DataStructures/TurnInstructions.h"
+#include "ParallelSCC.h"
 
 #include "../Util/SimpleLogger.h"
 
@@ -55,19 +56,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
     #include <gdal/ogrsf_frmts.h>
 #endif
 
-#include <stack>
 #include <vector>
 
 class TarjanSCC {
 private:
 
-    struct TarjanNode {
-        TarjanNode() : index(UINT_MAX), lowlink(UINT_MAX), onStack(false) {}
-        unsigned index;
-        unsigned lowlink;
-        bool onStack;
-    };
-
     struct TarjanEdgeData {
         int distance;
         unsigned nameID:31;
@@ -81,15 +74,6 @@ private:
         bool reversedEdge:1;
     };
 
-    struct TarjanStackFrame {
-        explicit TarjanStackFrame(
-            NodeID v,
-            NodeID parent
-        ) : v(v), parent(parent) { }
-        NodeID v;
-        NodeID parent;
-    };
-
     typedef DynamicGraph<TarjanEdgeData>        TarjanDynamicGraph;
     typedef TarjanDynamicGraph::InputEdge       TarjanEdge;
     typedef std::pair<NodeID, NodeID>           RestrictionSource;
@@ -254,102 +238,21 @@ public:
             throw OSRMException("Layer creation failed.");
         }
 
-        //The following is a hack to distinguish between stuff that happens
-        //before the recursive call and stuff that happens after
-        std::stack<std::pair<bool, TarjanStackFrame> > recursion_stack;
-        //true = stuff before, false = stuff after call
-        std::stack<NodeID> tarjan_stack;
+        //barriers are not taken into account, all nodes can be left
+        ParallelSCC scc(*m_node_based_graph, std::vector<bool>());
+        scc.Run();
         std::vector<unsigned> components_index(
-            m_node_based_graph->GetNumberOfNodes(),
-            UINT_MAX
-        );
-        std::vector<NodeID> component_size_vector;
-        std::vector<TarjanNode> tarjan_node_list(
             m_node_based_graph->GetNumberOfNodes()
         );
-        unsigned component_index = 0, size_of_current_component = 0;
-        int index = 0;
-        for(
-            NodeID node = 0, last_node = m_node_based_graph->GetNumberOfNodes();
-            node < last_node;
-            ++node
-        ) {
-            if(UINT_MAX == components_index[node]) {
-                recursion_stack.push(
-                    std::make_pair(true, TarjanStackFrame(node,node))
-                );
-            }
-
-            while(!recursion_stack.empty()) {
-                bool before_recursion = recursion_stack.top().first;
-                TarjanStackFrame currentFrame = recursion_stack.top().second;
-                NodeID v = currentFrame.v;
-                recursion_stack.pop();
-
-                if(before_recursion) {
-                    //Mark frame to handle tail of recursion
-                    recursion_stack.push(std::make_pair(false, currentFrame));
-
-                    //Mark essential information for SCC
-                    tarjan_node_list[v].index = index;
-                    tarjan_node_list[v].lowlink = index;
-                    tarjan_stack.push(v);
-                    tarjan_node_list[v].onStack = true;
-                    ++index;
-
-                    //Traverse outgoing edges
-                    for(
-                        TarjanDynamicGraph::EdgeIterator e2 = m_node_based_graph->BeginEdges(v);
-                        e2 < m_node_based_graph->EndEdges(v);
-                        ++e2
-                    ) {
-                        const TarjanDynamicGraph::NodeIterator vprime =
-                            m_node_based_graph->GetTarget(e2);
-                        if(UINT_MAX == tarjan_node_list[vprime].index) {
-                            recursion_stack.push(
-                                std::make_pair(
-                                    true,
-                                    TarjanStackFrame(vprime, v)
-                                )
-                            );
-                        } else {
-                            if(
-                                tarjan_node_list[vprime].onStack &&
-                                tarjan_node_list[vprime].index < tarjan_node_list[v].lowlink
-                            ) {
-                                tarjan_node_list[v].lowlink = tarjan_node_list[vprime].index;
-                            }
-                        }
-                    }
-                } else {
-                    tarjan_node_list[currentFrame.parent].lowlink =
-                        std::min(
-                            tarjan_node_list[currentFrame.parent].lowlink,
-                            tarjan_node_list[v].lowlink
-                        );
-                    //after recursion, lets do cycle checking
-                    //Check if we found a cycle. This is the bottom part of the recursion
-                    if(tarjan_node_list[v].lowlink == tarjan_node_list[v].index) {
-                        NodeID vprime;
-                        do {
-                            vprime = tarjan_stack.top(); tarjan_stack.pop();
-                            tarjan_node_list[vprime].onStack = false;
-                            components_index[vprime] = component_index;
-                            ++size_of_current_component;
-                        } while( v != vprime);
-
-                        component_size_vector.push_back(size_of_current_component);
-
-                        if(size_of_current_component > 1000) {
-                            SimpleLogger().Write() <<
-                            "large component [" << component_index << "]=" <<
-                            size_of_current_component;
-                        }
-
-                        ++component_index;
-                        size_of_current_component = 0;
-                    }
-                }
+        for(unsigned node = 0; node < components_index.size(); ++node) {
+            components_index[node] = scc.GetComponentID(node);
+        }
+        std::vector<NodeID> component_size_vector(scc.GetNumberOfComponents());
+        for(unsigned i = 0; i < component_size_vector.size(); ++i) {
+            component_size_vector[i] = scc.GetComponentSize(i);
+            if(component_size_vector[i] > 1000) {
+                SimpleLogger().Write() <<
+                "large component [" << i << "]=" << component_size_vector[i];
             }
         }
 
@@ -35,11 +35,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../DataStructures/Percent.h"
 #include "../DataStructures/XORFastHash.h"
 #include "../DataStructures/XORFastHashStorage.h"
+#include "../Util/GraphFileFormat.h"
 #include "../Util/OpenMPWrapper.h"
 #include "../Util/SimpleLogger.h"
 #include "../Util/StringUtil.h"
+#include "../Util/TimingUtil.h"
 
 #include <boost/assert.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
 #include <boost/lambda/lambda.hpp>
 #include <boost/make_shared.hpp>
@@ -49,6 +52,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <algorithm>
 #include <limits>
+#include <queue>
+#include <string>
 #include <vector>
 
 class Contractor {
@@ -114,8 +119,18 @@ private:
 
 public:
 
+    /**
+     * memoryBudgetInMB bounds the size of the contraction graph. Whenever it
+     * is exceeded, the edges of contracted nodes are written to disk in
+     * sorted, compressed runs. A budget of 0 keeps the single flush at 65%.
+     */
     template<class ContainerT >
-    Contractor( int nodes, ContainerT& inputEdges) {
+    Contractor( int nodes, ContainerT& inputEdges, const unsigned memoryBudgetInMB = 0) :
+        memoryBudget((uint64_t)memoryBudgetInMB << 20),
+        checkpointChecksum(0),
+        checkpointInterval(0.),
+        resumeFromCheckpoint(false)
+    {
         std::vector< _ContractorEdge > edges;
         edges.reserve(inputEdges.size()*2);
 
@@ -211,138 +226,96 @@ public:
         //            SimpleLogger().Write() << " ->(" << highestNode << "," << _graph->GetTarget(i) << "); via: " << _graph->GetEdgeData(i).via;
         //        }
 
-        //Create temporary file
-
-        //        GetTemporaryFileName(temporaryEdgeStorageFilename);
-        temporaryStorageSlotID = TemporaryStorage::GetInstance().allocateSlot();
         std::cout << "contractor finished initalization" << std::endl;
     }
 
     ~Contractor() {
-        //Delete temporary file
-        //        remove(temporaryEdgeStorageFilename.c_str());
-        TemporaryStorage::GetInstance().deallocateSlot(temporaryStorageSlotID);
+        //Delete temporary files
+        BOOST_FOREACH(const _SpillRun & run, spillRuns) {
+            TemporaryStorage::GetInstance().deallocateSlot(run.slotID);
+        }
+    }
+
+    /**
+     * Writes a snapshot of the contraction to path every intervalInSeconds.
+     * With resume, Run() continues from an existing snapshot that matches
+     * this build and the checksum of the input.
+     */
+    void EnableCheckpoints(const std::string & path, const unsigned checksum, const double intervalInSeconds, const bool resume) {
+        checkpointPath = path;
+        checkpointChecksum = checksum;
+        checkpointInterval = intervalInSeconds;
+        resumeFromCheckpoint = resume;
     }
 
     void Run() {
-        const NodeID numberOfNodes = _graph->GetNumberOfNodes();
+        _CheckpointInfo progress;
+        progress.numberOfNodes = _graph->GetNumberOfNodes();
+        progress.checksum = checkpointChecksum;
+        progress.numberOfContractedNodes = 0;
+        progress.numberOfFlushes = 0;
+        progress.memoryAfterLastFlush = 0;
+        std::vector< _RemainingNodeData > remainingNodes;
+        std::vector< float > nodePriority;
+        std::vector< _PriorityData > nodeData;
+        const bool resumed = resumeFromCheckpoint && _ReadCheckpoint(progress, remainingNodes, nodePriority, nodeData);
+
+        const NodeID numberOfNodes = progress.numberOfNodes;
+        NodeID numberOfContractedNodes = progress.numberOfContractedNodes;
+        unsigned numberOfFlushes = progress.numberOfFlushes;
+        //graph size right after the last flush, flushing again below it would not free anything
+        uint64_t memoryAfterLastFlush = progress.memoryAfterLastFlush;
         Percent p (numberOfNodes);
 
         const unsigned maxThreads = omp_get_max_threads();
         std::vector < _ThreadData* > threadData;
         for ( unsigned threadNum = 0; threadNum < maxThreads; ++threadNum ) {
-            threadData.push_back( new _ThreadData( numberOfNodes ) );
+            threadData.push_back( new _ThreadData( _graph->GetNumberOfNodes() ) );
         }
         std::cout << "Contractor is using " << maxThreads << " threads" << std::endl;
 
-        NodeID numberOfContractedNodes = 0;
-        std::vector< _RemainingNodeData > remainingNodes( numberOfNodes );
-        std::vector< float > nodePriority( numberOfNodes );
-        std::vector< _PriorityData > nodeData( numberOfNodes );
+        if(!resumed) {
+            remainingNodes.resize( numberOfNodes );
+            nodePriority.resize( numberOfNodes );
+            nodeData.resize( numberOfNodes );
 
-        //initialize the variables
+            //initialize the variables
 #pragma omp parallel for schedule ( guided )
-        for ( int x = 0; x < ( int ) numberOfNodes; ++x ) {
-            remainingNodes[x].id = x;
-        }
+            for ( int x = 0; x < ( int ) numberOfNodes; ++x ) {
+                remainingNodes[x].id = x;
+            }
 
-        std::cout << "initializing elimination PQ ..." << std::flush;
+            std::cout << "initializing elimination PQ ..." << std::flush;
 #pragma omp parallel
-        {
-            _ThreadData* data = threadData[omp_get_thread_num()];
+            {
+                _ThreadData* data = threadData[omp_get_thread_num()];
 #pragma omp parallel for schedule ( guided )
-            for ( int x = 0; x < ( int ) numberOfNodes; ++x ) {
-                nodePriority[x] = _Evaluate( data, &nodeData[x], x );
+                for ( int x = 0; x < ( int ) numberOfNodes; ++x ) {
+                    nodePriority[x] = _Evaluate( data, &nodeData[x], x );
+                }
             }
+            std::cout << "ok" << std::endl;
         }
-        std::cout << "ok" << std::endl << "preprocessing " << numberOfNodes << " nodes ..." << std::flush;
+        std::cout << "preprocessing " << numberOfNodes << " nodes ..." << std::flush;
 
-        bool flushedContractor = false;
+        double lastCheckpointTime = get_timestamp();
         while ( numberOfNodes > 2 && numberOfContractedNodes < numberOfNodes ) {
-            if(!flushedContractor && (numberOfContractedNodes > (numberOfNodes*0.65) ) ){
-                DeallocatingVector<_ContractorEdge> newSetOfEdges; //this one is not explicitely cleared since it goes out of scope anywa
-                std::cout << " [flush " << numberOfContractedNodes << " nodes] " << std::flush;
-
+            const NodeID numberOfStageNodes = _graph->GetNumberOfNodes();
+            const bool flushAtDefaultPoint = (0 == numberOfFlushes) && (numberOfContractedNodes > (numberOfNodes*0.65));
+            //flush only if at least 10% of the current graph can be written out
+            const bool flushOverBudget = (0 != memoryBudget)
+                && (10*(uint64_t)(numberOfStageNodes - remainingNodes.size()) > numberOfStageNodes)
+                && (_graph->GetMemoryUsage() > std::max(memoryBudget, memoryAfterLastFlush));
+            if( flushAtDefaultPoint || flushOverBudget ) {
+                std::cout << " [flush " << numberOfContractedNodes << " nodes, " << (_graph->GetMemoryUsage() >> 20) << " MB] " << std::flush;
                 //Delete old heap data to free memory that we need for the coming operations
                 BOOST_FOREACH(_ThreadData * data, threadData)
                 	delete data;
                 threadData.clear();
 
-
-                //Create new priority array
-                std::vector<float> newNodePriority(remainingNodes.size());
-                //this map gives the old IDs from the new ones, necessary to get a consistent graph at the end of contraction
-                oldNodeIDFromNewNodeIDMap.resize(remainingNodes.size());
-                //this map gives the new IDs from the old ones, necessary to remap targets from the remaining graph
-                std::vector<NodeID> newNodeIDFromOldNodeIDMap(numberOfNodes, UINT_MAX);
-
-                //build forward and backward renumbering map and remap ids in remainingNodes and Priorities.
-                for(unsigned newNodeID = 0; newNodeID < remainingNodes.size(); ++newNodeID) {
-                    //create renumbering maps in both directions
-                    oldNodeIDFromNewNodeIDMap[newNodeID] = remainingNodes[newNodeID].id;
-                    newNodeIDFromOldNodeIDMap[remainingNodes[newNodeID].id] = newNodeID;
-                    newNodePriority[newNodeID] = nodePriority[remainingNodes[newNodeID].id];
-                    remainingNodes[newNodeID].id = newNodeID;
-                }
-                TemporaryStorage & tempStorage = TemporaryStorage::GetInstance();
-                //Write dummy number of edges to temporary file
-                //        		std::ofstream temporaryEdgeStorage(temporaryEdgeStorageFilename.c_str(), std::ios::binary);
-                uint64_t initialFilePosition = tempStorage.tell(temporaryStorageSlotID);
-                unsigned numberOfTemporaryEdges = 0;
-                tempStorage.writeToSlot(temporaryStorageSlotID, (char*)&numberOfTemporaryEdges, sizeof(unsigned));
-
-                //walk over all nodes
-                for(unsigned i = 0; i < _graph->GetNumberOfNodes(); ++i) {
-                    const NodeID start = i;
-                    for(_DynamicGraph::EdgeIterator currentEdge = _graph->BeginEdges(start); currentEdge < _graph->EndEdges(start); ++currentEdge) {
-                        _DynamicGraph::EdgeData & data = _graph->GetEdgeData(currentEdge);
-                        const NodeID target = _graph->GetTarget(currentEdge);
-                        if(UINT_MAX == newNodeIDFromOldNodeIDMap[i] ){
-                            //Save edges of this node w/o renumbering.
-                            tempStorage.writeToSlot(temporaryStorageSlotID, (char*)&start,  sizeof(NodeID));
-                            tempStorage.writeToSlot(temporaryStorageSlotID, (char*)&target, sizeof(NodeID));
-                            tempStorage.writeToSlot(temporaryStorageSlotID, (char*)&data,   sizeof(_DynamicGraph::EdgeData));
-                            ++numberOfTemporaryEdges;
-                        }else {
-                            //node is not yet contracted.
-                            //add (renumbered) outgoing edges to new DynamicGraph.
-                            _ContractorEdge newEdge;
-                            newEdge.source = newNodeIDFromOldNodeIDMap[start];
-                            newEdge.target = newNodeIDFromOldNodeIDMap[target];
-                            newEdge.data = data;
-                            newEdge.data.originalViaNodeID = true;
-                            BOOST_ASSERT_MSG(
-                                UINT_MAX != newNodeIDFromOldNodeIDMap[start],
-                                "new start id not resolveable"
-                            );
-                            BOOST_ASSERT_MSG(
-                                UINT_MAX != newNodeIDFromOldNodeIDMap[target],
-                                "new target id not resolveable"
-                            );
-                            newSetOfEdges.push_back(newEdge);
-                        }
-                    }
-                }
-                //Note the number of temporarily stored edges
-                tempStorage.seek(temporaryStorageSlotID, initialFilePosition);
-                tempStorage.writeToSlot(temporaryStorageSlotID, (char*)&numberOfTemporaryEdges, sizeof(unsigned));
-
-                //Delete map from old NodeIDs to new ones.
-                std::vector<NodeID>().swap(newNodeIDFromOldNodeIDMap);
-
-                //Replace old priorities array by new one
-                nodePriority.swap(newNodePriority);
-                //Delete old nodePriority vector
-                std::vector<float>().swap(newNodePriority);
-                //old Graph is removed
-                _graph.reset();
-
-                //create new graph
-                std::sort(newSetOfEdges.begin(), newSetOfEdges.end());
-                _graph = boost::make_shared<_DynamicGraph>(remainingNodes.size(), newSetOfEdges);
-
-                newSetOfEdges.clear();
-                flushedContractor = true;
+                _FlushContractedNodes(remainingNodes, nodePriority);
+                ++numberOfFlushes;
+                memoryAfterLastFlush = _graph->GetMemoryUsage();
 
                 //INFO: MAKE SURE THIS IS THE LAST OPERATION OF THE FLUSH!
                 //reinitialize heaps and ThreadData objects with appropriate size
@@ -441,6 +414,17 @@ public:
             //            SimpleLogger().Write() << "rest: " << remainingNodes.size() << ", max: " << maxdegree << ", min: " << mindegree << ", avg: " << avgdegree << ", quad: " << quaddegree;
 
             p.printStatus(numberOfContractedNodes);
+
+            const bool checkpointIsDue = !checkpointPath.empty()
+                && (numberOfContractedNodes < numberOfNodes)
+                && (get_timestamp() - lastCheckpointTime) > checkpointInterval;
+            if(checkpointIsDue) {
+                progress.numberOfContractedNodes = numberOfContractedNodes;
+                progress.numberOfFlushes = numberOfFlushes;
+                progress.memoryAfterLastFlush = memoryAfterLastFlush;
+                _WriteCheckpoint(progress, remainingNodes, nodePriority, nodeData);
+                lastCheckpointTime = get_timestamp();
+            }
         }
         BOOST_FOREACH(_ThreadData * data, threadData) {
         	delete data;
@@ -448,80 +432,427 @@ public:
         threadData.clear();
     }
 
+    /**
+     * Returns all edges of the hierarchy in original node ids, sorted by
+     * source and target. The remaining graph is written out as a last run
+     * and all runs on disk are merged.
+     */
     template< class Edge >
     inline void GetEdges( DeallocatingVector< Edge >& edges ) {
-        Percent p (_graph->GetNumberOfNodes());
         SimpleLogger().Write() << "Getting edges of minimized graph";
-        NodeID numberOfNodes = _graph->GetNumberOfNodes();
-        if(_graph->GetNumberOfNodes()) {
-            for ( NodeID node = 0; node < numberOfNodes; ++node ) {
-                p.printStatus(node);
-                for ( _DynamicGraph::EdgeIterator edge = _graph->BeginEdges( node ), endEdges = _graph->EndEdges( node ); edge < endEdges; ++edge ) {
-                    const NodeID target = _graph->GetTarget( edge );
-                    const _DynamicGraph::EdgeData& data = _graph->GetEdgeData( edge );
-                    Edge newEdge;
-                    if(0 != oldNodeIDFromNewNodeIDMap.size()) {
-                        newEdge.source = oldNodeIDFromNewNodeIDMap[node];
-                        newEdge.target = oldNodeIDFromNewNodeIDMap[target];
-                    } else {
-                        newEdge.source = node;
-                        newEdge.target = target;
+        std::vector<_ContractorEdge> remainingEdges;
+        for ( NodeID node = 0; node < _graph->GetNumberOfNodes(); ++node ) {
+            for ( _DynamicGraph::EdgeIterator edge = _graph->BeginEdges( node ), endEdges = _graph->EndEdges( node ); edge < endEdges; ++edge ) {
+                remainingEdges.push_back(_GetOriginalEdge(node, edge));
+            }
+        }
+        _graph.reset();
+        std::vector<NodeID>().swap(oldNodeIDFromNewNodeIDMap);
+        _WriteSpillRun(remainingEdges);
+
+        uint64_t numberOfEdges = 0;
+        std::vector<_SpillRunReader> readers;
+        readers.reserve(spillRuns.size());
+        std::priority_queue<_MergeItem> mergeQueue;
+        for(unsigned runID = 0; runID < spillRuns.size(); ++runID) {
+            numberOfEdges += spillRuns[runID].numberOfEdges;
+            readers.push_back(_SpillRunReader(spillRuns[runID]));
+            _MergeItem item;
+            item.runID = runID;
+            if(readers.back().Next(item.edge)) {
+                mergeQueue.push(item);
+            }
+        }
+        SimpleLogger().Write() << "merging " << numberOfEdges << " edges from " << spillRuns.size() << " runs";
+
+        Percent p (numberOfEdges);
+        uint64_t numberOfMergedEdges = 0;
+        while(!mergeQueue.empty()) {
+            _MergeItem item = mergeQueue.top();
+            mergeQueue.pop();
+            p.printStatus(numberOfMergedEdges++);
+
+            Edge newEdge;
+            newEdge.source = item.edge.source;
+            newEdge.target = item.edge.target;
+            BOOST_ASSERT_MSG(
+                UINT_MAX != newEdge.source,
+                "Source id invalid"
+            );
+            BOOST_ASSERT_MSG(
+                UINT_MAX != newEdge.target,
+                "Target id invalid"
+            );
+            newEdge.data.distance = item.edge.data.distance;
+            newEdge.data.shortcut = item.edge.data.shortcut;
+            newEdge.data.id = item.edge.data.id;
+            BOOST_ASSERT_MSG(
+                newEdge.data.id != INT_MAX, //2^31
+                "edge id invalid"
+            );
+            newEdge.data.forward = item.edge.data.forward;
+            newEdge.data.backward = item.edge.data.backward;
+            edges.push_back( newEdge );
+
+            if(readers[item.runID].Next(item.edge)) {
+                mergeQueue.push(item);
+            }
+        }
+        BOOST_FOREACH(const _SpillRun & run, spillRuns) {
+            TemporaryStorage::GetInstance().deallocateSlot(run.slotID);
+        }
+        spillRuns.clear();
+    }
+
+private:
+    //a sorted run of edges in original node ids, stored compressed in its own temporary slot
+    struct _SpillRun {
+        _SpillRun(const int s) : slotID(s), numberOfEdges(0), numberOfBytes(0) {}
+        int slotID;
+        uint64_t numberOfEdges;
+        uint64_t numberOfBytes;
+    };
+
+    //decodes one run sequentially through a small buffer
+    class _SpillRunReader {
+    public:
+        _SpillRunReader(const _SpillRun & r) :
+            run(r), remainingEdges(r.numberOfEdges), remainingBytes(r.numberOfBytes), position(0), lastSource(0) {}
+
+        bool Next(_ContractorEdge & edge) {
+            if(0 == remainingEdges) {
+                return false;
+            }
+            //an edge takes at most four varints and a flag byte
+            if(buffer.size() - position < 21 && 0 != remainingBytes) {
+                buffer.erase(buffer.begin(), buffer.begin()+position);
+                position = 0;
+                const std::size_t oldSize = buffer.size();
+                const std::size_t chunkSize = std::min(remainingBytes, (uint64_t)1 << 20);
+                buffer.resize(oldSize + chunkSize);
+                TemporaryStorage::GetInstance().readFromSlot(run.slotID, (char*)&buffer[oldSize], chunkSize);
+                remainingBytes -= chunkSize;
+            }
+            lastSource += _ReadVarint();
+            edge.source = lastSource;
+            edge.target = _ReadVarint();
+            edge.data.distance = _ReadVarint();
+            edge.data.id = _ReadVarint();
+            const unsigned char flags = buffer[position++];
+            edge.data.shortcut = flags & 1;
+            edge.data.forward = flags & 2;
+            edge.data.backward = flags & 4;
+            edge.data.originalViaNodeID = true;
+            --remainingEdges;
+            return true;
+        }
+
+    private:
+        unsigned _ReadVarint() {
+            unsigned value = 0;
+            for(unsigned shift = 0; ; shift += 7) {
+                const unsigned char byte = buffer[position++];
+                value |= (unsigned)(byte & 0x7f) << shift;
+                if(!(byte & 0x80)) {
+                    return value;
+                }
+            }
+        }
+
+        _SpillRun run;
+        uint64_t remainingEdges;
+        uint64_t remainingBytes;
+        std::vector<unsigned char> buffer;
+        std::size_t position;
+        NodeID lastSource;
+    };
+
+    //progress of Run() that is stored with a snapshot
+    struct _CheckpointInfo {
+        unsigned numberOfNodes;
+        unsigned checksum;
+        unsigned numberOfContractedNodes;
+        unsigned numberOfFlushes;
+        uint64_t memoryAfterLastFlush;
+    };
+
+    struct _MergeItem {
+        _ContractorEdge edge;
+        unsigned runID;
+        //inverted to make std::priority_queue a min-heap
+        bool operator<(const _MergeItem & other) const {
+            return other.edge < edge;
+        }
+    };
+
+    inline NodeID _GetOriginalNodeID(const NodeID node) const {
+        return oldNodeIDFromNewNodeIDMap.empty() ? node : oldNodeIDFromNewNodeIDMap[node];
+    }
+
+    //edge of the current graph with source, target and via node in original ids
+    inline _ContractorEdge _GetOriginalEdge(const NodeID node, const _DynamicGraph::EdgeIterator edge) const {
+        _ContractorEdge originalEdge;
+        originalEdge.source = _GetOriginalNodeID(node);
+        originalEdge.target = _GetOriginalNodeID(_graph->GetTarget(edge));
+        originalEdge.data = _graph->GetEdgeData(edge);
+        if(!originalEdge.data.originalViaNodeID) {
+            originalEdge.data.id = _GetOriginalNodeID(originalEdge.data.id);
+            originalEdge.data.originalViaNodeID = true;
+        }
+        return originalEdge;
+    }
+
+    static inline void _AppendVarint(std::vector<unsigned char> & buffer, unsigned value) {
+        while(value >= 0x80) {
+            buffer.push_back((unsigned char)(value | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back((unsigned char)value);
+    }
+
+    //sorts the edges and writes them as a new compressed run. Clears the input.
+    void _WriteSpillRun(std::vector<_ContractorEdge> & edges) {
+        if(edges.empty()) {
+            return;
+        }
+        std::sort(edges.begin(), edges.end());
+        TemporaryStorage & tempStorage = TemporaryStorage::GetInstance();
+        _SpillRun run(tempStorage.allocateSlot());
+        std::vector<unsigned char> buffer;
+        NodeID lastSource = 0;
+        BOOST_FOREACH(const _ContractorEdge & edge, edges) {
+            _AppendVarint(buffer, edge.source - lastSource);
+            lastSource = edge.source;
+            _AppendVarint(buffer, edge.target);
+            _AppendVarint(buffer, edge.data.distance);
+            _AppendVarint(buffer, edge.data.id);
+            buffer.push_back((unsigned char)(edge.data.shortcut | (edge.data.forward << 1) | (edge.data.backward << 2)));
+            if(buffer.size() >= (1 << 20)) {
+                tempStorage.writeToSlot(run.slotID, (char*)&buffer[0], buffer.size());
+                run.numberOfBytes += buffer.size();
+                buffer.clear();
+            }
+        }
+        if(!buffer.empty()) {
+            tempStorage.writeToSlot(run.slotID, (char*)&buffer[0], buffer.size());
+            run.numberOfBytes += buffer.size();
+        }
+        run.numberOfEdges = edges.size();
+        spillRuns.push_back(run);
+        std::vector<_ContractorEdge>().swap(edges);
+    }
+
+    /**
+     * Writes the edges of all contracted nodes to disk, renumbers the
+     * remaining nodes densely and rebuilds the graph from their edges.
+     * Node ids in the maps are composed, so they always refer to the input.
+     */
+    void _FlushContractedNodes(std::vector<_RemainingNodeData> & remainingNodes, std::vector<float> & nodePriority) {
+        const NodeID numberOfStageNodes = _graph->GetNumberOfNodes();
+        //Create new priority array
+        std::vector<float> newNodePriority(remainingNodes.size());
+        //this map gives the original IDs from the new ones, necessary to get a consistent graph at the end of contraction
+        std::vector<NodeID> newOldNodeIDFromNewNodeIDMap(remainingNodes.size());
+        //this map gives the new IDs from the old ones, necessary to remap targets from the remaining graph
+        std::vector<NodeID> newNodeIDFromOldNodeIDMap(numberOfStageNodes, UINT_MAX);
+
+        //build forward and backward renumbering map and remap ids in remainingNodes and Priorities.
+        for(unsigned newNodeID = 0; newNodeID < remainingNodes.size(); ++newNodeID) {
+            const NodeID oldNodeID = remainingNodes[newNodeID].id;
+            newOldNodeIDFromNewNodeIDMap[newNodeID] = _GetOriginalNodeID(oldNodeID);
+            newNodeIDFromOldNodeIDMap[oldNodeID] = newNodeID;
+            newNodePriority[newNodeID] = nodePriority[oldNodeID];
+            remainingNodes[newNodeID].id = newNodeID;
+        }
+
+        //runs are bounded to a fraction of the budget, or written in one piece without budget
+        const std::size_t maximumRunSize = (0 != memoryBudget)
+            ? std::max((std::size_t)(memoryBudget/(4*sizeof(_ContractorEdge))), (std::size_t)1 << 16)
+            : std::numeric_limits<std::size_t>::max();
+        std::vector<_ContractorEdge> spilledEdges;
+        DeallocatingVector<_ContractorEdge> newSetOfEdges;
+        for(NodeID start = 0; start < numberOfStageNodes; ++start) {
+            for(_DynamicGraph::EdgeIterator currentEdge = _graph->BeginEdges(start); currentEdge < _graph->EndEdges(start); ++currentEdge) {
+                if(UINT_MAX == newNodeIDFromOldNodeIDMap[start] ){
+                    spilledEdges.push_back(_GetOriginalEdge(start, currentEdge));
+                    if(spilledEdges.size() >= maximumRunSize) {
+                        _WriteSpillRun(spilledEdges);
                     }
-                    BOOST_ASSERT_MSG(
-                        UINT_MAX != newEdge.source,
-                        "Source id invalid"
-                    );
-                    BOOST_ASSERT_MSG(
-                        UINT_MAX != newEdge.target,
-                        "Target id invalid"
-                    );
-                    newEdge.data.distance = data.distance;
-                    newEdge.data.shortcut = data.shortcut;
-                   if(!data.originalViaNodeID && oldNodeIDFromNewNodeIDMap.size()) {
-                        newEdge.data.id = oldNodeIDFromNewNodeIDMap[data.id];
-                    } else {
-                        newEdge.data.id = data.id;
+                } else {
+                    //node is not yet contracted.
+                    //add (renumbered) outgoing edges to new DynamicGraph.
+                    const NodeID target = _graph->GetTarget(currentEdge);
+                    _ContractorEdge newEdge;
+                    newEdge.source = newNodeIDFromOldNodeIDMap[start];
+                    newEdge.target = newNodeIDFromOldNodeIDMap[target];
+                    newEdge.data = _graph->GetEdgeData(currentEdge);
+                    if(!newEdge.data.originalViaNodeID) {
+                        newEdge.data.id = _GetOriginalNodeID(newEdge.data.id);
+                        newEdge.data.originalViaNodeID = true;
                     }
                     BOOST_ASSERT_MSG(
-                        newEdge.data.id != INT_MAX, //2^31
-                        "edge id invalid"
+                        UINT_MAX != newEdge.target,
+                        "new target id not resolveable"
                     );
-                    newEdge.data.forward = data.forward;
-                    newEdge.data.backward = data.backward;
-                    edges.push_back( newEdge );
+                    newSetOfEdges.push_back(newEdge);
                 }
             }
         }
+        _WriteSpillRun(spilledEdges);
+
+        //Delete map from old NodeIDs to new ones.
+        std::vector<NodeID>().swap(newNodeIDFromOldNodeIDMap);
+        oldNodeIDFromNewNodeIDMap.swap(newOldNodeIDFromNewNodeIDMap);
+        //Replace old priorities array by new one
+        nodePriority.swap(newNodePriority);
+        //old Graph is removed
         _graph.reset();
-        std::vector<NodeID>().swap(oldNodeIDFromNewNodeIDMap);
 
+        //create new graph
+        std::sort(newSetOfEdges.begin(), newSetOfEdges.end());
+        _graph = boost::make_shared<_DynamicGraph>(remainingNodes.size(), newSetOfEdges);
+    }
+
+    /**
+     * Stores the state of Run() along with the current graph and the
+     * spilled runs. Written to a temporary name and renamed, so that a
+     * snapshot is either complete or the previous one is kept.
+     */
+    void _WriteCheckpoint(
+        const _CheckpointInfo & progress,
+        const std::vector<_RemainingNodeData> & remainingNodes,
+        const std::vector<float> & nodePriority,
+        const std::vector<_PriorityData> & nodeData
+    ) {
+        std::cout << " [checkpoint] " << std::flush;
+        const std::string temporaryPath = checkpointPath + ".tmp";
+        const UUID uuid;
+        GraphFileWriter writer(temporaryPath, uuid, 8);
+        writer.BeginSection(GRAPH_FILE_CHECKPOINT_INFO_SECTION, sizeof(_CheckpointInfo));
+        writer.WriteRecords((const char *)&progress, 1);
+        writer.BeginSection(GRAPH_FILE_CONTRACTOR_NODE_SECTION, sizeof(_RemainingNodeData));
+        writer.WriteRecords((const char *)&remainingNodes[0], remainingNodes.size());
+        writer.BeginSection(GRAPH_FILE_CONTRACTOR_PRIORITY_SECTION, sizeof(float));
+        writer.WriteRecords((const char *)&nodePriority[0], nodePriority.size());
+        writer.BeginSection(GRAPH_FILE_CONTRACTOR_DEPTH_SECTION, sizeof(_PriorityData));
+        writer.WriteRecords((const char *)&nodeData[0], nodeData.size());
+        writer.BeginSection(GRAPH_FILE_CONTRACTOR_NODE_MAP_SECTION, sizeof(NodeID));
+        if(!oldNodeIDFromNewNodeIDMap.empty()) {
+            writer.WriteRecords((const char *)&oldNodeIDFromNewNodeIDMap[0], oldNodeIDFromNewNodeIDMap.size());
+        }
+
+        //edges of the current graph in current ids, grouped by source
+        writer.BeginSection(GRAPH_FILE_CONTRACTOR_EDGE_SECTION, sizeof(_ContractorEdge));
+        std::vector<_ContractorEdge> buffer;
+        buffer.reserve(1 << 16);
+        for(NodeID node = 0; node < _graph->GetNumberOfNodes(); ++node) {
+            for(_DynamicGraph::EdgeIterator edge = _graph->BeginEdges(node); edge < _graph->EndEdges(node); ++edge) {
+                _ContractorEdge currentEdge;
+                currentEdge.source = node;
+                currentEdge.target = _graph->GetTarget(edge);
+                currentEdge.data = _graph->GetEdgeData(edge);
+                buffer.push_back(currentEdge);
+                if(buffer.size() == buffer.capacity()) {
+                    writer.WriteRecords((const char *)&buffer[0], buffer.size());
+                    buffer.clear();
+                }
+            }
+        }
+        if(!buffer.empty()) {
+            writer.WriteRecords((const char *)&buffer[0], buffer.size());
+        }
+        std::vector<_ContractorEdge>().swap(buffer);
+
+        writer.BeginSection(GRAPH_FILE_CONTRACTOR_RUN_SECTION, sizeof(_SpillRun));
+        if(!spillRuns.empty()) {
+            writer.WriteRecords((const char *)&spillRuns[0], spillRuns.size());
+        }
+        //runs are copied verbatim and rewound for the final merge
         TemporaryStorage & tempStorage = TemporaryStorage::GetInstance();
-        //Also get the edges from temporary storage
-        unsigned numberOfTemporaryEdges = 0;
-        tempStorage.readFromSlot(temporaryStorageSlotID, (char*)&numberOfTemporaryEdges, sizeof(unsigned));
-        //loads edges of graph before renumbering, no need for further numbering action.
-        NodeID start;
-        NodeID target;
-        //edges.reserve(edges.size()+numberOfTemporaryEdges);
-        _DynamicGraph::EdgeData data;
-        for(unsigned i = 0; i < numberOfTemporaryEdges; ++i) {
-            tempStorage.readFromSlot(temporaryStorageSlotID, (char*)&start,  sizeof(NodeID));
-            tempStorage.readFromSlot(temporaryStorageSlotID, (char*)&target, sizeof(NodeID));
-            tempStorage.readFromSlot(temporaryStorageSlotID, (char*)&data,   sizeof(_DynamicGraph::EdgeData));
-            Edge newEdge;
-            newEdge.source =  start;
-            newEdge.target = target;
-            newEdge.data.distance = data.distance;
-            newEdge.data.shortcut = data.shortcut;
-            newEdge.data.id = data.id;
-            newEdge.data.forward = data.forward;
-            newEdge.data.backward = data.backward;
-            edges.push_back( newEdge );
+        writer.BeginSection(GRAPH_FILE_CONTRACTOR_RUN_DATA_SECTION, sizeof(char));
+        std::vector<char> runBuffer(1 << 20);
+        BOOST_FOREACH(const _SpillRun & run, spillRuns) {
+            for(uint64_t copiedBytes = 0; copiedBytes < run.numberOfBytes; ) {
+                const std::size_t chunkSize = std::min(run.numberOfBytes - copiedBytes, (uint64_t)runBuffer.size());
+                tempStorage.readFromSlot(run.slotID, &runBuffer[0], chunkSize);
+                writer.WriteRecords(&runBuffer[0], chunkSize);
+                copiedBytes += chunkSize;
+            }
+            tempStorage.seek(run.slotID, 0);
         }
-        tempStorage.deallocateSlot(temporaryStorageSlotID);
+        writer.Close();
+        boost::filesystem::rename(temporaryPath, checkpointPath);
+    }
+
+    //Restores a snapshot written by _WriteCheckpoint. Returns false if there is no usable one.
+    bool _ReadCheckpoint(
+        _CheckpointInfo & progress,
+        std::vector<_RemainingNodeData> & remainingNodes,
+        std::vector<float> & nodePriority,
+        std::vector<_PriorityData> & nodeData
+    ) {
+        if(!boost::filesystem::exists(checkpointPath)) {
+            return false;
+        }
+        try {
+            GraphFileReader reader(checkpointPath);
+            const UUID uuid_orig;
+            if(!reader.GetUUID().TestPrepare(uuid_orig)) {
+                SimpleLogger().Write(logWARNING) << checkpointPath << " was written by a different build";
+                return false;
+            }
+            uint64_t numberOfRecords = 0;
+            const _CheckpointInfo * storedProgress = reader.GetRecords<_CheckpointInfo>(GRAPH_FILE_CHECKPOINT_INFO_SECTION, numberOfRecords);
+            if(
+                1 != numberOfRecords ||
+                storedProgress->checksum != progress.checksum ||
+                storedProgress->numberOfNodes != progress.numberOfNodes
+            ) {
+                SimpleLogger().Write(logWARNING) << checkpointPath << " belongs to different input data";
+                return false;
+            }
+
+            const _RemainingNodeData * storedNodes = reader.GetRecords<_RemainingNodeData>(GRAPH_FILE_CONTRACTOR_NODE_SECTION, numberOfRecords);
+            remainingNodes.assign(storedNodes, storedNodes + numberOfRecords);
+            const float * storedPriorities = reader.GetRecords<float>(GRAPH_FILE_CONTRACTOR_PRIORITY_SECTION, numberOfRecords);
+            nodePriority.assign(storedPriorities, storedPriorities + numberOfRecords);
+            const _PriorityData * storedDepths = reader.GetRecords<_PriorityData>(GRAPH_FILE_CONTRACTOR_DEPTH_SECTION, numberOfRecords);
+            nodeData.assign(storedDepths, storedDepths + numberOfRecords);
+            const NodeID * storedNodeMap = reader.GetRecords<NodeID>(GRAPH_FILE_CONTRACTOR_NODE_MAP_SECTION, numberOfRecords);
+            oldNodeIDFromNewNodeIDMap.assign(storedNodeMap, storedNodeMap + numberOfRecords);
+
+            const _ContractorEdge * storedEdges = reader.GetRecords<_ContractorEdge>(GRAPH_FILE_CONTRACTOR_EDGE_SECTION, numberOfRecords);
+            std::vector<_ContractorEdge> edges(storedEdges, storedEdges + numberOfRecords);
+            const NodeID numberOfGraphNodes = oldNodeIDFromNewNodeIDMap.empty() ? progress.numberOfNodes : oldNodeIDFromNewNodeIDMap.size();
+            _graph.reset();
+            _graph = boost::make_shared<_DynamicGraph>( numberOfGraphNodes, edges );
+            std::vector<_ContractorEdge>().swap(edges);
+
+            TemporaryStorage & tempStorage = TemporaryStorage::GetInstance();
+            BOOST_FOREACH(const _SpillRun & run, spillRuns) {
+                tempStorage.deallocateSlot(run.slotID);
+            }
+            spillRuns.clear();
+            uint64_t numberOfRuns = 0;
+            const _SpillRun * storedRuns = reader.GetRecords<_SpillRun>(GRAPH_FILE_CONTRACTOR_RUN_SECTION, numberOfRuns);
+            const char * storedRunData = reader.GetRecords<char>(GRAPH_FILE_CONTRACTOR_RUN_DATA_SECTION, numberOfRecords);
+            for(uint64_t i = 0; i < numberOfRuns; ++i) {
+                _SpillRun run(tempStorage.allocateSlot());
+                run.numberOfEdges = storedRuns[i].numberOfEdges;
+                run.numberOfBytes = storedRuns[i].numberOfBytes;
+                tempStorage.writeToSlot(run.slotID, const_cast<char *>(storedRunData), run.numberOfBytes);
+                storedRunData += run.numberOfBytes;
+                spillRuns.push_back(run);
+            }
+            progress = *storedProgress;
+        } catch(const std::exception & e) {
+            SimpleLogger().Write(logWARNING) << "ignoring checkpoint " << checkpointPath << ": " << e.what();
+            return false;
+        }
+        SimpleLogger().Write() << "resuming contraction with " << progress.numberOfContractedNodes << " of " << progress.numberOfNodes << " nodes contracted";
+        return true;
     }
 
-private:
     inline void _Dijkstra( const int maxDistance, const unsigned numTargets, const int maxNodes, _ThreadData* const data, const NodeID middleNode ){
 
         _Heap& heap = data->heap;
@@ -784,7 +1115,12 @@ private:
 
     boost::shared_ptr<_DynamicGraph> _graph;
     std::vector<_DynamicGraph::InputEdge> contractedEdges;
-    unsigned temporaryStorageSlotID;
+    uint64_t memoryBudget;
+    std::vector<_SpillRun> spillRuns;
+    std::string checkpointPath;
+    unsigned checkpointChecksum;
+    double checkpointInterval;
+    bool resumeFromCheckpoint;
     std::vector<NodeID> oldNodeIDFromNewNodeIDMap;
     XORFastHash fastHash;
 };
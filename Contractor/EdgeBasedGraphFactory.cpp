@@ -26,6 +26,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "EdgeBasedGraphFactory.h"
+#include "../Algorithms/ParallelSCC.h"
+
+static bool CompareViaAndFromNode(const TurnRestriction & a, const TurnRestriction & b) {
+    if(a.viaNode != b.viaNode) {
+        return a.viaNode < b.viaNode;
+    }
+    return a.fromNode < b.fromNode;
+}
 
 EdgeBasedGraphFactory::EdgeBasedGraphFactory(
     int number_of_nodes,
@@ -39,41 +47,70 @@ EdgeBasedGraphFactory::EdgeBasedGraphFactory(
     m_turn_restrictions_count(0),
     m_node_info_list(m_node_info_list)
 {
-	BOOST_FOREACH(const TurnRestriction & restriction, input_restrictions_list) {
-        std::pair<NodeID, NodeID> restriction_source =
-            std::make_pair(restriction.fromNode, restriction.viaNode);
-        unsigned index;
-        RestrictionMap::iterator restriction_iter = m_restriction_map.find(restriction_source);
-        if(restriction_iter == m_restriction_map.end()) {
-            index = m_restriction_bucket_list.size();
-            m_restriction_bucket_list.resize(index+1);
-            m_restriction_map.emplace(restriction_source, index);
-        } else {
-            index = restriction_iter->second;
-            //Map already contains an is_only_*-restriction
-            if(m_restriction_bucket_list.at(index).begin()->second) {
-                continue;
-            } else if(restriction.flags.isOnly) {
-                //We are going to insert an is_only_*-restriction. There can be only one.
-                m_turn_restrictions_count -= m_restriction_bucket_list.at(index).size();
-                m_restriction_bucket_list.at(index).clear();
+    //Of the restrictions of one turn source the first only_-restriction
+    //wins, otherwise all no_-restrictions apply
+    std::stable_sort(
+        input_restrictions_list.begin(),
+        input_restrictions_list.end(),
+        CompareViaAndFromNode
+    );
+    m_restriction_begin.resize(number_of_nodes+1, 0);
+    std::vector<TurnRestriction>::const_iterator group_begin = input_restrictions_list.begin();
+    while(group_begin != input_restrictions_list.end()) {
+        std::vector<TurnRestriction>::const_iterator group_end = group_begin;
+        std::vector<TurnRestriction>::const_iterator only_restriction = input_restrictions_list.end();
+        while(
+            group_end != input_restrictions_list.end() &&
+            group_end->viaNode == group_begin->viaNode &&
+            group_end->fromNode == group_begin->fromNode
+        ) {
+            if(group_end->flags.isOnly && input_restrictions_list.end() == only_restriction) {
+                only_restriction = group_end;
             }
+            ++group_end;
         }
-        ++m_turn_restrictions_count;
-        m_restriction_bucket_list.at(index).push_back(
-            std::make_pair( restriction.toNode, restriction.flags.isOnly)
-        );
+        //the loader drops unmapped restrictions, this guards against any other caller
+        if(
+            group_begin->viaNode < (unsigned)number_of_nodes &&
+            group_begin->fromNode < (unsigned)number_of_nodes
+        ) {
+            std::vector<TurnRestriction>::const_iterator restriction = group_begin;
+            std::vector<TurnRestriction>::const_iterator restrictions_end = group_end;
+            if(input_restrictions_list.end() != only_restriction) {
+                restriction = only_restriction;
+                restrictions_end = only_restriction+1;
+            }
+            for(; restriction != restrictions_end; ++restriction) {
+                m_restriction_targets.push_back(
+                    RestrictionTarget(
+                        restriction->fromNode,
+                        restriction->toNode,
+                        restriction->flags.isOnly
+                    )
+                );
+                ++m_restriction_begin[restriction->viaNode+1];
+            }
+        }
+        group_begin = group_end;
+    }
+    for(int node = 0; node < number_of_nodes; ++node) {
+        m_restriction_begin[node+1] += m_restriction_begin[node];
     }
+    m_turn_restrictions_count = m_restriction_targets.size();
 
-	m_barrier_nodes.insert(
-        barrier_node_list.begin(),
-        barrier_node_list.end()
-    );
+    m_barrier_nodes.resize(number_of_nodes, false);
+    BOOST_FOREACH(const NodeID node, barrier_node_list) {
+        if(node < (unsigned)number_of_nodes) {
+            m_barrier_nodes[node] = true;
+        }
+    }
 
-    m_traffic_lights.insert(
-        traffic_light_node_list.begin(),
-        traffic_light_node_list.end()
-    );
+    m_traffic_lights.resize(number_of_nodes, false);
+    BOOST_FOREACH(const NodeID node, traffic_light_node_list) {
+        if(node < (unsigned)number_of_nodes) {
+            m_traffic_lights[node] = true;
+        }
+    }
 
     DeallocatingVector< NodeBasedEdge > edges_list;
     NodeBasedEdge edge;
@@ -138,43 +175,40 @@ void EdgeBasedGraphFactory::GetEdgeBasedNodes( std::vector<EdgeBasedNode> & node
     nodes.swap(m_edge_based_node_list);
 }
 
-NodeID EdgeBasedGraphFactory::CheckForEmanatingIsOnlyTurn(
+EdgeBasedGraphFactory::RestrictionRange EdgeBasedGraphFactory::GetRestrictions(
     const NodeID u,
     const NodeID v
 ) const {
-    const std::pair < NodeID, NodeID > restriction_source = std::make_pair(u, v);
-    RestrictionMap::const_iterator restriction_iter = m_restriction_map.find(restriction_source);
-    if (restriction_iter != m_restriction_map.end()) {
-        const unsigned index = restriction_iter->second;
-        BOOST_FOREACH(
-            const RestrictionSource & restriction_target,
-            m_restriction_bucket_list.at(index)
-        ) {
-            if(restriction_target.second) {
-                return restriction_target.first;
-            }
-        }
+    const std::vector<RestrictionTarget>::const_iterator restrictions_begin =
+        m_restriction_targets.begin();
+    return std::equal_range(
+        restrictions_begin + m_restriction_begin[v],
+        restrictions_begin + m_restriction_begin[v+1],
+        RestrictionTarget(u, UINT_MAX, false)
+    );
+}
+
+NodeID EdgeBasedGraphFactory::CheckForEmanatingIsOnlyTurn(
+    const RestrictionRange & restrictions
+) const {
+    //an only_-restriction is the single restriction of its turn source
+    if(restrictions.first != restrictions.second && restrictions.first->is_only) {
+        return restrictions.first->to_node;
     }
     return UINT_MAX;
 }
 
 bool EdgeBasedGraphFactory::CheckIfTurnIsRestricted(
-    const NodeID u,
-    const NodeID v,
+    const RestrictionRange & restrictions,
     const NodeID w
 ) const {
-    //only add an edge if turn is not a U-turn except it is the end of dead-end street.
-    const std::pair < NodeID, NodeID > restriction_source = std::make_pair(u, v);
-    RestrictionMap::const_iterator restriction_iter = m_restriction_map.find(restriction_source);
-    if (restriction_iter != m_restriction_map.end()) {
-        const unsigned index = restriction_iter->second;
-        BOOST_FOREACH(
-            const RestrictionTarget & restriction_target,
-            m_restriction_bucket_list.at(index)
-        ) {
-            if(w == restriction_target.first) {
-                return true;
-            }
+    for(
+        std::vector<RestrictionTarget>::const_iterator restriction = restrictions.first;
+        restriction != restrictions.second;
+        ++restriction
+    ) {
+        if(w == restriction->to_node) {
+            return true;
         }
     }
     return false;
@@ -201,8 +235,12 @@ void EdgeBasedGraphFactory::InsertEdgeBasedNode(
 
 void EdgeBasedGraphFactory::Run(
     const char * original_edge_data_filename,
-    lua_State *lua_state
+    const std::vector<lua_State *> & lua_state_list
 ) {
+    BOOST_ASSERT_MSG(
+        static_cast<int>(lua_state_list.size()) >= omp_get_max_threads(),
+        "not enough lua states for all threads"
+    );
     SimpleLogger().Write() << "Identifying components of the road network";
 
     Percent p(m_node_based_graph->GetNumberOfNodes());
@@ -221,87 +259,52 @@ void EdgeBasedGraphFactory::Run(
         sizeof(unsigned)
     );
 
-    unsigned current_component = 0, current_component_size = 0;
-    //Run a BFS on the undirected graph and identify small components
-    std::queue<std::pair<NodeID, NodeID> > bfs_queue;
+    double phase_start = get_timestamp();
     std::vector<unsigned> component_index_list(
-        m_node_based_graph->GetNumberOfNodes(),
-        UINT_MAX
+        m_node_based_graph->GetNumberOfNodes()
     );
-
     std::vector<NodeID> component_size_list;
-    //put unexplorered node with parent pointer into queue
-    for(
-        NodeID node = 0,
-            last_node = m_node_based_graph->GetNumberOfNodes();
-        node < last_node;
-        ++node
-    ) {
-        if(UINT_MAX == component_index_list[node]) {
-            bfs_queue.push(std::make_pair(node, node));
-            //mark node as read
-            component_index_list[node] = current_component;
-            p.printIncrement();
-            while(!bfs_queue.empty()) {
-                //fetch element from BFS queue
-                std::pair<NodeID, NodeID> current_queue_item = bfs_queue.front();
-                bfs_queue.pop();
-                // SimpleLogger().Write() << "sizeof queue: " << bfs_queue.size() <<
-                //  ", current_component_sizes: " <<  current_component_size <<
-                //", settled nodes: " << settledNodes++ << ", max: " << endNodes;
-                const NodeID v = current_queue_item.first;  //current node
-                const NodeID u = current_queue_item.second; //parent
-                //increment size counter of current component
-                ++current_component_size;
-                const bool is_barrier_node = (m_barrier_nodes.find(v) != m_barrier_nodes.end());
-                if(!is_barrier_node) {
-                    const NodeID to_node_of_only_restriction = CheckForEmanatingIsOnlyTurn(u, v);
-
-                    //relaxieren edge outgoing edge like below where edge-expanded graph
-                    for(
-                        EdgeIterator e2 = m_node_based_graph->BeginEdges(v);
-                        e2 < m_node_based_graph->EndEdges(v);
-                        ++e2
-                    ) {
-                        NodeIterator w = m_node_based_graph->GetTarget(e2);
-
-                        if(
-                            to_node_of_only_restriction != UINT_MAX &&
-                            w != to_node_of_only_restriction
-                        ) {
-                            //We are at an only_-restriction but not at the right turn.
-                            continue;
-                        }
-                        if( u != w ) {
-                            //only add an edge if turn is not a U-turn except
-                            //when it is at the end of a dead-end street.
-                            if (!CheckIfTurnIsRestricted(u, v, w) ) {
-                                //only add an edge if turn is not prohibited
-                                if(UINT_MAX == component_index_list[w]) {
-                                    //insert next (node, parent) only if w has
-                                    //not yet been explored
-                                    //mark node as read
-                                    component_index_list[w] = current_component;
-                                    bfs_queue.push(std::make_pair(w,v));
-                                    p.printIncrement();
-                                }
-                            }
-                        }
-                    }
+    {
+        //Barrier nodes may be entered but not left, so they do not connect
+        //the roads that meet at them
+        ParallelSCC scc(*m_node_based_graph, m_barrier_nodes);
+        scc.Run();
+        component_size_list.resize(scc.GetNumberOfComponents());
+        for(unsigned i = 0; i < component_size_list.size(); ++i) {
+            component_size_list[i] = scc.GetComponentSize(i);
+        }
+        const int number_of_node_based_nodes = m_node_based_graph->GetNumberOfNodes();
+#pragma omp parallel for schedule ( guided )
+        for(int node = 0; node < number_of_node_based_nodes; ++node) {
+            component_index_list[node] = scc.GetComponentID(node);
+            if(!m_barrier_nodes[node]) {
+                continue;
+            }
+            //a barrier node belongs to the largest component next to it
+            for(
+                EdgeIterator e = m_node_based_graph->BeginEdges(node);
+                e < m_node_based_graph->EndEdges(node);
+                ++e
+            ) {
+                const unsigned component = scc.GetComponentID(
+                    m_node_based_graph->GetTarget(e)
+                );
+                if(
+                    component_size_list[component] >
+                    component_size_list[component_index_list[node]]
+                ) {
+                    component_index_list[node] = component;
                 }
             }
-            //push size into vector
-            component_size_list.push_back(current_component_size);
-            //reset counters;
-            current_component_size = 0;
-            ++current_component;
         }
     }
     SimpleLogger().Write() <<
         "identified: " << component_size_list.size() << " many components";
+    const double component_search_duration = get_timestamp() - phase_start;
     SimpleLogger().Write() <<
         "generating edge-expanded nodes";
 
+    phase_start = get_timestamp();
     p.reinit(m_node_based_graph->GetNumberOfNodes());
     //loop over all edges and generate new set of nodes.
     for(
@@ -323,8 +326,8 @@ void EdgeBasedGraphFactory::Run(
                 BOOST_ASSERT_MSG(e1 != UINT_MAX, "edge id invalid");
                 BOOST_ASSERT_MSG(u != UINT_MAX,  "souce node invalid");
                 BOOST_ASSERT_MSG(v != UINT_MAX,  "target node invalid");
-            //Note: edges that end on barrier nodes or on a turn restriction
-            //may actually be in two distinct components. We choose the smallest
+            //Note: edges that end on barrier nodes may actually be in two
+            //distinct components. We choose the smallest
                 const unsigned size_of_component = std::min(
                     component_size_list[component_index_list[u]],
                     component_size_list[component_index_list[v]]
@@ -338,6 +341,7 @@ void EdgeBasedGraphFactory::Run(
     SimpleLogger().Write()
         << "Generated " << m_edge_based_node_list.size() << " nodes in " <<
         "edge-expanded graph";
+    const double node_insertion_duration = get_timestamp() - phase_start;
     SimpleLogger().Write() <<
         "generating edge-expanded edges";
 
@@ -351,29 +355,110 @@ void EdgeBasedGraphFactory::Run(
         0 == component_index_list.capacity(),
         "component index vector not deallocated"
     );
-    std::vector<OriginalEdgeData> original_edge_data_vector;
-    original_edge_data_vector.reserve(10000);
+    //Nodes are expanded in batches of fixed-size chunks. Each chunk fills its
+    //own buffer, and the buffers are merged in chunk order, so the output
+    //does not depend on the number of threads.
+    phase_start = get_timestamp();
+    const NodeID number_of_nodes = m_node_based_graph->GetNumberOfNodes();
+    const NodeID chunk_size = 4096;
+    const int chunks_per_batch = 4*omp_get_max_threads();
+    std::vector<TurnExpansionBuffer> buffer_list(chunks_per_batch);
+    p.reinit(number_of_nodes);
+    for(
+        NodeID batch_begin = 0;
+        batch_begin < number_of_nodes;
+        batch_begin += chunks_per_batch*chunk_size
+    ) {
+#pragma omp parallel for schedule ( dynamic )
+        for(int i = 0; i < chunks_per_batch; ++i) {
+            const NodeID first_node = std::min(batch_begin + i*chunk_size, number_of_nodes);
+            const NodeID last_node = std::min(first_node + chunk_size, number_of_nodes);
+            ExpandTurns(
+                first_node,
+                last_node,
+                lua_state_list[omp_get_thread_num()],
+                buffer_list[i]
+            );
+        }
 
+        BOOST_FOREACH(TurnExpansionBuffer & buffer, buffer_list) {
+            BOOST_FOREACH(const EdgeBasedEdge & edge, buffer.edge_based_edge_list) {
+                m_edge_based_edge_list.push_back(
+                    EdgeBasedEdge(
+                        edge.source(),
+                        edge.target(),
+                        m_edge_based_edge_list.size(),
+                        edge.weight(),
+                        edge.isForward(),
+                        edge.isBackward()
+                    )
+                );
+            }
+            if(!buffer.original_edge_data_list.empty()) {
+                edge_data_file.write(
+                    (char*)&(buffer.original_edge_data_list[0]),
+                    buffer.original_edge_data_list.size()*sizeof(OriginalEdgeData)
+                );
+            }
+            original_edges_counter += buffer.original_edge_data_list.size();
+            node_based_edge_counter += buffer.node_based_edge_counter;
+            skipped_turns_counter += buffer.skipped_turns_counter;
+            buffer.edge_based_edge_list.clear();
+            buffer.original_edge_data_list.clear();
+            buffer.node_based_edge_counter = 0;
+            buffer.skipped_turns_counter = 0;
+        }
+        p.printStatus(
+            std::min(batch_begin + chunks_per_batch*chunk_size, number_of_nodes) - 1
+        );
+    }
+    edge_data_file.seekp(std::ios::beg);
+    edge_data_file.write(
+        (char*)&original_edges_counter,
+        sizeof(unsigned)
+    );
+    edge_data_file.close();
+    const double expansion_duration = get_timestamp() - phase_start;
+
+    SimpleLogger().Write() <<
+        "Generated " << m_edge_based_node_list.size() << " edge based nodes";
+    SimpleLogger().Write() <<
+        "Node-based graph contains " << node_based_edge_counter << " edges";
+    SimpleLogger().Write() <<
+        "Edge-expanded graph ...";
+    SimpleLogger().Write() <<
+        "  contains " << m_edge_based_edge_list.size() << " edges";
+    SimpleLogger().Write() <<
+        "  skips "  << skipped_turns_counter << " turns, "
+        "defined by " << m_turn_restrictions_count << " restrictions";
+    SimpleLogger().Write() <<
+        "Timing: components " << component_search_duration << " sec, " <<
+        "node insertion " << node_insertion_duration << " sec, " <<
+        "turn expansion " << expansion_duration << " sec using " <<
+        omp_get_max_threads() << " threads";
+}
+
+void EdgeBasedGraphFactory::ExpandTurns(
+    const NodeID first_node,
+    const NodeID last_node,
+    lua_State * lua_state,
+    TurnExpansionBuffer & buffer
+) const {
     //Loop over all turns and generate new set of edges.
     //Three nested loop look super-linear, but we are dealing with a (kind of)
     //linear number of turns only.
-    p.reinit(m_node_based_graph->GetNumberOfNodes());
-    for(
-        NodeIterator u = 0,
-            last_node = m_node_based_graph->GetNumberOfNodes();
-        u < last_node;
-        ++u
-    ) {
+    for(NodeIterator u = first_node; u < last_node; ++u) {
         for(
             EdgeIterator e1 = m_node_based_graph->BeginEdges(u),
                 last_edge_u = m_node_based_graph->EndEdges(u);
             e1 < last_edge_u;
             ++e1
         ) {
-            ++node_based_edge_counter;
+            ++buffer.node_based_edge_counter;
             NodeIterator v = m_node_based_graph->GetTarget(e1);
-            bool is_barrier_node = (m_barrier_nodes.find(v) != m_barrier_nodes.end());
-            NodeID to_node_of_only_restriction = CheckForEmanatingIsOnlyTurn(u, v);
+            const bool is_barrier_node = m_barrier_nodes[v];
+            const RestrictionRange restrictions = GetRestrictions(u, v);
+            const NodeID to_node_of_only_restriction = CheckForEmanatingIsOnlyTurn(restrictions);
             for(
                 EdgeIterator e2 = m_node_based_graph->BeginEdges(v),
                     last_edge_v = m_node_based_graph->EndEdges(v);
@@ -386,7 +471,7 @@ void EdgeBasedGraphFactory::Run(
                     w != to_node_of_only_restriction
                 ) {
                     //We are at an only_-restriction but not at the right turn.
-                    ++skipped_turns_counter;
+                    ++buffer.skipped_turns_counter;
                     continue;
                 }
 
@@ -398,7 +483,7 @@ void EdgeBasedGraphFactory::Run(
                     //only add an edge if turn is not a U-turn except when it is
                     //at the end of a dead-end street
                     if (
-                        !CheckIfTurnIsRestricted(u, v, w) ||
+                        !CheckIfTurnIsRestricted(restrictions, w) ||
                         (to_node_of_only_restriction != UINT_MAX && w == to_node_of_only_restriction)
                     ) { //only add an edge if turn is not prohibited
                         const EdgeData edge_data1 = m_node_based_graph->GetEdgeData(e1);
@@ -411,7 +496,7 @@ void EdgeBasedGraphFactory::Run(
                         }
 
                         unsigned distance = edge_data1.distance;
-                        if(m_traffic_lights.find(v) != m_traffic_lights.end()) {
+                        if(m_traffic_lights[v]) {
                             distance += speed_profile.trafficSignalPenalty;
                         }
                         const unsigned penalty =
@@ -423,63 +508,32 @@ void EdgeBasedGraphFactory::Run(
                         distance += penalty;
 
                         assert(edge_data1.edgeBasedNodeID != edge_data2.edgeBasedNodeID);
-                        original_edge_data_vector.push_back(
+                        buffer.original_edge_data_list.push_back(
                             OriginalEdgeData(
                                 v,
                                 edge_data2.nameID,
                                 turnInstruction
                             )
                         );
-                        ++original_edges_counter;
-
-                        if(original_edge_data_vector.size() > 100000) {
-                            edge_data_file.write(
-                                (char*)&(original_edge_data_vector[0]),
-                                original_edge_data_vector.size()*sizeof(OriginalEdgeData)
-                            );
-                            original_edge_data_vector.clear();
-                        }
 
-                        m_edge_based_edge_list.push_back(
+                        //the edge id is assigned when the buffer is merged
+                        buffer.edge_based_edge_list.push_back(
                             EdgeBasedEdge(
                                 edge_data1.edgeBasedNodeID,
                                 edge_data2.edgeBasedNodeID,
-                                m_edge_based_edge_list.size(),
+                                UINT_MAX,
                                 distance,
                                 true,
                                 false
                             )
                         );
                     } else {
-                        ++skipped_turns_counter;
+                        ++buffer.skipped_turns_counter;
                     }
                 }
             }
         }
-        p.printIncrement();
     }
-    edge_data_file.write(
-        (char*)&(original_edge_data_vector[0]),
-        original_edge_data_vector.size()*sizeof(OriginalEdgeData)
-    );
-    edge_data_file.seekp(std::ios::beg);
-    edge_data_file.write(
-        (char*)&original_edges_counter,
-        sizeof(unsigned)
-    );
-    edge_data_file.close();
-
-    SimpleLogger().Write() <<
-        "Generated " << m_edge_based_node_list.size() << " edge based nodes";
-    SimpleLogger().Write() <<
-        "Node-based graph contains " << node_based_edge_counter << " edges";
-    SimpleLogger().Write() <<
-        "Edge-expanded graph ...";
-    SimpleLogger().Write() <<
-        "  contains " << m_edge_based_edge_list.size() << " edges";
-    SimpleLogger().Write() <<
-        "  skips "  << skipped_turns_counter << " turns, "
-        "defined by " << m_turn_restrictions_count << " restrictions";
 }
 
 int EdgeBasedGraphFactory::GetTurnPenalty(
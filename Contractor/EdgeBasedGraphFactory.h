@@ -40,18 +40,17 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../DataStructures/Percent.h"
 #include "../DataStructures/TurnInstructions.h"
 #include "../Util/LuaUtil.h"
+#include "../Util/OpenMPWrapper.h"
 #include "../Util/SimpleLogger.h"
+#include "../Util/TimingUtil.h"
 
 #include <boost/foreach.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
-#include <boost/unordered_map.hpp>
-#include <boost/unordered_set.hpp>
 
 #include <algorithm>
 #include <fstream>
-#include <queue>
 #include <vector>
 
 class EdgeBasedGraphFactory : boost::noncopyable {
@@ -123,7 +122,11 @@ public:
         SpeedProfileProperties speed_profile
     );
 
-    void Run(const char * originalEdgeDataFilename, lua_State *myLuaState);
+    //expects one lua state per OpenMP thread
+    void Run(
+        const char * originalEdgeDataFilename,
+        const std::vector<lua_State *> & lua_state_list
+    );
     void GetEdgeBasedEdges( DeallocatingVector< EdgeBasedEdge >& edges );
     void GetEdgeBasedNodes( std::vector< EdgeBasedNode> & nodes);
     void GetOriginalEdgeData( std::vector<OriginalEdgeData> & originalEdgeData);
@@ -165,6 +168,19 @@ private:
         TurnInstruction turnInstruction;
     };
 
+    //turns expanded from a contiguous range of node-based nodes
+    struct TurnExpansionBuffer {
+        TurnExpansionBuffer() :
+            node_based_edge_counter(0),
+            skipped_turns_counter(0)
+        { }
+
+        std::vector<EdgeBasedEdge>    edge_based_edge_list;
+        std::vector<OriginalEdgeData> original_edge_data_list;
+        unsigned                      node_based_edge_counter;
+        unsigned                      skipped_turns_counter;
+    };
+
     unsigned m_turn_restrictions_count;
 
     typedef DynamicGraph<NodeBasedEdgeData>     NodeBasedDynamicGraph;
@@ -172,34 +188,56 @@ private:
     typedef NodeBasedDynamicGraph::NodeIterator NodeIterator;
     typedef NodeBasedDynamicGraph::EdgeIterator EdgeIterator;
     typedef NodeBasedDynamicGraph::EdgeData     EdgeData;
-    typedef std::pair<NodeID, NodeID>           RestrictionSource;
-    typedef std::pair<NodeID, bool>             RestrictionTarget;
-    typedef std::vector<RestrictionTarget>      EmanatingRestrictionsVector;
-    typedef boost::unordered_map<RestrictionSource, unsigned > RestrictionMap;
+
+    //a restricted turn from from_node over the via node it is stored at
+    struct RestrictionTarget {
+        RestrictionTarget(const NodeID from_node, const NodeID to_node, const bool is_only) :
+            from_node(from_node), to_node(to_node), is_only(is_only) { }
+        bool operator<(const RestrictionTarget & other) const {
+            return from_node < other.from_node;
+        }
+        NodeID from_node;
+        NodeID to_node;
+        bool is_only;
+    };
+    //the restrictions of the turns from one node over another
+    typedef std::pair<
+        std::vector<RestrictionTarget>::const_iterator,
+        std::vector<RestrictionTarget>::const_iterator
+    > RestrictionRange;
 
     std::vector<NodeInfo>                       m_node_info_list;
-    std::vector<EmanatingRestrictionsVector>    m_restriction_bucket_list;
+    //restrictions by via node, sorted by from node
+    std::vector<unsigned>                       m_restriction_begin;
+    std::vector<RestrictionTarget>              m_restriction_targets;
     std::vector<EdgeBasedNode>                  m_edge_based_node_list;
     DeallocatingVector<EdgeBasedEdge>           m_edge_based_edge_list;
 
     boost::shared_ptr<NodeBasedDynamicGraph>    m_node_based_graph;
-    boost::unordered_set<NodeID>                m_barrier_nodes;
-    boost::unordered_set<NodeID>                m_traffic_lights;
-
-    RestrictionMap                              m_restriction_map;
+    std::vector<bool>                           m_barrier_nodes;
+    std::vector<bool>                           m_traffic_lights;
 
-
-    NodeID CheckForEmanatingIsOnlyTurn(
+    RestrictionRange GetRestrictions(
         const NodeID u,
         const NodeID v
     ) const;
 
+    NodeID CheckForEmanatingIsOnlyTurn(
+        const RestrictionRange & restrictions
+    ) const;
+
     bool CheckIfTurnIsRestricted(
-        const NodeID u,
-        const NodeID v,
+        const RestrictionRange & restrictions,
         const NodeID w
     ) const;
 
+    void ExpandTurns(
+        const NodeID first_node,
+        const NodeID last_node,
+        lua_State * lua_state,
+        TurnExpansionBuffer & buffer
+    ) const;
+
     void InsertEdgeBasedNode(
             NodeBasedDynamicGraph::EdgeIterator e1,
             NodeBasedDynamicGraph::NodeIterator u,
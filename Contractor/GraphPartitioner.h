@@ -0,0 +1,411 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef GRAPH_PARTITIONER_H_
+#define GRAPH_PARTITIONER_H_
+
+#include "EdgeBasedGraphFactory.h"
+#include "../DataStructures/DeallocatingVector.h"
+#include "../DataStructures/ImportEdge.h"
+#include "../DataStructures/QueryEdge.h"
+#include "../DataStructures/StaticGraph.h"
+#include "../Util/OpenMPWrapper.h"
+#include "../Util/SimpleLogger.h"
+#include "../Util/TimingUtil.h"
+#include "../typedefs.h"
+
+#include <boost/assert.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/foreach.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <climits>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+//largest number of nodes in a cell, from the lowest level upwards
+static const unsigned MLD_NUMBER_OF_LEVELS = 4;
+static const unsigned MLD_CELL_SIZES[MLD_NUMBER_OF_LEVELS] = { 1 << 7, 1 << 12, 1 << 16, 1 << 21 };
+//share of the nodes of a cell that become sources and sinks of a cut
+static const double MLD_INERTIAL_FLOW_BALANCE = 0.25;
+
+// Partitions the edge-based graph into nested cells for multi-level
+// routing. A cell that is too large for its level is cut in two by
+// inertial flow: its nodes are ordered along a few directions by their
+// coordinates, the first and the last quarter become sources and sinks,
+// and a minimum cut between them is found as a maximum flow. The direction
+// with the smallest cut wins. The cells of a level are cut further until
+// they fit the level below, so the cells of all levels nest.
+class GraphPartitioner : boost::noncopyable {
+public:
+    typedef StaticGraph<QueryEdge::EdgeData>::InputEdge BaseEdge;
+
+    GraphPartitioner(
+        const unsigned number_of_nodes,
+        const DeallocatingVector<EdgeBasedEdge> & edge_list,
+        const std::vector<EdgeBasedGraphFactory::EdgeBasedNode> & node_list
+    ) :
+        number_of_nodes(number_of_nodes),
+        edge_list(edge_list),
+        latitudes(number_of_nodes, INT_MAX),
+        longitudes(number_of_nodes, INT_MAX),
+        cell_labels(number_of_nodes, UINT_MAX),
+        local_indices(number_of_nodes, UINT_MAX)
+    {
+        //the cuts ignore directions and weights
+        std::vector<std::pair<NodeID, NodeID> > neighbors;
+        neighbors.reserve(2*edge_list.size());
+        for(unsigned i = 0; i < edge_list.size(); ++i) {
+            const EdgeBasedEdge & edge = edge_list[i];
+            if(edge.source() != edge.target()) {
+                neighbors.push_back(std::make_pair(edge.source(), edge.target()));
+                neighbors.push_back(std::make_pair(edge.target(), edge.source()));
+            }
+        }
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+        adjacency_begin.resize(number_of_nodes+1, 0);
+        adjacency.resize(neighbors.size());
+        for(unsigned i = 0; i < neighbors.size(); ++i) {
+            ++adjacency_begin[neighbors[i].first+1];
+            adjacency[i] = neighbors[i].second;
+        }
+        for(unsigned node = 0; node < number_of_nodes; ++node) {
+            adjacency_begin[node+1] += adjacency_begin[node];
+        }
+
+        BOOST_FOREACH(const EdgeBasedGraphFactory::EdgeBasedNode & node, node_list) {
+            if(node.id < number_of_nodes) {
+                const FixedPointCoordinate centroid = node.Centroid();
+                latitudes[node.id] = centroid.lat;
+                longitudes[node.id] = centroid.lon;
+            }
+        }
+        //nodes that are not in the node list sit next to a neighbor
+        for(unsigned node = 0; node < number_of_nodes; ++node) {
+            if(INT_MAX != latitudes[node]) {
+                continue;
+            }
+            latitudes[node] = longitudes[node] = 0;
+            for(unsigned i = adjacency_begin[node]; i < adjacency_begin[node+1]; ++i) {
+                if(INT_MAX != latitudes[adjacency[i]]) {
+                    latitudes[node] = latitudes[adjacency[i]];
+                    longitudes[node] = longitudes[adjacency[i]];
+                    break;
+                }
+            }
+        }
+    }
+
+    void Run() {
+        const double start = get_timestamp();
+        number_of_levels = 1;
+        while(number_of_levels < MLD_NUMBER_OF_LEVELS && MLD_CELL_SIZES[number_of_levels] < number_of_nodes) {
+            ++number_of_levels;
+        }
+        cell_ids.resize(number_of_levels, std::vector<unsigned>(number_of_nodes));
+
+        std::vector<std::vector<NodeID> > cells(1, std::vector<NodeID>(number_of_nodes));
+        for(unsigned node = 0; node < number_of_nodes; ++node) {
+            cells[0][node] = node;
+        }
+        unsigned next_label = 0;
+        for(unsigned level = number_of_levels; level > 0; --level) {
+            const unsigned maximum_cell_size = MLD_CELL_SIZES[level-1];
+            while(true) {
+                std::vector<unsigned> oversized_cells;
+                for(unsigned cell = 0; cell < cells.size(); ++cell) {
+                    if(maximum_cell_size < cells[cell].size()) {
+                        oversized_cells.push_back(cell);
+                    }
+                }
+                if(oversized_cells.empty()) {
+                    break;
+                }
+                //labels are never reused, so a cell never mistakes the
+                //nodes of another one for its own
+                for(unsigned i = 0; i < oversized_cells.size(); ++i) {
+                    BOOST_FOREACH(const NodeID node, cells[oversized_cells[i]]) {
+                        cell_labels[node] = next_label + i;
+                    }
+                }
+                std::vector<std::vector<NodeID> > second_halves(oversized_cells.size());
+#pragma omp parallel for schedule ( dynamic )
+                for(int i = 0; i < (int)oversized_cells.size(); ++i) {
+                    std::vector<NodeID> first_half;
+                    Bisect(next_label + i, cells[oversized_cells[i]], first_half, second_halves[i]);
+                    cells[oversized_cells[i]].swap(first_half);
+                }
+                next_label += oversized_cells.size();
+                for(unsigned i = 0; i < second_halves.size(); ++i) {
+                    cells.push_back(std::vector<NodeID>());
+                    cells.back().swap(second_halves[i]);
+                }
+            }
+            for(unsigned cell = 0; cell < cells.size(); ++cell) {
+                BOOST_FOREACH(const NodeID node, cells[cell]) {
+                    cell_ids[level-1][node] = cell;
+                }
+            }
+            SimpleLogger().Write() << "level " << level << ": " << cells.size() <<
+                " cells of at most " << maximum_cell_size << " nodes";
+        }
+        SimpleLogger().Write() << "Partitioning took " << (get_timestamp() - start) << " sec";
+    }
+
+    // Writes the cells of all levels and the uncontracted graph, each edge
+    // stored at both of its nodes like in the contracted one.
+    void Serialize(const std::string & path, const unsigned check_sum) const {
+        std::vector<BaseEdge> base_edges;
+        base_edges.reserve(2*edge_list.size());
+        for(unsigned i = 0; i < edge_list.size(); ++i) {
+            const EdgeBasedEdge & edge = edge_list[i];
+            if(edge.source() == edge.target()) {
+                continue;
+            }
+            BaseEdge base_edge;
+            base_edge.source = edge.source();
+            base_edge.target = edge.target();
+            base_edge.data.id = edge.id();
+            base_edge.data.shortcut = false;
+            base_edge.data.distance = std::max((int)edge.weight(), 1);
+            base_edge.data.forward = edge.isForward();
+            base_edge.data.backward = edge.isBackward();
+            base_edges.push_back(base_edge);
+            std::swap(base_edge.source, base_edge.target);
+            base_edge.data.forward = edge.isBackward();
+            base_edge.data.backward = edge.isForward();
+            base_edges.push_back(base_edge);
+        }
+        std::sort(base_edges.begin(), base_edges.end());
+
+        std::ofstream mld_output_stream(path.c_str(), std::ios::binary);
+        mld_output_stream.write((char*)&check_sum, sizeof(unsigned));
+        mld_output_stream.write((char*)&number_of_nodes, sizeof(unsigned));
+        mld_output_stream.write((char*)&number_of_levels, sizeof(unsigned));
+        for(unsigned level = 0; level < number_of_levels; ++level) {
+            mld_output_stream.write((char*)&cell_ids[level][0], number_of_nodes*sizeof(unsigned));
+        }
+        const unsigned number_of_edges = base_edges.size();
+        mld_output_stream.write((char*)&number_of_edges, sizeof(unsigned));
+        mld_output_stream.write((char*)&base_edges[0], number_of_edges*sizeof(BaseEdge));
+        mld_output_stream.close();
+    }
+
+private:
+    // the nodes of a cell, numbered in the order of their ids, with each
+    // undirected edge inside the cell as a pair of opposite arcs
+    struct CellGraph {
+        std::vector<unsigned> arc_begin;
+        std::vector<unsigned> arc_target;
+        std::vector<unsigned> reverse_arc;
+    };
+
+    void Bisect(
+        const unsigned label,
+        std::vector<NodeID> & nodes,
+        std::vector<NodeID> & first_half,
+        std::vector<NodeID> & second_half
+    ) {
+        std::sort(nodes.begin(), nodes.end());
+        const unsigned size = nodes.size();
+        for(unsigned i = 0; i < size; ++i) {
+            local_indices[nodes[i]] = i;
+        }
+        CellGraph cell_graph;
+        cell_graph.arc_begin.resize(size+1, 0);
+        for(unsigned i = 0; i < size; ++i) {
+            cell_graph.arc_begin[i+1] = cell_graph.arc_begin[i];
+            for(unsigned j = adjacency_begin[nodes[i]]; j < adjacency_begin[nodes[i]+1]; ++j) {
+                if(label == cell_labels[adjacency[j]]) {
+                    cell_graph.arc_target.push_back(local_indices[adjacency[j]]);
+                    ++cell_graph.arc_begin[i+1];
+                }
+            }
+        }
+        //adjacency lists are sorted, so the opposite arc is found by bisection
+        cell_graph.reverse_arc.resize(cell_graph.arc_target.size());
+        for(unsigned i = 0; i < size; ++i) {
+            for(unsigned arc = cell_graph.arc_begin[i]; arc < cell_graph.arc_begin[i+1]; ++arc) {
+                const unsigned target = cell_graph.arc_target[arc];
+                cell_graph.reverse_arc[arc] = std::lower_bound(
+                    cell_graph.arc_target.begin() + cell_graph.arc_begin[target],
+                    cell_graph.arc_target.begin() + cell_graph.arc_begin[target+1],
+                    i
+                ) - cell_graph.arc_target.begin();
+            }
+        }
+
+        //horizontal, vertical and both diagonals
+        const int directions[4][2] = { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 1, -1 } };
+        const unsigned number_of_terminals = std::max(1u, (unsigned)(MLD_INERTIAL_FLOW_BALANCE*size));
+        unsigned smallest_cut = UINT_MAX;
+        unsigned best_balance = 0;
+        std::vector<bool> best_side;
+        std::vector<bool> side;
+        std::vector<std::pair<boost::int64_t, unsigned> > order(size);
+        for(unsigned direction = 0; direction < 4; ++direction) {
+            for(unsigned i = 0; i < size; ++i) {
+                order[i].first =
+                    (boost::int64_t)directions[direction][0]*longitudes[nodes[i]] +
+                    (boost::int64_t)directions[direction][1]*latitudes[nodes[i]];
+                order[i].second = i;
+            }
+            std::sort(order.begin(), order.end());
+            const unsigned cut = MinimumCut(cell_graph, order, number_of_terminals, smallest_cut, side);
+            if(UINT_MAX == cut) {
+                continue;
+            }
+            const unsigned first_side_size = std::count(side.begin(), side.end(), true);
+            const unsigned balance = std::min(first_side_size, size - first_side_size);
+            if(cut < smallest_cut || (cut == smallest_cut && balance > best_balance)) {
+                smallest_cut = cut;
+                best_balance = balance;
+                best_side.swap(side);
+            }
+        }
+        BOOST_ASSERT(size == best_side.size());
+        for(unsigned i = 0; i < size; ++i) {
+            (best_side[i] ? first_half : second_half).push_back(nodes[i]);
+        }
+    }
+
+    // Unit capacity maximum flow by Dinic's algorithm from the first to the
+    // last nodes of the order. The first side of the cut are the nodes that
+    // remain reachable from the sources. Gives up with UINT_MAX once the
+    // cut gets larger than the given bound.
+    unsigned MinimumCut(
+        const CellGraph & cell_graph,
+        const std::vector<std::pair<boost::int64_t, unsigned> > & order,
+        const unsigned number_of_terminals,
+        const unsigned bound,
+        std::vector<bool> & side
+    ) const {
+        const unsigned size = order.size();
+        std::vector<unsigned> sources(number_of_terminals);
+        std::vector<bool> is_sink(size, false);
+        for(unsigned i = 0; i < number_of_terminals; ++i) {
+            sources[i] = order[i].second;
+            is_sink[order[size-1-i].second] = true;
+        }
+        std::vector<signed char> flow(cell_graph.arc_target.size(), 0);
+        std::vector<unsigned> distance(size);
+        std::vector<unsigned> queue;
+        std::vector<unsigned> current_arc;
+        std::vector<unsigned> path;
+        unsigned flow_value = 0;
+        while(true) {
+            std::fill(distance.begin(), distance.end(), UINT_MAX);
+            queue.clear();
+            BOOST_FOREACH(const unsigned source, sources) {
+                distance[source] = 0;
+                queue.push_back(source);
+            }
+            bool reached_sink = false;
+            for(unsigned i = 0; i < queue.size(); ++i) {
+                const unsigned node = queue[i];
+                for(unsigned arc = cell_graph.arc_begin[node]; arc < cell_graph.arc_begin[node+1]; ++arc) {
+                    const unsigned target = cell_graph.arc_target[arc];
+                    if(1 > flow[arc] && UINT_MAX == distance[target]) {
+                        distance[target] = distance[node] + 1;
+                        reached_sink |= is_sink[target];
+                        queue.push_back(target);
+                    }
+                }
+            }
+            if(!reached_sink) {
+                break;
+            }
+
+            //blocking flow along shortest augmenting paths
+            current_arc.assign(cell_graph.arc_begin.begin(), cell_graph.arc_begin.end()-1);
+            BOOST_FOREACH(const unsigned source, sources) {
+                path.clear();
+                unsigned node = source;
+                while(UINT_MAX != distance[source]) {
+                    if(is_sink[node]) {
+                        BOOST_FOREACH(const unsigned arc, path) {
+                            ++flow[arc];
+                            --flow[cell_graph.reverse_arc[arc]];
+                        }
+                        if(bound < ++flow_value) {
+                            return UINT_MAX;
+                        }
+                        path.clear();
+                        node = source;
+                        continue;
+                    }
+                    unsigned & arc = current_arc[node];
+                    while(arc < cell_graph.arc_begin[node+1] && (
+                        1 <= flow[arc] ||
+                        distance[cell_graph.arc_target[arc]] != distance[node] + 1
+                    )) {
+                        ++arc;
+                    }
+                    if(arc < cell_graph.arc_begin[node+1]) {
+                        path.push_back(arc);
+                        node = cell_graph.arc_target[arc];
+                        continue;
+                    }
+                    //dead end, never enter it again in this phase
+                    distance[node] = UINT_MAX;
+                    if(path.empty()) {
+                        break;
+                    }
+                    path.pop_back();
+                    node = path.empty() ? source : cell_graph.arc_target[path.back()];
+                    ++current_arc[node];
+                }
+            }
+        }
+        side.assign(size, false);
+        for(unsigned i = 0; i < size; ++i) {
+            side[i] = (UINT_MAX != distance[i]);
+        }
+        return flow_value;
+    }
+
+    const unsigned number_of_nodes;
+    const DeallocatingVector<EdgeBasedEdge> & edge_list;
+    unsigned number_of_levels;
+    std::vector<unsigned> adjacency_begin;
+    std::vector<NodeID> adjacency;
+    std::vector<int> latitudes;
+    std::vector<int> longitudes;
+    //cells of each level, the lowest first
+    std::vector<std::vector<unsigned> > cell_ids;
+    //work arrays of Bisect(), each cell only touches its own nodes
+    std::vector<unsigned> cell_labels;
+    std::vector<unsigned> local_indices;
+};
+
+#endif /* GRAPH_PARTITIONER_H_ */
@@ -0,0 +1,241 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef PREPARE_CHECKPOINT_H_
+#define PREPARE_CHECKPOINT_H_
+
+#include "EdgeBasedGraphFactory.h"
+#include "../DataStructures/DeallocatingVector.h"
+#include "../DataStructures/ImportEdge.h"
+#include "../DataStructures/Restriction.h"
+#include "../Util/GraphFileFormat.h"
+#include "../Util/OSRMException.h"
+#include "../Util/SimpleLogger.h"
+#include "../typedefs.h"
+
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// osrm-prepare checkpoints its edge-based graph after expansion, so that a
+// later run with --resume continues with contraction directly. Snapshots
+// of the contractor itself are written by Contractor.
+
+// A resumed run keeps these files of the expansion, so the checkpoint
+// records their checksums.
+static const char * const EXPANSION_OUTPUT_EXTENSIONS[] = { ".edges", ".nodes", ".ramIndex", ".fileIndex" };
+static const unsigned NUMBER_OF_EXPANSION_OUTPUTS = 4;
+
+struct EdgeBasedGraphCheckpointInfo {
+    unsigned input_checksum;
+    unsigned number_of_node_based_nodes;
+    unsigned number_of_edge_based_nodes;
+    unsigned reserved;
+    unsigned output_checksums[NUMBER_OF_EXPANSION_OUTPUTS];
+};
+
+// Fingerprint of everything the edge-based graph is derived from: the
+// section table of the .osrm file (which carries the section CRCs), the
+// turn restrictions and the profile.
+inline unsigned ComputePrepareInputChecksum(
+    const std::string & graph_file_name,
+    std::vector<TurnRestriction> & restrictions,
+    const std::string & profile_file_name
+) {
+    CRC32 crc32;
+    unsigned checksum = 0;
+
+    std::ifstream graph_stream(graph_file_name.c_str(), std::ios::binary);
+    GraphFileHeader header;
+    graph_stream.read((char *)&header, sizeof(GraphFileHeader));
+    if(!graph_stream) {
+        throw OSRMException("cannot read header of .osrm file");
+    }
+    std::vector<char> table(
+        GraphFileTableOffset() + header.number_of_sections*sizeof(GraphFileSection)
+    );
+    graph_stream.seekg(0);
+    graph_stream.read(&table[0], table.size());
+    checksum = crc32(&table[0], table.size());
+
+    if(!restrictions.empty()) {
+        checksum = crc32(
+            (char *)&restrictions[0],
+            restrictions.size()*sizeof(TurnRestriction)
+        );
+    }
+
+    std::ifstream profile_stream(profile_file_name.c_str(), std::ios::binary);
+    std::vector<char> profile(
+        (std::istreambuf_iterator<char>(profile_stream)),
+        std::istreambuf_iterator<char>()
+    );
+    if(!profile.empty()) {
+        checksum = crc32(&profile[0], profile.size());
+    }
+    return checksum;
+}
+
+// Fingerprint of a contraction snapshot: the input and the parameters that
+// change how the contraction proceeds
+inline unsigned ComputeContractionChecksum(
+    const unsigned input_checksum,
+    const unsigned memory_budget
+) {
+    CRC32 crc32;
+    unsigned parameters[2] = { input_checksum, memory_budget };
+    return crc32((char *)parameters, sizeof(parameters));
+}
+
+// Throws if the file cannot be read
+inline unsigned ComputeFileChecksum(const std::string & file_name) {
+    std::ifstream file_stream(file_name.c_str(), std::ios::binary);
+    if(!file_stream) {
+        throw OSRMException(file_name + " cannot be read");
+    }
+    CRC32 crc32;
+    unsigned checksum = 0;
+    std::vector<char> buffer(1 << 20);
+    while(file_stream) {
+        file_stream.read(&buffer[0], buffer.size());
+        if(0 < file_stream.gcount()) {
+            checksum = crc32(&buffer[0], file_stream.gcount());
+        }
+    }
+    return checksum;
+}
+
+inline void ComputeExpansionOutputChecksums(const std::string & base_name, unsigned * checksums) {
+    for(unsigned i = 0; i < NUMBER_OF_EXPANSION_OUTPUTS; ++i) {
+        checksums[i] = ComputeFileChecksum(base_name + EXPANSION_OUTPUT_EXTENSIONS[i]);
+    }
+}
+
+// Written to a temporary name and renamed, so a checkpoint is either complete or absent
+inline void WriteEdgeBasedGraphCheckpoint(
+    const std::string & file_name,
+    const UUID & uuid,
+    const EdgeBasedGraphCheckpointInfo & info,
+    DeallocatingVector<EdgeBasedEdge> & edges,
+    std::vector<EdgeBasedGraphFactory::EdgeBasedNode> & nodes
+) {
+    const std::string temporary_file_name = file_name + ".tmp";
+    GraphFileWriter writer(temporary_file_name, uuid, 3);
+    writer.BeginSection(GRAPH_FILE_CHECKPOINT_INFO_SECTION, sizeof(EdgeBasedGraphCheckpointInfo));
+    writer.WriteRecords((const char *)&info, 1);
+
+    writer.BeginSection(GRAPH_FILE_EDGE_BASED_NODE_SECTION, sizeof(EdgeBasedGraphFactory::EdgeBasedNode));
+    for(std::size_t i = 0; i < nodes.size(); i += (1 << 20)) {
+        writer.WriteRecords(
+            (const char *)&nodes[i],
+            std::min(nodes.size() - i, (std::size_t)1 << 20)
+        );
+    }
+
+    //edges are not stored contiguously, copy them block-wise
+    writer.BeginSection(GRAPH_FILE_EDGE_BASED_EDGE_SECTION, sizeof(EdgeBasedEdge));
+    std::vector<EdgeBasedEdge> buffer;
+    buffer.reserve(1 << 16);
+    for(std::size_t i = 0; i < edges.size(); ++i) {
+        buffer.push_back(edges[i]);
+        if(buffer.size() == buffer.capacity()) {
+            writer.WriteRecords((const char *)&buffer[0], buffer.size());
+            buffer.clear();
+        }
+    }
+    if(!buffer.empty()) {
+        writer.WriteRecords((const char *)&buffer[0], buffer.size());
+    }
+    writer.Close();
+    boost::filesystem::rename(temporary_file_name, file_name);
+}
+
+// Returns false if there is no usable checkpoint for this build and input,
+// or if the outputs of the expansion next to base_name have changed since
+inline bool ReadEdgeBasedGraphCheckpoint(
+    const std::string & file_name,
+    const std::string & base_name,
+    const unsigned input_checksum,
+    EdgeBasedGraphCheckpointInfo & info,
+    DeallocatingVector<EdgeBasedEdge> & edges,
+    std::vector<EdgeBasedGraphFactory::EdgeBasedNode> & nodes
+) {
+    if(!boost::filesystem::exists(file_name)) {
+        return false;
+    }
+    try {
+        GraphFileReader reader(file_name);
+        const UUID uuid_orig;
+        if(!reader.GetUUID().TestPrepare(uuid_orig)) {
+            SimpleLogger().Write(logWARNING) << file_name << " was written by a different build";
+            return false;
+        }
+        boost::uint64_t number_of_records = 0;
+        const EdgeBasedGraphCheckpointInfo * stored_info =
+            reader.GetRecords<EdgeBasedGraphCheckpointInfo>(GRAPH_FILE_CHECKPOINT_INFO_SECTION, number_of_records);
+        if(1 != number_of_records || input_checksum != stored_info->input_checksum) {
+            SimpleLogger().Write(logWARNING) << file_name << " belongs to different input data";
+            return false;
+        }
+        info = *stored_info;
+
+        unsigned output_checksums[NUMBER_OF_EXPANSION_OUTPUTS];
+        ComputeExpansionOutputChecksums(base_name, output_checksums);
+        for(unsigned i = 0; i < NUMBER_OF_EXPANSION_OUTPUTS; ++i) {
+            if(output_checksums[i] != info.output_checksums[i]) {
+                SimpleLogger().Write(logWARNING) << base_name << EXPANSION_OUTPUT_EXTENSIONS[i] <<
+                    " has changed since " << file_name << " was written";
+                return false;
+            }
+        }
+
+        const EdgeBasedGraphFactory::EdgeBasedNode * stored_nodes =
+            reader.GetRecords<EdgeBasedGraphFactory::EdgeBasedNode>(GRAPH_FILE_EDGE_BASED_NODE_SECTION, number_of_records);
+        nodes.assign(stored_nodes, stored_nodes + number_of_records);
+
+        const EdgeBasedEdge * stored_edges =
+            reader.GetRecords<EdgeBasedEdge>(GRAPH_FILE_EDGE_BASED_EDGE_SECTION, number_of_records);
+        edges.clear();
+        for(boost::uint64_t i = 0; i < number_of_records; ++i) {
+            edges.push_back(stored_edges[i]);
+        }
+    } catch(const std::exception & e) {
+        SimpleLogger().Write(logWARNING) << "ignoring checkpoint " << file_name << ": " << e.what();
+        edges.clear();
+        nodes.clear();
+        return false;
+    }
+    return true;
+}
+
+#endif /* PREPARE_CHECKPOINT_H_ */
@@ -108,7 +108,7 @@ private:
         boost::shared_ptr<boost::mutex> readWriteMutex;
         StreamData() :
             writeMode(true),
-            pathToTemporaryFile (boost::filesystem::unique_path(tempDirectory.append(TemporaryFilePattern.begin(), TemporaryFilePattern.end()))),
+            pathToTemporaryFile (boost::filesystem::unique_path(tempDirectory / TemporaryFilePattern)),
             streamToTemporaryFile(new boost::filesystem::fstream(pathToTemporaryFile, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary)),
             readWriteMutex(new boost::mutex)
         {
@@ -0,0 +1,63 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef ALTERNATIVE_ROUTE_PARAMETERS_H_
+#define ALTERNATIVE_ROUTE_PARAMETERS_H_
+
+const double VIAPATH_ALPHA   = 0.10; //local optimality, length of the T-test relative to the shortest path
+const double VIAPATH_EPSILON = 0.10; //alternative at most 10% longer
+const double VIAPATH_GAMMA   = 0.75; //alternative shares at most 75% with the shortest.
+const unsigned VIAPATH_MAXIMUM_NUMBER_OF_ALTERNATIVES = 5;
+
+// Tuning of the via node alternative search, settable per request
+struct AlternativeRouteParameters {
+    AlternativeRouteParameters() :
+        alpha(VIAPATH_ALPHA),
+        epsilon(VIAPATH_EPSILON),
+        gamma(VIAPATH_GAMMA),
+        numberOfCandidates(0),
+        numberOfAlternatives(1),
+        searchTimeBudget(0),
+        qualityThreshold(0.)
+    { }
+
+    double alpha;
+    double epsilon;
+    double gamma;
+    //number of ranked via node candidates that are T-tested, 0 for all
+    unsigned numberOfCandidates;
+    //number of alternatives to return, at most VIAPATH_MAXIMUM_NUMBER_OF_ALTERNATIVES
+    unsigned numberOfAlternatives;
+    //milliseconds after which no further candidates are tested, 0 for no limit
+    unsigned searchTimeBudget;
+    //quality score of an accepted alternative at which the search for
+    //further alternatives stops, 0 to always look for all of them
+    double qualityThreshold;
+};
+
+#endif /* ALTERNATIVE_ROUTE_PARAMETERS_H_ */
@@ -55,6 +55,10 @@ public:
         return positions[node];
     }
 
+    Key Peek( const NodeID node ) const {
+        return positions[node];
+    }
+
     void Clear() {}
 
 private:
@@ -71,6 +75,12 @@ public:
         return nodes[node];
     }
 
+    //unlike operator[] never inserts, unknown nodes map to zero
+    Key Peek( const NodeID node ) const {
+        typename std::map< NodeID, Key >::const_iterator iter = nodes.find(node);
+        return (nodes.end() == iter) ? 0 : iter->second;
+    }
+
     void Clear() {
         nodes.clear();
     }
@@ -93,6 +103,12 @@ public:
     	return nodes[node];
     }
 
+    //unlike operator[] never inserts, unknown nodes map to zero
+    Key Peek( const NodeID node ) const {
+        typename boost::unordered_map< NodeID, Key >::const_iterator iter = nodes.find(node);
+        return (nodes.end() == iter) ? 0 : iter->second;
+    }
+
     void Clear() {
         nodes.clear();
     }
@@ -124,6 +140,8 @@ public:
     void Clear() {
         heap.resize( 1 );
         insertedNodes.clear();
+        numberOfDeletedNodes = 0;
+        peakSize = 0;
         heap[0].weight = std::numeric_limits< Weight >::min();
         nodeIndex.Clear();
     }
@@ -132,12 +150,28 @@ public:
         return static_cast<Key>( heap.size() - 1 );
     }
 
+    //number of nodes inserted since the last Clear()
+    unsigned NumberOfInsertedNodes() const {
+        return insertedNodes.size();
+    }
+
+    //number of nodes removed by DeleteMin() since the last Clear()
+    unsigned NumberOfDeletedNodes() const {
+        return numberOfDeletedNodes;
+    }
+
+    //largest Size() since the last Clear()
+    unsigned PeakSize() const {
+        return peakSize;
+    }
+
     void Insert( NodeID node, Weight weight, const Data &data ) {
         HeapElement element;
         element.index = static_cast<NodeID>(insertedNodes.size());
         element.weight = weight;
         const Key key = static_cast<Key>(heap.size());
         heap.push_back( element );
+        peakSize = std::max( peakSize, static_cast<unsigned>( heap.size() - 1 ) );
         insertedNodes.push_back( HeapNode( node, key, weight, data ) );
         nodeIndex[node] = element.index;
         Upheap( key );
@@ -167,6 +201,22 @@ public:
         return insertedNodes[index].node == node;
     }
 
+    //read-only lookups, several threads may use them on a finished search
+    bool WasInserted( const NodeID node ) const {
+        const Key index = nodeIndex.Peek(node);
+        if ( index >= static_cast<Key> (insertedNodes.size()) )
+            return false;
+        return insertedNodes[index].node == node;
+    }
+
+    const Data& GetData( NodeID node ) const {
+        return insertedNodes[nodeIndex.Peek(node)].data;
+    }
+
+    const Weight& GetKey( NodeID node ) const {
+        return insertedNodes[nodeIndex.Peek(node)].weight;
+    }
+
     NodeID Min() const {
         assert( heap.size() > 1 );
         return insertedNodes[heap[1].index].node;
@@ -180,6 +230,7 @@ public:
         if ( heap.size() > 1 )
             Downheap( 1 );
         insertedNodes[removedIndex].key = 0;
+        ++numberOfDeletedNodes;
         CheckHeap();
         return insertedNodes[removedIndex].node;
     }
@@ -225,6 +276,8 @@ private:
     std::vector< HeapNode > insertedNodes;
     std::vector< HeapElement > heap;
     IndexStorage nodeIndex;
+    unsigned numberOfDeletedNodes;
+    unsigned peakSize;
 
     void Downheap( Key key ) {
         const Key droppingIndex = heap[key].index;
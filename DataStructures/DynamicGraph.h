@@ -109,6 +109,11 @@ class DynamicGraph {
             return m_numEdges;
         }
 
+        //bytes held by node and edge arrays, including unused edge slots
+        uint64_t GetMemoryUsage() const {
+            return m_nodes.capacity()*sizeof(Node) + (uint64_t)m_edges.capacity()*sizeof(Edge);
+        }
+
         uint32_t GetOutDegree( const NodeIterator n ) const {
             return m_nodes[n].edges;
         }
@@ -49,48 +49,49 @@ public:
 		return result;
 	}
 private:
+	//interleaves the bits of a and b, i.e. bit i of a goes to 2i+1, bit i of b to 2i
 	static inline uint64_t BitInterleaving(const uint32_t a, const uint32_t b) {
-		uint64_t result = 0;
-		for(int8_t index = 31; index >= 0; --index){
-			result |= (a >> index) & 1;
-			result <<= 1;
-			result |= (b >> index) & 1;
-			if(0 != index){
-				result <<= 1;
-			}
-		}
+		return (SpreadBits(a) << 1) | SpreadBits(b);
+	}
+
+	//moves bit i of x to bit 2i of the result
+	static inline uint64_t SpreadBits(const uint32_t x) {
+		uint64_t result = x;
+		result = (result | (result << 16)) & 0x0000FFFF0000FFFFULL;
+		result = (result | (result <<  8)) & 0x00FF00FF00FF00FFULL;
+		result = (result | (result <<  4)) & 0x0F0F0F0F0F0F0F0FULL;
+		result = (result | (result <<  2)) & 0x3333333333333333ULL;
+		result = (result | (result <<  1)) & 0x5555555555555555ULL;
 		return result;
 	}
 
+	//Skilling's transform of the axes to the transposed hilbert index.
+	//Written without branches, as the bits tested are effectively random.
 	static inline void TransposeCoordinate( uint32_t * X) {
-		uint32_t M = 1 << (32-1), P, Q, t;
-		int i;
+		uint32_t M = 1 << (32-1), P, Q, t, is_set;
 		// Inverse undo
 		for( Q = M; Q > 1; Q >>= 1 ) {
 			P=Q-1;
-			for( i = 0; i < 2; ++i ) {
-				if( X[i] & Q ) {
-					X[0] ^= P; // invert
-				} else {
-					t = (X[0]^X[i]) & P;
-					X[0] ^= t;
-					X[i] ^= t;
-				}
-			} // exchange
+			// invert
+			X[0] ^= P & (0 - ((X[0] & Q) != 0));
+			is_set = 0 - ((X[1] & Q) != 0);
+			X[0] ^= P & is_set;
+			// exchange
+			t = (X[0]^X[1]) & P & ~is_set;
+			X[0] ^= t;
+			X[1] ^= t;
 		}
 		// Gray encode
-		for( i = 1; i < 2; ++i ) {
-			X[i] ^= X[i-1];
-		}
-		t=0;
-		for( Q = M; Q > 1; Q >>= 1 ) {
-			if( X[2-1] & Q ) {
-				t ^= Q-1;
-			}
-		} //check if this for loop is wrong
-		for( i = 0; i < 2; ++i ) {
-			X[i] ^= t;
-		}
+		X[1] ^= X[0];
+		// bit i of t is the parity of the bits above i in X[1]
+		t = X[1] >> 1;
+		t ^= t >> 1;
+		t ^= t >> 2;
+		t ^= t >> 4;
+		t ^= t >> 8;
+		t ^= t >> 16;
+		X[0] ^= t;
+		X[1] ^= t;
 	}
 };
 
@@ -28,62 +28,86 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef LRUCACHE_H
 #define LRUCACHE_H
 
-#include <list>
 #include <boost/unordered_map.hpp>
 
+#include <cstddef>
+
+#include <list>
+
+// Least recently used cache. Every entry has a cost, by default one, and
+// the least recently used entries are evicted once the sum of costs
+// exceeds the capacity. Not thread-safe, see ShardedLRUCache.
 template<typename KeyT, typename ValueT>
 class LRUCache {
 private:
     struct CacheEntry {
-        CacheEntry(KeyT k, ValueT v) : key(k), value(v) {}
+        CacheEntry(const KeyT & k, const ValueT & v, const std::size_t c) : key(k), value(v), cost(c) {}
         KeyT key;
         ValueT value;
+        std::size_t cost;
     };
-    unsigned capacity;
+    typedef typename std::list<CacheEntry>::iterator EntryIterator;
+    std::size_t capacity;
+    std::size_t total_cost;
     std::list<CacheEntry> itemsInCache;
-    boost::unordered_map<KeyT, typename std::list<CacheEntry>::iterator > positionMap;
+    boost::unordered_map<KeyT, EntryIterator> positionMap;
 public:
-    LRUCache(unsigned c) : capacity(c) {}
+    LRUCache(std::size_t c) : capacity(c), total_cost(0) {}
 
-    bool Holds(KeyT key) {
-        if(positionMap.find(key) != positionMap.end()) {
-            return true;
-        }
-        return false;
+    bool Holds(const KeyT & key) const {
+        return positionMap.find(key) != positionMap.end();
     }
 
-    void Insert(const KeyT key, ValueT &value) {
-        itemsInCache.push_front(CacheEntry(key, value));
+    // returns the number of entries that were evicted to make room
+    unsigned Insert(const KeyT & key, const ValueT & value, const std::size_t cost = 1) {
+        Erase(key);
+        itemsInCache.push_front(CacheEntry(key, value, cost));
         positionMap.insert(std::make_pair(key, itemsInCache.begin()));
-        if(itemsInCache.size() > capacity) {
+        total_cost += cost;
+        unsigned number_of_evicted_entries = 0;
+        while(total_cost > capacity && !itemsInCache.empty()) {
+            total_cost -= itemsInCache.back().cost;
             positionMap.erase(itemsInCache.back().key);
             itemsInCache.pop_back();
+            ++number_of_evicted_entries;
         }
+        return number_of_evicted_entries;
     }
 
-    void Insert(const KeyT key, ValueT value) {
-        itemsInCache.push_front(CacheEntry(key, value));
-        positionMap.insert(std::make_pair(key, itemsInCache.begin()));
-        if(itemsInCache.size() > capacity) {
-            positionMap.erase(itemsInCache.back().key);
-            itemsInCache.pop_back();
+    bool Fetch(const KeyT & key, ValueT & result) {
+        typename boost::unordered_map<KeyT, EntryIterator>::iterator position = positionMap.find(key);
+        if(positionMap.end() == position) {
+            return false;
         }
+        result = position->second->value;
+        //move to front, list iterators stay valid
+        itemsInCache.splice(itemsInCache.begin(), itemsInCache, position->second);
+        return true;
     }
 
-    bool Fetch(const KeyT key, ValueT& result) {
-        if(Holds(key)) {
-            CacheEntry e = *(positionMap.find(key)->second);
-            result = e.value;
-
-            //move to front
-            itemsInCache.splice(positionMap.find(key)->second, itemsInCache, itemsInCache.begin());
-            positionMap.find(key)->second = itemsInCache.begin();
-            return true;
+    bool Erase(const KeyT & key) {
+        typename boost::unordered_map<KeyT, EntryIterator>::iterator position = positionMap.find(key);
+        if(positionMap.end() == position) {
+            return false;
         }
-        return false;
+        total_cost -= position->second->cost;
+        itemsInCache.erase(position->second);
+        positionMap.erase(position);
+        return true;
+    }
+
+    void Clear() {
+        itemsInCache.clear();
+        positionMap.clear();
+        total_cost = 0;
     }
+
     unsigned Size() const {
         return itemsInCache.size();
     }
+
+    std::size_t GetTotalCost() const {
+        return total_cost;
+    }
 };
 #endif //LRUCACHE_H
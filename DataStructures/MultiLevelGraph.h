@@ -0,0 +1,344 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef MULTI_LEVEL_GRAPH_H_
+#define MULTI_LEVEL_GRAPH_H_
+
+#include "BinaryHeap.h"
+#include "QueryEdge.h"
+#include "StaticGraph.h"
+#include "../Util/OpenMPWrapper.h"
+#include "../Util/OSRMException.h"
+#include "../Util/SimpleLogger.h"
+#include "../Util/TimingUtil.h"
+#include "../typedefs.h"
+
+#include <boost/assert.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <climits>
+
+#include <algorithm>
+#include <vector>
+
+// The uncontracted edge-based graph with the nested cells written by
+// osrm-prepare --mld. A node is a boundary node of a level if it has an
+// edge into another cell of that level. The overlay of a level consists of
+// a clique between the boundary nodes of each of its cells, weighted with
+// their shortest distance inside the cell, and of the edges between cells.
+// A search far from its start and target thus skips the inside of cells.
+// The cliques only depend on the edge weights and are customized level by
+// level at load time, which takes a small fraction of a contraction. New
+// weights, e.g. from live traffic, are customized the same way into a
+// metric of their own, so searches on the loaded weights are unaffected.
+class MultiLevelGraph : boost::noncopyable {
+public:
+    typedef StaticGraph<QueryEdge::EdgeData> BaseGraph;
+
+    // weights of the edges of the base graph and the cliques of each level
+    // customized from them
+    struct Metric {
+        std::vector<int> edge_weights;
+        //by level, the clique of a cell starts at its clique_begin
+        std::vector<std::vector<int> > clique_weights;
+    };
+
+    MultiLevelGraph(const boost::filesystem::path & mld_path, const unsigned check_sum) : base_graph(NULL) {
+        if(!boost::filesystem::exists(mld_path)) {
+            throw OSRMException("mld file does not exist");
+        }
+        boost::filesystem::ifstream mld_input_stream(mld_path, std::ios::binary);
+        unsigned loaded_check_sum = 0;
+        unsigned number_of_nodes = 0;
+        unsigned number_of_levels = 0;
+        mld_input_stream.read((char*)&loaded_check_sum, sizeof(unsigned));
+        if(check_sum != loaded_check_sum) {
+            throw OSRMException("mld file was prepared with other data than the hsgr file");
+        }
+        mld_input_stream.read((char*)&number_of_nodes, sizeof(unsigned));
+        mld_input_stream.read((char*)&number_of_levels, sizeof(unsigned));
+        levels.resize(number_of_levels);
+        for(unsigned level = 0; level < number_of_levels; ++level) {
+            levels[level].cell_ids.resize(number_of_nodes);
+            mld_input_stream.read((char*)&levels[level].cell_ids[0], number_of_nodes*sizeof(unsigned));
+        }
+        unsigned number_of_edges = 0;
+        mld_input_stream.read((char*)&number_of_edges, sizeof(unsigned));
+        std::vector<BaseGraph::InputEdge> edge_list(number_of_edges);
+        mld_input_stream.read((char*)&edge_list[0], number_of_edges*sizeof(BaseGraph::InputEdge));
+        if(!mld_input_stream) {
+            throw OSRMException("mld file is truncated");
+        }
+        mld_input_stream.close();
+        base_graph = new BaseGraph(number_of_nodes, edge_list);
+        SimpleLogger().Write() << "Multi-level graph has " << number_of_nodes <<
+            " nodes, " << number_of_edges << " edges and " << number_of_levels << " levels";
+
+        FindBoundaryNodes();
+        std::vector<int> edge_weights(base_graph->GetNumberOfEdges());
+        for(BaseGraph::EdgeIterator edge = 0; edge < edge_weights.size(); ++edge) {
+            edge_weights[edge] = base_graph->GetEdgeData(edge).distance;
+        }
+        Customize(edge_weights);
+        static_metric = latest_metric;
+    }
+
+    ~MultiLevelGraph() {
+        delete base_graph;
+    }
+
+    const BaseGraph & GetBaseGraph() const {
+        return *base_graph;
+    }
+
+    unsigned GetNumberOfLevels() const {
+        return levels.size();
+    }
+
+    // the metric of the weights that were loaded
+    boost::shared_ptr<const Metric> GetStaticMetric() const {
+        return static_metric;
+    }
+
+    // the metric of the weights last passed to Customize()
+    boost::shared_ptr<const Metric> GetLatestMetric() const {
+        boost::mutex::scoped_lock lock(metric_mutex);
+        return latest_metric;
+    }
+
+    // cell of a node on a level, the lowest level is 1
+    unsigned GetCell(const unsigned level, const NodeID node) const {
+        BOOST_ASSERT(0 < level && level <= levels.size());
+        return levels[level-1].cell_ids[node];
+    }
+
+    // The highest level on which a node is in none of the cells of the
+    // endpoints of a search, 0 if it shares its lowest cell with one.
+    // Searches relax the overlay of this level at the node.
+    unsigned GetQueryLevel(const NodeID node, const NodeID * endpoints, const unsigned number_of_endpoints) const {
+        //cells nest, so once a cell is shared all higher ones are
+        for(unsigned level = 1; level <= levels.size(); ++level) {
+            const unsigned cell = GetCell(level, node);
+            for(unsigned i = 0; i < number_of_endpoints; ++i) {
+                if(cell == GetCell(level, endpoints[i])) {
+                    return level-1;
+                }
+            }
+        }
+        return levels.size();
+    }
+
+    // Relaxes the edges of a node on the overlay of a level, level 0 being
+    // the base graph, in reverse for backward searches. A restricting level
+    // keeps the search inside the cell of the node on that level.
+    template<class HeapT>
+    void RelaxEdges(
+        const Metric & metric,
+        HeapT & heap,
+        const NodeID node,
+        const int distance,
+        const unsigned level,
+        const unsigned restricting_level,
+        const bool forward
+    ) const {
+        if(0 < level) {
+            const Level & overlay = levels[level-1];
+            const std::vector<int> & clique_weights = metric.clique_weights[level-1];
+            const Cell & cell = overlay.cells[overlay.cell_ids[node]];
+            const unsigned index = GetBoundaryIndex(level, node);
+            const unsigned number_of_boundary_nodes = cell.boundary_end - cell.boundary_begin;
+            for(unsigned i = 0; i < number_of_boundary_nodes && UINT_MAX != index; ++i) {
+                const int weight = forward ?
+                    clique_weights[cell.clique_begin + index*number_of_boundary_nodes + i] :
+                    clique_weights[cell.clique_begin + i*number_of_boundary_nodes + index];
+                if(INT_MAX != weight && i != index) {
+                    RelaxEdge(heap, node, distance + weight, overlay.boundary_nodes[cell.boundary_begin + i]);
+                }
+            }
+        }
+        for(BaseGraph::EdgeIterator edge = base_graph->BeginEdges(node); edge < base_graph->EndEdges(node); ++edge) {
+            const BaseGraph::EdgeData & data = base_graph->GetEdgeData(edge);
+            if(!(forward ? data.forward : data.backward)) {
+                continue;
+            }
+            const NodeID target = base_graph->GetTarget(edge);
+            //the inside of the cell is covered by its clique
+            if(0 < level && GetCell(level, target) == GetCell(level, node)) {
+                continue;
+            }
+            if(0 < restricting_level && GetCell(restricting_level, target) != GetCell(restricting_level, node)) {
+                continue;
+            }
+            RelaxEdge(heap, node, distance + metric.edge_weights[edge], target);
+        }
+    }
+
+    // Computes the cliques of all levels from new weights of the base
+    // graph, one per edge, each level from the one below it and its cells
+    // in parallel. The result becomes the latest metric, searches that
+    // already hold the previous one keep it.
+    void Customize(const std::vector<int> & edge_weights) {
+        BOOST_ASSERT(edge_weights.size() == base_graph->GetNumberOfEdges());
+        const double start = get_timestamp();
+        boost::shared_ptr<Metric> metric(new Metric);
+        metric->edge_weights = edge_weights;
+        metric->clique_weights.resize(levels.size());
+        for(unsigned level = 1; level <= levels.size(); ++level) {
+            metric->clique_weights[level-1].resize(levels[level-1].number_of_clique_weights, INT_MAX);
+            const int number_of_cells = levels[level-1].cells.size();
+#pragma omp parallel
+            {
+                CustomizationHeap heap(base_graph->GetNumberOfNodes());
+#pragma omp for schedule ( dynamic )
+                for(int cell = 0; cell < number_of_cells; ++cell) {
+                    CustomizeCell(*metric, level, cell, heap);
+                }
+            }
+        }
+        {
+            boost::mutex::scoped_lock lock(metric_mutex);
+            latest_metric = metric;
+        }
+        SimpleLogger().Write() << "Customization took " << (get_timestamp() - start) << " sec";
+    }
+
+private:
+    typedef BinaryHeap<NodeID, NodeID, int, _SimpleHeapData<NodeID>, UnorderedMapStorage<NodeID, int> > CustomizationHeap;
+
+    struct Cell {
+        unsigned boundary_begin;
+        unsigned boundary_end;
+        //row-major distances from each boundary node to each other one
+        unsigned clique_begin;
+    };
+
+    struct Level {
+        std::vector<unsigned> cell_ids;
+        std::vector<Cell> cells;
+        //sorted by id within each cell
+        std::vector<NodeID> boundary_nodes;
+        unsigned number_of_clique_weights;
+    };
+
+    template<class HeapT>
+    static void RelaxEdge(HeapT & heap, const NodeID node, const int to_distance, const NodeID target) {
+        if(!heap.WasInserted(target)) {
+            heap.Insert(target, to_distance, node);
+        } else if(to_distance < heap.GetKey(target)) {
+            heap.GetData(target).parent = node;
+            heap.DecreaseKey(target, to_distance);
+        }
+    }
+
+    // position of a node among the boundary nodes of its cell, UINT_MAX if
+    // it is none
+    unsigned GetBoundaryIndex(const unsigned level, const NodeID node) const {
+        const Level & overlay = levels[level-1];
+        const Cell & cell = overlay.cells[overlay.cell_ids[node]];
+        const std::vector<NodeID>::const_iterator begin = overlay.boundary_nodes.begin() + cell.boundary_begin;
+        const std::vector<NodeID>::const_iterator end = overlay.boundary_nodes.begin() + cell.boundary_end;
+        const std::vector<NodeID>::const_iterator position = std::lower_bound(begin, end, node);
+        return (end != position && node == *position) ? (position - begin) : UINT_MAX;
+    }
+
+    void FindBoundaryNodes() {
+        const unsigned number_of_nodes = base_graph->GetNumberOfNodes();
+        for(unsigned level = 1; level <= levels.size(); ++level) {
+            Level & overlay = levels[level-1];
+            std::vector<char> is_boundary_node(number_of_nodes, false);
+#pragma omp parallel for schedule ( guided )
+            for(int i = 0; i < (int)number_of_nodes; ++i) {
+                const NodeID node = i;
+                for(BaseGraph::EdgeIterator edge = base_graph->BeginEdges(node); edge < base_graph->EndEdges(node); ++edge) {
+                    if(GetCell(level, base_graph->GetTarget(edge)) != GetCell(level, node)) {
+                        is_boundary_node[node] = true;
+                        break;
+                    }
+                }
+            }
+            const unsigned number_of_cells = 1 + *std::max_element(overlay.cell_ids.begin(), overlay.cell_ids.end());
+            std::vector<unsigned> boundary_begin(number_of_cells+1, 0);
+            for(unsigned node = 0; node < number_of_nodes; ++node) {
+                boundary_begin[overlay.cell_ids[node]+1] += is_boundary_node[node];
+            }
+            overlay.cells.resize(number_of_cells);
+            unsigned number_of_clique_weights = 0;
+            for(unsigned cell = 0; cell < number_of_cells; ++cell) {
+                boundary_begin[cell+1] += boundary_begin[cell];
+                const unsigned number_of_boundary_nodes = boundary_begin[cell+1] - boundary_begin[cell];
+                overlay.cells[cell].boundary_begin = overlay.cells[cell].boundary_end = boundary_begin[cell];
+                overlay.cells[cell].clique_begin = number_of_clique_weights;
+                number_of_clique_weights += number_of_boundary_nodes*number_of_boundary_nodes;
+            }
+            overlay.boundary_nodes.resize(boundary_begin.back());
+            for(unsigned node = 0; node < number_of_nodes; ++node) {
+                if(is_boundary_node[node]) {
+                    overlay.boundary_nodes[overlay.cells[overlay.cell_ids[node]].boundary_end++] = node;
+                }
+            }
+            overlay.number_of_clique_weights = number_of_clique_weights;
+            SimpleLogger().Write() << "level " << level << ": " << number_of_cells <<
+                " cells, " << overlay.boundary_nodes.size() << " boundary nodes";
+        }
+    }
+
+    // shortest distances between the boundary nodes of a cell on the
+    // overlay of the level below, without leaving the cell
+    void CustomizeCell(Metric & metric, const unsigned level, const unsigned cell_id, CustomizationHeap & heap) const {
+        const Level & overlay = levels[level-1];
+        const Cell & cell = overlay.cells[cell_id];
+        const unsigned number_of_boundary_nodes = cell.boundary_end - cell.boundary_begin;
+        for(unsigned i = 0; i < number_of_boundary_nodes; ++i) {
+            const NodeID source = overlay.boundary_nodes[cell.boundary_begin + i];
+            heap.Clear();
+            heap.Insert(source, 0, source);
+            while(0 < heap.Size()) {
+                const NodeID node = heap.DeleteMin();
+                RelaxEdges(metric, heap, node, heap.GetKey(node), level-1, level, true);
+            }
+            for(unsigned j = 0; j < number_of_boundary_nodes; ++j) {
+                const NodeID target = overlay.boundary_nodes[cell.boundary_begin + j];
+                metric.clique_weights[level-1][cell.clique_begin + i*number_of_boundary_nodes + j] =
+                    heap.WasInserted(target) ? heap.GetKey(target) : INT_MAX;
+            }
+        }
+    }
+
+    BaseGraph * base_graph;
+    //the lowest level first
+    std::vector<Level> levels;
+    boost::shared_ptr<const Metric> static_metric;
+    mutable boost::mutex metric_mutex;
+    boost::shared_ptr<const Metric> latest_metric;
+};
+
+#endif /* MULTI_LEVEL_GRAPH_H_ */
@@ -107,6 +107,11 @@ public:
         return m_number_of_nodes;
     }
 
+    //number of entries of the .edges file
+    inline unsigned GetNumberOfOriginalEdges() const {
+        return m_name_ID_list.size();
+    }
+
     inline bool LocateClosestEndPointForCoordinate(
             const FixedPointCoordinate& input_coordinate,
             FixedPointCoordinate& result,
@@ -0,0 +1,238 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef OUTPUT_BUFFER_H_
+#define OUTPUT_BUFFER_H_
+
+#include "../Util/StringUtil.h"
+
+#include <boost/assert.hpp>
+#include <boost/thread.hpp>
+
+#include <cstring>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Keeps released chunks of output buffers for reuse by the same thread.
+class OutputBufferChunkPool {
+public:
+    static const std::size_t CHUNK_SIZE = 64*1024;
+
+    static char * GetChunk() {
+        std::vector<char *> & free_chunks = GetFreeChunks().chunks;
+        if(free_chunks.empty()) {
+            return new char[CHUNK_SIZE];
+        }
+        char * chunk = free_chunks.back();
+        free_chunks.pop_back();
+        return chunk;
+    }
+
+    static void ReleaseChunk(char * chunk) {
+        std::vector<char *> & free_chunks = GetFreeChunks().chunks;
+        if(free_chunks.size() < MAX_FREE_CHUNKS_PER_THREAD) {
+            free_chunks.push_back(chunk);
+        } else {
+            delete[] chunk;
+        }
+    }
+
+private:
+    static const std::size_t MAX_FREE_CHUNKS_PER_THREAD = 256;
+
+    struct FreeChunks {
+        ~FreeChunks() {
+            for(unsigned i = 0; i < chunks.size(); ++i) {
+                delete[] chunks[i];
+            }
+        }
+        std::vector<char *> chunks;
+    };
+
+    static FreeChunks & GetFreeChunks() {
+        static boost::thread_specific_ptr<FreeChunks> thread_local_free_chunks;
+        if(!thread_local_free_chunks.get()) {
+            thread_local_free_chunks.reset(new FreeChunks());
+        }
+        return *thread_local_free_chunks;
+    }
+};
+
+// Append-only text buffer made of fixed-size chunks. Written data never
+// moves, so the chunks can be handed to asio as a scatter/gather list.
+class OutputBuffer {
+public:
+    OutputBuffer() : used_bytes_in_last_chunk(0) { }
+
+    OutputBuffer(const OutputBuffer & other) : used_bytes_in_last_chunk(0) {
+        AppendBuffer(other);
+    }
+
+    ~OutputBuffer() {
+        Clear();
+    }
+
+    OutputBuffer & operator=(const OutputBuffer & other) {
+        if(this != &other) {
+            Clear();
+            AppendBuffer(other);
+        }
+        return *this;
+    }
+
+    void Append(const char * data, std::size_t length) {
+        while(0 < length) {
+            if(chunk_list.empty() || OutputBufferChunkPool::CHUNK_SIZE == used_bytes_in_last_chunk) {
+                chunk_list.push_back(OutputBufferChunkPool::GetChunk());
+                used_bytes_in_last_chunk = 0;
+            }
+            const std::size_t bytes_to_copy = std::min(
+                length,
+                OutputBufferChunkPool::CHUNK_SIZE - used_bytes_in_last_chunk
+            );
+            memcpy(chunk_list.back() + used_bytes_in_last_chunk, data, bytes_to_copy);
+            used_bytes_in_last_chunk += bytes_to_copy;
+            data += bytes_to_copy;
+            length -= bytes_to_copy;
+        }
+    }
+
+    OutputBuffer & operator+=(const char character) {
+        Append(&character, 1);
+        return *this;
+    }
+
+    OutputBuffer & operator+=(const char * str) {
+        Append(str, strlen(str));
+        return *this;
+    }
+
+    OutputBuffer & operator+=(const std::string & str) {
+        Append(str.data(), str.size());
+        return *this;
+    }
+
+    void AppendInt(const int value) {
+        if(0 > value) {
+            *this += '-';
+            // negate in unsigned arithmetic to handle INT_MIN
+            AppendUnsigned(0u - static_cast<unsigned>(value));
+        } else {
+            AppendUnsigned(value);
+        }
+    }
+
+    void AppendUnsigned(unsigned value) {
+        char buffer[10];
+        char * position = buffer + sizeof(buffer);
+        do {
+            *(--position) = '0' + (value % 10);
+            value /= 10;
+        } while(0 != value);
+        Append(position, buffer + sizeof(buffer) - position);
+    }
+
+    // prints a fixed point coordinate value with six decimals
+    void AppendCoordinate(const int value) {
+        char buffer[12];
+        buffer[11] = 0;
+        const char * position = printInt<11, 6>(buffer, value);
+        Append(position, buffer + 11 - position);
+    }
+
+    // Returns the free space at the end of the buffer, for producers like
+    // zlib that write directly into it. Call CommitWrittenBytes afterwards.
+    char * GetWritableSpace(std::size_t & length) {
+        if(chunk_list.empty() || OutputBufferChunkPool::CHUNK_SIZE == used_bytes_in_last_chunk) {
+            chunk_list.push_back(OutputBufferChunkPool::GetChunk());
+            used_bytes_in_last_chunk = 0;
+        }
+        length = OutputBufferChunkPool::CHUNK_SIZE - used_bytes_in_last_chunk;
+        return chunk_list.back() + used_bytes_in_last_chunk;
+    }
+
+    void CommitWrittenBytes(const std::size_t length) {
+        BOOST_ASSERT(!chunk_list.empty());
+        BOOST_ASSERT(used_bytes_in_last_chunk + length <= OutputBufferChunkPool::CHUNK_SIZE);
+        used_bytes_in_last_chunk += length;
+    }
+
+    std::size_t size() const {
+        if(chunk_list.empty()) {
+            return 0;
+        }
+        return (chunk_list.size()-1)*OutputBufferChunkPool::CHUNK_SIZE + used_bytes_in_last_chunk;
+    }
+
+    bool empty() const {
+        return 0 == size();
+    }
+
+    void Clear() {
+        for(unsigned i = 0; i < chunk_list.size(); ++i) {
+            OutputBufferChunkPool::ReleaseChunk(chunk_list[i]);
+        }
+        chunk_list.clear();
+        used_bytes_in_last_chunk = 0;
+    }
+
+    unsigned GetNumberOfChunks() const {
+        return chunk_list.size();
+    }
+
+    const char * GetChunk(const unsigned index, std::size_t & length) const {
+        BOOST_ASSERT(index < chunk_list.size());
+        length = (index+1 == chunk_list.size()) ? used_bytes_in_last_chunk : OutputBufferChunkPool::CHUNK_SIZE;
+        return chunk_list[index];
+    }
+
+    void AppendTo(std::string & output) const {
+        output.reserve(output.size() + size());
+        for(unsigned i = 0; i < chunk_list.size(); ++i) {
+            std::size_t length;
+            const char * chunk = GetChunk(i, length);
+            output.append(chunk, length);
+        }
+    }
+
+private:
+    void AppendBuffer(const OutputBuffer & other) {
+        for(unsigned i = 0; i < other.chunk_list.size(); ++i) {
+            std::size_t length;
+            const char * chunk = other.GetChunk(i, length);
+            Append(chunk, length);
+        }
+    }
+
+    std::vector<char *> chunk_list;
+    std::size_t used_bytes_in_last_chunk;
+};
+
+#endif /* OUTPUT_BUFFER_H_ */
@@ -42,15 +42,23 @@ struct _PathData {
     short turnInstruction;
 };
 
+struct _AlternativePathData {
+    _AlternativePathData() : length(INT_MAX), sharing(0) {}
+    std::vector< _PathData > path;
+    int length;
+    //length of the parts shared with the shortest path
+    int sharing;
+};
+
 struct RawRouteData {
     std::vector< _PathData > computedShortestPath;
-    std::vector< _PathData > computedAlternativePath;
+    //ranked, best alternative first
+    std::vector< _AlternativePathData > computedAlternativePaths;
     std::vector< PhantomNodes > segmentEndCoordinates;
     std::vector< FixedPointCoordinate > rawViaNodeCoordinates;
     unsigned checkSum;
     int lengthOfShortestPath;
-    int lengthOfAlternativePath;
-    RawRouteData() : checkSum(UINT_MAX), lengthOfShortestPath(INT_MAX), lengthOfAlternativePath(INT_MAX) {}
+    RawRouteData() : checkSum(UINT_MAX), lengthOfShortestPath(INT_MAX) {}
 };
 
 #endif /* RAWROUTEDATA_H_ */
@@ -78,6 +78,7 @@ struct _RawRestrictionContainer {
     EdgeID fromWay;
     EdgeID toWay;
     unsigned viaNode;
+    unsigned relationID;
 
     _RawRestrictionContainer(
         EdgeID fromWay,
@@ -87,7 +88,8 @@ struct _RawRestrictionContainer {
     ) :
         fromWay(fromWay),
         toWay(toWay),
-        viaNode(vw)
+        viaNode(vw),
+        relationID(UINT_MAX)
     {
         restriction.viaNode = vn;
     }
@@ -96,7 +98,8 @@ struct _RawRestrictionContainer {
     ) :
         fromWay(UINT_MAX),
         toWay(UINT_MAX),
-        viaNode(UINT_MAX)
+        viaNode(UINT_MAX),
+        relationID(UINT_MAX)
     {
         restriction.flags.isOnly = isOnly;
     }
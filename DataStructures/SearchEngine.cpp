@@ -30,11 +30,24 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 SearchEngine::SearchEngine( QueryObjectsStorage * query_objects ) :
     _queryData(query_objects),
     shortestPath(_queryData),
-    alternativePaths(_queryData)
+    alternativePaths(_queryData),
+    multiLevelPath(_queryData)
 {}
 
 SearchEngine::~SearchEngine() {}
 
+void SearchEngine::UseClassicKernel(const bool use_classic_kernel) {
+    _queryData.use_classic_kernel = use_classic_kernel;
+}
+
+void SearchEngine::UseTraffic(const bool use_traffic) {
+    _queryData.use_traffic = use_traffic;
+}
+
+void SearchEngine::SetParallelLegThreshold(const unsigned number_of_legs) {
+    _queryData.parallel_leg_threshold = number_of_legs;
+}
+
 void SearchEngine::GetCoordinatesForNodeID(
     NodeID id,
     FixedPointCoordinate& result
@@ -76,9 +89,28 @@ NodeID SearchEngine::GetNameIDForOriginDestinationNodeID(
 }
 
 std::string SearchEngine::GetEscapedNameForNameID(const unsigned nameID) const {
-    std::string result;
-    _queryData.query_objects->GetName(nameID, result);
-    return HTMLEntitize(result);
+    const char * name;
+    unsigned length;
+    _queryData.query_objects->GetEscapedName(nameID, name, length);
+    return std::string(name, length);
+}
+
+void SearchEngine::GetNameForNameID(
+    const unsigned nameID,
+    const char *& name,
+    unsigned & length
+) const {
+    _queryData.query_objects->GetName(nameID, name, length);
+}
+
+void SearchEngine::AppendEscapedNameForNameID(
+    const unsigned nameID,
+    OutputBuffer & output
+) const {
+    const char * name;
+    unsigned length;
+    _queryData.query_objects->GetEscapedName(nameID, name, length);
+    output.Append(name, length);
 }
 
 SearchEngineHeapPtr SearchEngineData::forwardHeap;
@@ -30,10 +30,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Coordinate.h"
 #include "NodeInformationHelpDesk.h"
+#include "OutputBuffer.h"
 #include "PhantomNodes.h"
 #include "QueryEdge.h"
 #include "SearchEngineData.h"
 #include "../RoutingAlgorithms/AlternativePathRouting.h"
+#include "../RoutingAlgorithms/MultiLevelRouting.h"
 #include "../RoutingAlgorithms/ShortestPathRouting.h"
 #include "../Server/DataStructures/QueryObjectsStorage.h"
 
@@ -51,10 +53,21 @@ private:
 public:
     ShortestPathRouting<SearchEngineData> shortestPath;
     AlternativeRouting<SearchEngineData> alternativePaths;
+    //only finds routes if the multi-level graph is loaded
+    MultiLevelRouting<SearchEngineData> multiLevelPath;
 
     SearchEngine( QueryObjectsStorage * query_objects );
 	~SearchEngine();
 
+    //selects the original CH query kernel, e.g. to validate the new one
+    void UseClassicKernel(const bool use_classic_kernel);
+
+    //searches use the weights of the traffic overlay, if there is one
+    void UseTraffic(const bool use_traffic);
+
+    //routes with at least this many legs are searched leg-parallel, 0 never
+    void SetParallelLegThreshold(const unsigned number_of_legs);
+
 	void GetCoordinatesForNodeID(NodeID id, FixedPointCoordinate& result) const;
 
     void FindPhantomNodeForCoordinate(
@@ -67,6 +80,17 @@ public:
         const NodeID s, const NodeID t) const;
 
     std::string GetEscapedNameForNameID(const unsigned nameID) const;
+
+    void GetNameForNameID(
+        const unsigned nameID,
+        const char *& name,
+        unsigned & length
+    ) const;
+
+    void AppendEscapedNameForNameID(
+        const unsigned nameID,
+        OutputBuffer & output
+    ) const;
 };
 
 #endif /* SEARCHENGINE_H_ */
@@ -27,6 +27,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "SearchEngineData.h"
 
+#include "../Util/OpenMPWrapper.h"
+
+//the threads serving requests already keep the cores busy under load
+SearchThreadBudget SearchEngineData::searchThreadBudget(omp_get_num_procs()-1);
+
 void SearchEngineData::InitializeOrClearFirstThreadLocalStorage() {
     if(!forwardHeap.get()) {
         forwardHeap.reset(new QueryHeap(nodeHelpDesk->GetNumberOfNodes()));
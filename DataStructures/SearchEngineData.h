@@ -26,8 +26,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "BinaryHeap.h"
+#include "MultiLevelGraph.h"
 #include "QueryEdge.h"
+#include "SearchGraph.h"
+#include "SearchThreadBudget.h"
 #include "StaticGraph.h"
+#include "TrafficOverlay.h"
 #include "../Server/DataStructures/QueryObjectsStorage.h"
 
 #include "../typedefs.h"
@@ -52,12 +56,30 @@ struct SearchEngineData {
      :
         query_objects(query_objects),
         graph(query_objects->graph),
-        nodeHelpDesk(query_objects->nodeHelpDesk)
+        search_graph(query_objects->search_graph),
+        traffic_overlay(query_objects->traffic_overlay),
+        multi_level_graph(query_objects->multi_level_graph),
+        nodeHelpDesk(query_objects->nodeHelpDesk),
+        use_classic_kernel(false),
+        use_traffic(false),
+        parallel_leg_threshold(8)
     {}
 
     const QueryObjectsStorage       * query_objects;
     const QueryGraph                * graph;
+    const SearchGraph               * search_graph;
+    const TrafficOverlay            * traffic_overlay;
+    const MultiLevelGraph           * multi_level_graph;
     const NodeInformationHelpDesk   * nodeHelpDesk;
+    //run searches with RoutingStep instead of SearchGraphRoutingStep
+    bool                              use_classic_kernel;
+    //search the latest re-weighted graph of the traffic overlay, if any
+    bool                              use_traffic;
+    //routes with at least this many legs search them in parallel, 0 never
+    unsigned                          parallel_leg_threshold;
+
+    //helper threads shared by the parallel searches of all requests
+    static SearchThreadBudget searchThreadBudget;
 
     static SearchEngineHeapPtr forwardHeap;
     static SearchEngineHeapPtr backwardHeap;
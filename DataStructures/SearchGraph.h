@@ -0,0 +1,169 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef SEARCH_GRAPH_H_
+#define SEARCH_GRAPH_H_
+
+#include "StaticGraph.h"
+#include "../typedefs.h"
+
+#include <boost/assert.hpp>
+
+#include <climits>
+
+#include <vector>
+
+// Copy of the query graph that is laid out for the CH query kernel. The
+// edges of a node are grouped as backward-only, bidirectional and
+// forward-only, so a search relaxes one contiguous range and checks the
+// stall condition on the overlapping one without looking at direction
+// flags. Only target and weight are kept, unpacking still uses the graph.
+// The weights may differ from the ones of the graph, e.g. under traffic.
+class SearchGraph {
+public:
+    typedef NodeID EdgeIterator;
+
+    struct SearchEdge {
+        NodeID target;
+        int weight;
+    };
+
+    template<typename GraphT>
+    explicit SearchGraph(const GraphT & graph) {
+        Build(graph, EdgeDistances<GraphT>(graph));
+    }
+
+    // weights(edge, forward) gives the weight of each direction of an edge.
+    // Edges whose directions differ in weight are split in two.
+    template<typename GraphT, typename WeightsT>
+    SearchGraph(const GraphT & graph, const WeightsT & weights) {
+        Build(graph, weights);
+    }
+
+    // Splits every edge in two, so that each direction has an edge of its
+    // own whose weight can be changed later on. The edge of direction
+    // 2*edge+(forward ? 0 : 1) is stored in edge_of_direction, UINT_MAX if
+    // the direction does not exist.
+    template<typename GraphT, typename WeightsT>
+    SearchGraph(const GraphT & graph, const WeightsT & weights, std::vector<EdgeIterator> & edge_of_direction) {
+        edge_of_direction.assign(2*graph.GetNumberOfEdges(), UINT_MAX);
+        Build(graph, weights, &edge_of_direction);
+    }
+
+    // all edges of a node, [begin, bidirectional) are backward-only,
+    // [bidirectional, forward) go both ways, [forward, end) are forward-only
+    EdgeIterator BeginEdges(const NodeID node) const {
+        return node_array[node].first_edge;
+    }
+
+    EdgeIterator BeginBidirectionalEdges(const NodeID node) const {
+        return node_array[node].first_bidirectional_edge;
+    }
+
+    EdgeIterator BeginForwardOnlyEdges(const NodeID node) const {
+        return node_array[node].first_forward_edge;
+    }
+
+    EdgeIterator EndEdges(const NodeID node) const {
+        return node_array[node+1].first_edge;
+    }
+
+    const SearchEdge & GetEdge(const EdgeIterator edge) const {
+        return edge_array[edge];
+    }
+
+    unsigned GetNumberOfNodes() const {
+        return node_array.size()-1;
+    }
+
+    // not safe while the graph is searched
+    void SetWeight(const EdgeIterator edge, const int weight) {
+        BOOST_ASSERT(0 < weight);
+        edge_array[edge].weight = weight;
+    }
+
+private:
+    struct NodeEntry {
+        EdgeIterator first_edge;
+        EdgeIterator first_bidirectional_edge;
+        EdgeIterator first_forward_edge;
+    };
+
+    template<typename GraphT>
+    struct EdgeDistances {
+        explicit EdgeDistances(const GraphT & graph) : graph(graph) { }
+        int operator()(const typename GraphT::EdgeIterator edge, const bool) const {
+            return graph.GetEdgeData(edge).distance;
+        }
+        const GraphT & graph;
+    };
+
+    template<typename GraphT, typename WeightsT>
+    void Build(const GraphT & graph, const WeightsT & weights, std::vector<EdgeIterator> * edge_of_direction = NULL) {
+        const unsigned number_of_nodes = graph.GetNumberOfNodes();
+        node_array.resize(number_of_nodes+1);
+        edge_array.reserve(graph.GetNumberOfEdges());
+        for(NodeID node = 0; node < number_of_nodes; ++node) {
+            node_array[node].first_edge = edge_array.size();
+            AppendEdges(graph, weights, node, false, true, edge_of_direction);
+            node_array[node].first_bidirectional_edge = edge_array.size();
+            AppendEdges(graph, weights, node, true, true, edge_of_direction);
+            node_array[node].first_forward_edge = edge_array.size();
+            AppendEdges(graph, weights, node, true, false, edge_of_direction);
+        }
+        node_array[number_of_nodes].first_edge = edge_array.size();
+        node_array[number_of_nodes].first_bidirectional_edge = edge_array.size();
+        node_array[number_of_nodes].first_forward_edge = edge_array.size();
+    }
+
+    template<typename GraphT, typename WeightsT>
+    void AppendEdges(const GraphT & graph, const WeightsT & weights, const NodeID node, const bool forward, const bool backward, std::vector<EdgeIterator> * edge_of_direction) {
+        for(typename GraphT::EdgeIterator edge = graph.BeginEdges(node); edge < graph.EndEdges(node); ++edge) {
+            const typename GraphT::EdgeData & data = graph.GetEdgeData(edge);
+            const bool bidirectional = (NULL == edge_of_direction) && data.forward && data.backward && (weights(edge, true) == weights(edge, false));
+            const bool append = (forward && backward) ?
+                bidirectional :
+                (!bidirectional && (forward ? data.forward : data.backward));
+            if(append) {
+                if(NULL != edge_of_direction) {
+                    (*edge_of_direction)[2*edge + (forward ? 0 : 1)] = edge_array.size();
+                }
+                SearchEdge search_edge;
+                search_edge.target = graph.GetTarget(edge);
+                search_edge.weight = weights(edge, forward);
+                BOOST_ASSERT(0 < search_edge.weight);
+                edge_array.push_back(search_edge);
+            }
+        }
+    }
+
+    std::vector<NodeEntry> node_array;
+    std::vector<SearchEdge> edge_array;
+};
+
+#endif /* SEARCH_GRAPH_H_ */
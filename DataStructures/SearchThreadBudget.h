@@ -0,0 +1,87 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef SEARCH_THREAD_BUDGET_H_
+#define SEARCH_THREAD_BUDGET_H_
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <algorithm>
+
+// Hands out helper threads to the parallel parts of a search. The server
+// already runs about one thread per core, so if every request started a
+// full OpenMP team of its own, concurrent requests would oversubscribe the
+// CPU. All requests draw from one pool of helpers instead; a search that
+// finds the pool empty simply runs on its own thread.
+class SearchThreadBudget : boost::noncopyable {
+public:
+    explicit SearchThreadBudget(const int number_of_helpers) :
+        number_of_free_helpers(std::max(0, number_of_helpers))
+    { }
+
+    // returns the team size for the given number of tasks, at least one
+    int Acquire(const int number_of_tasks) {
+        boost::mutex::scoped_lock lock(mutex);
+        const int number_of_helpers = std::max(0, std::min(number_of_free_helpers, number_of_tasks-1));
+        number_of_free_helpers -= number_of_helpers;
+        return number_of_helpers+1;
+    }
+
+    void Release(const int team_size) {
+        boost::mutex::scoped_lock lock(mutex);
+        number_of_free_helpers += team_size-1;
+    }
+
+private:
+    boost::mutex mutex;
+    int number_of_free_helpers;
+};
+
+// Holds helpers of the budget for the lifetime of one parallel region:
+// #pragma omp parallel for num_threads(team.Size()) if(1 < team.Size())
+class SearchThreadTeam : boost::noncopyable {
+public:
+    SearchThreadTeam(SearchThreadBudget & budget, const int number_of_tasks) :
+        budget(budget),
+        team_size(budget.Acquire(number_of_tasks))
+    { }
+
+    ~SearchThreadTeam() {
+        budget.Release(team_size);
+    }
+
+    inline int Size() const {
+        return team_size;
+    }
+
+private:
+    SearchThreadBudget & budget;
+    const int team_size;
+};
+
+#endif /* SEARCH_THREAD_BUDGET_H_ */
@@ -0,0 +1,135 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef SHARDED_LRU_CACHE_H
+#define SHARDED_LRU_CACHE_H
+
+#include "LRUCache.h"
+
+#include <boost/assert.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+
+#include <cstddef>
+
+#include <vector>
+
+// Thread-safe LRU cache. Keys are spread by hash over independently locked
+// shards so that concurrent lookups rarely contend. The capacity, given in
+// cost units, is split evenly between the shards.
+template<typename KeyT, typename ValueT>
+class ShardedLRUCache : boost::noncopyable {
+private:
+    struct Shard {
+        Shard(const std::size_t capacity) :
+            cache(capacity),
+            number_of_hits(0),
+            number_of_misses(0),
+            number_of_evictions(0)
+        { }
+        boost::mutex mutex;
+        LRUCache<KeyT, ValueT> cache;
+        std::size_t number_of_hits;
+        std::size_t number_of_misses;
+        std::size_t number_of_evictions;
+    };
+    std::vector<Shard *> shards;
+
+    Shard & GetShard(const KeyT & key) {
+        return *shards[boost::hash<KeyT>()(key) % shards.size()];
+    }
+public:
+    struct Statistics {
+        Statistics() :
+            number_of_hits(0),
+            number_of_misses(0),
+            number_of_evictions(0),
+            number_of_entries(0),
+            total_cost(0)
+        { }
+        std::size_t number_of_hits;
+        std::size_t number_of_misses;
+        std::size_t number_of_evictions;
+        std::size_t number_of_entries;
+        std::size_t total_cost;
+    };
+
+    ShardedLRUCache(const std::size_t capacity, const unsigned number_of_shards = 16) {
+        BOOST_ASSERT(0 < number_of_shards);
+        for(unsigned i = 0; i < number_of_shards; ++i) {
+            shards.push_back(new Shard(capacity/number_of_shards));
+        }
+    }
+
+    ~ShardedLRUCache() {
+        for(unsigned i = 0; i < shards.size(); ++i) {
+            delete shards[i];
+        }
+    }
+
+    bool Fetch(const KeyT & key, ValueT & result) {
+        Shard & shard = GetShard(key);
+        boost::lock_guard<boost::mutex> lock(shard.mutex);
+        if(shard.cache.Fetch(key, result)) {
+            ++shard.number_of_hits;
+            return true;
+        }
+        ++shard.number_of_misses;
+        return false;
+    }
+
+    void Insert(const KeyT & key, const ValueT & value, const std::size_t cost = 1) {
+        Shard & shard = GetShard(key);
+        boost::lock_guard<boost::mutex> lock(shard.mutex);
+        shard.number_of_evictions += shard.cache.Insert(key, value, cost);
+    }
+
+    void Clear() {
+        for(unsigned i = 0; i < shards.size(); ++i) {
+            boost::lock_guard<boost::mutex> lock(shards[i]->mutex);
+            shards[i]->cache.Clear();
+        }
+    }
+
+    Statistics GetStatistics() {
+        Statistics statistics;
+        for(unsigned i = 0; i < shards.size(); ++i) {
+            boost::lock_guard<boost::mutex> lock(shards[i]->mutex);
+            statistics.number_of_hits += shards[i]->number_of_hits;
+            statistics.number_of_misses += shards[i]->number_of_misses;
+            statistics.number_of_evictions += shards[i]->number_of_evictions;
+            statistics.number_of_entries += shards[i]->cache.Size();
+            statistics.total_cost += shards[i]->cache.GetTotalCost();
+        }
+        return statistics;
+    }
+};
+
+#endif /* SHARDED_LRU_CACHE_H */
@@ -29,11 +29,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define STATICRTREE_H_
 
 #include "MercatorUtil.h"
+#include "ConcurrentQueue.h"
 #include "Coordinate.h"
 #include "PhantomNodes.h"
 #include "DeallocatingVector.h"
 #include "HilbertValue.h"
+#include "../Util/OpenMPWrapper.h"
 #include "../Util/OSRMException.h"
+#include "../Util/QueryMetrics.h"
 #include "../Util/SimpleLogger.h"
 #include "../Util/TimingUtil.h"
 #include "../typedefs.h"
@@ -47,6 +50,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/algorithm/minmax_element.hpp>
 #include <boost/range/algorithm_ext/erase.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/ref.hpp>
 #include <boost/thread.hpp>
 
 #include <algorithm>
@@ -58,6 +62,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //tuning parameters
 const static uint32_t RTREE_BRANCHING_FACTOR = 50;
 const static uint32_t RTREE_LEAF_NODE_SIZE = 1170;
+//leaves are built and written in batches of this many nodes
+const static uint32_t RTREE_LEAF_BATCH_SIZE = 256;
+//number of leaf batches in flight between builder and writer
+const static uint32_t RTREE_LEAF_BATCH_COUNT = 3;
+//bits per radix sort pass over the 64 bit hilbert values
+const static uint32_t RTREE_RADIX_BITS = 11;
 
 // Implements a static, i.e. packed, R-tree
 
@@ -259,6 +269,8 @@ private:
         DataT objects[RTREE_LEAF_NODE_SIZE];
     };
 
+    typedef std::vector<LeafNode> LeafNodeBatch;
+
     struct TreeNode {
         TreeNode() : child_count(0), child_is_on_disk(false) {}
         RectangleT minimum_bounding_rectangle;
@@ -280,6 +292,76 @@ private:
         }
     };
 
+    //Stable LSD radix sort by hilbert value. Each chunk of the input is
+    //histogrammed and scattered by its own thread, passes in which all keys
+    //share the same digit are skipped.
+    static void SortByHilbertValue(std::vector<WrappedInputElement> & input_vector) {
+        const uint64_t element_count = input_vector.size();
+        const uint32_t number_of_buckets = 1 << RTREE_RADIX_BITS;
+        const int number_of_chunks = omp_get_max_threads();
+        const uint64_t chunk_size = (element_count + number_of_chunks - 1)/number_of_chunks;
+
+        std::vector<WrappedInputElement> buffer_vector(element_count);
+        std::vector<uint64_t> bucket_offsets(number_of_chunks*number_of_buckets);
+        for(uint32_t shift = 0; shift < 64; shift += RTREE_RADIX_BITS) {
+            std::fill(bucket_offsets.begin(), bucket_offsets.end(), 0);
+#pragma omp parallel for schedule(static)
+            for(int chunk = 0; chunk < number_of_chunks; ++chunk) {
+                uint64_t * histogram = &bucket_offsets[chunk*number_of_buckets];
+                const uint64_t chunk_end = std::min(element_count, (chunk+1)*chunk_size);
+                for(uint64_t i = chunk*chunk_size; i < chunk_end; ++i) {
+                    ++histogram[(input_vector[i].m_hilbert_value >> shift) & (number_of_buckets-1)];
+                }
+            }
+
+            //exclusive prefix sum in (bucket, chunk) order keeps the sort stable
+            uint64_t offset = 0;
+            bool is_trivial_pass = false;
+            for(uint32_t bucket = 0; bucket < number_of_buckets; ++bucket) {
+                const uint64_t bucket_begin = offset;
+                for(int chunk = 0; chunk < number_of_chunks; ++chunk) {
+                    const uint64_t count = bucket_offsets[chunk*number_of_buckets + bucket];
+                    bucket_offsets[chunk*number_of_buckets + bucket] = offset;
+                    offset += count;
+                }
+                is_trivial_pass |= (element_count == offset - bucket_begin);
+            }
+            if(is_trivial_pass) {
+                continue;
+            }
+
+#pragma omp parallel for schedule(static)
+            for(int chunk = 0; chunk < number_of_chunks; ++chunk) {
+                uint64_t * offsets = &bucket_offsets[chunk*number_of_buckets];
+                const uint64_t chunk_end = std::min(element_count, (chunk+1)*chunk_size);
+                for(uint64_t i = chunk*chunk_size; i < chunk_end; ++i) {
+                    const uint32_t bucket = (input_vector[i].m_hilbert_value >> shift) & (number_of_buckets-1);
+                    buffer_vector[offsets[bucket]++] = input_vector[i];
+                }
+            }
+            input_vector.swap(buffer_vector);
+        }
+    }
+
+    //Writer side of the leaf pipeline, each batch goes out in a single write.
+    //A NULL batch marks the end of input.
+    static void WriteLeafNodeBatches(
+        boost::filesystem::ofstream & leaf_node_file,
+        ConcurrentQueue<LeafNodeBatch *> & full_batches,
+        ConcurrentQueue<LeafNodeBatch *> & empty_batches
+    ) {
+        LeafNodeBatch * current_batch;
+        full_batches.wait_and_pop(current_batch);
+        while(NULL != current_batch) {
+            leaf_node_file.write(
+                (char*)&(*current_batch)[0],
+                sizeof(LeafNode)*current_batch->size()
+            );
+            empty_batches.push(current_batch);
+            full_batches.wait_and_pop(current_batch);
+        }
+    }
+
     std::vector<TreeNode> m_search_tree;
     uint64_t m_element_count;
 
@@ -314,67 +396,123 @@ public:
             input_wrapper_vector[element_counter].m_hilbert_value = current_hilbert_value;
 
         }
+
+        //sort the hilbert-value representatives
+        SortByHilbertValue(input_wrapper_vector);
+        double time2 = get_timestamp();
+
         //open leaf file
         boost::filesystem::ofstream leaf_node_file(leaf_node_filename, std::ios::binary);
         leaf_node_file.write((char*) &m_element_count, sizeof(uint64_t));
 
-        //sort the hilbert-value representatives
-        std::sort(input_wrapper_vector.begin(), input_wrapper_vector.end());
-        std::vector<TreeNode> tree_nodes_in_level;
-
-        //pack M elements into leaf node and write to leaf file
-        uint64_t processed_objects_count = 0;
-        while(processed_objects_count < m_element_count) {
-
-            LeafNode current_leaf;
-            TreeNode current_node;
-            for(uint32_t current_element_index = 0; RTREE_LEAF_NODE_SIZE > current_element_index; ++current_element_index) {
-                if(m_element_count > (processed_objects_count + current_element_index)) {
-                    uint32_t index_of_next_object = input_wrapper_vector[processed_objects_count + current_element_index].m_array_index;
-                    current_leaf.objects[current_element_index] = input_data_vector[index_of_next_object];
-                    ++current_leaf.object_count;
+        //pack M elements into leaf nodes. Batches of leaves are filled in
+        //parallel while a writer thread streams the previous batch to disk.
+        const uint32_t number_of_leaf_nodes =
+            (m_element_count + RTREE_LEAF_NODE_SIZE - 1)/RTREE_LEAF_NODE_SIZE;
+        std::vector<TreeNode> tree_nodes_in_level(number_of_leaf_nodes);
+
+        ConcurrentQueue<LeafNodeBatch *> empty_batches(RTREE_LEAF_BATCH_COUNT);
+        ConcurrentQueue<LeafNodeBatch *> full_batches(RTREE_LEAF_BATCH_COUNT);
+        for(uint32_t i = 0; i < RTREE_LEAF_BATCH_COUNT; ++i) {
+            empty_batches.push(new LeafNodeBatch(RTREE_LEAF_BATCH_SIZE));
+        }
+        boost::thread writer_thread(
+            boost::bind(
+                &StaticRTree::WriteLeafNodeBatches,
+                boost::ref(leaf_node_file),
+                boost::ref(full_batches),
+                boost::ref(empty_batches)
+            )
+        );
+
+        for(
+            uint32_t first_leaf_in_batch = 0;
+            first_leaf_in_batch < number_of_leaf_nodes;
+            first_leaf_in_batch += RTREE_LEAF_BATCH_SIZE
+        ) {
+            const int leaves_in_batch = std::min(
+                RTREE_LEAF_BATCH_SIZE,
+                number_of_leaf_nodes - first_leaf_in_batch
+            );
+            LeafNodeBatch * current_batch;
+            empty_batches.wait_and_pop(current_batch);
+            current_batch->resize(leaves_in_batch);
+
+#pragma omp parallel for schedule(guided)
+            for(int i = 0; i < leaves_in_batch; ++i) {
+                const uint32_t leaf_id = first_leaf_in_batch + i;
+                const uint64_t first_element = uint64_t(leaf_id)*RTREE_LEAF_NODE_SIZE;
+                LeafNode & current_leaf = (*current_batch)[i];
+                current_leaf.object_count = std::min(
+                    uint64_t(RTREE_LEAF_NODE_SIZE),
+                    m_element_count - first_element
+                );
+                for(uint32_t j = 0; j < current_leaf.object_count; ++j) {
+                    const uint32_t index_of_next_object =
+                        input_wrapper_vector[first_element + j].m_array_index;
+                    current_leaf.objects[j] = input_data_vector[index_of_next_object];
+                }
+                //only the last leaf is partially filled, pad it as before
+                for(uint32_t j = current_leaf.object_count; j < RTREE_LEAF_NODE_SIZE; ++j) {
+                    current_leaf.objects[j] = DataT();
                 }
-            }
 
-            //generate tree node that resemble the objects in leaf and store it for next level
-            current_node.minimum_bounding_rectangle.InitializeMBRectangle(current_leaf.objects, current_leaf.object_count);
-            current_node.child_is_on_disk = true;
-            current_node.children[0] = tree_nodes_in_level.size();
-            tree_nodes_in_level.push_back(current_node);
+                //generate tree node that resemble the objects in leaf and store it for next level
+                TreeNode & current_node = tree_nodes_in_level[leaf_id];
+                current_node.minimum_bounding_rectangle.InitializeMBRectangle(
+                    current_leaf.objects,
+                    current_leaf.object_count
+                );
+                current_node.child_is_on_disk = true;
+                current_node.children[0] = leaf_id;
+            }
+            full_batches.push(current_batch);
+        }
+        full_batches.push(NULL);
+        writer_thread.join();
 
-            //write leaf_node to leaf node file
-            leaf_node_file.write((char*)&current_leaf, sizeof(current_leaf));
-            processed_objects_count += current_leaf.object_count;
+        LeafNodeBatch * unused_batch;
+        while(empty_batches.try_pop(unused_batch)) {
+            delete unused_batch;
         }
 
         //close leaf file
         leaf_node_file.close();
+        if(leaf_node_file.fail()) {
+            throw OSRMException("could not write r-tree leaf file");
+        }
+        double time3 = get_timestamp();
 
         uint32_t processing_level = 0;
         while(1 < tree_nodes_in_level.size()) {
-            std::vector<TreeNode> tree_nodes_in_next_level;
-            uint32_t processed_tree_nodes_in_level = 0;
-            while(processed_tree_nodes_in_level < tree_nodes_in_level.size()) {
-                TreeNode parent_node;
-                //pack RTREE_BRANCHING_FACTOR elements into tree_nodes each
-                for(
-                    uint32_t current_child_node_index = 0;
-                    RTREE_BRANCHING_FACTOR > current_child_node_index;
-                    ++current_child_node_index
-                ) {
-                    if(processed_tree_nodes_in_level < tree_nodes_in_level.size()) {
-                        TreeNode & current_child_node = tree_nodes_in_level[processed_tree_nodes_in_level];
-                        //add tree node to parent entry
-                        parent_node.children[current_child_node_index] = m_search_tree.size();
-                        m_search_tree.push_back(current_child_node);
-                        //augment MBR of parent
-                        parent_node.minimum_bounding_rectangle.AugmentMBRectangle(current_child_node.minimum_bounding_rectangle);
-                        //increase counters
-                        ++parent_node.child_count;
-                        ++processed_tree_nodes_in_level;
-                    }
+            //children of this level are stored consecutively in the search tree
+            const uint32_t first_child_id = m_search_tree.size();
+            m_search_tree.insert(
+                m_search_tree.end(),
+                tree_nodes_in_level.begin(),
+                tree_nodes_in_level.end()
+            );
+
+            const int number_of_parent_nodes =
+                (tree_nodes_in_level.size() + RTREE_BRANCHING_FACTOR - 1)/RTREE_BRANCHING_FACTOR;
+            std::vector<TreeNode> tree_nodes_in_next_level(number_of_parent_nodes);
+            //pack RTREE_BRANCHING_FACTOR elements into tree_nodes each
+#pragma omp parallel for schedule(guided)
+            for(int i = 0; i < number_of_parent_nodes; ++i) {
+                TreeNode & parent_node = tree_nodes_in_next_level[i];
+                const uint32_t first_child_index = i*RTREE_BRANCHING_FACTOR;
+                const uint32_t last_child_index = std::min(
+                    first_child_index + RTREE_BRANCHING_FACTOR,
+                    uint32_t(tree_nodes_in_level.size())
+                );
+                for(uint32_t j = first_child_index; j < last_child_index; ++j) {
+                    //add tree node to parent entry and augment MBR of parent
+                    parent_node.children[parent_node.child_count] = first_child_id + j;
+                    parent_node.minimum_bounding_rectangle.AugmentMBRectangle(
+                        tree_nodes_in_level[j].minimum_bounding_rectangle
+                    );
+                    ++parent_node.child_count;
                 }
-                tree_nodes_in_next_level.push_back(parent_node);
             }
             tree_nodes_in_level.swap(tree_nodes_in_next_level);
             ++processing_level;
@@ -407,9 +545,11 @@ public:
         tree_node_file.write((char *)&m_search_tree[0], sizeof(TreeNode)*size_of_tree);
         //close tree node file.
         tree_node_file.close();
-        double time2 = get_timestamp();
+        double time4 = get_timestamp();
         SimpleLogger().Write() <<
-            "finished r-tree construction in " << (time2-time1) << " seconds";
+            "finished r-tree construction in " << (time4-time1) << " seconds (" <<
+            "hilbert and sort: " << (time2-time1) << "s, leaves: " << (time3-time2) << "s, " <<
+            "tree: " << (time4-time3) << "s)";
     }
 
     //Read-only operation for queries
@@ -606,6 +746,8 @@ public:
     ) {
         bool ignore_tiny_components = (zoom_level <= 14);
         DataT nearest_edge;
+        uint32_t io_count = 0;
+        uint32_t explored_tree_nodes_count = 0;
         double min_dist = std::numeric_limits<double>::max();
         double min_max_dist = std::numeric_limits<double>::max();
         bool found_a_nearest_edge = false;
@@ -626,6 +768,7 @@ public:
             const QueryCandidate current_query_node = traversal_queue.top();
             traversal_queue.pop();
 
+            ++explored_tree_nodes_count;
             const bool prune_downward = (current_query_node.min_dist >= min_max_dist);
             const bool prune_upward = (current_query_node.min_dist >= min_dist);
             if( !prune_downward && !prune_upward ) { //downward pruning
@@ -636,6 +779,7 @@ public:
                         current_tree_node.children[0],
                         current_leaf_node
                     );
+                    ++io_count;
                     for(uint32_t i = 0; i < current_leaf_node.object_count; ++i) {
                         const DataT & current_edge = current_leaf_node.objects[i];
                         if(
@@ -701,7 +845,8 @@ public:
                 }
             }
         }
-
+        QueryMetrics::AddToCounter(QUERY_COUNTER_RTREE_NODES, explored_tree_nodes_count);
+        QueryMetrics::AddToCounter(QUERY_COUNTER_RTREE_LEAVES, io_count);
         return found_a_nearest_edge;
     }
 
@@ -853,6 +998,8 @@ public:
             result_phantom_node.location.lat = input_coordinate.lat;
         }
 
+        QueryMetrics::AddToCounter(QUERY_COUNTER_RTREE_NODES, explored_tree_nodes_count);
+        QueryMetrics::AddToCounter(QUERY_COUNTER_RTREE_LEAVES, io_count);
         return found_a_nearest_edge;
 
     }
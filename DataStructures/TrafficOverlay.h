@@ -0,0 +1,581 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef TRAFFIC_OVERLAY_H_
+#define TRAFFIC_OVERLAY_H_
+
+#include "MultiLevelGraph.h"
+#include "PhantomNodes.h"
+#include "QueryEdge.h"
+#include "SearchGraph.h"
+#include "StaticGraph.h"
+#include "../Util/SimpleLogger.h"
+#include "../Util/TimingUtil.h"
+#include "../typedefs.h"
+
+#include <boost/assert.hpp>
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <climits>
+#include <cstdlib>
+#include <ctime>
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <vector>
+
+static const unsigned TRAFFIC_POLL_INTERVAL = 2; //seconds
+static const unsigned char TRAFFIC_FREE_FLOW_SPEED = 100; //percent
+static const int TRAFFIC_MAXIMUM_WEIGHT = 1 << 29;
+
+// Live traffic on top of the contracted graph. Each original edge, i.e.
+// each entry of the .edges file, travels at a speed given in percent of
+// the one the hierarchy was built with. When the feed changes, the weights
+// of the affected original edges and of the shortcuts above them are
+// recomputed bottom-up and written into the one of two re-weighted
+// SearchGraphs that is not published, once the last request using it is
+// done. That one is then published for new requests, so an update costs
+// time in the number of changed weights, not in the size of the graph.
+// A request takes a Snapshot, which gives the search graph, the weights to
+// unpack with and the factors for the phantom nodes of one and the same
+// feed. The shortcuts are those of the contraction, so a route can be
+// missed where traffic made a witness path slower than the shortcut it
+// replaced. Routes that are found are always valid. A multi-level graph,
+// if given, is customized with the same speeds after each update.
+//
+// The feed is either a CSV file (*.csv) with "<edge id>,<speed factor>"
+// lines, 1.0 being free flow and edges not listed travel at free flow, or
+// a binary file with the number of edges followed by one byte per edge,
+// the speed in percent. It is polled for changes, so replace it by renaming.
+class TrafficOverlay : private boost::noncopyable {
+public:
+    typedef StaticGraph<QueryEdge::EdgeData> QueryGraph;
+
+    // The weights of one feed. A request keeps its snapshot for searching,
+    // unpacking and its phantom nodes, even if a newer feed is published.
+    class Snapshot {
+    public:
+        Snapshot() : overlay(NULL), is_reweighted(false) { }
+
+        const SearchGraph & GetSearchGraph() const {
+            return *search_graph;
+        }
+
+        // the weight of one direction of an edge of the query graph, INT_MAX
+        // if the edge does not go that way
+        int GetWeight(const QueryGraph::EdgeIterator edge, const bool forward) const {
+            if(!is_reweighted) {
+                return overlay->graph.GetEdgeData(edge).distance;
+            }
+            const SearchGraph::EdgeIterator search_edge = overlay->edge_of_ref[2*edge + (forward ? 0 : 1)];
+            if(UINT_MAX == search_edge) {
+                return INT_MAX;
+            }
+            return search_graph->GetEdge(search_edge).weight;
+        }
+
+        // scales the offsets into the edge-based nodes of a phantom node
+        // like the original edges that leave those nodes
+        void ScalePhantomNode(PhantomNode & phantom_node) const {
+            if(!is_reweighted || UINT_MAX == phantom_node.edgeBasedNode) {
+                return;
+            }
+            ScaleOffset(phantom_node.edgeBasedNode, phantom_node.weight1);
+            if(phantom_node.isBidirected()) {
+                ScaleOffset(phantom_node.edgeBasedNode+1, phantom_node.weight2);
+            }
+        }
+
+    private:
+        friend class TrafficOverlay;
+
+        void ScaleOffset(const NodeID node, int & offset) const {
+            if(node >= overlay->ref_of_node.size() || UINT_MAX == overlay->ref_of_node[node]) {
+                return;
+            }
+            const unsigned ref = overlay->ref_of_node[node];
+            const boost::uint64_t base_weight = overlay->graph.GetEdgeData(ref/2).distance;
+            const boost::uint64_t weight = GetWeight(ref/2, 0 == ref%2);
+            offset = (int)std::min<boost::uint64_t>(
+                TRAFFIC_MAXIMUM_WEIGHT,
+                (offset*weight + base_weight/2) / base_weight
+            );
+        }
+
+        boost::shared_ptr<const SearchGraph> search_graph;
+        const TrafficOverlay * overlay;
+        bool is_reweighted;
+    };
+
+    TrafficOverlay(
+        const QueryGraph & graph,
+        const SearchGraph & base_search_graph,
+        const unsigned number_of_original_edges,
+        const boost::filesystem::path & feed_path,
+        MultiLevelGraph * multi_level_graph = NULL,
+        const unsigned poll_interval = TRAFFIC_POLL_INTERVAL
+    ) :
+        graph(graph),
+        multi_level_graph(multi_level_graph),
+        feed_path(feed_path),
+        poll_interval(poll_interval),
+        feed_time(0),
+        feed_size(0),
+        search_graph(&base_search_graph, NullDeleter()),
+        is_reweighted(false),
+        published_buffer(0),
+        speeds(number_of_original_edges, TRAFFIC_FREE_FLOW_SPEED)
+    {
+        SimpleLogger().Write() << "Preparing traffic overlay";
+        BuildHierarchy();
+        Update();
+        poll_thread = boost::thread(boost::bind(&TrafficOverlay::Poll, this));
+    }
+
+    ~TrafficOverlay() {
+        poll_thread.interrupt();
+        poll_thread.join();
+    }
+
+    // the weights of the latest feed
+    Snapshot GetSnapshot() const {
+        Snapshot snapshot;
+        snapshot.overlay = this;
+        boost::mutex::scoped_lock lock(search_graph_mutex);
+        snapshot.search_graph = search_graph;
+        snapshot.is_reweighted = is_reweighted;
+        return snapshot;
+    }
+
+    // Reads the feed if it changed since the last call and publishes the
+    // re-weighted graph. Returns true if any weight changed.
+    bool Update() {
+        boost::mutex::scoped_lock lock(update_mutex);
+        std::time_t current_feed_time;
+        boost::uintmax_t current_feed_size;
+        try {
+            if(!boost::filesystem::exists(feed_path)) {
+                return false;
+            }
+            current_feed_time = boost::filesystem::last_write_time(feed_path);
+            current_feed_size = boost::filesystem::file_size(feed_path);
+        } catch(const boost::filesystem::filesystem_error & e) {
+            SimpleLogger().Write(logWARNING) << "cannot access traffic feed: " << e.what();
+            return false;
+        }
+        if(current_feed_time == feed_time && current_feed_size == feed_size) {
+            return false;
+        }
+        feed_time = current_feed_time;
+        feed_size = current_feed_size;
+
+        const boost::uint64_t start = get_monotonic_microseconds();
+        std::vector<unsigned char> new_speeds;
+        if(!ReadFeed(new_speeds)) {
+            return false;
+        }
+        unsigned number_of_changed_edges = 0;
+        unsigned number_of_reweighted_shortcuts = 0;
+        std::vector<unsigned> changed_refs;
+        ApplySpeeds(new_speeds, number_of_changed_edges, number_of_reweighted_shortcuts, changed_refs);
+        if(0 == number_of_changed_edges) {
+            return false;
+        }
+        Publish(changed_refs);
+        if(NULL != multi_level_graph) {
+            CustomizeMultiLevelGraph();
+        }
+        SimpleLogger().Write() << "Traffic update: " << number_of_changed_edges <<
+            " edges changed, " << number_of_reweighted_shortcuts <<
+            " shortcuts re-weighted in " << (get_monotonic_microseconds()-start)/1000 << " ms";
+        return true;
+    }
+
+private:
+    struct NullDeleter {
+        void operator()(const void *) const { }
+    };
+
+    // Writes the changed weights into the search graph that is not
+    // published and publishes it. The first update builds both graphs.
+    void Publish(const std::vector<unsigned> & changed_refs) {
+        if(!buffers[0]) {
+            for(unsigned i = 0; i < 2; ++i) {
+                buffers[i].reset(new SearchGraph(graph, RefWeights(weights), edge_of_ref));
+            }
+        } else {
+            boost::shared_ptr<SearchGraph> & buffer = buffers[1-published_buffer];
+            //requests still searching the graph hold a snapshot of it
+            while(!buffer.unique()) {
+                boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+            }
+            //it also misses the changes of the update that published the other one
+            for(unsigned i = 0; i < unpublished_refs.size(); ++i) {
+                buffer->SetWeight(edge_of_ref[unpublished_refs[i]], weights[unpublished_refs[i]]);
+            }
+            for(unsigned i = 0; i < changed_refs.size(); ++i) {
+                buffer->SetWeight(edge_of_ref[changed_refs[i]], weights[changed_refs[i]]);
+            }
+            published_buffer = 1-published_buffer;
+        }
+        unpublished_refs = changed_refs;
+        boost::mutex::scoped_lock graph_lock(search_graph_mutex);
+        search_graph = buffers[published_buffer];
+        is_reweighted = true;
+    }
+
+    // weights of the edges of the graph by direction, see RefWeights
+    struct RefWeights {
+        explicit RefWeights(const std::vector<int> & weights) : weights(weights) { }
+        int operator()(const QueryGraph::EdgeIterator edge, const bool forward) const {
+            return weights[2*edge + (forward ? 0 : 1)];
+        }
+        const std::vector<int> & weights;
+    };
+
+    // A ref is one direction of an edge of the graph, 2*edge for travel
+    // from its source to its target and 2*edge+1 for the other way round.
+    // The ref of a shortcut has those of its two halves as children, found
+    // the same way unpacking finds them.
+    void BuildHierarchy() {
+        const unsigned number_of_nodes = graph.GetNumberOfNodes();
+        const unsigned number_of_refs = 2*graph.GetNumberOfEdges();
+        weights.resize(number_of_refs, INT_MAX);
+        children.resize(2*number_of_refs, UINT_MAX);
+#pragma omp parallel for schedule ( guided )
+        for(int i = 0; i < (int)number_of_nodes; ++i) {
+            const NodeID node = i;
+            for(QueryGraph::EdgeIterator edge = graph.BeginEdges(node); edge < graph.EndEdges(node); ++edge) {
+                const QueryGraph::EdgeData & data = graph.GetEdgeData(edge);
+                const NodeID target = graph.GetTarget(edge);
+                if(data.forward) {
+                    weights[2*edge] = data.distance;
+                    if(data.shortcut) {
+                        children[4*edge]   = FindRef(node, data.id);
+                        children[4*edge+1] = FindRef(data.id, target);
+                    }
+                }
+                if(data.backward) {
+                    weights[2*edge+1] = data.distance;
+                    if(data.shortcut) {
+                        children[4*edge+2] = FindRef(target, data.id);
+                        children[4*edge+3] = FindRef(data.id, node);
+                    }
+                }
+            }
+        }
+
+        //a shortcut is recomputed after both of its halves
+        heights.resize(number_of_refs, UINT_MAX);
+        unsigned maximum_height = 0;
+        std::vector<unsigned> stack;
+        for(unsigned ref = 0; ref < number_of_refs; ++ref) {
+            if(INT_MAX == weights[ref] || UINT_MAX != heights[ref]) {
+                continue;
+            }
+            stack.push_back(ref);
+            while(!stack.empty()) {
+                const unsigned current = stack.back();
+                if(!HasChildren(current)) {
+                    heights[current] = 0;
+                    stack.pop_back();
+                    continue;
+                }
+                const unsigned first = children[2*current];
+                const unsigned second = children[2*current+1];
+                if(UINT_MAX != heights[first] && UINT_MAX != heights[second]) {
+                    heights[current] = 1 + std::max(heights[first], heights[second]);
+                    maximum_height = std::max(maximum_height, heights[current]);
+                    stack.pop_back();
+                    continue;
+                }
+                if(UINT_MAX == heights[first]) {
+                    stack.push_back(first);
+                }
+                if(UINT_MAX == heights[second]) {
+                    stack.push_back(second);
+                }
+            }
+        }
+        dirty_refs.resize(maximum_height+1);
+        is_dirty.resize(number_of_refs, false);
+
+        //parents of each ref and the refs of each original edge
+        parent_begin.resize(number_of_refs+1, 0);
+        original_ref_begin.resize(speeds.size()+1, 0);
+        for(unsigned ref = 0; ref < number_of_refs; ++ref) {
+            if(HasChildren(ref)) {
+                ++parent_begin[children[2*ref]+1];
+                ++parent_begin[children[2*ref+1]+1];
+            } else if(IsOriginal(ref)) {
+                ++original_ref_begin[graph.GetEdgeData(ref/2).id+1];
+            }
+        }
+        std::partial_sum(parent_begin.begin(), parent_begin.end(), parent_begin.begin());
+        std::partial_sum(original_ref_begin.begin(), original_ref_begin.end(), original_ref_begin.begin());
+        parents.resize(parent_begin.back());
+        original_refs.resize(original_ref_begin.back());
+        std::vector<unsigned> parent_end(parent_begin.begin(), parent_begin.end()-1);
+        std::vector<unsigned> original_ref_end(original_ref_begin.begin(), original_ref_begin.end()-1);
+        for(unsigned ref = 0; ref < number_of_refs; ++ref) {
+            if(HasChildren(ref)) {
+                parents[parent_end[children[2*ref]]++] = ref;
+                parents[parent_end[children[2*ref+1]]++] = ref;
+            } else if(IsOriginal(ref)) {
+                const unsigned original_edge = graph.GetEdgeData(ref/2).id;
+                original_refs[original_ref_end[original_edge]++] = ref;
+            }
+        }
+        //an original ref leaving each node scales the phantom nodes on it
+        ref_of_node.resize(number_of_nodes, UINT_MAX);
+        for(NodeID node = 0; node < number_of_nodes; ++node) {
+            for(QueryGraph::EdgeIterator edge = graph.BeginEdges(node); edge < graph.EndEdges(node); ++edge) {
+                const NodeID target = graph.GetTarget(edge);
+                if(IsOriginal(2*edge) && UINT_MAX == ref_of_node[node]) {
+                    ref_of_node[node] = 2*edge;
+                }
+                if(IsOriginal(2*edge+1) && UINT_MAX == ref_of_node[target]) {
+                    ref_of_node[target] = 2*edge+1;
+                }
+            }
+        }
+        SimpleLogger().Write() << "Traffic overlay covers " << speeds.size() <<
+            " edges, " << maximum_height << " shortcut levels";
+    }
+
+    // the ref for travel from one node to another, UINT_MAX if there is none
+    unsigned FindRef(const NodeID from, const NodeID to) const {
+        unsigned ref = UINT_MAX;
+        int smallest_weight = INT_MAX;
+        for(QueryGraph::EdgeIterator edge = graph.BeginEdges(from); edge < graph.EndEdges(from); ++edge) {
+            const QueryGraph::EdgeData & data = graph.GetEdgeData(edge);
+            if(graph.GetTarget(edge) == to && data.distance < smallest_weight && data.forward) {
+                ref = 2*edge;
+                smallest_weight = data.distance;
+            }
+        }
+        if(UINT_MAX != ref) {
+            return ref;
+        }
+        for(QueryGraph::EdgeIterator edge = graph.BeginEdges(to); edge < graph.EndEdges(to); ++edge) {
+            const QueryGraph::EdgeData & data = graph.GetEdgeData(edge);
+            if(graph.GetTarget(edge) == from && data.distance < smallest_weight && data.backward) {
+                ref = 2*edge+1;
+                smallest_weight = data.distance;
+            }
+        }
+        return ref;
+    }
+
+    // shortcuts whose halves cannot be found keep their weight
+    bool HasChildren(const unsigned ref) const {
+        return UINT_MAX != children[2*ref] && UINT_MAX != children[2*ref+1];
+    }
+
+    bool IsOriginal(const unsigned ref) const {
+        const QueryGraph::EdgeData & data = graph.GetEdgeData(ref/2);
+        return INT_MAX != weights[ref] && !data.shortcut && data.id < speeds.size();
+    }
+
+    void MarkParentsDirty(const unsigned ref) {
+        for(unsigned i = parent_begin[ref]; i < parent_begin[ref+1]; ++i) {
+            const unsigned parent = parents[i];
+            if(!is_dirty[parent]) {
+                is_dirty[parent] = true;
+                dirty_refs[heights[parent]].push_back(parent);
+            }
+        }
+    }
+
+    static int ScaleWeight(const boost::uint64_t distance, const unsigned char speed) {
+        return std::max(1, (int)std::min<boost::uint64_t>(
+            TRAFFIC_MAXIMUM_WEIGHT,
+            (distance*TRAFFIC_FREE_FLOW_SPEED + speed - 1) / speed
+        ));
+    }
+
+    // the base graph of the multi-level graph consists of original edges
+    void CustomizeMultiLevelGraph() {
+        const MultiLevelGraph::BaseGraph & base_graph = multi_level_graph->GetBaseGraph();
+        std::vector<int> edge_weights(base_graph.GetNumberOfEdges());
+        for(MultiLevelGraph::BaseGraph::EdgeIterator edge = 0; edge < edge_weights.size(); ++edge) {
+            const MultiLevelGraph::BaseGraph::EdgeData & data = base_graph.GetEdgeData(edge);
+            const unsigned char speed = (data.id < speeds.size()) ? speeds[data.id] : TRAFFIC_FREE_FLOW_SPEED;
+            edge_weights[edge] = ScaleWeight(data.distance, speed);
+        }
+        multi_level_graph->Customize(edge_weights);
+    }
+
+    void ApplySpeeds(
+        std::vector<unsigned char> & new_speeds,
+        unsigned & number_of_changed_edges,
+        unsigned & number_of_reweighted_shortcuts,
+        std::vector<unsigned> & changed_refs
+    ) {
+        for(unsigned original_edge = 0; original_edge < speeds.size(); ++original_edge) {
+            if(new_speeds[original_edge] == speeds[original_edge]) {
+                continue;
+            }
+            ++number_of_changed_edges;
+            for(unsigned i = original_ref_begin[original_edge]; i < original_ref_begin[original_edge+1]; ++i) {
+                const unsigned ref = original_refs[i];
+                const int weight = ScaleWeight(graph.GetEdgeData(ref/2).distance, new_speeds[original_edge]);
+                if(weight != weights[ref]) {
+                    weights[ref] = weight;
+                    changed_refs.push_back(ref);
+                    MarkParentsDirty(ref);
+                }
+            }
+        }
+        speeds.swap(new_speeds);
+
+        //parents are higher than their children, so they come later
+        for(unsigned height = 1; height < dirty_refs.size(); ++height) {
+            for(unsigned i = 0; i < dirty_refs[height].size(); ++i) {
+                const unsigned ref = dirty_refs[height][i];
+                is_dirty[ref] = false;
+                const int weight = std::min(
+                    TRAFFIC_MAXIMUM_WEIGHT,
+                    weights[children[2*ref]] + weights[children[2*ref+1]]
+                );
+                if(weight != weights[ref]) {
+                    weights[ref] = weight;
+                    changed_refs.push_back(ref);
+                    MarkParentsDirty(ref);
+                    ++number_of_reweighted_shortcuts;
+                }
+            }
+            dirty_refs[height].clear();
+        }
+    }
+
+    bool ReadFeed(std::vector<unsigned char> & new_speeds) const {
+        new_speeds.assign(speeds.size(), TRAFFIC_FREE_FLOW_SPEED);
+        boost::filesystem::ifstream feed_stream(feed_path, std::ios::binary);
+        if(!feed_stream.good()) {
+            SimpleLogger().Write(logWARNING) << "cannot open traffic feed " << feed_path.string();
+            return false;
+        }
+        if(".csv" != boost::filesystem::extension(feed_path)) {
+            unsigned number_of_edges = 0;
+            feed_stream.read((char*)&number_of_edges, sizeof(unsigned));
+            if(number_of_edges != speeds.size()) {
+                SimpleLogger().Write(logWARNING) << "traffic feed has " <<
+                    number_of_edges << " edges instead of " << speeds.size();
+                return false;
+            }
+            feed_stream.read((char*)&new_speeds[0], number_of_edges);
+            if(!feed_stream) {
+                SimpleLogger().Write(logWARNING) << "traffic feed is truncated";
+                return false;
+            }
+            for(unsigned i = 0; i < number_of_edges; ++i) {
+                new_speeds[i] = std::max((unsigned char)1, new_speeds[i]);
+            }
+            return true;
+        }
+        std::string line;
+        unsigned number_of_invalid_lines = 0;
+        while(std::getline(feed_stream, line)) {
+            if(line.empty() || '#' == line[0]) {
+                continue;
+            }
+            char * end = NULL;
+            const unsigned long original_edge = std::strtoul(line.c_str(), &end, 10);
+            if(',' != *end || original_edge >= speeds.size()) {
+                ++number_of_invalid_lines;
+                continue;
+            }
+            const double factor = std::strtod(end+1, &end);
+            const int speed = (int)(factor*TRAFFIC_FREE_FLOW_SPEED + .5);
+            new_speeds[original_edge] = std::max(1, std::min(UCHAR_MAX, speed));
+        }
+        if(0 < number_of_invalid_lines) {
+            SimpleLogger().Write(logWARNING) << "ignored " <<
+                number_of_invalid_lines << " invalid lines of the traffic feed";
+        }
+        return true;
+    }
+
+    void Poll() {
+        try {
+            while(true) {
+                boost::this_thread::sleep(boost::posix_time::seconds(poll_interval));
+                try {
+                    Update();
+                } catch(const std::exception & e) {
+                    SimpleLogger().Write(logWARNING) << "traffic update failed: " << e.what();
+                }
+            }
+        } catch(const boost::thread_interrupted &) { }
+    }
+
+    const QueryGraph & graph;
+    MultiLevelGraph * multi_level_graph;
+    const boost::filesystem::path feed_path;
+    const unsigned poll_interval;
+    std::time_t feed_time;
+    boost::uintmax_t feed_size;
+
+    mutable boost::mutex search_graph_mutex;
+    boost::shared_ptr<const SearchGraph> search_graph;
+    bool is_reweighted;
+
+    //read by snapshots, fixed once the first re-weighted graph is published
+    std::vector<SearchGraph::EdgeIterator> edge_of_ref;
+    std::vector<unsigned> ref_of_node;
+
+    //only touched by Update()
+    boost::mutex update_mutex;
+    boost::shared_ptr<SearchGraph> buffers[2];
+    unsigned published_buffer;
+    //changes the graph that is not published has not seen yet
+    std::vector<unsigned> unpublished_refs;
+    std::vector<unsigned char> speeds;
+    std::vector<int> weights;
+    std::vector<unsigned> children;
+    std::vector<unsigned> heights;
+    std::vector<unsigned> parent_begin;
+    std::vector<unsigned> parents;
+    std::vector<unsigned> original_ref_begin;
+    std::vector<unsigned> original_refs;
+    std::vector<std::vector<unsigned> > dirty_refs;
+    std::vector<bool> is_dirty;
+
+    boost::thread poll_thread;
+};
+
+#endif /* TRAFFIC_OVERLAY_H_ */
@@ -44,10 +44,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <vector>
 
 struct _DescriptorConfig {
-    _DescriptorConfig() : instructions(true), geometry(true), encodeGeometry(true), z(18) {}
+    _DescriptorConfig() : instructions(true), geometry(true), encodeGeometry(true), trace(false), z(18) {}
     bool instructions;
     bool geometry;
     bool encodeGeometry;
+    bool trace;
     unsigned short z;
 };
 
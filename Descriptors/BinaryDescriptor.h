@@ -0,0 +1,301 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef BINARY_DESCRIPTOR_H_
+#define BINARY_DESCRIPTOR_H_
+
+#include "BaseDescriptor.h"
+#include "BinaryResponseFormat.h"
+#include "DescriptionFactory.h"
+#include "../DataStructures/SegmentInformation.h"
+#include "../DataStructures/TurnInstructions.h"
+
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+#include <vector>
+
+// Writes routes in the fixed layout described in BinaryResponseFormat.h.
+// Apart from the packed geometry everything is a plain copy of POD records.
+class BinaryDescriptor : public BaseDescriptor {
+private:
+    _DescriptorConfig config;
+    DescriptionFactory descriptionFactory;
+    std::vector<DescriptionFactory> alternativeDescriptionFactories;
+    FixedPointCoordinate current;
+    std::vector<unsigned> name_id_list;
+    std::vector<BinaryInstruction> instruction_list;
+    OutputBuffer geometry_buffer;
+
+    template<class T>
+    inline void AppendRecord(const T & record, OutputBuffer & output) const {
+        output.Append(reinterpret_cast<const char *>(&record), sizeof(T));
+    }
+
+    inline void AppendPadding(const unsigned size, OutputBuffer & output) const {
+        const char padding[4] = { 0, 0, 0, 0 };
+        output.Append(padding, BinaryPaddingBytes(size));
+    }
+
+    inline void BuildDescription(
+        DescriptionFactory & factory,
+        const std::vector<_PathData> & path,
+        const PhantomNodes & phantomNodes,
+        SearchEngine & sEngine
+    ) {
+        factory.SetStartSegment(phantomNodes.startPhantom);
+        BOOST_FOREACH(const _PathData & pathData, path) {
+            sEngine.GetCoordinatesForNodeID(pathData.node, current);
+            factory.AppendSegment(current, pathData);
+        }
+        factory.SetEndSegment(phantomNodes.targetPhantom);
+        factory.Run(sEngine, config.z);
+    }
+
+    inline void CollectNames(const DescriptionFactory & factory) {
+        if(!config.instructions) {
+            return;
+        }
+        BOOST_FOREACH(const SegmentInformation & segment, factory.pathDescription) {
+            name_id_list.push_back(segment.nameID);
+        }
+    }
+
+    inline unsigned GetNameIndex(const unsigned name_id) const {
+        return std::lower_bound(
+            name_id_list.begin(),
+            name_id_list.end(),
+            name_id
+        ) - name_id_list.begin();
+    }
+
+    // Same instruction semantics as the JSON descriptor. Returns the number
+    // of access restricted areas entered along the route.
+    inline unsigned BuildInstructions(
+        const DescriptionFactory & factory,
+        const int lengthOfRoute
+    ) {
+        instruction_list.clear();
+        unsigned numberOfEnteredRestrictedAreas = 0;
+        unsigned prefixSumOfNecessarySegments = 0;
+        unsigned leaveAtExit = 0;
+        BOOST_FOREACH(const SegmentInformation & segment, factory.pathDescription) {
+            TurnInstruction currentInstruction = segment.turnInstruction & TurnInstructions.InverseAccessRestrictionFlag;
+            numberOfEnteredRestrictedAreas += (currentInstruction != segment.turnInstruction);
+            if(!config.instructions) {
+                continue;
+            }
+            if(TurnInstructions.TurnIsNecessary(currentInstruction)) {
+                if(TurnInstructions.EnterRoundAbout != currentInstruction) {
+                    BinaryInstruction instruction;
+                    instruction.turn_instruction = currentInstruction;
+                    instruction.roundabout_exit = 0;
+                    if(TurnInstructions.LeaveRoundAbout == currentInstruction) {
+                        instruction.turn_instruction = TurnInstructions.EnterRoundAbout;
+                        instruction.roundabout_exit = leaveAtExit+1;
+                        leaveAtExit = 0;
+                    }
+                    instruction.bearing = round(segment.bearing);
+                    instruction.name = GetNameIndex(segment.nameID);
+                    instruction.length = segment.length;
+                    instruction.position = prefixSumOfNecessarySegments;
+                    instruction.duration = segment.duration/10;
+                    instruction_list.push_back(instruction);
+                }
+            } else if(TurnInstructions.StayOnRoundAbout == currentInstruction) {
+                ++leaveAtExit;
+            }
+            if(segment.necessary) {
+                ++prefixSumOfNecessarySegments;
+            }
+        }
+        if(config.instructions && INT_MAX != lengthOfRoute) {
+            BinaryInstruction instruction;
+            instruction.turn_instruction = TurnInstructions.ReachedYourDestination;
+            instruction.roundabout_exit = 0;
+            instruction.bearing = 0;
+            instruction.name = GetNameIndex(UINT_MAX);
+            instruction.length = 0;
+            instruction.position = prefixSumOfNecessarySegments-1;
+            instruction.duration = 0;
+            instruction_list.push_back(instruction);
+        }
+        return numberOfEnteredRestrictedAreas;
+    }
+
+    inline unsigned BuildGeometry(const DescriptionFactory & factory) {
+        geometry_buffer.Clear();
+        if(!config.geometry || factory.pathDescription.empty()) {
+            return 0;
+        }
+        FixedPointCoordinate lastCoordinate = factory.pathDescription[0].location;
+        AppendBinaryVarint(lastCoordinate.lat, geometry_buffer);
+        AppendBinaryVarint(lastCoordinate.lon, geometry_buffer);
+        unsigned number_of_coordinates = 1;
+        for(unsigned i = 1; i < factory.pathDescription.size(); ++i) {
+            const SegmentInformation & segment = factory.pathDescription[i];
+            if(!segment.necessary) {
+                continue;
+            }
+            AppendBinaryVarint(segment.location.lat - lastCoordinate.lat, geometry_buffer);
+            AppendBinaryVarint(segment.location.lon - lastCoordinate.lon, geometry_buffer);
+            lastCoordinate = segment.location;
+            ++number_of_coordinates;
+        }
+        return number_of_coordinates;
+    }
+
+    inline void AppendRoute(
+        DescriptionFactory & factory,
+        const int lengthOfRoute,
+        OutputBuffer & output
+    ) {
+        const unsigned numberOfEnteredRestrictedAreas = BuildInstructions(factory, lengthOfRoute);
+        const int duration = lengthOfRoute - numberOfEnteredRestrictedAreas*TurnInstructions.AccessRestrictionPenalty;
+        factory.BuildRouteSummary(factory.entireLength, duration);
+
+        BinaryRoute route;
+        route.total_distance = round(factory.entireLength);
+        route.total_time = duration/10 + 1;
+        route.start_name = GetNameIndex(factory.summary.startName);
+        route.end_name = GetNameIndex(factory.summary.destName);
+        route.number_of_instructions = instruction_list.size();
+        route.number_of_coordinates = BuildGeometry(factory);
+        route.geometry_bytes = geometry_buffer.size();
+        route.reserved = 0;
+        AppendRecord(route, output);
+        if(!instruction_list.empty()) {
+            output.Append(
+                reinterpret_cast<const char *>(&instruction_list[0]),
+                instruction_list.size()*sizeof(BinaryInstruction)
+            );
+        }
+        for(unsigned i = 0; i < geometry_buffer.GetNumberOfChunks(); ++i) {
+            std::size_t length;
+            const char * chunk = geometry_buffer.GetChunk(i, length);
+            output.Append(chunk, length);
+        }
+        AppendPadding(route.geometry_bytes, output);
+    }
+
+public:
+    void SetConfig(const _DescriptorConfig & c) { config = c; }
+
+    void Run(http::Reply & reply, const RawRouteData &rawRoute, PhantomNodes &phantomNodes, SearchEngine &sEngine) {
+        OutputBuffer & output = reply.chunked_content;
+        const bool found_route = (INT_MAX != rawRoute.lengthOfShortestPath);
+        const unsigned number_of_alternatives = rawRoute.computedAlternativePaths.size();
+
+        //route summaries name the streets of the start and target phantoms
+        name_id_list.push_back(phantomNodes.startPhantom.nodeBasedEdgeNameID);
+        name_id_list.push_back(phantomNodes.targetPhantom.nodeBasedEdgeNameID);
+        name_id_list.push_back(UINT_MAX);
+        if(found_route) {
+            BuildDescription(descriptionFactory, rawRoute.computedShortestPath, phantomNodes, sEngine);
+            CollectNames(descriptionFactory);
+        }
+        alternativeDescriptionFactories.resize(number_of_alternatives);
+        for(unsigned i = 0; i < number_of_alternatives; ++i) {
+            BuildDescription(alternativeDescriptionFactories[i], rawRoute.computedAlternativePaths[i].path, phantomNodes, sEngine);
+            CollectNames(alternativeDescriptionFactories[i]);
+        }
+        std::sort(name_id_list.begin(), name_id_list.end());
+        name_id_list.erase(
+            std::unique(name_id_list.begin(), name_id_list.end()),
+            name_id_list.end()
+        );
+
+        BinaryResponseHeader header;
+        std::copy(BINARY_RESPONSE_MAGIC, BINARY_RESPONSE_MAGIC+4, header.magic);
+        header.version = BINARY_RESPONSE_VERSION;
+        header.type = BINARY_ROUTE_RESPONSE;
+        header.status = (found_route ? 0 : 207);
+        header.check_sum = rawRoute.checkSum;
+        AppendRecord(header, output);
+
+        const char * name;
+        unsigned name_length;
+        unsigned name_bytes = 0;
+        BOOST_FOREACH(const unsigned name_id, name_id_list) {
+            sEngine.GetNameForNameID(name_id, name, name_length);
+            name_bytes += name_length;
+        }
+
+        BinaryRouteResponse route_response;
+        route_response.number_of_routes = (found_route ? 1 : 0) + number_of_alternatives;
+        route_response.number_of_via_points = rawRoute.segmentEndCoordinates.size()+1;
+        route_response.hint_size = sizeof(PhantomNode);
+        route_response.number_of_names = name_id_list.size();
+        route_response.name_bytes = name_bytes;
+        route_response.reserved = 0;
+        AppendRecord(route_response, output);
+
+        for(unsigned i = 0; i < route_response.number_of_via_points; ++i) {
+            FixedPointCoordinate location;
+            if(i+1 < route_response.number_of_via_points) {
+                location = rawRoute.segmentEndCoordinates[i].startPhantom.location;
+            } else {
+                location = rawRoute.segmentEndCoordinates.back().targetPhantom.location;
+            }
+            if(!location.isSet()) {
+                location = rawRoute.rawViaNodeCoordinates[i];
+            }
+            BinaryCoordinate via_point;
+            via_point.lat = location.lat;
+            via_point.lon = location.lon;
+            AppendRecord(via_point, output);
+        }
+        for(unsigned i = 0; i < rawRoute.segmentEndCoordinates.size(); ++i) {
+            AppendRecord(rawRoute.segmentEndCoordinates[i].startPhantom, output);
+        }
+        AppendRecord(rawRoute.segmentEndCoordinates.back().targetPhantom, output);
+        AppendPadding(route_response.number_of_via_points*sizeof(PhantomNode), output);
+
+        if(found_route) {
+            AppendRoute(descriptionFactory, rawRoute.lengthOfShortestPath, output);
+        }
+        for(unsigned i = 0; i < number_of_alternatives; ++i) {
+            AppendRoute(alternativeDescriptionFactories[i], rawRoute.computedAlternativePaths[i].length, output);
+        }
+
+        unsigned name_offset = 0;
+        BOOST_FOREACH(const unsigned name_id, name_id_list) {
+            AppendRecord(name_offset, output);
+            sEngine.GetNameForNameID(name_id, name, name_length);
+            name_offset += name_length;
+        }
+        AppendRecord(name_offset, output);
+        BOOST_FOREACH(const unsigned name_id, name_id_list) {
+            sEngine.GetNameForNameID(name_id, name, name_length);
+            output.Append(name, name_length);
+        }
+        AppendPadding(name_bytes, output);
+    }
+};
+
+#endif /* BINARY_DESCRIPTOR_H_ */
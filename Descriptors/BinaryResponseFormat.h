@@ -0,0 +1,186 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef BINARY_RESPONSE_FORMAT_H_
+#define BINARY_RESPONSE_FORMAT_H_
+
+#include "../DataStructures/Coordinate.h"
+
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+
+#include <cstring>
+
+#include <vector>
+
+// Layout of output=binary responses. All values are in host byte order,
+// which is little endian on every platform OSRM runs on.
+//
+// viaroute:
+//   BinaryResponseHeader | BinaryRouteResponse
+//   | BinaryCoordinate[number_of_via_points]
+//   | hint_size bytes per via point (a PhantomNode, base64 it for &hint=)
+//   | per route: BinaryRoute | BinaryInstruction[number_of_instructions]
+//                | geometry_bytes of packed geometry
+//   | unsigned name_offsets[number_of_names+1] | name_bytes of UTF-8 names
+//
+// nearest:
+//   BinaryResponseHeader | BinaryNearest | name_length bytes of UTF-8 name
+//
+// The first route is the shortest one, alternatives follow in rank order.
+// Geometry is packed as zig-zag varints, starting with the absolute
+// coordinate of the first point followed by lat/lon deltas. Name fields
+// are indices into the name table of the response, the first entry of
+// which is the empty name. Every block is padded to a multiple of 4 bytes.
+
+static const char BINARY_RESPONSE_MAGIC[4] = { 'O', 'S', 'R', 'B' };
+static const unsigned short BINARY_RESPONSE_VERSION = 1;
+
+enum BinaryResponseType {
+    BINARY_ROUTE_RESPONSE = 1,
+    BINARY_NEAREST_RESPONSE = 2
+};
+
+struct BinaryResponseHeader {
+    char magic[4];
+    unsigned short version;
+    unsigned short type;
+    int status;
+    unsigned check_sum;
+};
+
+struct BinaryCoordinate {
+    int lat;
+    int lon;
+};
+
+struct BinaryRouteResponse {
+    unsigned number_of_routes;
+    unsigned number_of_via_points;
+    unsigned hint_size;
+    unsigned number_of_names;
+    unsigned name_bytes;
+    unsigned reserved;
+};
+
+struct BinaryRoute {
+    int total_distance;
+    int total_time;
+    unsigned start_name;
+    unsigned end_name;
+    unsigned number_of_instructions;
+    unsigned number_of_coordinates;
+    unsigned geometry_bytes;
+    unsigned reserved;
+};
+
+struct BinaryInstruction {
+    unsigned char turn_instruction;
+    unsigned char roundabout_exit;
+    unsigned short bearing;
+    unsigned name;
+    int length;
+    unsigned position;
+    int duration;
+};
+
+struct BinaryNearest {
+    BinaryCoordinate mapped_coordinate;
+    unsigned name_length;
+    unsigned reserved;
+};
+
+BOOST_STATIC_ASSERT(sizeof(BinaryResponseHeader) == 16);
+BOOST_STATIC_ASSERT(sizeof(BinaryCoordinate) == 8);
+BOOST_STATIC_ASSERT(sizeof(BinaryRouteResponse) == 24);
+BOOST_STATIC_ASSERT(sizeof(BinaryRoute) == 32);
+BOOST_STATIC_ASSERT(sizeof(BinaryInstruction) == 20);
+BOOST_STATIC_ASSERT(sizeof(BinaryNearest) == 16);
+
+inline unsigned BinaryPaddingBytes(const unsigned size) {
+    return (4 - (size & 3)) & 3;
+}
+
+template<class OutputT>
+inline void AppendBinaryVarint(const int value, OutputT & output) {
+    unsigned zig_zag = (static_cast<unsigned>(value) << 1) ^ static_cast<unsigned>(value >> 31);
+    char buffer[5];
+    unsigned length = 0;
+    while(zig_zag >= 0x80) {
+        buffer[length++] = static_cast<char>(zig_zag | 0x80);
+        zig_zag >>= 7;
+    }
+    buffer[length++] = static_cast<char>(zig_zag);
+    output.Append(buffer, length);
+}
+
+// returns false on truncated input
+inline bool ReadBinaryVarint(
+    const unsigned char *& position,
+    const unsigned char * end,
+    int & value
+) {
+    unsigned zig_zag = 0;
+    for(unsigned shift = 0; shift < 35; shift += 7) {
+        if(position == end) {
+            return false;
+        }
+        const unsigned char byte = *position++;
+        zig_zag |= static_cast<unsigned>(byte & 0x7f) << shift;
+        if(0 == (byte & 0x80)) {
+            value = static_cast<int>(zig_zag >> 1) ^ -static_cast<int>(zig_zag & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool DecodeBinaryGeometry(
+    const unsigned char * position,
+    const unsigned char * end,
+    const unsigned number_of_coordinates,
+    std::vector<FixedPointCoordinate> & geometry
+) {
+    geometry.resize(number_of_coordinates);
+    int lat = 0, lon = 0;
+    for(unsigned i = 0; i < number_of_coordinates; ++i) {
+        int delta_lat, delta_lon;
+        if(
+            !ReadBinaryVarint(position, end, delta_lat) ||
+            !ReadBinaryVarint(position, end, delta_lon)
+        ) {
+            return false;
+        }
+        lat += delta_lat;
+        lon += delta_lon;
+        geometry[i] = FixedPointCoordinate(lat, lon);
+    }
+    return true;
+}
+
+#endif /* BINARY_RESPONSE_FORMAT_H_ */
@@ -77,7 +77,7 @@ void DescriptionFactory::AppendSegment(const FixedPointCoordinate & coordinate,
     }
 }
 
-void DescriptionFactory::AppendEncodedPolylineString(std::string & output, bool isEncoded) {
+void DescriptionFactory::AppendEncodedPolylineString(OutputBuffer & output, bool isEncoded) {
     if(isEncoded)
         pc.printEncodedString(pathDescription, output);
     else
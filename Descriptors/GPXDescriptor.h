@@ -37,37 +37,34 @@ private:
     _DescriptorConfig config;
     FixedPointCoordinate current;
 
-    std::string tmp;
+    inline void AppendRoutePoint(const FixedPointCoordinate & coordinate, OutputBuffer & output) {
+        output += "<rtept lat=\"";
+        output.AppendCoordinate(coordinate.lat);
+        output += "\" lon=\"";
+        output.AppendCoordinate(coordinate.lon);
+        output += "\"></rtept>";
+    }
+
 public:
     void SetConfig(const _DescriptorConfig& c) { config = c; }
     void Run(http::Reply & reply, const RawRouteData &rawRoute, PhantomNodes &phantomNodes, SearchEngine &sEngine) {
-        reply.content += ("<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
-        reply.content += "<gpx creator=\"OSRM Routing Engine\" version=\"1.1\" xmlns=\"http://www.topografix.com/GPX/1/1\" "
+        reply.chunked_content += ("<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
+        reply.chunked_content += "<gpx creator=\"OSRM Routing Engine\" version=\"1.1\" xmlns=\"http://www.topografix.com/GPX/1/1\" "
                 "xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
                 "xsi:schemaLocation=\"http://www.topografix.com/GPX/1/1 gpx.xsd"
                 "\">";
-        reply.content += "<metadata><copyright author=\"Project OSRM\"><license>Data (c) OpenStreetMap contributors (ODbL)</license></copyright></metadata>";
-        reply.content += "<rte>";
+        reply.chunked_content += "<metadata><copyright author=\"Project OSRM\"><license>Data (c) OpenStreetMap contributors (ODbL)</license></copyright></metadata>";
+        reply.chunked_content += "<rte>";
         if(rawRoute.lengthOfShortestPath != INT_MAX && rawRoute.computedShortestPath.size()) {
-            convertInternalLatLonToString(phantomNodes.startPhantom.location.lat, tmp);
-            reply.content += "<rtept lat=\"" + tmp + "\" ";
-            convertInternalLatLonToString(phantomNodes.startPhantom.location.lon, tmp);
-            reply.content += "lon=\"" + tmp + "\"></rtept>";
+            AppendRoutePoint(phantomNodes.startPhantom.location, reply.chunked_content);
 
             BOOST_FOREACH(const _PathData & pathData, rawRoute.computedShortestPath) {
                 sEngine.GetCoordinatesForNodeID(pathData.node, current);
-
-                convertInternalLatLonToString(current.lat, tmp);
-                reply.content += "<rtept lat=\"" + tmp + "\" ";
-                convertInternalLatLonToString(current.lon, tmp);
-                reply.content += "lon=\"" + tmp + "\"></rtept>";
+                AppendRoutePoint(current, reply.chunked_content);
             }
-            convertInternalLatLonToString(phantomNodes.targetPhantom.location.lat, tmp);
-            reply.content += "<rtept lat=\"" + tmp + "\" ";
-            convertInternalLatLonToString(phantomNodes.targetPhantom.location.lon, tmp);
-            reply.content += "lon=\"" + tmp + "\"></rtept>";
+            AppendRoutePoint(phantomNodes.targetPhantom.location, reply.chunked_content);
         }
-        reply.content += "</rte></gpx>";
+        reply.chunked_content += "</rte></gpx>";
     }
 };
 #endif /* GPX_DESCRIPTOR_H_ */
@@ -34,18 +34,20 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../DataStructures/SegmentInformation.h"
 #include "../DataStructures/TurnInstructions.h"
 #include "../Util/Azimuth.h"
+#include "../Util/QueryMetrics.h"
 #include "../Util/StringUtil.h"
 
 #include <boost/bind.hpp>
 #include <boost/lambda/lambda.hpp>
 
 #include <algorithm>
+#include <vector>
 
 class JSONDescriptor : public BaseDescriptor{
 private:
     _DescriptorConfig config;
     DescriptionFactory descriptionFactory;
-    DescriptionFactory alternateDescriptionFactory;
+    std::vector<DescriptionFactory> alternativeDescriptionFactories;
     FixedPointCoordinate current;
     unsigned numberOfEnteredRestrictedAreas;
     struct RoundAbout{
@@ -66,13 +68,20 @@ private:
         int length;
         int position;
     };
-    std::vector<Segment> shortestSegments, alternativeSegments;
+    std::vector<Segment> shortestSegments;
+    std::vector<std::vector<Segment> > alternativeSegments;
 
     struct RouteNames {
-        std::string shortestPathName1;
-        std::string shortestPathName2;
-        std::string alternativePathName1;
-        std::string alternativePathName2;
+        RouteNames() :
+            shortestPathName1(UINT_MAX),
+            shortestPathName2(UINT_MAX),
+            alternativePathName1(UINT_MAX),
+            alternativePathName2(UINT_MAX)
+        {}
+        unsigned shortestPathName1;
+        unsigned shortestPathName2;
+        unsigned alternativePathName1;
+        unsigned alternativePathName2;
     };
 
 public:
@@ -81,11 +90,11 @@ public:
 
     void Run(http::Reply & reply, const RawRouteData &rawRoute, PhantomNodes &phantomNodes, SearchEngine &sEngine) {
 
-        WriteHeaderToOutput(reply.content);
+        WriteHeaderToOutput(reply.chunked_content);
 
         if(rawRoute.lengthOfShortestPath != INT_MAX) {
             descriptionFactory.SetStartSegment(phantomNodes.startPhantom);
-            reply.content += "0,"
+            reply.chunked_content += "0,"
                     "\"status_message\": \"Found route between points\",";
 
             //Get all the coordinates for the computed route
@@ -96,19 +105,19 @@ public:
             descriptionFactory.SetEndSegment(phantomNodes.targetPhantom);
         } else {
             //We do not need to do much, if there is no route ;-)
-            reply.content += "207,"
+            reply.chunked_content += "207,"
                     "\"status_message\": \"Cannot find route between points\",";
         }
 
         descriptionFactory.Run(sEngine, config.z);
-        reply.content += "\"route_geometry\": ";
+        reply.chunked_content += "\"route_geometry\": ";
         if(config.geometry) {
-            descriptionFactory.AppendEncodedPolylineString(reply.content, config.encodeGeometry);
+            descriptionFactory.AppendEncodedPolylineString(reply.chunked_content, config.encodeGeometry);
         } else {
-            reply.content += "[]";
+            reply.chunked_content += "[]";
         }
 
-        reply.content += ","
+        reply.chunked_content += ","
                 "\"route_instructions\": [";
         numberOfEnteredRestrictedAreas = 0;
         if(config.instructions) {
@@ -119,142 +128,187 @@ public:
                 numberOfEnteredRestrictedAreas += (currentInstruction != segment.turnInstruction);
             }
         }
-        reply.content += "],";
+        reply.chunked_content += "],";
         descriptionFactory.BuildRouteSummary(descriptionFactory.entireLength, rawRoute.lengthOfShortestPath - ( numberOfEnteredRestrictedAreas*TurnInstructions.AccessRestrictionPenalty));
 
-        reply.content += "\"route_summary\":";
-        reply.content += "{";
-        reply.content += "\"total_distance\":";
-        reply.content += descriptionFactory.summary.lengthString;
-        reply.content += ","
+        reply.chunked_content += "\"route_summary\":";
+        reply.chunked_content += "{";
+        reply.chunked_content += "\"total_distance\":";
+        reply.chunked_content += descriptionFactory.summary.lengthString;
+        reply.chunked_content += ","
                 "\"total_time\":";
-        reply.content += descriptionFactory.summary.durationString;
-        reply.content += ","
+        reply.chunked_content += descriptionFactory.summary.durationString;
+        reply.chunked_content += ","
                 "\"start_point\":\"";
-        reply.content += sEngine.GetEscapedNameForNameID(descriptionFactory.summary.startName);
-        reply.content += "\","
+        sEngine.AppendEscapedNameForNameID(descriptionFactory.summary.startName, reply.chunked_content);
+        reply.chunked_content += "\","
                 "\"end_point\":\"";
-        reply.content += sEngine.GetEscapedNameForNameID(descriptionFactory.summary.destName);
-        reply.content += "\"";
-        reply.content += "}";
-        reply.content +=",";
-
-        //only one alternative route is computed at this time, so this is hardcoded
-
-        if(rawRoute.lengthOfAlternativePath != INT_MAX) {
+        sEngine.AppendEscapedNameForNameID(descriptionFactory.summary.destName, reply.chunked_content);
+        reply.chunked_content += "\"";
+        reply.chunked_content += "}";
+        reply.chunked_content +=",";
+
+        const unsigned numberOfAlternatives = rawRoute.computedAlternativePaths.size();
+        alternativeDescriptionFactories.resize(numberOfAlternatives);
+        alternativeSegments.resize(numberOfAlternatives);
+        for(unsigned i = 0; i < numberOfAlternatives; ++i) {
+            DescriptionFactory & alternateDescriptionFactory = alternativeDescriptionFactories[i];
             alternateDescriptionFactory.SetStartSegment(phantomNodes.startPhantom);
             //Get all the coordinates for the computed route
-            BOOST_FOREACH(const _PathData & pathData, rawRoute.computedAlternativePath) {
+            BOOST_FOREACH(const _PathData & pathData, rawRoute.computedAlternativePaths[i].path) {
                 sEngine.GetCoordinatesForNodeID(pathData.node, current);
                 alternateDescriptionFactory.AppendSegment(current, pathData );
             }
             alternateDescriptionFactory.SetEndSegment(phantomNodes.targetPhantom);
+            alternateDescriptionFactory.Run(sEngine, config.z);
         }
-        alternateDescriptionFactory.Run(sEngine, config.z);
 
         //give an array of alternative routes
-        reply.content += "\"alternative_geometries\": [";
-        if(config.geometry && INT_MAX != rawRoute.lengthOfAlternativePath) {
+        reply.chunked_content += "\"alternative_geometries\": [";
+        if(config.geometry) {
             //Generate the linestrings for each alternative
-            alternateDescriptionFactory.AppendEncodedPolylineString(reply.content, config.encodeGeometry);
+            for(unsigned i = 0; i < numberOfAlternatives; ++i) {
+                if(0 < i) {
+                    reply.chunked_content += ",";
+                }
+                alternativeDescriptionFactories[i].AppendEncodedPolylineString(reply.chunked_content, config.encodeGeometry);
+            }
         }
-        reply.content += "],";
-        reply.content += "\"alternative_instructions\":[";
-        numberOfEnteredRestrictedAreas = 0;
-        if(INT_MAX != rawRoute.lengthOfAlternativePath) {
-            reply.content += "[";
+        reply.chunked_content += "],";
+        reply.chunked_content += "\"alternative_instructions\":[";
+        std::vector<unsigned> enteredRestrictedAreas(numberOfAlternatives, 0);
+        for(unsigned i = 0; i < numberOfAlternatives; ++i) {
+            if(0 < i) {
+                reply.chunked_content += ",";
+            }
+            reply.chunked_content += "[";
+            numberOfEnteredRestrictedAreas = 0;
             //Generate instructions for each alternative
             if(config.instructions) {
-                BuildTextualDescription(alternateDescriptionFactory, reply, rawRoute.lengthOfAlternativePath, sEngine, alternativeSegments);
+                BuildTextualDescription(alternativeDescriptionFactories[i], reply, rawRoute.computedAlternativePaths[i].length, sEngine, alternativeSegments[i]);
             } else {
-                BOOST_FOREACH(const SegmentInformation & segment, alternateDescriptionFactory.pathDescription) {
+                BOOST_FOREACH(const SegmentInformation & segment, alternativeDescriptionFactories[i].pathDescription) {
                 	TurnInstruction currentInstruction = segment.turnInstruction & TurnInstructions.InverseAccessRestrictionFlag;
                     numberOfEnteredRestrictedAreas += (currentInstruction != segment.turnInstruction);
                 }
             }
-            reply.content += "]";
+            enteredRestrictedAreas[i] = numberOfEnteredRestrictedAreas;
+            reply.chunked_content += "]";
         }
-        reply.content += "],";
-        reply.content += "\"alternative_summaries\":[";
-        if(INT_MAX != rawRoute.lengthOfAlternativePath) {
+        reply.chunked_content += "],";
+        reply.chunked_content += "\"alternative_summaries\":[";
+        for(unsigned i = 0; i < numberOfAlternatives; ++i) {
+            DescriptionFactory & alternateDescriptionFactory = alternativeDescriptionFactories[i];
             //Generate route summary (length, duration) for each alternative
-            alternateDescriptionFactory.BuildRouteSummary(alternateDescriptionFactory.entireLength, rawRoute.lengthOfAlternativePath - ( numberOfEnteredRestrictedAreas*TurnInstructions.AccessRestrictionPenalty));
-            reply.content += "{";
-            reply.content += "\"total_distance\":";
-            reply.content += alternateDescriptionFactory.summary.lengthString;
-            reply.content += ","
+            alternateDescriptionFactory.BuildRouteSummary(alternateDescriptionFactory.entireLength, rawRoute.computedAlternativePaths[i].length - ( enteredRestrictedAreas[i]*TurnInstructions.AccessRestrictionPenalty));
+            if(0 < i) {
+                reply.chunked_content += ",";
+            }
+            reply.chunked_content += "{";
+            reply.chunked_content += "\"total_distance\":";
+            reply.chunked_content += alternateDescriptionFactory.summary.lengthString;
+            reply.chunked_content += ","
                     "\"total_time\":";
-            reply.content += alternateDescriptionFactory.summary.durationString;
-            reply.content += ","
+            reply.chunked_content += alternateDescriptionFactory.summary.durationString;
+            reply.chunked_content += ","
                     "\"start_point\":\"";
-            reply.content += sEngine.GetEscapedNameForNameID(descriptionFactory.summary.startName);
-            reply.content += "\","
+            sEngine.AppendEscapedNameForNameID(descriptionFactory.summary.startName, reply.chunked_content);
+            reply.chunked_content += "\","
                     "\"end_point\":\"";
-            reply.content += sEngine.GetEscapedNameForNameID(descriptionFactory.summary.destName);
-            reply.content += "\"";
-            reply.content += "}";
+            sEngine.AppendEscapedNameForNameID(descriptionFactory.summary.destName, reply.chunked_content);
+            reply.chunked_content += "\"";
+            reply.chunked_content += "}";
         }
-        reply.content += "],";
+        reply.chunked_content += "],";
+
+        //stretch and sharing are relative to the length of the shortest path
+        reply.chunked_content += "\"alternative_metrics\":[";
+        for(unsigned i = 0; i < numberOfAlternatives; ++i) {
+            std::string stretch, sharing;
+            doubleToStringWithTwoDigitsBehindComma(rawRoute.computedAlternativePaths[i].length/static_cast<double>(rawRoute.lengthOfShortestPath), stretch);
+            doubleToStringWithTwoDigitsBehindComma(rawRoute.computedAlternativePaths[i].sharing/static_cast<double>(rawRoute.lengthOfShortestPath), sharing);
+            if(0 < i) {
+                reply.chunked_content += ",";
+            }
+            reply.chunked_content += "{\"stretch\":";
+            reply.chunked_content += stretch;
+            reply.chunked_content += ",\"sharing\":";
+            reply.chunked_content += sharing;
+            reply.chunked_content += "}";
+        }
+        reply.chunked_content += "],";
 
-        //Get Names for both routes
+        //Get Names for the shortest route and each alternative
         RouteNames routeNames;
-        GetRouteNames(shortestSegments, alternativeSegments, sEngine, routeNames);
-
-        reply.content += "\"route_name\":[\"";
-        reply.content += routeNames.shortestPathName1;
-        reply.content += "\",\"";
-        reply.content += routeNames.shortestPathName2;
-        reply.content += "\"],"
+        std::vector<Segment> noSegments;
+        GetRouteNames(shortestSegments, (0 < numberOfAlternatives ? alternativeSegments[0] : noSegments), sEngine, routeNames);
+
+        reply.chunked_content += "\"route_name\":[\"";
+        sEngine.AppendEscapedNameForNameID(routeNames.shortestPathName1, reply.chunked_content);
+        reply.chunked_content += "\",\"";
+        sEngine.AppendEscapedNameForNameID(routeNames.shortestPathName2, reply.chunked_content);
+        reply.chunked_content += "\"],"
                 "\"alternative_names\":[";
-        reply.content += "[\"";
-        reply.content += routeNames.alternativePathName1;
-        reply.content += "\",\"";
-        reply.content += routeNames.alternativePathName2;
-        reply.content += "\"]";
-        reply.content += "],";
+        //a pair of empty names is given if there is no alternative
+        for(unsigned i = 0; i < std::max(1u, numberOfAlternatives); ++i) {
+            RouteNames alternativeRouteNames = routeNames;
+            if(0 < i) {
+                alternativeRouteNames = RouteNames();
+                GetRouteNames(shortestSegments, alternativeSegments[i], sEngine, alternativeRouteNames);
+                reply.chunked_content += ",";
+            }
+            reply.chunked_content += "[\"";
+            sEngine.AppendEscapedNameForNameID(alternativeRouteNames.alternativePathName1, reply.chunked_content);
+            reply.chunked_content += "\",\"";
+            sEngine.AppendEscapedNameForNameID(alternativeRouteNames.alternativePathName2, reply.chunked_content);
+            reply.chunked_content += "\"]";
+        }
+        reply.chunked_content += "],";
         //list all viapoints so that the client may display it
-        reply.content += "\"via_points\":[";
-        std::string tmp;
+        reply.chunked_content += "\"via_points\":[";
         if(config.geometry && INT_MAX != rawRoute.lengthOfShortestPath) {
             for(unsigned i = 0; i < rawRoute.segmentEndCoordinates.size(); ++i) {
-                reply.content += "[";
+                reply.chunked_content += "[";
                 if(rawRoute.segmentEndCoordinates[i].startPhantom.location.isSet())
-                    convertInternalReversedCoordinateToString(rawRoute.segmentEndCoordinates[i].startPhantom.location, tmp);
+                    AppendReversedCoordinate(rawRoute.segmentEndCoordinates[i].startPhantom.location, reply.chunked_content);
                 else
-                    convertInternalReversedCoordinateToString(rawRoute.rawViaNodeCoordinates[i], tmp);
+                    AppendReversedCoordinate(rawRoute.rawViaNodeCoordinates[i], reply.chunked_content);
 
-                reply.content += tmp;
-                reply.content += "],";
+                reply.chunked_content += "],";
             }
-            reply.content += "[";
+            reply.chunked_content += "[";
             if(rawRoute.segmentEndCoordinates.back().startPhantom.location.isSet())
-                convertInternalReversedCoordinateToString(rawRoute.segmentEndCoordinates.back().targetPhantom.location, tmp);
+                AppendReversedCoordinate(rawRoute.segmentEndCoordinates.back().targetPhantom.location, reply.chunked_content);
             else
-                convertInternalReversedCoordinateToString(rawRoute.rawViaNodeCoordinates.back(), tmp);
-            reply.content += tmp;
-            reply.content += "]";
+                AppendReversedCoordinate(rawRoute.rawViaNodeCoordinates.back(), reply.chunked_content);
+            reply.chunked_content += "]";
         }
-        reply.content += "],";
-        reply.content += "\"hint_data\": {";
-        reply.content += "\"checksum\":";
-        intToString(rawRoute.checkSum, tmp);
-        reply.content += tmp;
-        reply.content += ", \"locations\": [";
+        reply.chunked_content += "],";
+        reply.chunked_content += "\"hint_data\": {";
+        reply.chunked_content += "\"checksum\":";
+        reply.chunked_content.AppendInt(rawRoute.checkSum);
+        reply.chunked_content += ", \"locations\": [";
 
         std::string hint;
         for(unsigned i = 0; i < rawRoute.segmentEndCoordinates.size(); ++i) {
-            reply.content += "\"";
+            reply.chunked_content += "\"";
             EncodeObjectToBase64(rawRoute.segmentEndCoordinates[i].startPhantom, hint);
-            reply.content += hint;
-            reply.content += "\", ";
+            reply.chunked_content += hint;
+            reply.chunked_content += "\", ";
         }
         EncodeObjectToBase64(rawRoute.segmentEndCoordinates.back().targetPhantom, hint);
-        reply.content += "\"";
-        reply.content += hint;
-        reply.content += "\"]";
-        reply.content += "},";
-        reply.content += "\"transactionId\": \"OSRM Routing Engine JSON Descriptor (v0.3)\"";
-        reply.content += "}";
+        reply.chunked_content += "\"";
+        reply.chunked_content += hint;
+        reply.chunked_content += "\"]";
+        reply.chunked_content += "},";
+        reply.chunked_content += "\"transactionId\": \"OSRM Routing Engine JSON Descriptor (v0.3)\"";
+        if(config.trace) {
+            std::string trace;
+            QueryMetrics::AppendTraceAsJSON(trace);
+            reply.chunked_content += ",\"trace\":";
+            reply.chunked_content += trace;
+        }
+        reply.chunked_content += "}";
     }
 
     void GetRouteNames(std::vector<Segment> & shortestSegments, std::vector<Segment> & alternativeSegments, const SearchEngine &sEngine, RouteNames & routeNames) {
@@ -301,15 +355,22 @@ public:
             if(alternativeSegment1.position >  alternativeSegment2.position)
                 std::swap(alternativeSegment1, alternativeSegment2);
 
-            routeNames.shortestPathName1 = sEngine.GetEscapedNameForNameID(shortestSegment1.nameID);
-            routeNames.shortestPathName2 = sEngine.GetEscapedNameForNameID(shortestSegment2.nameID);
+            routeNames.shortestPathName1 = shortestSegment1.nameID;
+            routeNames.shortestPathName2 = shortestSegment2.nameID;
 
-            routeNames.alternativePathName1 = sEngine.GetEscapedNameForNameID(alternativeSegment1.nameID);
-            routeNames.alternativePathName2 = sEngine.GetEscapedNameForNameID(alternativeSegment2.nameID);
+            routeNames.alternativePathName1 = alternativeSegment1.nameID;
+            routeNames.alternativePathName2 = alternativeSegment2.nameID;
         }
     }
 
-    inline void WriteHeaderToOutput(std::string & output) {
+    inline void AppendReversedCoordinate(const FixedPointCoordinate & coordinate, OutputBuffer & output) {
+        output.AppendCoordinate(coordinate.lat);
+        output += ",";
+        output.AppendCoordinate(coordinate.lon);
+        output += " ";
+    }
+
+    inline void WriteHeaderToOutput(OutputBuffer & output) {
         output += "{"
                 "\"version\": 0.3,"
                 "\"status\":";
@@ -323,7 +384,7 @@ public:
         unsigned prefixSumOfNecessarySegments = 0;
         roundAbout.leaveAtExit = 0;
         roundAbout.nameID = 0;
-        std::string tmpDist, tmpLength, tmpDuration, tmpBearing, tmpInstruction;
+
         //Fetch data from Factory and generate a string from it.
         BOOST_FOREACH(const SegmentInformation & segment, descriptionFactory.pathDescription) {
         	TurnInstruction currentInstruction = segment.turnInstruction & TurnInstructions.InverseAccessRestrictionFlag;
@@ -334,42 +395,34 @@ public:
                     roundAbout.startIndex = prefixSumOfNecessarySegments;
                 } else {
                     if(0 != prefixSumOfNecessarySegments){
-                        reply.content += ",";
+                        reply.chunked_content += ",";
                     }
-                    reply.content += "[\"";
+                    reply.chunked_content += "[\"";
                     if(TurnInstructions.LeaveRoundAbout == currentInstruction) {
-                        intToString(TurnInstructions.EnterRoundAbout, tmpInstruction);
-                        reply.content += tmpInstruction;
-                        reply.content += "-";
-                        intToString(roundAbout.leaveAtExit+1, tmpInstruction);
-                        reply.content += tmpInstruction;
+                        reply.chunked_content.AppendInt(TurnInstructions.EnterRoundAbout);
+                        reply.chunked_content += "-";
+                        reply.chunked_content.AppendInt(roundAbout.leaveAtExit+1);
                         roundAbout.leaveAtExit = 0;
                     } else {
-                        intToString(currentInstruction, tmpInstruction);
-                        reply.content += tmpInstruction;
+                        reply.chunked_content.AppendInt(currentInstruction);
                     }
 
 
-                    reply.content += "\",\"";
-                    reply.content += sEngine.GetEscapedNameForNameID(segment.nameID);
-                    reply.content += "\",";
-                    intToString(segment.length, tmpDist);
-                    reply.content += tmpDist;
-                    reply.content += ",";
-                    intToString(prefixSumOfNecessarySegments, tmpLength);
-                    reply.content += tmpLength;
-                    reply.content += ",";
-                    intToString(segment.duration/10, tmpDuration);
-                    reply.content += tmpDuration;
-                    reply.content += ",\"";
-                    intToString(segment.length, tmpLength);
-                    reply.content += tmpLength;
-                    reply.content += "m\",\"";
-                    reply.content += Azimuth::Get(segment.bearing);
-                    reply.content += "\",";
-                    intToString(round(segment.bearing), tmpBearing);
-                    reply.content += tmpBearing;
-                    reply.content += "]";
+                    reply.chunked_content += "\",\"";
+                    sEngine.AppendEscapedNameForNameID(segment.nameID, reply.chunked_content);
+                    reply.chunked_content += "\",";
+                    reply.chunked_content.AppendInt(segment.length);
+                    reply.chunked_content += ",";
+                    reply.chunked_content.AppendInt(prefixSumOfNecessarySegments);
+                    reply.chunked_content += ",";
+                    reply.chunked_content.AppendInt(segment.duration/10);
+                    reply.chunked_content += ",\"";
+                    reply.chunked_content.AppendInt(segment.length);
+                    reply.chunked_content += "m\",\"";
+                    reply.chunked_content += Azimuth::Get(segment.bearing);
+                    reply.chunked_content += "\",";
+                    reply.chunked_content.AppendInt(round(segment.bearing));
+                    reply.chunked_content += "]";
 
                     segmentVector.push_back( Segment(segment.nameID, segment.length, segmentVector.size() ));
                 }
@@ -380,23 +433,21 @@ public:
                 ++prefixSumOfNecessarySegments;
         }
         if(INT_MAX != lengthOfRoute) {
-            reply.content += ",[\"";
-            intToString(TurnInstructions.ReachedYourDestination, tmpInstruction);
-            reply.content += tmpInstruction;
-            reply.content += "\",\"";
-            reply.content += "\",";
-            reply.content += "0";
-            reply.content += ",";
-            intToString(prefixSumOfNecessarySegments-1, tmpLength);
-            reply.content += tmpLength;
-            reply.content += ",";
-            reply.content += "0";
-            reply.content += ",\"";
-            reply.content += "\",\"";
-            reply.content += Azimuth::Get(0.0);
-            reply.content += "\",";
-            reply.content += "0.0";
-            reply.content += "]";
+            reply.chunked_content += ",[\"";
+            reply.chunked_content.AppendInt(TurnInstructions.ReachedYourDestination);
+            reply.chunked_content += "\",\"";
+            reply.chunked_content += "\",";
+            reply.chunked_content += "0";
+            reply.chunked_content += ",";
+            reply.chunked_content.AppendInt(prefixSumOfNecessarySegments-1);
+            reply.chunked_content += ",";
+            reply.chunked_content += "0";
+            reply.chunked_content += ",\"";
+            reply.chunked_content += "\",\"";
+            reply.chunked_content += Azimuth::Get(0.0);
+            reply.chunked_content += "\",";
+            reply.chunked_content += "0.0";
+            reply.chunked_content += "]";
         }
     }
 
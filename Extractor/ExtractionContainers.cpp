@@ -26,6 +26,86 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "ExtractionContainers.h"
+#include "../Util/GraphFileFormat.h"
+
+#include <cstring>
+
+#include <algorithm>
+
+// Finds the rank of a node among the used nodes, which is its index in the
+// node section of the graph file.
+static inline bool LookupUsedNode(
+    const NodeID node,
+    const std::vector<NodeID> & used_node_id_index,
+    NodeID & rank
+) {
+    std::vector<NodeID>::const_iterator position = std::lower_bound(
+        used_node_id_index.begin(),
+        used_node_id_index.end(),
+        node
+    );
+    if(position == used_node_id_index.end() || *position != node) {
+        return false;
+    }
+    rank = position - used_node_id_index.begin();
+    return true;
+}
+
+// Resolves both end points of an edge and serializes it into a fixed-size
+// graph file record that refers to its nodes by their index in the node
+// section. Returns false if an end point is unknown.
+static bool SerializeEdge(
+    const InternalExtractorEdge & edge,
+    const std::vector<NodeID> & used_node_id_index,
+    const std::vector<FixedPointCoordinate> & used_node_coordinates,
+    GraphFileEdgeRecord & record
+) {
+    NodeID start_rank, target_rank;
+    if(
+        !LookupUsedNode(edge.start, used_node_id_index, start_rank) ||
+        !LookupUsedNode(edge.target, used_node_id_index, target_rank)
+    ) {
+        return false;
+    }
+
+    double distance = ApproximateDistance(
+        used_node_coordinates[start_rank],
+        used_node_coordinates[target_rank]
+    );
+    assert(edge.speed != -1);
+    double weight = ( distance * 10. ) / (edge.speed / 3.6);
+    int intWeight = std::max(1, (int)std::floor((edge.isDurationSet ? edge.speed : weight)+.5) );
+    int intDist = std::max(1, (int)distance);
+    short direction = 0;
+    switch(edge.direction) {
+    case ExtractionWay::notSure:
+    case ExtractionWay::bidirectional:
+        direction = 0;
+        break;
+    case ExtractionWay::oneway:
+    case ExtractionWay::opposite:
+        direction = 1;
+        break;
+    default:
+        std::cerr << "[error] edge with no direction: " << edge.direction << std::endl;
+        assert(false);
+        break;
+    }
+    assert(edge.type >= 0);
+
+    record.source = start_rank;
+    record.target = target_rank;
+    record.length = intDist;
+    record.weight = intWeight;
+    record.name_id = edge.nameID;
+    record.direction = direction;
+    record.type = edge.type;
+    record.is_roundabout = edge.isRoundabout;
+    record.ignore_in_grid = edge.ignoreInGrid;
+    record.is_access_restricted = edge.isAccessRestricted;
+    record.is_contra_flow = edge.isContraFlow;
+    return true;
+}
 
 void ExtractionContainers::PrepareData(const std::string & output_file_name, const std::string restrictionsFileName, const unsigned amountOfRAM) {
     try {
@@ -147,13 +227,25 @@ void ExtractionContainers::PrepareData(const std::string & output_file_name, con
         }
         restrictionsOutstream.close();
 
-        std::ofstream fout;
-        fout.open(output_file_name.c_str(), std::ios::binary);
-        fout.write((char*)&uuid, sizeof(UUID));
-        fout.write((char*)&usedNodeCounter, sizeof(unsigned));
+        GraphFileWriter graph_file_writer(output_file_name, uuid, 2);
         time = get_timestamp();
         std::cout << "[extractor] Confirming/Writing used nodes     ... " << std::flush;
 
+        // The used nodes are written in ascending order of their IDs. Their
+        // IDs and coordinates are kept as a dense, rank-indexed lookup table
+        // that resolves both end points of every edge in a single pass.
+        std::vector<NodeID> used_node_id_index;
+        std::vector<FixedPointCoordinate> used_node_coordinates;
+        used_node_id_index.reserve(usedNodeIDs.size());
+        used_node_coordinates.reserve(usedNodeIDs.size());
+
+        const std::size_t node_block_size = 1024*1024;
+        std::vector<GraphFileNodeRecord> node_block;
+        node_block.reserve(node_block_size);
+        GraphFileNodeRecord node_record;
+        memset(&node_record, 0, sizeof(GraphFileNodeRecord));
+
+        graph_file_writer.BeginSection(GRAPH_FILE_NODE_SECTION, sizeof(GraphFileNodeRecord));
         STXXLNodeVector::iterator nodesIT = allNodes.begin();
         STXXLNodeIDVector::iterator usedNodeIDsIT = usedNodeIDs.begin();
         while(usedNodeIDsIT != usedNodeIDs.end() && nodesIT != allNodes.end()) {
@@ -166,128 +258,83 @@ void ExtractionContainers::PrepareData(const std::string & output_file_name, con
                 continue;
             }
             if(*usedNodeIDsIT == nodesIT->id) {
-                fout.write((char*)&(*nodesIT), sizeof(_Node));
+                node_record.lat = nodesIT->lat;
+                node_record.lon = nodesIT->lon;
+                node_record.id = nodesIT->id;
+                node_record.bollard = nodesIT->bollard;
+                node_record.traffic_light = nodesIT->trafficLight;
+                node_block.push_back(node_record);
+                if(node_block.size() == node_block_size) {
+                    graph_file_writer.WriteRecords((char*)&node_block[0], node_block.size());
+                    node_block.clear();
+                }
+                used_node_id_index.push_back(nodesIT->id);
+                used_node_coordinates.push_back(
+                    FixedPointCoordinate(nodesIT->lat, nodesIT->lon)
+                );
                 ++usedNodeCounter;
                 ++usedNodeIDsIT;
                 ++nodesIT;
             }
         }
-
-        std::cout << "ok, after " << get_timestamp() - time << "s" << std::endl;
-
-        std::cout << "[extractor] setting number of nodes   ... " << std::flush;
-        std::ios::pos_type positionInFile = fout.tellp();
-        fout.seekp(std::ios::beg+sizeof(UUID));
-        fout.write((char*)&usedNodeCounter, sizeof(unsigned));
-        fout.seekp(positionInFile);
-
-        std::cout << "ok" << std::endl;
-        time = get_timestamp();
-
-        // Sort edges by start.
-        std::cout << "[extractor] Sorting edges by start    ... " << std::flush;
-        stxxl::sort(allEdges.begin(), allEdges.end(), CmpEdgeByStartID(), memory_to_use);
-        std::cout << "ok, after " << get_timestamp() - time << "s" << std::endl;
-        time = get_timestamp();
-
-        std::cout << "[extractor] Setting start coords      ... " << std::flush;
-        fout.write((char*)&usedEdgeCounter, sizeof(unsigned));
-        // Traverse list of edges and nodes in parallel and set start coord
-        nodesIT = allNodes.begin();
-        STXXLEdgeVector::iterator edgeIT = allEdges.begin();
-        while(edgeIT != allEdges.end() && nodesIT != allNodes.end()) {
-            if(edgeIT->start < nodesIT->id){
-                ++edgeIT;
-                continue;
-            }
-            if(edgeIT->start > nodesIT->id) {
-                nodesIT++;
-                continue;
-            }
-            if(edgeIT->start == nodesIT->id) {
-                edgeIT->startCoord.lat = nodesIT->lat;
-                edgeIT->startCoord.lon = nodesIT->lon;
-                ++edgeIT;
-            }
+        if(!node_block.empty()) {
+            graph_file_writer.WriteRecords((char*)&node_block[0], node_block.size());
         }
-        std::cout << "ok, after " << get_timestamp() - time << "s" << std::endl;
-        time = get_timestamp();
+        std::vector<GraphFileNodeRecord>().swap(node_block);
+        //nodes are not needed anymore, release the external memory early
+        allNodes.clear();
+        usedNodeIDs.clear();
 
-        // Sort Edges by target
-        std::cout << "[extractor] Sorting edges by target   ... " << std::flush;
-        stxxl::sort(allEdges.begin(), allEdges.end(), CmpEdgeByTargetID(), memory_to_use);
         std::cout << "ok, after " << get_timestamp() - time << "s" << std::endl;
         time = get_timestamp();
 
-        std::cout << "[extractor] Setting target coords     ... " << std::flush;
-        // Traverse list of edges and nodes in parallel and set target coord
-        nodesIT = allNodes.begin();
-        edgeIT = allEdges.begin();
-
-        while(edgeIT != allEdges.end() && nodesIT != allNodes.end()) {
-            if(edgeIT->target < nodesIT->id){
+        std::cout << "[extractor] Resolving/Writing edges   ... " << std::flush;
+
+        // Edges are streamed in blocks. Each block is resolved against the
+        // node index in parallel, compacted and appended in a single write.
+        const std::size_t edge_block_size = 1024*1024;
+        std::vector<InternalExtractorEdge> edge_block;
+        std::vector<GraphFileEdgeRecord> record_block(edge_block_size);
+        std::vector<char> record_is_valid(edge_block_size);
+        edge_block.reserve(edge_block_size);
+
+        graph_file_writer.BeginSection(GRAPH_FILE_EDGE_SECTION, sizeof(GraphFileEdgeRecord));
+        STXXLEdgeVector::const_iterator edgeIT = allEdges.begin();
+        while(edgeIT != allEdges.end()) {
+            edge_block.clear();
+            while(edgeIT != allEdges.end() && edge_block.size() < edge_block_size) {
+                edge_block.push_back(*edgeIT);
                 ++edgeIT;
-                continue;
             }
-            if(edgeIT->target > nodesIT->id) {
-                ++nodesIT;
-                continue;
+
+            const int number_of_edges_in_block = edge_block.size();
+#pragma omp parallel for schedule ( guided )
+            for(int i = 0; i < number_of_edges_in_block; ++i) {
+                record_is_valid[i] = SerializeEdge(
+                    edge_block[i],
+                    used_node_id_index,
+                    used_node_coordinates,
+                    record_block[i]
+                );
             }
-            if(edgeIT->target == nodesIT->id) {
-                if(edgeIT->startCoord.lat != INT_MIN && edgeIT->startCoord.lon != INT_MIN) {
-                    edgeIT->targetCoord.lat = nodesIT->lat;
-                    edgeIT->targetCoord.lon = nodesIT->lon;
-
-                    double distance = ApproximateDistance(edgeIT->startCoord.lat, edgeIT->startCoord.lon, nodesIT->lat, nodesIT->lon);
-                    assert(edgeIT->speed != -1);
-                    double weight = ( distance * 10. ) / (edgeIT->speed / 3.6);
-                    int intWeight = std::max(1, (int)std::floor((edgeIT->isDurationSet ? edgeIT->speed : weight)+.5) );
-                    int intDist = std::max(1, (int)distance);
-                    short zero = 0;
-                    short one = 1;
-
-                    fout.write((char*)&edgeIT->start, sizeof(unsigned));
-                    fout.write((char*)&edgeIT->target, sizeof(unsigned));
-                    fout.write((char*)&intDist, sizeof(int));
-                    switch(edgeIT->direction) {
-                    case ExtractionWay::notSure:
-                        fout.write((char*)&zero, sizeof(short));
-                        break;
-                    case ExtractionWay::oneway:
-                        fout.write((char*)&one, sizeof(short));
-                        break;
-                    case ExtractionWay::bidirectional:
-                        fout.write((char*)&zero, sizeof(short));
-
-                        break;
-                    case ExtractionWay::opposite:
-                        fout.write((char*)&one, sizeof(short));
-                        break;
-                    default:
-                      std::cerr << "[error] edge with no direction: " << edgeIT->direction << std::endl;
-                      assert(false);
-                        break;
-                    }
-                    fout.write((char*)&intWeight, sizeof(int));
-                    assert(edgeIT->type >= 0);
-                    fout.write((char*)&edgeIT->type, sizeof(short));
-                    fout.write((char*)&edgeIT->nameID, sizeof(unsigned));
-                    fout.write((char*)&edgeIT->isRoundabout, sizeof(bool));
-                    fout.write((char*)&edgeIT->ignoreInGrid, sizeof(bool));
-                    fout.write((char*)&edgeIT->isAccessRestricted, sizeof(bool));
-                    fout.write((char*)&edgeIT->isContraFlow, sizeof(bool));
-                    ++usedEdgeCounter;
+
+            int number_of_valid_records = 0;
+            for(int i = 0; i < number_of_edges_in_block; ++i) {
+                if(record_is_valid[i]) {
+                    record_block[number_of_valid_records] = record_block[i];
+                    ++number_of_valid_records;
                 }
-                ++edgeIT;
             }
+            graph_file_writer.WriteRecords((char*)&record_block[0], number_of_valid_records);
+            usedEdgeCounter += number_of_valid_records;
         }
+        graph_file_writer.Close();
         std::cout << "ok, after " << get_timestamp() - time << "s" << std::endl;
-        std::cout << "[extractor] setting number of edges   ... " << std::flush;
-
-        fout.seekp(positionInFile);
-        fout.write((char*)&usedEdgeCounter, sizeof(unsigned));
-        fout.close();
-        std::cout << "ok" << std::endl;
+        SimpleLogger().Write() <<
+            "graph file has " << usedNodeCounter << " nodes (crc32: " <<
+            graph_file_writer.GetSection(0).crc32 << ") and " <<
+            usedEdgeCounter << " edges (crc32: " <<
+            graph_file_writer.GetSection(1).crc32 << ")";
         time = get_timestamp();
 
         std::cout << "[extractor] writing street name index ... " << std::flush;
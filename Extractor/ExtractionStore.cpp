@@ -0,0 +1,313 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "ExtractionStore.h"
+
+#include "ExtractorCallbacks.h"
+#include "../Util/OSRMException.h"
+#include "../Util/SimpleLogger.h"
+
+#include <boost/filesystem.hpp>
+
+static const unsigned STORE_FORMAT_VERSION = 1;
+
+static inline unsigned RecordID(const _Node & node) {
+    return node.id;
+}
+
+static inline unsigned RecordID(const ExtractionWay & way) {
+    return way.id;
+}
+
+static inline unsigned RecordID(const _RawRestrictionContainer & restriction) {
+    return restriction.relationID;
+}
+
+template<typename T>
+static inline void WriteValue(std::ostream & out, const T & value) {
+    out.write((char*)&value, sizeof(T));
+}
+
+template<typename T>
+static inline void ReadValue(std::istream & in, T & value) {
+    in.read((char*)&value, sizeof(T));
+}
+
+static void WriteRecord(std::ostream & out, const _Node & node) {
+    WriteValue(out, node);
+}
+
+static void ReadRecord(std::istream & in, _Node & node) {
+    ReadValue(in, node);
+}
+
+static void WriteRecord(std::ostream & out, const _RawRestrictionContainer & restriction) {
+    WriteValue(out, restriction);
+}
+
+static void ReadRecord(std::istream & in, _RawRestrictionContainer & restriction) {
+    ReadValue(in, restriction);
+}
+
+// Only the profile's output is stored, tags are not needed after processing.
+static void WriteRecord(std::ostream & out, const ExtractionWay & way) {
+    WriteValue(out, way.id);
+    const unsigned name_length = way.name.size();
+    WriteValue(out, name_length);
+    out.write(way.name.c_str(), name_length);
+    WriteValue(out, way.speed);
+    WriteValue(out, way.backward_speed);
+    WriteValue(out, way.duration);
+    WriteValue(out, way.type);
+    const int direction = way.direction;
+    WriteValue(out, direction);
+    WriteValue(out, way.access);
+    WriteValue(out, way.roundabout);
+    WriteValue(out, way.isAccessRestricted);
+    WriteValue(out, way.ignoreInGrid);
+    const unsigned path_length = way.path.size();
+    WriteValue(out, path_length);
+    if(0 < path_length) {
+        out.write((char*)&way.path[0], path_length*sizeof(NodeID));
+    }
+}
+
+static void ReadRecord(std::istream & in, ExtractionWay & way) {
+    way.Clear();
+    ReadValue(in, way.id);
+    unsigned name_length;
+    ReadValue(in, name_length);
+    way.name.resize(name_length);
+    if(0 < name_length) {
+        in.read(&way.name[0], name_length);
+    }
+    ReadValue(in, way.speed);
+    ReadValue(in, way.backward_speed);
+    ReadValue(in, way.duration);
+    ReadValue(in, way.type);
+    int direction;
+    ReadValue(in, direction);
+    way.direction = static_cast<ExtractionWay::Directions>(direction);
+    ReadValue(in, way.access);
+    ReadValue(in, way.roundabout);
+    ReadValue(in, way.isAccessRestricted);
+    ReadValue(in, way.ignoreInGrid);
+    unsigned path_length;
+    ReadValue(in, path_length);
+    way.path.resize(path_length);
+    if(0 < path_length) {
+        in.read((char*)&way.path[0], path_length*sizeof(NodeID));
+    }
+}
+
+static unsigned ReadHeader(std::istream & in, const std::string & file_name) {
+    unsigned format_version = 0, number_of_records = 0;
+    ReadValue(in, format_version);
+    ReadValue(in, number_of_records);
+    if(!in || STORE_FORMAT_VERSION != format_version) {
+        throw OSRMException(file_name + " is not a valid extraction store");
+    }
+    return number_of_records;
+}
+
+ExtractionStore::ExtractionStore(const std::string & output_file_name) {
+    node_file.file_name        = output_file_name + ".store.nodes";
+    way_file.file_name         = output_file_name + ".store.ways";
+    restriction_file.file_name = output_file_name + ".store.restrictions";
+}
+
+ExtractionStore::~ExtractionStore() {
+    CloseForWriting();
+}
+
+bool ExtractionStore::Exists() const {
+    return boost::filesystem::is_regular_file(node_file.file_name) &&
+           boost::filesystem::is_regular_file(way_file.file_name) &&
+           boost::filesystem::is_regular_file(restriction_file.file_name);
+}
+
+void ExtractionStore::OpenForWriting() {
+    StoreFile * files[] = { &node_file, &way_file, &restriction_file };
+    for(unsigned i = 0; i < 3; ++i) {
+        files[i]->stream.open(files[i]->file_name, std::ios::binary);
+        files[i]->number_of_records = 0;
+        files[i]->last_id = 0;
+        WriteValue(files[i]->stream, STORE_FORMAT_VERSION);
+        WriteValue(files[i]->stream, files[i]->number_of_records);
+    }
+}
+
+template<typename RecordT>
+void ExtractionStore::WriteSortedRecord(StoreFile & store_file, const RecordT & record) {
+    const unsigned id = RecordID(record);
+    if(0 < store_file.number_of_records && id <= store_file.last_id) {
+        throw OSRMException("extraction store requires input that is sorted by id");
+    }
+    WriteRecord(store_file.stream, record);
+    store_file.last_id = id;
+    ++store_file.number_of_records;
+}
+
+void ExtractionStore::WriteNode(const _Node & node) {
+    WriteSortedRecord(node_file, node);
+}
+
+void ExtractionStore::WriteWay(const ExtractionWay & way) {
+    WriteSortedRecord(way_file, way);
+}
+
+void ExtractionStore::WriteRestriction(const _RawRestrictionContainer & restriction) {
+    WriteSortedRecord(restriction_file, restriction);
+}
+
+void ExtractionStore::CloseForWriting() {
+    StoreFile * files[] = { &node_file, &way_file, &restriction_file };
+    for(unsigned i = 0; i < 3; ++i) {
+        if(!files[i]->stream.is_open()) {
+            continue;
+        }
+        files[i]->stream.seekp(sizeof(unsigned));
+        WriteValue(files[i]->stream, files[i]->number_of_records);
+        files[i]->stream.close();
+    }
+}
+
+// Appends a record to a merged store file, which has to stay sorted by id.
+template<typename RecordT>
+static inline void WriteMergedRecord(
+    std::ostream & out,
+    const RecordT & record,
+    unsigned & number_of_written_records,
+    unsigned & last_written_id
+) {
+    const unsigned id = RecordID(record);
+    if(0 < number_of_written_records && id <= last_written_id) {
+        throw OSRMException("change set breaks the id order of the extraction store");
+    }
+    WriteRecord(out, record);
+    last_written_id = id;
+    ++number_of_written_records;
+}
+
+// Merges a sorted store file with a set of changes into a new file that then
+// replaces the old one. Runs in time linear in the size of both inputs. Files
+// without changes are left untouched.
+template<typename RecordT>
+void ExtractionStore::MergeFile(
+    const std::string & file_name,
+    const ChangedRecords<RecordT> & changes
+) const {
+    if(0 == changes.size()) {
+        return;
+    }
+    boost::filesystem::ifstream input_stream(file_name, std::ios::binary);
+    const unsigned number_of_records = ReadHeader(input_stream, file_name);
+
+    const std::string temporary_file_name = file_name + ".tmp";
+    boost::filesystem::ofstream output_stream(temporary_file_name, std::ios::binary);
+    unsigned number_of_written_records = 0;
+    unsigned last_written_id = 0;
+    WriteValue(output_stream, STORE_FORMAT_VERSION);
+    WriteValue(output_stream, number_of_written_records);
+
+    typename std::map<unsigned, RecordT>::const_iterator change = changes.upserted.begin();
+    RecordT record;
+    unsigned last_read_id = 0;
+    for(unsigned i = 0; i < number_of_records; ++i) {
+        ReadRecord(input_stream, record);
+        const unsigned id = RecordID(record);
+        if(0 < i && id <= last_read_id) {
+            throw OSRMException(file_name + " is not sorted by id");
+        }
+        last_read_id = id;
+        while(change != changes.upserted.end() && change->first < id) {
+            WriteMergedRecord(output_stream, change->second, number_of_written_records, last_written_id);
+            ++change;
+        }
+        if(change != changes.upserted.end() && change->first == id) {
+            WriteMergedRecord(output_stream, change->second, number_of_written_records, last_written_id);
+            ++change;
+            continue;
+        }
+        if(changes.deleted.count(id)) {
+            continue;
+        }
+        WriteMergedRecord(output_stream, record, number_of_written_records, last_written_id);
+    }
+    for(; change != changes.upserted.end(); ++change) {
+        WriteMergedRecord(output_stream, change->second, number_of_written_records, last_written_id);
+    }
+    if(!input_stream) {
+        throw OSRMException(file_name + " is truncated");
+    }
+
+    output_stream.seekp(sizeof(unsigned));
+    WriteValue(output_stream, number_of_written_records);
+    output_stream.close();
+    input_stream.close();
+    boost::filesystem::rename(temporary_file_name, file_name);
+}
+
+void ExtractionStore::ApplyChanges(const ExtractionChangeSet & changes) const {
+    MergeFile(node_file.file_name, changes.nodes);
+    MergeFile(way_file.file_name, changes.ways);
+    MergeFile(restriction_file.file_name, changes.restrictions);
+}
+
+void ExtractionStore::Replay(ExtractorCallbacks & callbacks) const {
+    boost::filesystem::ifstream node_stream(node_file.file_name, std::ios::binary);
+    const unsigned number_of_nodes = ReadHeader(node_stream, node_file.file_name);
+    _Node node;
+    for(unsigned i = 0; i < number_of_nodes; ++i) {
+        ReadRecord(node_stream, node);
+        callbacks.nodeFunction(node);
+    }
+
+    boost::filesystem::ifstream way_stream(way_file.file_name, std::ios::binary);
+    const unsigned number_of_ways = ReadHeader(way_stream, way_file.file_name);
+    ExtractionWay way;
+    for(unsigned i = 0; i < number_of_ways; ++i) {
+        ReadRecord(way_stream, way);
+        callbacks.wayFunction(way);
+    }
+
+    boost::filesystem::ifstream restriction_stream(restriction_file.file_name, std::ios::binary);
+    const unsigned number_of_restrictions = ReadHeader(restriction_stream, restriction_file.file_name);
+    _RawRestrictionContainer restriction;
+    for(unsigned i = 0; i < number_of_restrictions; ++i) {
+        ReadRecord(restriction_stream, restriction);
+        callbacks.restrictionFunction(restriction);
+    }
+
+    if(!node_stream || !way_stream || !restriction_stream) {
+        throw OSRMException("extraction store is truncated");
+    }
+    SimpleLogger().Write() <<
+        "Replayed " << number_of_nodes << " nodes, " << number_of_ways <<
+        " ways and " << number_of_restrictions << " restrictions from store";
+}
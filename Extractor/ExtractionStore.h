@@ -0,0 +1,115 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef EXTRACTIONSTORE_H_
+#define EXTRACTIONSTORE_H_
+
+#include "ExtractorStructs.h"
+#include "../DataStructures/ImportNode.h"
+#include "../DataStructures/Restriction.h"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <map>
+#include <set>
+#include <string>
+
+class ExtractorCallbacks;
+
+// Changes of one entity type, keyed by OSM id. Later changes of the same id
+// supersede earlier ones.
+template<typename RecordT>
+struct ChangedRecords {
+    std::map<unsigned, RecordT> upserted;
+    std::set<unsigned> deleted;
+
+    inline void Upsert(const unsigned id, const RecordT & record) {
+        deleted.erase(id);
+        upserted[id] = record;
+    }
+
+    inline void Delete(const unsigned id) {
+        upserted.erase(id);
+        deleted.insert(id);
+    }
+
+    inline unsigned size() const {
+        return upserted.size() + deleted.size();
+    }
+};
+
+struct ExtractionChangeSet {
+    ChangedRecords<_Node> nodes;
+    ChangedRecords<ExtractionWay> ways;
+    ChangedRecords<_RawRestrictionContainer> restrictions;
+};
+
+// Persistent store of the profile-processed nodes, ways and restrictions of an
+// extract. Each entity type lives in its own file sorted by OSM id, so change
+// sets are applied by a single sequential merge and the .osrm files can be
+// regenerated without parsing the input or running the profile again.
+// Only parsing and the profile are saved: every store file that has changes is
+// rewritten, and the whole store is replayed into ExtractionContainers, so
+// PrepareData still runs over the full data set.
+class ExtractionStore : boost::noncopyable {
+public:
+    explicit ExtractionStore(const std::string & output_file_name);
+    ~ExtractionStore();
+
+    bool Exists() const;
+
+    void OpenForWriting();
+    void WriteNode(const _Node & node);
+    void WriteWay(const ExtractionWay & way);
+    void WriteRestriction(const _RawRestrictionContainer & restriction);
+    void CloseForWriting();
+
+    void ApplyChanges(const ExtractionChangeSet & changes) const;
+    void Replay(ExtractorCallbacks & callbacks) const;
+
+private:
+    struct StoreFile {
+        StoreFile() : number_of_records(0), last_id(0) { }
+        std::string file_name;
+        boost::filesystem::ofstream stream;
+        unsigned number_of_records;
+        unsigned last_id;
+    };
+
+    template<typename RecordT>
+    void WriteSortedRecord(StoreFile & store_file, const RecordT & record);
+    template<typename RecordT>
+    void MergeFile(const std::string & file_name, const ChangedRecords<RecordT> & changes) const;
+
+    StoreFile node_file;
+    StoreFile way_file;
+    StoreFile restriction_file;
+};
+
+#endif /* EXTRACTIONSTORE_H_ */
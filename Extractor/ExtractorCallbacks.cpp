@@ -27,22 +27,33 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "ExtractorCallbacks.h"
 
-ExtractorCallbacks::ExtractorCallbacks() {externalMemory = NULL; stringMap = NULL; }
-ExtractorCallbacks::ExtractorCallbacks(ExtractionContainers * ext, StringMap * strMap) {
+ExtractorCallbacks::ExtractorCallbacks() {externalMemory = NULL; stringMap = NULL; extractionStore = NULL; }
+ExtractorCallbacks::ExtractorCallbacks(
+    ExtractionContainers * ext,
+    StringMap * strMap,
+    ExtractionStore * store
+) {
     externalMemory = ext;
     stringMap = strMap;
+    extractionStore = store;
 }
 
 ExtractorCallbacks::~ExtractorCallbacks() { }
 
 /** warning: caller needs to take care of synchronization! */
 void ExtractorCallbacks::nodeFunction(const _Node &n) {
+    if(NULL != extractionStore) {
+        extractionStore->WriteNode(n);
+    }
     if(n.lat <= 85*COORDINATE_PRECISION && n.lat >= -85*COORDINATE_PRECISION) {
         externalMemory->allNodes.push_back(n);
     }
 }
 
 bool ExtractorCallbacks::restrictionFunction(const _RawRestrictionContainer &r) {
+    if(NULL != extractionStore) {
+        extractionStore->WriteRestriction(r);
+    }
     externalMemory->restrictionsVector.push_back(r);
     return true;
 }
@@ -57,6 +68,10 @@ void ExtractorCallbacks::wayFunction(ExtractionWay &parsed_way) {
             return;
         }
 
+        if(NULL != extractionStore) {
+            extractionStore->WriteWay(parsed_way);
+        }
+
         if(0 < parsed_way.duration) {
          //TODO: iterate all way segments and set duration corresponding to the length of each segment
             parsed_way.speed = parsed_way.duration/(parsed_way.path.size()-1);
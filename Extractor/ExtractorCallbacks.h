@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "ExtractionContainers.h"
 #include "ExtractionHelperFunctions.h"
+#include "ExtractionStore.h"
 #include "ExtractorStructs.h"
 
 #include "../DataStructures/Coordinate.h"
@@ -47,10 +48,15 @@ class ExtractorCallbacks{
 private:
     StringMap * stringMap;
     ExtractionContainers * externalMemory;
+    ExtractionStore * extractionStore;
 
     ExtractorCallbacks();
 public:
-    explicit ExtractorCallbacks(ExtractionContainers * ext, StringMap * strMap);
+    explicit ExtractorCallbacks(
+        ExtractionContainers * ext,
+        StringMap * strMap,
+        ExtractionStore * store = NULL
+    );
 
     ~ExtractorCallbacks();
 
@@ -116,9 +116,6 @@ struct InternalExtractorEdge {
     bool isAccessRestricted;
     bool isContraFlow;
 
-    FixedPointCoordinate startCoord;
-    FixedPointCoordinate targetCoord;
-
     static InternalExtractorEdge min_value() {
         return InternalExtractorEdge(0,0);
     }
@@ -185,32 +182,6 @@ struct CmpNodeByID : public std::binary_function<_Node, _Node, bool> {
     }
 };
 
-struct CmpEdgeByStartID : public std::binary_function<InternalExtractorEdge, InternalExtractorEdge, bool> {
-    typedef InternalExtractorEdge value_type;
-    bool operator ()  (const InternalExtractorEdge & a, const InternalExtractorEdge & b) const {
-        return a.start < b.start;
-    }
-    value_type max_value() {
-        return InternalExtractorEdge::max_value();
-    }
-    value_type min_value() {
-        return InternalExtractorEdge::min_value();
-    }
-};
-
-struct CmpEdgeByTargetID : public std::binary_function<InternalExtractorEdge, InternalExtractorEdge, bool> {
-    typedef InternalExtractorEdge value_type;
-    bool operator ()  (const InternalExtractorEdge & a, const InternalExtractorEdge & b) const {
-        return a.target < b.target;
-    }
-    value_type max_value() {
-        return InternalExtractorEdge::max_value();
-    }
-    value_type min_value() {
-        return InternalExtractorEdge::min_value();
-    }
-};
-
 inline std::string GetRandomString() {
     char s[128];
     static const char alphanum[] =
@@ -0,0 +1,169 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "OSCParser.h"
+
+#include "OSMXMLTokenizer.h"
+
+#include <zlib.h>
+
+OSCParser::OSCParser(
+    const char * filename,
+    ExtractorCallbacks* ec,
+    ScriptingEnvironment& se,
+    ExtractionChangeSet & change_set
+) : BaseParser(ec, se), file_name(filename), change_set(change_set) { }
+
+// gzread passes uncompressed files through unchanged
+bool OSCParser::ReadHeader() {
+    gzFile input = gzopen(file_name.c_str(), "rb");
+    if(NULL == input) {
+        return false;
+    }
+    char buffer[64*1024];
+    int bytes_read;
+    while(0 < (bytes_read = gzread(input, buffer, sizeof(buffer)))) {
+        change_text.insert(change_text.end(), buffer, buffer + bytes_read);
+    }
+    gzclose(input);
+    return (0 == bytes_read) && !change_text.empty();
+}
+
+bool OSCParser::Parse() {
+    std::vector<ImportNode> nodes;
+    std::vector<ExtractionWay> ways;
+    std::vector<_RawRestrictionContainer> restrictions;
+    std::vector<std::string> restriction_except_tags;
+    std::vector<char> relation_is_restriction;
+    std::vector<Change> changes;
+
+    const char * position = &change_text[0];
+    const char * end = position + change_text.size();
+    bool inside_delete_block = false;
+    while(position < end) {
+        position = static_cast<const char *>(memchr(position, '<', end - position));
+        if(NULL == position) {
+            break;
+        }
+        if(HasElementName(position+1, end, "node")) {
+            changes.push_back(Change(TypeNode, inside_delete_block, nodes.size()));
+            nodes.push_back(ImportNode());
+            position = ReadOSMNode(position, end, nodes.back());
+        } else if(HasElementName(position+1, end, "way")) {
+            changes.push_back(Change(TypeWay, inside_delete_block, ways.size()));
+            ways.push_back(ExtractionWay());
+            position = ReadOSMWay(position, end, ways.back());
+        } else if(HasElementName(position+1, end, "relation")) {
+            changes.push_back(Change(TypeRelation, inside_delete_block, restrictions.size()));
+            restrictions.push_back(_RawRestrictionContainer());
+            restriction_except_tags.push_back(std::string());
+            bool is_restriction = false;
+            position = ReadOSMRelation(
+                position,
+                end,
+                restrictions.back(),
+                is_restriction,
+                restriction_except_tags.back()
+            );
+            relation_is_restriction.push_back(is_restriction);
+        } else {
+            if(HasElementName(position+1, end, "delete")) {
+                inside_delete_block = true;
+            } else if(
+                HasElementName(position+1, end, "create") ||
+                HasElementName(position+1, end, "modify")
+            ) {
+                inside_delete_block = false;
+            }
+            position = SkipTag(position, end);
+        }
+    }
+
+    // only entities that are created or modified go through the profile
+    const int number_of_changes = changes.size();
+#pragma omp parallel for schedule ( guided )
+    for(int i = 0; i < number_of_changes; ++i) {
+        const Change & change = changes[i];
+        if(change.is_deletion) {
+            continue;
+        }
+        lua_State * lua_state = scriptingEnvironment.getLuaStateForThreadID(omp_get_thread_num());
+        if(TypeNode == change.type) {
+            ParseNodeInLua(nodes[change.index], lua_state);
+        } else if(TypeWay == change.type && 2 <= ways[change.index].path.size()) {
+            ParseWayInLua(ways[change.index], lua_state);
+        }
+    }
+
+    // Apply in file order, so later changes of an entity supersede earlier
+    // ones. Entities that became irrelevant for routing are deleted.
+    BOOST_FOREACH(const Change & change, changes) {
+        switch(change.type) {
+        case TypeNode: {
+            const ImportNode & node = nodes[change.index];
+            if(change.is_deletion) {
+                change_set.nodes.Delete(node.id);
+            } else {
+                change_set.nodes.Upsert(node.id, node);
+            }
+            break;
+        }
+        case TypeWay: {
+            const ExtractionWay & way = ways[change.index];
+            const bool is_routable =
+                (2 <= way.path.size()) && ((0 < way.speed) || (0 < way.duration));
+            if(change.is_deletion || !is_routable) {
+                change_set.ways.Delete(way.id);
+            } else {
+                change_set.ways.Upsert(way.id, way);
+            }
+            break;
+        }
+        case TypeRelation: {
+            const _RawRestrictionContainer & restriction = restrictions[change.index];
+            const bool is_usable_restriction =
+                use_turn_restrictions &&
+                relation_is_restriction[change.index] &&
+                UINT_MAX != restriction.fromWay &&
+                !ShouldIgnoreRestriction(restriction_except_tags[change.index]);
+            if(change.is_deletion || !is_usable_restriction) {
+                change_set.restrictions.Delete(restriction.relationID);
+            } else {
+                change_set.restrictions.Upsert(restriction.relationID, restriction);
+            }
+            break;
+        }
+        }
+    }
+
+    SimpleLogger().Write() <<
+        "Change set touches " << change_set.nodes.size() << " nodes, " <<
+        change_set.ways.size() << " ways and " <<
+        change_set.restrictions.size() << " relations";
+    return true;
+}
@@ -0,0 +1,75 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef OSCPARSER_H_
+#define OSCPARSER_H_
+
+#include "BaseParser.h"
+#include "ExtractionStore.h"
+#include "../Util/OpenMPWrapper.h"
+#include "../typedefs.h"
+
+#include <string>
+#include <vector>
+
+// Reads an OSM change file (.osc or .osc.gz) and runs the profile on the
+// created and modified entities only. The result is a change set that can be
+// merged into an ExtractionStore.
+class OSCParser : public BaseParser {
+public:
+    OSCParser(
+        const char * filename,
+        ExtractorCallbacks* ec,
+        ScriptingEnvironment& se,
+        ExtractionChangeSet & change_set
+    );
+
+    bool ReadHeader();
+    bool Parse();
+
+private:
+    enum EntityType {
+        TypeNode = 0,
+        TypeWay,
+        TypeRelation
+    };
+
+    struct Change {
+        Change(const EntityType type, const bool is_deletion, const unsigned index) :
+            type(type), is_deletion(is_deletion), index(index) { }
+        EntityType type;
+        bool is_deletion;
+        unsigned index;
+    };
+
+    std::string file_name;
+    std::vector<char> change_text;
+    ExtractionChangeSet & change_set;
+};
+
+#endif /* OSCPARSER_H_ */
@@ -0,0 +1,443 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef OSMXMLTOKENIZER_H_
+#define OSMXMLTOKENIZER_H_
+
+#include "ExtractorStructs.h"
+#include "../DataStructures/Coordinate.h"
+#include "../DataStructures/HashTable.h"
+#include "../DataStructures/ImportNode.h"
+#include "../DataStructures/Restriction.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <string>
+
+// A minimal, allocation-free tokenizer for the subset of XML used by .osm and
+// .osc files. All functions work on [position, end) ranges of raw text.
+
+struct XMLAttribute {
+    const char * name;
+    std::size_t name_length;
+    const char * value;
+    std::size_t value_length;
+
+    inline bool NameEquals(const char * other) const {
+        return (strlen(other) == name_length) && (0 == memcmp(name, other, name_length));
+    }
+    inline bool ValueEquals(const char * other) const {
+        return (strlen(other) == value_length) && (0 == memcmp(value, other, value_length));
+    }
+};
+
+inline bool IsXMLWhiteSpace(const char c) {
+    return ' ' == c || '\t' == c || '\n' == c || '\r' == c;
+}
+
+inline bool IsNameDelimiter(const char c) {
+    return IsXMLWhiteSpace(c) || '/' == c || '>' == c || '=' == c;
+}
+
+inline bool HasElementName(const char * position, const char * end, const char * name) {
+    const std::size_t name_length = strlen(name);
+    return (position + name_length < end) &&
+        (0 == memcmp(position, name, name_length)) &&
+        IsNameDelimiter(position[name_length]);
+}
+
+// Nodes, ways and relations are never nested in OSM files and a raw '<' can
+// not occur inside attribute values. Each of them thus starts a top-level
+// element at which the input can be cut.
+inline bool IsElementStart(const char * position, const char * end) {
+    return '<' == *position && (
+        HasElementName(position+1, end, "node") ||
+        HasElementName(position+1, end, "way")  ||
+        HasElementName(position+1, end, "relation")
+    );
+}
+
+inline const char * FindElementStart(const char * position, const char * end) {
+    while(position < end) {
+        position = static_cast<const char *>(memchr(position, '<', end - position));
+        if(NULL == position) {
+            return end;
+        }
+        if(IsElementStart(position, end)) {
+            return position;
+        }
+        ++position;
+    }
+    return end;
+}
+
+inline const char * FindLastElementStart(const char * begin, const char * end) {
+    for(const char * position = end; position != begin; --position) {
+        if(IsElementStart(position-1, end)) {
+            return position-1;
+        }
+    }
+    return begin;
+}
+
+inline const char * SkipTag(const char * position, const char * end) {
+    const char * tag_end = static_cast<const char *>(memchr(position, '>', end - position));
+    return (NULL == tag_end) ? end : tag_end + 1;
+}
+
+// Reads the next attribute of the current start tag. Returns false at the end
+// of the tag and reports whether the tag was an empty element, i.e. "/>".
+inline bool ReadAttribute(
+    const char *& position,
+    const char * end,
+    XMLAttribute & attribute,
+    bool & is_empty_element
+) {
+    while(position < end && IsXMLWhiteSpace(*position)) {
+        ++position;
+    }
+    if(position >= end || '/' == *position || '>' == *position) {
+        is_empty_element = (position >= end) || ('/' == *position);
+        position = SkipTag(position, end);
+        return false;
+    }
+    attribute.name = position;
+    while(position < end && !IsNameDelimiter(*position)) {
+        ++position;
+    }
+    attribute.name_length = position - attribute.name;
+    while(position < end && (IsXMLWhiteSpace(*position) || '=' == *position)) {
+        ++position;
+    }
+    if(position >= end || ('"' != *position && '\'' != *position)) {
+        is_empty_element = true;
+        position = SkipTag(position, end);
+        return false;
+    }
+    const char quote = *position;
+    attribute.value = ++position;
+    position = static_cast<const char *>(memchr(position, quote, end - position));
+    if(NULL == position) {
+        is_empty_element = true;
+        position = end;
+        return false;
+    }
+    attribute.value_length = position - attribute.value;
+    ++position;
+    return true;
+}
+
+// Advances to the next tag and returns a pointer to its name.
+inline const char * ReadTagName(
+    const char *& position,
+    const char * end,
+    std::size_t & name_length,
+    bool & is_closing_tag
+) {
+    position = static_cast<const char *>(memchr(position, '<', end - position));
+    if(NULL == position) {
+        position = end;
+        return NULL;
+    }
+    ++position;
+    is_closing_tag = (position < end && '/' == *position);
+    if(is_closing_tag) {
+        ++position;
+    }
+    const char * name = position;
+    while(position < end && !IsNameDelimiter(*position)) {
+        ++position;
+    }
+    name_length = position - name;
+    return name;
+}
+
+inline bool TagNameEquals(const char * name, const std::size_t name_length, const char * other) {
+    return (strlen(other) == name_length) && (0 == memcmp(name, other, name_length));
+}
+
+inline unsigned ParseUnsigned(const XMLAttribute & attribute) {
+    unsigned value = 0;
+    for(std::size_t i = 0; i < attribute.value_length; ++i) {
+        const char digit = attribute.value[i];
+        if(digit < '0' || digit > '9') {
+            break;
+        }
+        value = 10*value + (digit - '0');
+    }
+    return value;
+}
+
+inline int ParseFixedPointCoordinate(const XMLAttribute & attribute) {
+    // the value is terminated by its quote, which strtod does not accept
+    return static_cast<int>(COORDINATE_PRECISION*strtod(attribute.value, NULL));
+}
+
+inline void AppendUTF8(const unsigned code_point, std::string & output) {
+    if(code_point < 0x80) {
+        output += static_cast<char>(code_point);
+    } else if(code_point < 0x800) {
+        output += static_cast<char>(0xC0 | (code_point >> 6));
+        output += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else if(code_point < 0x10000) {
+        output += static_cast<char>(0xE0 | (code_point >> 12));
+        output += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        output += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else {
+        output += static_cast<char>(0xF0 | (code_point >> 18));
+        output += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+        output += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        output += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+}
+
+inline std::string DecodeAttributeValue(const XMLAttribute & attribute) {
+    const char * value = attribute.value;
+    const std::size_t length = attribute.value_length;
+    if(NULL == memchr(value, '&', length)) {
+        return std::string(value, length);
+    }
+    std::string result;
+    result.reserve(length);
+    for(std::size_t i = 0; i < length; ++i) {
+        if('&' != value[i]) {
+            result += value[i];
+            continue;
+        }
+        const char * entity_end = static_cast<const char *>(memchr(value + i, ';', length - i));
+        if(NULL == entity_end) {
+            result += value[i];
+            continue;
+        }
+        const std::string entity(value + i + 1, entity_end);
+        if("amp" == entity) {
+            result += '&';
+        } else if("lt" == entity) {
+            result += '<';
+        } else if("gt" == entity) {
+            result += '>';
+        } else if("quot" == entity) {
+            result += '"';
+        } else if("apos" == entity) {
+            result += '\'';
+        } else if(1 < entity.size() && '#' == entity[0]) {
+            const bool is_hex = ('x' == entity[1] || 'X' == entity[1]);
+            AppendUTF8(strtoul(entity.c_str() + (is_hex ? 2 : 1), NULL, is_hex ? 16 : 10), result);
+        } else {
+            result.append(value + i, entity_end + 1);
+        }
+        i = entity_end - value;
+    }
+    return result;
+}
+
+// Reads the attributes of a <tag k=".." v=".."/> element into keyVals.
+inline void ReadTag(
+    const char *& position,
+    const char * end,
+    HashTable<std::string, std::string> & key_value_pairs
+) {
+    XMLAttribute attribute, key, value;
+    bool has_key = false, has_value = false, is_empty_element = false;
+    while(ReadAttribute(position, end, attribute, is_empty_element)) {
+        if(attribute.NameEquals("k")) {
+            key = attribute;
+            has_key = true;
+        } else if(attribute.NameEquals("v")) {
+            value = attribute;
+            has_value = true;
+        }
+    }
+    if(has_key && has_value) {
+        key_value_pairs.Add(DecodeAttributeValue(key), DecodeAttributeValue(value));
+    }
+}
+
+
+inline const char * ReadOSMNode(
+    const char * position,
+    const char * end,
+    ImportNode & node
+) {
+    position += strlen("<node");
+    XMLAttribute attribute;
+    bool is_empty_element = false;
+    while(ReadAttribute(position, end, attribute, is_empty_element)) {
+        if(attribute.NameEquals("id")) {
+            node.id = ParseUnsigned(attribute);
+        } else if(attribute.NameEquals("lat")) {
+            node.lat = ParseFixedPointCoordinate(attribute);
+        } else if(attribute.NameEquals("lon")) {
+            node.lon = ParseFixedPointCoordinate(attribute);
+        }
+    }
+    if(is_empty_element) {
+        return position;
+    }
+
+    std::size_t name_length;
+    bool is_closing_tag;
+    while(position < end) {
+        const char * name = ReadTagName(position, end, name_length, is_closing_tag);
+        if(NULL == name) {
+            break;
+        }
+        if(is_closing_tag) {
+            position = SkipTag(position, end);
+            if(TagNameEquals(name, name_length, "node")) {
+                break;
+            }
+        } else if(TagNameEquals(name, name_length, "tag")) {
+            ReadTag(position, end, node.keyVals);
+        } else {
+            position = SkipTag(position, end);
+        }
+    }
+    return position;
+}
+
+inline const char * ReadOSMWay(
+    const char * position,
+    const char * end,
+    ExtractionWay & way
+) {
+    position += strlen("<way");
+    XMLAttribute attribute;
+    bool is_empty_element = false;
+    while(ReadAttribute(position, end, attribute, is_empty_element)) {
+        if(attribute.NameEquals("id")) {
+            way.id = ParseUnsigned(attribute);
+        }
+    }
+    if(is_empty_element) {
+        return position;
+    }
+
+    std::size_t name_length;
+    bool is_closing_tag;
+    while(position < end) {
+        const char * name = ReadTagName(position, end, name_length, is_closing_tag);
+        if(NULL == name) {
+            break;
+        }
+        if(is_closing_tag) {
+            position = SkipTag(position, end);
+            if(TagNameEquals(name, name_length, "way")) {
+                break;
+            }
+        } else if(TagNameEquals(name, name_length, "nd")) {
+            while(ReadAttribute(position, end, attribute, is_empty_element)) {
+                if(attribute.NameEquals("ref")) {
+                    way.path.push_back(ParseUnsigned(attribute));
+                }
+            }
+        } else if(TagNameEquals(name, name_length, "tag")) {
+            ReadTag(position, end, way.keyVals);
+        } else {
+            position = SkipTag(position, end);
+        }
+    }
+    return position;
+}
+
+// Reads a <relation> element. Only turn restrictions are of interest, so
+// is_restriction reports whether it is tagged type=restriction.
+inline const char * ReadOSMRelation(
+    const char * position,
+    const char * end,
+    _RawRestrictionContainer & restriction,
+    bool & is_restriction,
+    std::string & except_tag_string
+) {
+    position += strlen("<relation");
+    XMLAttribute attribute;
+    bool is_empty_element = false;
+    while(ReadAttribute(position, end, attribute, is_empty_element)) {
+        if(attribute.NameEquals("id")) {
+            restriction.relationID = ParseUnsigned(attribute);
+        }
+    }
+    if(is_empty_element) {
+        return position;
+    }
+
+    std::size_t name_length;
+    bool is_closing_tag;
+    while(position < end) {
+        const char * name = ReadTagName(position, end, name_length, is_closing_tag);
+        if(NULL == name) {
+            break;
+        }
+        if(is_closing_tag) {
+            position = SkipTag(position, end);
+            if(TagNameEquals(name, name_length, "relation")) {
+                break;
+            }
+        } else if(TagNameEquals(name, name_length, "tag")) {
+            HashTable<std::string, std::string> key_value_pairs;
+            ReadTag(position, end, key_value_pairs);
+            if("restriction" == key_value_pairs.Find("type")) {
+                is_restriction = true;
+            }
+            if(0 == key_value_pairs.Find("restriction").find("only_")) {
+                restriction.restriction.flags.isOnly = true;
+            }
+            if(key_value_pairs.Holds("except")) {
+                except_tag_string = key_value_pairs.Find("except");
+            }
+        } else if(TagNameEquals(name, name_length, "member")) {
+            XMLAttribute type, ref, role;
+            type.value_length = ref.value_length = role.value_length = 0;
+            while(ReadAttribute(position, end, attribute, is_empty_element)) {
+                if(attribute.NameEquals("type")) {
+                    type = attribute;
+                } else if(attribute.NameEquals("ref")) {
+                    ref = attribute;
+                } else if(attribute.NameEquals("role")) {
+                    role = attribute;
+                }
+            }
+            if(0 == ref.value_length) {
+                continue;
+            }
+            if(role.ValueEquals("from") && type.ValueEquals("way")) {
+                restriction.fromWay = ParseUnsigned(ref);
+            } else if(role.ValueEquals("to") && type.ValueEquals("way")) {
+                restriction.toWay = ParseUnsigned(ref);
+            } else if(role.ValueEquals("via") && type.ValueEquals("node")) {
+                restriction.restriction.viaNode = ParseUnsigned(ref);
+            }
+        } else {
+            position = SkipTag(position, end);
+        }
+    }
+    return position;
+}
+
+#endif /* OSMXMLTOKENIZER_H_ */
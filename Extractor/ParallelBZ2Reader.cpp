@@ -0,0 +1,365 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "ParallelBZ2Reader.h"
+
+#include "../Util/OpenMPWrapper.h"
+#include "../Util/OSRMException.h"
+
+#include <boost/foreach.hpp>
+
+#include <bzlib.h>
+
+#include <algorithm>
+
+// 48 bit magic numbers that start a compressed block and end a bz2 stream.
+static const boost::uint64_t BZ2_BLOCK_MAGIC         = 0x314159265359ULL;
+static const boost::uint64_t BZ2_END_OF_STREAM_MAGIC = 0x177245385090ULL;
+static const boost::uint64_t BZ2_MAGIC_MASK          = 0xFFFFFFFFFFFFULL;
+static const unsigned BZ2_MAGIC_BITS = 48;
+static const unsigned BZ2_CRC_BITS   = 32;
+// a magic at any bit offset lies within this many bytes
+static const unsigned BZ2_WINDOW_BYTES = 7;
+
+// A block with a spurious magic number inside is retried against up to this
+// many following markers before giving up.
+static const unsigned MAX_MARKERS_TO_MERGE = 4;
+
+// For every bit offset of a magic within its 7 byte window the second byte
+// of the window is completely covered by the magic. A table on that byte
+// rules out almost all windows without looking at single bits.
+struct BlockMagicFilter {
+    BlockMagicFilter() {
+        std::fill(candidates, candidates + 256, 0);
+        for(unsigned shift = 0; shift < 8; ++shift) {
+            candidates[SecondWindowByte(BZ2_BLOCK_MAGIC, shift)]         |= 1 << (2*shift);
+            candidates[SecondWindowByte(BZ2_END_OF_STREAM_MAGIC, shift)] |= 2 << (2*shift);
+        }
+    }
+
+    static unsigned char SecondWindowByte(const boost::uint64_t magic, const unsigned shift) {
+        return ((magic << (8 - shift)) >> 40) & 0xFF;
+    }
+
+    boost::uint16_t candidates[256];
+};
+
+static const BlockMagicFilter block_magic_filter;
+
+static inline unsigned GetBit(
+    const std::vector<unsigned char> & buffer,
+    const boost::uint64_t bit
+) {
+    return (buffer[bit/8] >> (7 - bit%8)) & 1;
+}
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<char> & output) : output(output), free_bits(0) { }
+
+    inline void PutBit(const unsigned bit) {
+        if(0 == free_bits) {
+            output.push_back(0);
+            free_bits = 8;
+        }
+        --free_bits;
+        output.back() |= (bit << free_bits);
+    }
+
+    inline void PutBits(const boost::uint64_t value, const unsigned number_of_bits) {
+        for(unsigned i = number_of_bits; i > 0; --i) {
+            PutBit((value >> (i-1)) & 1);
+        }
+    }
+
+    inline bool IsByteAligned() const {
+        return 0 == free_bits;
+    }
+
+private:
+    std::vector<char> & output;
+    unsigned free_bits;
+};
+
+ParallelBZ2Reader::ParallelBZ2Reader(const std::string & file_name) :
+    input_file(NULL),
+    input_exhausted(false),
+    scanned_bytes(0)
+{
+    input_file = fopen(file_name.c_str(), "rb");
+    if(NULL == input_file) {
+        throw OSRMException("bz2 file not found.");
+    }
+}
+
+ParallelBZ2Reader::~ParallelBZ2Reader() {
+    if(NULL != input_file) {
+        fclose(input_file);
+    }
+}
+
+// Scans the bytes that arrived since the last call. Only windows in which
+// every bit offset of a magic fits into the buffer are scanned, the rest is
+// picked up once more data is there.
+void ParallelBZ2Reader::FindBlockMarkers() {
+    const std::size_t buffer_size = compressed_buffer.size();
+    std::size_t last_byte = buffer_size;
+    if(!input_exhausted) {
+        last_byte = (buffer_size > BZ2_MAGIC_BITS/8) ? buffer_size - BZ2_MAGIC_BITS/8 : 0;
+    }
+    if(last_byte <= scanned_bytes) {
+        return;
+    }
+
+    const int number_of_chunks = 4*omp_get_max_threads();
+    const std::size_t chunk_size = (last_byte - scanned_bytes + number_of_chunks - 1)/number_of_chunks;
+    std::vector<std::vector<BlockMarker> > chunk_markers(number_of_chunks);
+#pragma omp parallel for schedule ( dynamic )
+    for(int i = 0; i < number_of_chunks; ++i) {
+        const std::size_t first_byte = std::min(last_byte, scanned_bytes + i*chunk_size);
+        FindBlockMarkersInRange(
+            first_byte,
+            std::min(last_byte, first_byte + chunk_size),
+            chunk_markers[i]
+        );
+    }
+    BOOST_FOREACH(const std::vector<BlockMarker> & markers, chunk_markers) {
+        block_markers.insert(block_markers.end(), markers.begin(), markers.end());
+    }
+    scanned_bytes = last_byte;
+}
+
+// Looks for magics starting in the bytes [first_byte, last_byte).
+void ParallelBZ2Reader::FindBlockMarkersInRange(
+    const std::size_t first_byte,
+    const std::size_t last_byte,
+    std::vector<BlockMarker> & markers
+) const {
+    const std::size_t buffer_size = compressed_buffer.size();
+    for(std::size_t i = first_byte; i < last_byte && i+1 < buffer_size; ++i) {
+        const boost::uint16_t candidates = block_magic_filter.candidates[compressed_buffer[i+1]];
+        if(0 == candidates) {
+            continue;
+        }
+        boost::uint64_t window = 0;
+        for(std::size_t j = i; j < i + BZ2_WINDOW_BYTES; ++j) {
+            window = (window << 8) | ((j < buffer_size) ? compressed_buffer[j] : 0);
+        }
+        for(unsigned shift = 0; shift < 8; ++shift) {
+            const boost::uint64_t bit = 8*i + shift;
+            if(0 == (candidates & (3 << 2*shift)) || bit + BZ2_MAGIC_BITS > 8*buffer_size) {
+                continue;
+            }
+            const boost::uint64_t candidate = (window >> (8 - shift)) & BZ2_MAGIC_MASK;
+            if(BZ2_BLOCK_MAGIC == candidate) {
+                markers.push_back(BlockMarker(bit, false));
+            } else if(BZ2_END_OF_STREAM_MAGIC == candidate) {
+                markers.push_back(BlockMarker(bit, true));
+            }
+        }
+    }
+}
+
+// Wraps the bits [first_bit, last_bit) of a single compressed block into a
+// standalone stream: stream header, block, end of stream marker and a
+// combined CRC, which for a single block equals the block CRC.
+void ParallelBZ2Reader::BuildSingleBlockStream(
+    const boost::uint64_t first_bit,
+    const boost::uint64_t last_bit,
+    std::vector<char> & stream
+) const {
+    stream.clear();
+    stream.reserve((last_bit - first_bit)/8 + 16);
+    stream.push_back('B');
+    stream.push_back('Z');
+    stream.push_back('h');
+    stream.push_back('9');
+
+    const unsigned shift = first_bit % 8;
+    const boost::uint64_t number_of_full_bytes = (last_bit - first_bit)/8;
+    const std::size_t first_byte = first_bit/8;
+    for(boost::uint64_t i = 0; i < number_of_full_bytes; ++i) {
+        unsigned char value = compressed_buffer[first_byte + i] << shift;
+        if(0 != shift) {
+            value |= compressed_buffer[first_byte + i + 1] >> (8 - shift);
+        }
+        stream.push_back(value);
+    }
+
+    BitWriter writer(stream);
+    for(boost::uint64_t bit = first_bit + 8*number_of_full_bytes; bit < last_bit; ++bit) {
+        writer.PutBit(GetBit(compressed_buffer, bit));
+    }
+    writer.PutBits(BZ2_END_OF_STREAM_MAGIC, BZ2_MAGIC_BITS);
+    for(unsigned i = 0; i < BZ2_CRC_BITS; ++i) {
+        writer.PutBit(GetBit(compressed_buffer, first_bit + BZ2_MAGIC_BITS + i));
+    }
+}
+
+bool ParallelBZ2Reader::DecompressBlock(
+    const boost::uint64_t first_bit,
+    const boost::uint64_t last_bit,
+    std::vector<char> & output
+) const {
+    std::vector<char> stream;
+    BuildSingleBlockStream(first_bit, last_bit, stream);
+
+    output.resize(std::max(output.capacity(), (std::size_t)(2*1024*1024)));
+    while(true) {
+        unsigned output_length = output.size();
+        const int error = BZ2_bzBuffToBuffDecompress(
+            &output[0],
+            &output_length,
+            &stream[0],
+            stream.size(),
+            0,
+            0
+        );
+        if(BZ_OK == error) {
+            output.resize(output_length);
+            return true;
+        }
+        if(BZ_OUTBUFF_FULL != error) {
+            output.clear();
+            return false;
+        }
+        output.resize(2*output.size());
+    }
+}
+
+bool ParallelBZ2Reader::Read(std::vector<char> & output) {
+    if(!input_exhausted) {
+        const std::size_t old_size = compressed_buffer.size();
+        compressed_buffer.resize(old_size + READ_SIZE);
+        const std::size_t bytes_read = fread(
+            &compressed_buffer[old_size],
+            1,
+            READ_SIZE,
+            input_file
+        );
+        compressed_buffer.resize(old_size + bytes_read);
+        if(bytes_read < READ_SIZE) {
+            input_exhausted = true;
+        }
+    }
+
+    FindBlockMarkers();
+    const std::vector<BlockMarker> & markers = block_markers;
+
+    // every block marker that is followed by another marker is complete
+    std::vector<std::size_t> complete_blocks;
+    for(std::size_t i = 0; i+1 < markers.size(); ++i) {
+        if(!markers[i].end_of_stream) {
+            complete_blocks.push_back(i);
+        }
+    }
+
+    const int number_of_blocks = complete_blocks.size();
+    std::vector<std::vector<char> > decompressed_blocks(number_of_blocks);
+    std::vector<char> block_is_valid(number_of_blocks);
+#pragma omp parallel for schedule ( dynamic )
+    for(int i = 0; i < number_of_blocks; ++i) {
+        const std::size_t marker = complete_blocks[i];
+        block_is_valid[i] = DecompressBlock(
+            markers[marker].bit,
+            markers[marker+1].bit,
+            decompressed_blocks[i]
+        );
+    }
+
+    // Append in file order. A block that fails to decompress most likely
+    // contains a spurious block magic, so it is merged with its successors.
+    std::size_t first_unconsumed_marker = 0;
+    bool needs_more_data = false;
+    for(int i = 0; i < number_of_blocks; ++i) {
+        const std::size_t marker = complete_blocks[i];
+        if(marker < first_unconsumed_marker) {
+            continue;
+        }
+        if(block_is_valid[i]) {
+            output.insert(output.end(), decompressed_blocks[i].begin(), decompressed_blocks[i].end());
+            first_unconsumed_marker = marker + 1;
+            continue;
+        }
+        std::vector<char> merged_block;
+        bool block_is_recovered = false;
+        for(
+            std::size_t last_marker = marker + 2;
+            last_marker < markers.size() && last_marker <= marker + MAX_MARKERS_TO_MERGE;
+            ++last_marker
+        ) {
+            if(DecompressBlock(markers[marker].bit, markers[last_marker].bit, merged_block)) {
+                output.insert(output.end(), merged_block.begin(), merged_block.end());
+                first_unconsumed_marker = last_marker;
+                block_is_recovered = true;
+                break;
+            }
+        }
+        if(!block_is_recovered) {
+            if(input_exhausted) {
+                throw OSRMException("bz2 block could not be decompressed");
+            }
+            first_unconsumed_marker = marker;
+            needs_more_data = true;
+            break;
+        }
+    }
+
+    // Retain everything from the first block that has not been decompressed.
+    // Without any marker, keep enough bytes for a magic that straddles reads.
+    std::size_t first_retained_byte = 0;
+    if(needs_more_data) {
+        first_retained_byte = markers[first_unconsumed_marker].bit/8;
+    } else if(!markers.empty()) {
+        first_retained_byte = markers.back().bit/8;
+    } else if(compressed_buffer.size() > BZ2_MAGIC_BITS/8) {
+        first_retained_byte = compressed_buffer.size() - BZ2_MAGIC_BITS/8;
+    }
+    compressed_buffer.erase(compressed_buffer.begin(), compressed_buffer.begin() + first_retained_byte);
+
+    if(input_exhausted) {
+        if(markers.empty() || !markers.back().end_of_stream) {
+            throw OSRMException("bz2 file is truncated");
+        }
+        compressed_buffer.clear();
+        block_markers.clear();
+        return false;
+    }
+
+    // keep the markers within the retained bytes, the scan resumes behind them
+    std::vector<BlockMarker> retained_markers;
+    const boost::uint64_t first_retained_bit = 8*first_retained_byte;
+    BOOST_FOREACH(const BlockMarker & marker, markers) {
+        if(marker.bit >= first_retained_bit) {
+            retained_markers.push_back(BlockMarker(marker.bit - first_retained_bit, marker.end_of_stream));
+        }
+    }
+    block_markers.swap(retained_markers);
+    scanned_bytes -= std::min(scanned_bytes, first_retained_byte);
+    return true;
+}
@@ -0,0 +1,87 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef PARALLELBZ2READER_H_
+#define PARALLELBZ2READER_H_
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+// Reads a (possibly multi-stream) .bz2 file and decompresses it on all cores.
+// Compressed blocks are located by their bit-aligned block magic, wrapped into
+// standalone single-block streams and decompressed independently.
+class ParallelBZ2Reader : boost::noncopyable {
+public:
+    explicit ParallelBZ2Reader(const std::string & file_name);
+    ~ParallelBZ2Reader();
+
+    // Appends the next run of decompressed blocks to output in file order.
+    // Returns false once the whole file has been decompressed.
+    bool Read(std::vector<char> & output);
+
+private:
+    struct BlockMarker {
+        BlockMarker(const boost::uint64_t bit, const bool end_of_stream) :
+            bit(bit), end_of_stream(end_of_stream) { }
+        boost::uint64_t bit;
+        bool end_of_stream;
+    };
+
+    void FindBlockMarkers();
+    void FindBlockMarkersInRange(
+        const std::size_t first_byte,
+        const std::size_t last_byte,
+        std::vector<BlockMarker> & markers
+    ) const;
+    void BuildSingleBlockStream(
+        const boost::uint64_t first_bit,
+        const boost::uint64_t last_bit,
+        std::vector<char> & stream
+    ) const;
+    bool DecompressBlock(
+        const boost::uint64_t first_bit,
+        const boost::uint64_t last_bit,
+        std::vector<char> & output
+    ) const;
+
+    FILE * input_file;
+    bool input_exhausted;
+    std::vector<unsigned char> compressed_buffer;
+    // markers found so far and the first byte that has not been scanned
+    std::vector<BlockMarker> block_markers;
+    std::size_t scanned_bytes;
+
+    static const std::size_t READ_SIZE = 32*1024*1024;
+};
+
+#endif /* PARALLELBZ2READER_H_ */
@@ -0,0 +1,192 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "ParallelXMLParser.h"
+
+#include "ExtractorStructs.h"
+#include "OSMXMLTokenizer.h"
+#include "../Util/OSRMException.h"
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread.hpp>
+
+ParallelXMLParser::ParallelXMLParser(
+    const char * filename,
+    ExtractorCallbacks* ec,
+    ScriptingEnvironment& se
+) : BaseParser(ec, se), plain_input(NULL) {
+    const std::string input_name(filename);
+    if(std::string::npos != input_name.find(".osm.bz2")) {
+        bz2_reader = boost::make_shared<ParallelBZ2Reader>(input_name);
+    } else {
+        plain_input = fopen(filename, "rb");
+        if(NULL == plain_input) {
+            throw OSRMException("osm file not found.");
+        }
+    }
+    text_queue = boost::make_shared<ConcurrentQueue<std::vector<char> *> >(4);
+}
+
+ParallelXMLParser::~ParallelXMLParser() {
+    if(NULL != plain_input) {
+        fclose(plain_input);
+    }
+    std::vector<char> * text;
+    while(text_queue->try_pop(text)) {
+        delete text;
+    }
+}
+
+bool ParallelXMLParser::ReadHeader() {
+    return (NULL != plain_input) || bz2_reader;
+}
+
+void ParallelXMLParser::ReadData() {
+    bool keep_running = true;
+    do {
+        std::vector<char> * text = new std::vector<char>();
+        if(bz2_reader) {
+            keep_running = bz2_reader->Read(*text);
+        } else {
+            text->resize(PLAIN_READ_SIZE);
+            text->resize(fread(&(*text)[0], 1, PLAIN_READ_SIZE, plain_input));
+            keep_running = (PLAIN_READ_SIZE == text->size());
+        }
+        if(text->empty()) {
+            delete text;
+        } else {
+            text_queue->push(text);
+        }
+    } while(keep_running);
+    text_queue->push(NULL); // No more data to read, parse stops when NULL encountered
+}
+
+void ParallelXMLParser::ParseData() {
+    std::vector<char> pending_text;
+    while(true) {
+        std::vector<char> * text;
+        text_queue->wait_and_pop(text);
+        if(NULL == text) {
+            break;
+        }
+        pending_text.insert(pending_text.end(), text->begin(), text->end());
+        delete text;
+
+        // the last element may still be cut off, keep it for the next round
+        const char * begin = &pending_text[0];
+        const char * last_element_start = FindLastElementStart(begin, begin + pending_text.size());
+        ParseText(begin, last_element_start);
+        pending_text.erase(pending_text.begin(), pending_text.begin() + (last_element_start - begin));
+    }
+    if(!pending_text.empty()) {
+        ParseText(&pending_text[0], &pending_text[0] + pending_text.size());
+    }
+    SimpleLogger().Write() << "Parse Data Thread Finished";
+}
+
+void ParallelXMLParser::ParseText(const char * begin, const char * end) {
+    if(begin == end) {
+        return;
+    }
+    const int number_of_chunks = 4*omp_get_max_threads();
+    std::vector<const char *> chunk_boundaries(number_of_chunks+1, end);
+    chunk_boundaries[0] = begin;
+    for(int i = 1; i < number_of_chunks; ++i) {
+        chunk_boundaries[i] = FindElementStart(
+            std::max(chunk_boundaries[i-1], begin + i*((end - begin)/number_of_chunks)),
+            end
+        );
+    }
+
+    std::vector<ParsedChunk> parsed_chunks(number_of_chunks);
+#pragma omp parallel for schedule ( dynamic )
+    for(int i = 0; i < number_of_chunks; ++i) {
+        ParseChunk(chunk_boundaries[i], chunk_boundaries[i+1], parsed_chunks[i]);
+    }
+
+    // hand over the results in file order
+    BOOST_FOREACH(ParsedChunk & chunk, parsed_chunks) {
+        BOOST_FOREACH(const ImportNode & n, chunk.nodes) {
+            extractor_callbacks->nodeFunction(n);
+        }
+        BOOST_FOREACH(ExtractionWay & w, chunk.ways) {
+            // ExtractorCallbacks needs a first and a last segment
+            if(2 > w.path.size()) {
+                continue;
+            }
+            extractor_callbacks->wayFunction(w);
+        }
+        BOOST_FOREACH(const _RawRestrictionContainer & r, chunk.restrictions) {
+            if(!extractor_callbacks->restrictionFunction(r)) {
+                std::cerr << "[ParallelXMLParser] restriction not parsed" << std::endl;
+            }
+        }
+    }
+}
+
+void ParallelXMLParser::ParseChunk(const char * begin, const char * end, ParsedChunk & chunk) {
+    lua_State * lua_state = scriptingEnvironment.getLuaStateForThreadID(omp_get_thread_num());
+    const char * position = FindElementStart(begin, end);
+    while(position < end) {
+        if(HasElementName(position+1, end, "node")) {
+            chunk.nodes.push_back(ImportNode());
+            position = ReadOSMNode(position, end, chunk.nodes.back());
+            ParseNodeInLua(chunk.nodes.back(), lua_state);
+        } else if(HasElementName(position+1, end, "way")) {
+            chunk.ways.push_back(ExtractionWay());
+            position = ReadOSMWay(position, end, chunk.ways.back());
+            ParseWayInLua(chunk.ways.back(), lua_state);
+        } else if(use_turn_restrictions) {
+            // like the libxml2 path, any relation with a from way is handed on
+            _RawRestrictionContainer restriction;
+            bool is_restriction = false;
+            std::string except_tag_string;
+            position = ReadOSMRelation(position, end, restriction, is_restriction, except_tag_string);
+            if(UINT_MAX != restriction.fromWay && !ShouldIgnoreRestriction(except_tag_string)) {
+                chunk.restrictions.push_back(restriction);
+            }
+        } else {
+            ++position;
+        }
+        position = FindElementStart(position, end);
+    }
+}
+
+bool ParallelXMLParser::Parse() {
+    // Start the read and parse threads
+    boost::thread readThread(boost::bind(&ParallelXMLParser::ReadData, this));
+    boost::thread parseThread(boost::bind(&ParallelXMLParser::ParseData, this));
+
+    // Wait for the threads to finish
+    readThread.join();
+    parseThread.join();
+
+    return true;
+}
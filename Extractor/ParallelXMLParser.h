@@ -0,0 +1,77 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef PARALLELXMLPARSER_H_
+#define PARALLELXMLPARSER_H_
+
+#include "BaseParser.h"
+#include "ParallelBZ2Reader.h"
+#include "../DataStructures/ConcurrentQueue.h"
+#include "../DataStructures/Coordinate.h"
+#include "../Util/OpenMPWrapper.h"
+#include "../Util/SimpleLogger.h"
+#include "../typedefs.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+// Parses .osm and .osm.bz2 files without libxml2. The input is decompressed
+// block-parallel, cut at top-level element boundaries and every piece is
+// tokenized and run through the profile on its own thread.
+class ParallelXMLParser : public BaseParser {
+public:
+    ParallelXMLParser(const char * filename, ExtractorCallbacks* ec, ScriptingEnvironment& se);
+    virtual ~ParallelXMLParser();
+
+    bool ReadHeader();
+    bool Parse();
+
+private:
+    struct ParsedChunk {
+        std::vector<ImportNode> nodes;
+        std::vector<ExtractionWay> ways;
+        std::vector<_RawRestrictionContainer> restrictions;
+    };
+
+    void ReadData();
+    void ParseData();
+    void ParseText(const char * begin, const char * end);
+    void ParseChunk(const char * begin, const char * end, ParsedChunk & chunk);
+
+    boost::shared_ptr<ParallelBZ2Reader> bz2_reader;
+    FILE * plain_input;
+    boost::shared_ptr<ConcurrentQueue<std::vector<char> *> > text_queue;
+
+    static const std::size_t PLAIN_READ_SIZE = 32*1024*1024;
+};
+
+#endif /* PARALLELXMLPARSER_H_ */
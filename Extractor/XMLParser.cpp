@@ -91,6 +91,12 @@ _RawRestrictionContainer XMLParser::_ReadXMLRestriction() {
     _RawRestrictionContainer restriction;
     std::string except_tag_string;
 
+	xmlChar* relation_id = xmlTextReaderGetAttribute( inputReader, ( const xmlChar* ) "id" );
+	if ( relation_id != NULL ) {
+		restriction.relationID = stringToUint(( const char* ) relation_id );
+		xmlFree( relation_id );
+	}
+
 	if ( xmlTextReaderIsEmptyElement( inputReader ) != 1 ) {
 		const int depth = xmlTextReaderDepth( inputReader );while ( xmlTextReaderRead( inputReader ) == 1 ) {
 			const int childType = xmlTextReaderNodeType( inputReader );
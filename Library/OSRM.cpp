@@ -29,19 +29,30 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/foreach.hpp>
 
 
-OSRM::OSRM(boost::unordered_map<const std::string,boost::filesystem::path>& paths) {
+OSRM::OSRM(
+    boost::unordered_map<const std::string,boost::filesystem::path>& paths,
+    const unsigned route_cache_megabytes
+) : route_cache(NULL) {
     objects = new QueryObjectsStorage( paths );
+    if(0 < route_cache_megabytes) {
+        route_cache = new RouteCache(
+            static_cast<std::size_t>(route_cache_megabytes)*1024*1024,
+            objects->nodeHelpDesk->GetCheckSum()
+        );
+    }
     RegisterPlugin(new HelloWorldPlugin());
     RegisterPlugin(new LocatePlugin(objects));
+    RegisterPlugin(new MetricsPlugin(route_cache));
     RegisterPlugin(new NearestPlugin(objects));
     RegisterPlugin(new TimestampPlugin(objects));
-    RegisterPlugin(new ViaRoutePlugin(objects));
+    RegisterPlugin(new ViaRoutePlugin(objects, route_cache));
 }
 
 OSRM::~OSRM() {
     BOOST_FOREACH(PluginMap::value_type & plugin_pointer, pluginMap) {
         delete plugin_pointer.second;
     }
+    delete route_cache;
     delete objects;
 }
 
@@ -51,14 +62,24 @@ void OSRM::RegisterPlugin(BasePlugin * plugin) {
         delete pluginMap.find(plugin->GetDescriptor())->second;
     }
     pluginMap.emplace(plugin->GetDescriptor(), plugin);
+    QueryMetrics::RegisterPlugin(plugin->GetDescriptor());
 }
 
 void OSRM::RunQuery(RouteParameters & route_parameters, http::Reply & reply) {
+    //queries that do not come in through the server are measured here
+    const bool is_server_request = (NULL != QueryMetrics::GetCurrentStatistics());
+    if(!is_server_request) {
+        QueryMetrics::BeginRequest();
+    }
     const PluginMap::const_iterator & iter = pluginMap.find(route_parameters.service);
     if(pluginMap.end() != iter) {
+        QueryMetrics::SetPlugin(route_parameters.service);
         reply.status = http::Reply::ok;
         iter->second->HandleRequest(route_parameters, reply );
     } else {
         reply = http::Reply::stockReply(http::Reply::badRequest);
     }
+    if(!is_server_request) {
+        QueryMetrics::EndRequest();
+    }
 }
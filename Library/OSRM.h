@@ -33,13 +33,16 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../Plugins/BasePlugin.h"
 #include "../Plugins/HelloWorldPlugin.h"
 #include "../Plugins/LocatePlugin.h"
+#include "../Plugins/MetricsPlugin.h"
 #include "../Plugins/NearestPlugin.h"
 #include "../Plugins/TimestampPlugin.h"
 #include "../Plugins/ViaRoutePlugin.h"
+#include "../Server/DataStructures/RouteCache.h"
 #include "../Server/DataStructures/RouteParameters.h"
 #include "../Util/InputFileUtil.h"
 #include "../Util/OSRMException.h"
 #include "../Util/ProgramOptions.h"
+#include "../Util/QueryMetrics.h"
 #include "../Util/SimpleLogger.h"
 #include "../Server/BasicDatastructures.h"
 
@@ -53,8 +56,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 class OSRM : boost::noncopyable {
     typedef boost::unordered_map<std::string, BasePlugin *> PluginMap;
     QueryObjectsStorage * objects;
+    RouteCache * route_cache;
 public:
-    OSRM(boost::unordered_map<const std::string,boost::filesystem::path>& paths);
+    //a route cache size of zero disables caching of route responses
+    OSRM(
+        boost::unordered_map<const std::string,boost::filesystem::path>& paths,
+        const unsigned route_cache_megabytes = 0
+    );
     ~OSRM();
     void RunQuery(RouteParameters & route_parameters, http::Reply & reply);
 private:
@@ -31,6 +31,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "BasePlugin.h"
 #include "../DataStructures/NodeInformationHelpDesk.h"
 #include "../Server/DataStructures/QueryObjectsStorage.h"
+#include "../Util/QueryMetrics.h"
 #include "../Util/StringUtil.h"
 
 /*
@@ -66,7 +67,10 @@ public:
         reply.status = http::Reply::ok;
         reply.content += ("{");
         reply.content += ("\"version\":0.3,");
-        if(!nodeHelpDesk->LocateClosestEndPointForCoordinate(routeParameters.coordinates[0], result)) {
+        QueryStageTimer snapping_timer(QUERY_STAGE_SNAPPING);
+        const bool found_coordinate = nodeHelpDesk->LocateClosestEndPointForCoordinate(routeParameters.coordinates[0], result);
+        snapping_timer.Stop();
+        if(!found_coordinate) {
             reply.content += ("\"status\":207,");
             reply.content += ("\"mapped_coordinate\":[]");
         } else {
@@ -83,6 +87,10 @@ public:
             reply.content += "]";
         }
         reply.content += ",\"transactionId\": \"OSRM Routing Engine JSON Locate (v0.3)\"";
+        if(routeParameters.trace) {
+            reply.content += ",\"trace\":";
+            QueryMetrics::AppendTraceAsJSON(reply.content);
+        }
         reply.content += ("}");
         reply.headers.resize(3);
         if("" != routeParameters.jsonpParameter) {
@@ -0,0 +1,67 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef METRICSPLUGIN_H_
+#define METRICSPLUGIN_H_
+
+#include "BasePlugin.h"
+#include "../Server/DataStructures/RouteCache.h"
+#include "../Util/AsyncLogger.h"
+#include "../Util/QueryMetrics.h"
+#include "../Util/StringUtil.h"
+
+// Exports the per-stage latency histograms, query and logger counters in
+// the Prometheus text format, e.g. for scraping /metrics
+class MetricsPlugin : public BasePlugin {
+public:
+    MetricsPlugin(RouteCache * route_cache = NULL) :
+        route_cache(route_cache),
+        descriptor_string("metrics")
+    { }
+    const std::string & GetDescriptor() const { return descriptor_string; }
+    void HandleRequest(const RouteParameters & routeParameters, http::Reply& reply) {
+        std::string tmp;
+        reply.status = http::Reply::ok;
+        QueryMetrics::WritePrometheus(reply.content);
+        AsyncLogger::GetInstance().WritePrometheus(reply.content);
+        if(NULL != route_cache) {
+            route_cache->WritePrometheus(reply.content);
+        }
+        reply.headers.resize(2);
+        reply.headers[1].name = "Content-Type";
+        reply.headers[1].value = "text/plain; version=0.0.4";
+        reply.headers[0].name = "Content-Length";
+        intToString(reply.content.size(), tmp);
+        reply.headers[0].value = tmp;
+    }
+private:
+    RouteCache * route_cache;
+    std::string descriptor_string;
+};
+
+#endif /* METRICSPLUGIN_H_ */
@@ -31,7 +31,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "BasePlugin.h"
 
 #include "../DataStructures/NodeInformationHelpDesk.h"
+#include "../Descriptors/BinaryResponseFormat.h"
 #include "../Server/DataStructures/QueryObjectsStorage.h"
+#include "../Util/QueryMetrics.h"
 #include "../Util/StringUtil.h"
 
 /*
@@ -46,6 +48,7 @@ public:
     {
         descriptorTable.insert(std::make_pair(""    , 0)); //default descriptor
         descriptorTable.insert(std::make_pair("json", 1));
+        descriptorTable.insert(std::make_pair("binary", 2));
     }
     const std::string & GetDescriptor() const { return descriptor_string; }
     void HandleRequest(const RouteParameters & routeParameters, http::Reply& reply) {
@@ -61,13 +64,19 @@ public:
         NodeInformationHelpDesk * nodeHelpDesk = m_query_objects->nodeHelpDesk;
         //query to helpdesk
         PhantomNode result;
+        QueryStageTimer snapping_timer(QUERY_STAGE_SNAPPING);
         nodeHelpDesk->FindPhantomNodeForCoordinate(
             routeParameters.coordinates[0],
             result,
             routeParameters.zoomLevel
         );
+        snapping_timer.Stop();
 
         std::string temp_string;
+        if(2 == descriptorTable.Find(routeParameters.outputFormat)) {
+            WriteBinaryReply(result, reply);
+            return;
+        }
         //json
 
         if("" != routeParameters.jsonpParameter) {
@@ -96,11 +105,21 @@ public:
         reply.content += "],";
         reply.content += "\"name\":\"";
         if(UINT_MAX != result.edgeBasedNode) {
-            m_query_objects->GetName(result.nodeBasedEdgeNameID, temp_string);
-            reply.content += temp_string;
+            const char * name;
+            unsigned name_length;
+            m_query_objects->GetEscapedName(
+                result.nodeBasedEdgeNameID,
+                name,
+                name_length
+            );
+            reply.content.append(name, name_length);
         }
         reply.content += "\"";
         reply.content += ",\"transactionId\":\"OSRM Routing Engine JSON Nearest (v0.3)\"";
+        if(routeParameters.trace) {
+            reply.content += ",\"trace\":";
+            QueryMetrics::AppendTraceAsJSON(reply.content);
+        }
         reply.content += ("}");
         reply.headers.resize(3);
         if("" != routeParameters.jsonpParameter) {
@@ -121,6 +140,48 @@ public:
     }
 
 private:
+    void WriteBinaryReply(const PhantomNode & result, http::Reply & reply) const {
+        const bool found = (UINT_MAX != result.edgeBasedNode);
+        const char * name = "";
+        unsigned name_length = 0;
+        if(found) {
+            m_query_objects->GetName(
+                result.nodeBasedEdgeNameID,
+                name,
+                name_length
+            );
+        }
+
+        BinaryResponseHeader header;
+        std::copy(BINARY_RESPONSE_MAGIC, BINARY_RESPONSE_MAGIC+4, header.magic);
+        header.version = BINARY_RESPONSE_VERSION;
+        header.type = BINARY_NEAREST_RESPONSE;
+        header.status = (found ? 0 : 207);
+        header.check_sum = m_query_objects->nodeHelpDesk->GetCheckSum();
+
+        BinaryNearest nearest;
+        nearest.mapped_coordinate.lat = (found ? result.location.lat : INT_MIN);
+        nearest.mapped_coordinate.lon = (found ? result.location.lon : INT_MIN);
+        nearest.name_length = name_length;
+        nearest.reserved = 0;
+
+        reply.status = http::Reply::ok;
+        reply.content.append((const char *)&header, sizeof(header));
+        reply.content.append((const char *)&nearest, sizeof(nearest));
+        reply.content.append(name, name_length);
+        reply.content.append(BinaryPaddingBytes(name_length), '\0');
+
+        std::string temp_string;
+        reply.headers.resize(3);
+        reply.headers[0].name = "Content-Length";
+        intToString(reply.content.size(), temp_string);
+        reply.headers[0].value = temp_string;
+        reply.headers[1].name = "Content-Type";
+        reply.headers[1].value = "application/octet-stream";
+        reply.headers[2].name = "Content-Disposition";
+        reply.headers[2].value = "attachment; filename=\"location.osrb\"";
+    }
+
     QueryObjectsStorage * m_query_objects;
     HashTable<std::string, unsigned> descriptorTable;
     std::string descriptor_string;
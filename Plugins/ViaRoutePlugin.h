@@ -35,9 +35,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../DataStructures/StaticGraph.h"
 #include "../DataStructures/SearchEngine.h"
 #include "../Descriptors/BaseDescriptor.h"
+#include "../Descriptors/BinaryDescriptor.h"
 #include "../Descriptors/GPXDescriptor.h"
 #include "../Descriptors/JSONDescriptor.h"
 #include "../Server/DataStructures/QueryObjectsStorage.h"
+#include "../Server/DataStructures/RouteCache.h"
+#include "../Util/QueryMetrics.h"
 #include "../Util/SimpleLogger.h"
 #include "../Util/StringUtil.h"
 
@@ -54,25 +57,40 @@ private:
     StaticGraph<QueryEdge::EdgeData> * graph;
     HashTable<std::string, unsigned> descriptorTable;
     SearchEngine * searchEnginePtr;
+    //searches the weights of the traffic overlay, NULL without one
+    SearchEngine * trafficSearchEnginePtr;
+    RouteCache * route_cache;
+    //answer all route queries on the multi-level graph, without alternatives
+    bool useMultiLevelGraph;
 public:
 
-    ViaRoutePlugin(QueryObjectsStorage * objects)
+    //route_cache may be NULL, which disables caching of responses
+    ViaRoutePlugin(QueryObjectsStorage * objects, RouteCache * route_cache = NULL)
      :
         // objects(objects),
+        route_cache(route_cache),
         descriptor_string("viaroute")
     {
         nodeHelpDesk = objects->nodeHelpDesk;
         graph = objects->graph;
+        useMultiLevelGraph = (NULL != objects->multi_level_graph);
 
         searchEnginePtr = new SearchEngine(objects);
+        trafficSearchEnginePtr = NULL;
+        if(NULL != objects->traffic_overlay) {
+            trafficSearchEnginePtr = new SearchEngine(objects);
+            trafficSearchEnginePtr->UseTraffic(true);
+        }
 
         // descriptorTable.emplace(""    , 0);
         descriptorTable.emplace("json", 0);
         descriptorTable.emplace("gpx" , 1);
+        descriptorTable.emplace("binary", 2);
     }
 
     virtual ~ViaRoutePlugin() {
         delete searchEnginePtr;
+        delete trafficSearchEnginePtr;
     }
 
     const std::string & GetDescriptor() const { return descriptor_string; }
@@ -96,6 +114,7 @@ public:
             rawRoute.rawViaNodeCoordinates.push_back(routeParameters.coordinates[i]);
         }
         std::vector<PhantomNode> phantomNodeVector(rawRoute.rawViaNodeCoordinates.size());
+        QueryStageTimer snapping_timer(QUERY_STAGE_SNAPPING);
         for(unsigned i = 0; i < rawRoute.rawViaNodeCoordinates.size(); ++i) {
             if(checksumOK && i < routeParameters.hints.size() && "" != routeParameters.hints[i]) {
 //                SimpleLogger().Write() <<"Decoding hint: " << routeParameters.hints[i] << " for location index " << i;
@@ -108,6 +127,37 @@ public:
 //            SimpleLogger().Write() << "Brute force lookup of coordinate " << i;
             searchEnginePtr->FindPhantomNodeForCoordinate( rawRoute.rawViaNodeCoordinates[i], phantomNodeVector[i], routeParameters.zoomLevel);
         }
+        snapping_timer.Stop();
+
+        unsigned descriptorType = 0;
+        if(descriptorTable.find(routeParameters.outputFormat) != descriptorTable.end() ) {
+            descriptorType = descriptorTable.find(routeParameters.outputFormat)->second;
+        }
+        //binary responses cannot be wrapped into a javascript call
+        const bool wrapJSONP = ("" != routeParameters.jsonpParameter) && (2 != descriptorType);
+
+        //live traffic weights change between requests and are never cached
+        const bool useTraffic = routeParameters.traffic && (NULL != trafficSearchEnginePtr);
+        //traced requests have to run the search to report its statistics
+        const bool useCache = (NULL != route_cache) && !routeParameters.trace && !useTraffic;
+        std::string cacheKey;
+        RouteCache::Response cachedResponse;
+        if(useCache) {
+            RouteCache::BuildKey(phantomNodeVector, routeParameters, descriptorType, cacheKey);
+            if(route_cache->Fetch(cacheKey, rawRoute.checkSum, cachedResponse)) {
+                reply.status = http::Reply::ok;
+                if(wrapJSONP) {
+                    reply.content += routeParameters.jsonpParameter;
+                    reply.content += "(";
+                }
+                reply.chunked_content += *cachedResponse;
+                if(wrapJSONP) {
+                    reply.chunked_content += ")\n";
+                }
+                SetHeaders(reply, routeParameters, descriptorType);
+                return;
+            }
+        }
 
         for(unsigned i = 0; i < phantomNodeVector.size()-1; ++i) {
             PhantomNodes segmentPhantomNodes;
@@ -115,13 +165,22 @@ public:
             segmentPhantomNodes.targetPhantom = phantomNodeVector[i+1];
             rawRoute.segmentEndCoordinates.push_back(segmentPhantomNodes);
         }
-        if( ( routeParameters.alternateRoute ) && (1 == rawRoute.segmentEndCoordinates.size()) ) {
+        QueryStageTimer search_timer(QUERY_STAGE_SEARCH);
+        if( useMultiLevelGraph ) {
+            //computes no alternatives, loading the graph opts out of them
+            SearchEngine * engine = useTraffic ? trafficSearchEnginePtr : searchEnginePtr;
+            engine->multiLevelPath(rawRoute.segmentEndCoordinates, rawRoute);
+        } else if( useTraffic ) {
+            //alternatives are only computed on the static weights
+            trafficSearchEnginePtr->shortestPath(rawRoute.segmentEndCoordinates, rawRoute);
+        } else if( ( routeParameters.alternateRoute ) && (1 == rawRoute.segmentEndCoordinates.size()) ) {
 //            SimpleLogger().Write() << "Checking for alternative paths";
-            searchEnginePtr->alternativePaths(rawRoute.segmentEndCoordinates[0],  rawRoute);
+            searchEnginePtr->alternativePaths(rawRoute.segmentEndCoordinates[0], rawRoute, routeParameters.alternativeParameters);
 
         } else {
             searchEnginePtr->shortestPath(rawRoute.segmentEndCoordinates, rawRoute);
         }
+        search_timer.Stop();
 
 
         if(INT_MAX == rawRoute.lengthOfShortestPath ) {
@@ -131,21 +190,17 @@ public:
 
         //TODO: Move to member as smart pointer
         BaseDescriptor * desc;
-        if("" != routeParameters.jsonpParameter) {
-            reply.content += routeParameters.jsonpParameter;
-            reply.content += "(";
-        }
-
         _DescriptorConfig descriptorConfig;
 
-        unsigned descriptorType = 0;
-        if(descriptorTable.find(routeParameters.outputFormat) != descriptorTable.end() ) {
-            descriptorType = descriptorTable.find(routeParameters.outputFormat)->second;
+        if(wrapJSONP) {
+            reply.content += routeParameters.jsonpParameter;
+            reply.content += "(";
         }
         descriptorConfig.z = routeParameters.zoomLevel;
         descriptorConfig.instructions = routeParameters.printInstructions;
         descriptorConfig.geometry = routeParameters.geometry;
         descriptorConfig.encodeGeometry = routeParameters.compression;
+        descriptorConfig.trace = routeParameters.trace;
 
         switch(descriptorType){
         case 0:
@@ -155,6 +210,10 @@ public:
         case 1:
             desc = new GPXDescriptor();
 
+            break;
+        case 2:
+            desc = new BinaryDescriptor();
+
             break;
         default:
             desc = new JSONDescriptor();
@@ -166,18 +225,43 @@ public:
         phantomNodes.startPhantom = rawRoute.segmentEndCoordinates[0].startPhantom;
 //        SimpleLogger().Write() << "Start location: " << phantomNodes.startPhantom.location;
         phantomNodes.targetPhantom = rawRoute.segmentEndCoordinates[rawRoute.segmentEndCoordinates.size()-1].targetPhantom;
+        if( useTraffic ) {
+            //the search scaled the phantom nodes to the feed, hints keep the static offsets
+            for(unsigned i = 0; i < rawRoute.segmentEndCoordinates.size(); ++i) {
+                rawRoute.segmentEndCoordinates[i].startPhantom = phantomNodeVector[i];
+                rawRoute.segmentEndCoordinates[i].targetPhantom = phantomNodeVector[i+1];
+            }
+        }
 //        SimpleLogger().Write() << "TargetLocation: " << phantomNodes.targetPhantom.location;
 //        SimpleLogger().Write() << "Number of segments: " << rawRoute.segmentEndCoordinates.size();
         desc->SetConfig(descriptorConfig);
 
+        QueryStageTimer description_timer(QUERY_STAGE_DESCRIPTION);
         desc->Run(reply, rawRoute, phantomNodes, *searchEnginePtr);
-        if("" != routeParameters.jsonpParameter) {
-            reply.content += ")\n";
+        description_timer.Stop();
+        if(useCache) {
+            std::string * response = new std::string();
+            reply.chunked_content.AppendTo(*response);
+            route_cache->Insert(cacheKey, rawRoute.checkSum, RouteCache::Response(response));
+        }
+        if(wrapJSONP) {
+            reply.chunked_content += ")\n";
         }
+        SetHeaders(reply, routeParameters, descriptorType);
+
+        delete desc;
+        return;
+    }
+private:
+    void SetHeaders(
+        http::Reply & reply,
+        const RouteParameters & routeParameters,
+        const unsigned descriptorType
+    ) const {
         reply.headers.resize(3);
         reply.headers[0].name = "Content-Length";
         std::string tmp;
-        intToString(reply.content.size(), tmp);
+        intToString(reply.ContentSize(), tmp);
         reply.headers[0].value = tmp;
         switch(descriptorType){
         case 0:
@@ -200,6 +284,13 @@ public:
             reply.headers[2].name = "Content-Disposition";
             reply.headers[2].value = "attachment; filename=\"route.gpx\"";
 
+            break;
+        case 2:
+            reply.headers[1].name = "Content-Type";
+            reply.headers[1].value = "application/octet-stream";
+            reply.headers[2].name = "Content-Disposition";
+            reply.headers[2].value = "attachment; filename=\"route.osrb\"";
+
             break;
         default:
             if("" != routeParameters.jsonpParameter){
@@ -215,11 +306,8 @@ public:
             }
             break;
         }
-
-        delete desc;
-        return;
     }
-private:
+
     std::string descriptor_string;
 };
 
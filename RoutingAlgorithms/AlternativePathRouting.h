@@ -29,13 +29,16 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define ALTERNATIVEROUTES_H_
 
 #include "BasicRoutingInterface.h"
+#include "../DataStructures/AlternativeRouteParameters.h"
+#include "../DataStructures/SearchThreadBudget.h"
+#include "../Util/TimingUtil.h"
 #include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 #include <cmath>
 #include <vector>
 
-const double VIAPATH_ALPHA   = 0.15;
-const double VIAPATH_EPSILON = 0.10; //alternative at most 15% longer
-const double VIAPATH_GAMMA   = 0.75; //alternative shares at most 75% with the shortest.
+//number of via node candidates that are T-tested concurrently
+const unsigned VIAPATH_TASK_GROUP_SIZE = 4;
 
 template<class QueryDataT>
 class AlternativeRouting : private BasicRoutingInterface<QueryDataT> {
@@ -54,6 +57,15 @@ class AlternativeRouting : private BasicRoutingInterface<QueryDataT> {
         }
     };
 
+    //outcome of a T-test, evaluated on a helper thread
+    struct ViaNodeTest {
+        ViaNodeTest() : passed(false), lengthOfViaPath(INT_MAX) {}
+        bool passed;
+        int lengthOfViaPath;
+        std::vector<NodeID> packedViaPath;
+        DeferredSearchStatistics statistics;
+    };
+
     const SearchGraph * search_graph;
 
 public:
@@ -62,11 +74,16 @@ public:
 
     ~AlternativeRouting() {}
 
-    void operator()(const PhantomNodes & phantomNodePair, RawRouteData & rawRouteData) {
+    void operator()(
+        const PhantomNodes & phantomNodePair,
+        RawRouteData & rawRouteData,
+        const AlternativeRouteParameters & parameters = AlternativeRouteParameters()
+    ) {
         if(!phantomNodePair.AtLeastOnePhantomNodeIsUINTMAX() || phantomNodePair.PhantomNodesHaveEqualLocation()) {
-            rawRouteData.lengthOfShortestPath = rawRouteData.lengthOfAlternativePath = INT_MAX;
+            rawRouteData.lengthOfShortestPath = INT_MAX;
             return;
         }
+        const boost::uint64_t searchStart = get_monotonic_microseconds();
 
         std::vector<NodeID> alternativePath;
         std::vector<NodeID> viaNodeCandidates;
@@ -75,13 +92,9 @@ public:
 
         //Initialize Queues, semi-expensive because access to TSS invokes a system call
         super::_queryData.InitializeOrClearFirstThreadLocalStorage();
-        super::_queryData.InitializeOrClearSecondThreadLocalStorage();
-        super::_queryData.InitializeOrClearThirdThreadLocalStorage();
 
         QueryHeap & forward_heap1 = *(super::_queryData.forwardHeap);
         QueryHeap & reverse_heap1 = *(super::_queryData.backwardHeap);
-        QueryHeap & forward_heap2 = *(super::_queryData.forwardHeap2);
-        QueryHeap & reverse_heap2 = *(super::_queryData.backwardHeap2);
 
         int upper_bound_to_shortest_path_distance = INT_MAX;
         NodeID middle_node = UINT_MAX;
@@ -100,12 +113,14 @@ public:
         //exploration dijkstra from nodes s and t until deletemin/(1+epsilon) > _lengthOfShortestPath
         while(0 < (forward_heap1.Size() + reverse_heap1.Size())){
             if(0 < forward_heap1.Size()){
-                AlternativeRoutingStep<true >(forward_heap1, reverse_heap1, &middle_node, &upper_bound_to_shortest_path_distance, viaNodeCandidates, forward_search_space, forward_offset);
+                AlternativeRoutingStep<true >(forward_heap1, reverse_heap1, &middle_node, &upper_bound_to_shortest_path_distance, viaNodeCandidates, forward_search_space, forward_offset, parameters.epsilon);
             }
             if(0 < reverse_heap1.Size()){
-                AlternativeRoutingStep<false>(reverse_heap1, forward_heap1, &middle_node, &upper_bound_to_shortest_path_distance, viaNodeCandidates, reverse_search_space, reverse_offset);
+                AlternativeRoutingStep<false>(reverse_heap1, forward_heap1, &middle_node, &upper_bound_to_shortest_path_distance, viaNodeCandidates, reverse_search_space, reverse_offset, parameters.epsilon);
             }
         }
+        super::RecordSearchStatistics(forward_heap1, true);
+        super::RecordSearchStatistics(reverse_heap1, false);
         sort_unique_resize(viaNodeCandidates);
 
         std::vector<NodeID> packed_forward_path;
@@ -149,9 +164,9 @@ public:
         BOOST_FOREACH(const NodeID node, viaNodeCandidates) {
             int approximated_sharing = approximated_forward_sharing[node] + approximated_reverse_sharing[node];
             int approximated_length = forward_heap1.GetKey(node)+reverse_heap1.GetKey(node);
-            bool lengthPassed = (approximated_length < upper_bound_to_shortest_path_distance*(1+VIAPATH_EPSILON));
-            bool sharingPassed = (approximated_sharing <= upper_bound_to_shortest_path_distance*VIAPATH_GAMMA);
-            bool stretchPassed = approximated_length - approximated_sharing < (1.+VIAPATH_EPSILON)*(upper_bound_to_shortest_path_distance-approximated_sharing);
+            bool lengthPassed = (approximated_length < upper_bound_to_shortest_path_distance*(1+parameters.epsilon));
+            bool sharingPassed = (approximated_sharing <= upper_bound_to_shortest_path_distance*parameters.gamma);
+            bool stretchPassed = approximated_length - approximated_sharing < (1.+parameters.epsilon)*(upper_bound_to_shortest_path_distance-approximated_sharing);
 
             if(lengthPassed && sharingPassed && stretchPassed) {
                 nodes_that_passed_preselection.push_back(node);
@@ -164,65 +179,201 @@ public:
         packedShortestPath.insert(packedShortestPath.end(),packed_reverse_path.begin(), packed_reverse_path.end());
         std::vector<RankedCandidateNode > rankedCandidates;
 
-        //prioritizing via nodes for deep inspection
-        BOOST_FOREACH(const NodeID node, nodes_that_passed_preselection) {
-            int lengthOfViaPath = 0, sharingOfViaPath = 0;
-            computeLengthAndSharingOfViaPath(node, &lengthOfViaPath, &sharingOfViaPath, forward_offset+reverse_offset, packedShortestPath);
-            if(sharingOfViaPath <= upper_bound_to_shortest_path_distance*VIAPATH_GAMMA) {
-                rankedCandidates.push_back(RankedCandidateNode(node, lengthOfViaPath, sharingOfViaPath));
+        //prioritizing via nodes for deep inspection. The searches only read
+        //the finished heaps of the main search and run in parallel on the
+        //helpers that other requests leave free.
+        const QueryHeap & finished_forward_heap = forward_heap1;
+        const QueryHeap & finished_reverse_heap = reverse_heap1;
+        const int numberOfPreselectedNodes = nodes_that_passed_preselection.size();
+        std::vector<int> lengthsOfViaPaths(numberOfPreselectedNodes, 0);
+        std::vector<int> sharingsOfViaPaths(numberOfPreselectedNodes, 0);
+        std::vector<DeferredSearchStatistics> rankingStatistics(numberOfPreselectedNodes);
+        {
+            SearchThreadTeam team(QueryDataT::searchThreadBudget, numberOfPreselectedNodes);
+#pragma omp parallel for schedule ( guided ) num_threads( team.Size() ) if( 1 < team.Size() )
+            for(int i = 0; i < numberOfPreselectedNodes; ++i) {
+                computeLengthAndSharingOfViaPath(finished_forward_heap, finished_reverse_heap, nodes_that_passed_preselection[i], &lengthsOfViaPaths[i], &sharingsOfViaPaths[i], forward_offset+reverse_offset, packedShortestPath, rankingStatistics[i]);
+            }
+        }
+        for(int i = 0; i < numberOfPreselectedNodes; ++i) {
+            rankingStatistics[i].AddToCurrentRequest();
+            if(sharingsOfViaPaths[i] <= upper_bound_to_shortest_path_distance*parameters.gamma) {
+                rankedCandidates.push_back(RankedCandidateNode(nodes_that_passed_preselection[i], lengthsOfViaPaths[i], sharingsOfViaPaths[i]));
             }
         }
         std::sort(rankedCandidates.begin(), rankedCandidates.end());
 
-        NodeID selectedViaNode = UINT_MAX;
-        int lengthOfViaPath = INT_MAX;
-        NodeID s_v_middle = UINT_MAX, v_t_middle = UINT_MAX;
-        BOOST_FOREACH(const RankedCandidateNode & candidate, rankedCandidates){
-            if(viaNodeCandidatePasses_T_Test(forward_heap1, reverse_heap1, forward_heap2, reverse_heap2, candidate, forward_offset+reverse_offset, upper_bound_to_shortest_path_distance, &lengthOfViaPath, &s_v_middle, &v_t_middle)) {
-                // select first admissable
-                selectedViaNode = candidate.node;
+        //all via nodes on a plateau yield the same via path, so only the best
+        //ranked candidate of each plateau is kept for the T-test
+        boost::unordered_map<NodeID, NodeID> plateauOfNode;
+        ComputePlateaus(forward_search_space, reverse_search_space, plateauOfNode);
+        boost::unordered_set<NodeID> rankedPlateaus;
+        std::vector<RankedCandidateNode> candidatesOnDistinctPlateaus;
+        BOOST_FOREACH(const RankedCandidateNode & candidate, rankedCandidates) {
+            if(rankedPlateaus.insert(GetPlateau(plateauOfNode, candidate.node)).second) {
+                candidatesOnDistinctPlateaus.push_back(candidate);
+            }
+        }
+        rankedCandidates.swap(candidatesOnDistinctPlateaus);
+        if(0 < parameters.numberOfCandidates && parameters.numberOfCandidates < rankedCandidates.size()) {
+            rankedCandidates.erase(rankedCandidates.begin()+parameters.numberOfCandidates, rankedCandidates.end());
+        }
+
+        //T-test the candidates in rank order, a group at a time, and accept
+        //admissable ones until enough alternatives are found, or until one of
+        //them scores at least the quality threshold. The time budget is
+        //checked before every single T-test.
+        const unsigned numberOfAlternatives = std::max(1u, std::min(parameters.numberOfAlternatives, VIAPATH_MAXIMUM_NUMBER_OF_ALTERNATIVES));
+        const boost::uint64_t searchDeadline = searchStart + 1000*static_cast<boost::uint64_t>(parameters.searchTimeBudget);
+        std::vector<std::vector<_PathData> > acceptedPaths;
+        unsigned nextCandidate = 0;
+        bool foundPathOfThresholdQuality = false;
+        while((nextCandidate < rankedCandidates.size()) && (acceptedPaths.size() < numberOfAlternatives) && !foundPathOfThresholdQuality) {
+            if(0 < parameters.searchTimeBudget && searchDeadline < get_monotonic_microseconds()) {
                 break;
             }
+            const int groupSize = std::min(VIAPATH_TASK_GROUP_SIZE, static_cast<unsigned>(rankedCandidates.size())-nextCandidate);
+            std::vector<ViaNodeTest> tests(groupSize);
+            {
+                SearchThreadTeam team(QueryDataT::searchThreadBudget, groupSize);
+#pragma omp parallel for schedule ( dynamic ) num_threads( team.Size() ) if( 1 < team.Size() )
+                for(int i = 0; i < groupSize; ++i) {
+                    if(0 < parameters.searchTimeBudget && searchDeadline < get_monotonic_microseconds()) {
+                        continue;
+                    }
+                    EvaluateViaNodeCandidate(finished_forward_heap, finished_reverse_heap, rankedCandidates[nextCandidate+i], forward_offset+reverse_offset, upper_bound_to_shortest_path_distance, parameters.alpha, tests[i]);
+                }
+            }
+            for(int i = 0; i < groupSize; ++i) {
+                tests[i].statistics.AddToCurrentRequest();
+                const RankedCandidateNode & candidate = rankedCandidates[nextCandidate+i];
+                if(!tests[i].passed || (numberOfAlternatives <= acceptedPaths.size()) || foundPathOfThresholdQuality) {
+                    continue;
+                }
+                std::vector<_PathData> unpackedViaPath;
+                super::UnpackPath(tests[i].packedViaPath, unpackedViaPath);
+                if(!IsDissimilarToAcceptedPaths(unpackedViaPath, acceptedPaths, upper_bound_to_shortest_path_distance*parameters.gamma)) {
+                    continue;
+                }
+                acceptedPaths.push_back(std::vector<_PathData>());
+                acceptedPaths.back().swap(unpackedViaPath);
+
+                rawRouteData.computedAlternativePaths.push_back(_AlternativePathData());
+                rawRouteData.computedAlternativePaths.back().length = tests[i].lengthOfViaPath;
+                rawRouteData.computedAlternativePaths.back().sharing = candidate.sharing;
+                if(0. < parameters.qualityThreshold &&
+                   parameters.qualityThreshold <= QualityOfViaPath(tests[i].lengthOfViaPath, candidate.sharing, upper_bound_to_shortest_path_distance, parameters)
+                ) {
+                    foundPathOfThresholdQuality = true;
+                }
+            }
+            nextCandidate += groupSize;
         }
 
-        //Unpack shortest path and alternative, if they exist
+        //Unpack shortest path and hand out the alternatives, if they exist
         if(INT_MAX != upper_bound_to_shortest_path_distance) {
             super::UnpackPath(packedShortestPath, rawRouteData.computedShortestPath);
             rawRouteData.lengthOfShortestPath = upper_bound_to_shortest_path_distance;
         } else {
             rawRouteData.lengthOfShortestPath = INT_MAX;
         }
-
-        if(selectedViaNode != UINT_MAX) {
-            retrievePackedViaPath(forward_heap1, reverse_heap1, forward_heap2, reverse_heap2, s_v_middle, v_t_middle, rawRouteData.computedAlternativePath);
-            rawRouteData.lengthOfAlternativePath = lengthOfViaPath;
-        } else {
-            rawRouteData.lengthOfAlternativePath = INT_MAX;
+        for(unsigned i = 0; i < acceptedPaths.size(); ++i) {
+            rawRouteData.computedAlternativePaths[i].path.swap(acceptedPaths[i]);
         }
     }
 
 private:
-    //unpack <s,..,v,..,t> by exploring search spaces from v
-    inline void retrievePackedViaPath(QueryHeap & _forwardHeap1, QueryHeap & _backwardHeap1, QueryHeap & _forwardHeap2, QueryHeap & _backwardHeap2,
-            const NodeID s_v_middle, const NodeID v_t_middle, std::vector<_PathData> & unpackedPath) {
+    //1 for a via path as short as the shortest path that shares nothing with
+    //it, 0 for one at the limits of both stretch and sharing
+    inline double QualityOfViaPath(const int lengthOfViaPath, const int sharing, const int lengthOfShortestPath, const AlternativeRouteParameters & parameters) const {
+        if(0 >= lengthOfShortestPath) {
+            return 0.;
+        }
+        const double stretch = (lengthOfViaPath - lengthOfShortestPath)/(parameters.epsilon*lengthOfShortestPath);
+        const double shared = (0. < parameters.gamma) ? sharing/(parameters.gamma*lengthOfShortestPath) : 0.;
+        return 1. - 0.5*std::min(1., std::max(0., stretch)) - 0.5*std::min(1., shared);
+    }
+
+    //retrieve packed <s,..,v,..,t> from the search spaces explored from v
+    inline void retrievePackedViaPath(const QueryHeap & _forwardHeap1, const QueryHeap & _backwardHeap1, const QueryHeap & _forwardHeap2, const QueryHeap & _backwardHeap2,
+            const NodeID s_v_middle, const NodeID v_t_middle, std::vector<NodeID> & packed_s_v_path) const {
         //unpack [s,v)
-        std::vector<NodeID> packed_s_v_path, packed_v_t_path;
+        std::vector<NodeID> packed_v_t_path;
         super::RetrievePackedPathFromHeap(_forwardHeap1, _backwardHeap2, s_v_middle, packed_s_v_path);
         packed_s_v_path.resize(packed_s_v_path.size()-1);
         //unpack [v,t]
         super::RetrievePackedPathFromHeap(_forwardHeap2, _backwardHeap1, v_t_middle, packed_v_t_path);
         packed_s_v_path.insert(packed_s_v_path.end(),packed_v_t_path.begin(), packed_v_t_path.end() );
-        super::UnpackPath(packed_s_v_path, unpackedPath);
     }
 
-    inline void computeLengthAndSharingOfViaPath(const NodeID via_node, int *real_length_of_via_path, int *sharing_of_via_path,
-            const int offset, const std::vector<NodeID> & packed_shortest_path) {
+    //A plateau is a path that lies in both shortest path trees. Its edges are
+    //the edges (u,v) of the forward tree where v is the parent of u in the
+    //reverse tree. Nodes on a plateau map to its first node, the others form
+    //a plateau of their own and are not stored.
+    inline void ComputePlateaus(const std::vector<SearchSpaceEdge> & forward_search_space, const std::vector<SearchSpaceEdge> & reverse_search_space,
+            boost::unordered_map<NodeID, NodeID> & plateauOfNode) const {
+        boost::unordered_map<NodeID, NodeID> reverseParent;
+        BOOST_FOREACH(const SearchSpaceEdge & current_edge, reverse_search_space) {
+            reverseParent[current_edge.second] = current_edge.first;
+        }
+        //the forward search space is in settling order, parents come first
+        BOOST_FOREACH(const SearchSpaceEdge & current_edge, forward_search_space) {
+            const NodeID u = current_edge.first;
+            const NodeID v = current_edge.second;
+            if(u == v) {
+                continue;
+            }
+            const boost::unordered_map<NodeID, NodeID>::const_iterator parent = reverseParent.find(u);
+            if(reverseParent.end() != parent && v == parent->second) {
+                plateauOfNode[v] = GetPlateau(plateauOfNode, u);
+            }
+        }
+    }
+
+    inline NodeID GetPlateau(const boost::unordered_map<NodeID, NodeID> & plateauOfNode, const NodeID node) const {
+        const boost::unordered_map<NodeID, NodeID>::const_iterator plateau = plateauOfNode.find(node);
+        return (plateauOfNode.end() == plateau) ? node : plateau->second;
+    }
+
+    //an alternative may share at most maximumSharing with each one accepted before it
+    inline bool IsDissimilarToAcceptedPaths(const std::vector<_PathData> & path, const std::vector<std::vector<_PathData> > & acceptedPaths, const int maximumSharing) const {
+        BOOST_FOREACH(const std::vector<_PathData> & acceptedPath, acceptedPaths) {
+            boost::unordered_set<NodeID> nodesOfAcceptedPath;
+            BOOST_FOREACH(const _PathData & pathData, acceptedPath) {
+                nodesOfAcceptedPath.insert(pathData.node);
+            }
+            int sharing = 0;
+            BOOST_FOREACH(const _PathData & pathData, path) {
+                if(nodesOfAcceptedPath.count(pathData.node)) {
+                    sharing += pathData.durationOfSegment;
+                }
+            }
+            if(sharing > maximumSharing) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //runs on a helper thread with the heaps of that thread
+    inline void EvaluateViaNodeCandidate(const QueryHeap & existingForwardHeap, const QueryHeap & existingBackwardHeap, const RankedCandidateNode & candidate,
+            const int offset, const int lengthOfShortestPath, const double alpha, ViaNodeTest & test) const {
+        super::_queryData.InitializeOrClearSecondThreadLocalStorage();
+        QueryHeap & newForwardHeap  = *super::_queryData.forwardHeap2;
+        QueryHeap & newBackwardHeap = *super::_queryData.backwardHeap2;
+        NodeID s_v_middle = UINT_MAX, v_t_middle = UINT_MAX;
+        test.passed = viaNodeCandidatePasses_T_Test(existingForwardHeap, existingBackwardHeap, newForwardHeap, newBackwardHeap, candidate, offset, lengthOfShortestPath, alpha, &test.lengthOfViaPath, &s_v_middle, &v_t_middle, test.statistics);
+        if(test.passed) {
+            retrievePackedViaPath(existingForwardHeap, existingBackwardHeap, newForwardHeap, newBackwardHeap, s_v_middle, v_t_middle, test.packedViaPath);
+        }
+    }
+
+    inline void computeLengthAndSharingOfViaPath(const QueryHeap & existingForwardHeap, const QueryHeap & existingBackwardHeap, const NodeID via_node, int *real_length_of_via_path, int *sharing_of_via_path,
+            const int offset, const std::vector<NodeID> & packed_shortest_path, DeferredSearchStatistics & statistics) const {
         //compute and unpack <s,..,v> and <v,..,t> by exploring search spaces from v and intersecting against queues
         //only half-searches have to be done at this stage
         super::_queryData.InitializeOrClearSecondThreadLocalStorage();
 
-        QueryHeap & existingForwardHeap  = *super::_queryData.forwardHeap;
-        QueryHeap & existingBackwardHeap = *super::_queryData.backwardHeap;
         QueryHeap & newForwardHeap       = *super::_queryData.forwardHeap2;
         QueryHeap & newBackwardHeap      = *super::_queryData.backwardHeap2;
 
@@ -238,6 +389,7 @@ private:
         while (0 < newBackwardHeap.Size()) {
             super::RoutingStep(newBackwardHeap, existingForwardHeap, &s_v_middle, &upperBoundFor_s_v_Path, 2 * offset, false);
         }
+        super::RecordSearchStatistics(newBackwardHeap, false, &statistics);
         //compute path <v,..,t> by reusing backward search from node t
         NodeID v_t_middle = UINT_MAX;
         int upperBoundFor_v_t_Path = INT_MAX;
@@ -245,6 +397,7 @@ private:
         while (0 < newForwardHeap.Size() ) {
             super::RoutingStep(newForwardHeap, existingBackwardHeap, &v_t_middle, &upperBoundFor_v_t_Path, 2 * offset, true);
         }
+        super::RecordSearchStatistics(newForwardHeap, true, &statistics);
         *real_length_of_via_path = upperBoundFor_s_v_Path + upperBoundFor_v_t_Path;
 
         if(UINT_MAX == s_v_middle || UINT_MAX == v_t_middle)
@@ -339,11 +492,12 @@ private:
     		int *upper_bound_to_shortest_path_distance,
     		std::vector<NodeID>& searchSpaceIntersection,
     		std::vector<SearchSpaceEdge> & search_space,
-    		const int edgeBasedOffset
+    		const int edgeBasedOffset,
+    		const double epsilon
     		) const {
         const NodeID node = _forward_heap.DeleteMin();
         const int distance = _forward_heap.GetKey(node);
-        int scaledDistance = (distance-edgeBasedOffset)/(1.+VIAPATH_EPSILON);
+        int scaledDistance = (distance-edgeBasedOffset)/(1.+epsilon);
         if(scaledDistance > *upper_bound_to_shortest_path_distance){
             _forward_heap.DeleteAll();
             return;
@@ -390,7 +544,8 @@ private:
     }
 
     //conduct T-Test
-    inline bool viaNodeCandidatePasses_T_Test( QueryHeap& existingForwardHeap, QueryHeap& existingBackwardHeap, QueryHeap& newForwardHeap, QueryHeap& newBackwardHeap, const RankedCandidateNode& candidate, const int offset, const int lengthOfShortestPath, int * lengthOfViaPath, NodeID * s_v_middle, NodeID * v_t_middle) {
+    inline bool viaNodeCandidatePasses_T_Test( const QueryHeap& existingForwardHeap, const QueryHeap& existingBackwardHeap, QueryHeap& newForwardHeap, QueryHeap& newBackwardHeap, const RankedCandidateNode& candidate, const int offset, const int lengthOfShortestPath, const double alpha, int * lengthOfViaPath, NodeID * s_v_middle, NodeID * v_t_middle, DeferredSearchStatistics & statistics) const {
+    	++statistics.number_of_via_node_tests;
     	newForwardHeap.Clear();
     	newBackwardHeap.Clear();
         std::vector < NodeID > packed_s_v_path;
@@ -403,6 +558,7 @@ private:
         while (newBackwardHeap.Size() > 0) {
             super::RoutingStep(newBackwardHeap, existingForwardHeap, s_v_middle, &upperBoundFor_s_v_Path, 2*offset, false);
         }
+        super::RecordSearchStatistics(newBackwardHeap, false, &statistics);
 
         if(INT_MAX == upperBoundFor_s_v_Path)
             return false;
@@ -414,6 +570,7 @@ private:
         while (newForwardHeap.Size() > 0) {
             super::RoutingStep(newForwardHeap, existingBackwardHeap, v_t_middle, &upperBoundFor_v_t_Path, 2*offset, true);
         }
+        super::RecordSearchStatistics(newForwardHeap, true, &statistics);
 
         if(INT_MAX == upperBoundFor_v_t_Path)
             return false;
@@ -432,7 +589,7 @@ private:
         if(UINT_MAX == t_P) {
             return false;
         }
-        const int T_threshold = VIAPATH_EPSILON * lengthOfShortestPath;
+        const int T_threshold = alpha * lengthOfShortestPath;
         int unpackedUntilDistance = 0;
 
         std::stack<SearchSpaceEdge> unpackStack;
@@ -526,14 +683,9 @@ private:
         forward_heap3.Insert(s_P, 0, s_P);
         backward_heap3.Insert(t_P, 0, t_P);
         //exploration from s and t until deletemin/(1+epsilon) > _lengthOfShortestPath
-        while (forward_heap3.Size() + backward_heap3.Size() > 0) {
-            if (forward_heap3.Size() > 0) {
-                super::RoutingStep(forward_heap3, backward_heap3, &middle, &_upperBound, offset, true);
-            }
-            if (backward_heap3.Size() > 0) {
-                super::RoutingStep(backward_heap3, forward_heap3, &middle, &_upperBound, offset, false);
-            }
-        }
+        super::RunBidirectionalSearch(forward_heap3, backward_heap3, &middle, &_upperBound, offset, offset);
+        super::RecordSearchStatistics(forward_heap3, true, &statistics);
+        super::RecordSearchStatistics(backward_heap3, false, &statistics);
         return (_upperBound <= lengthOfPathT_Test_Path);
     }
 };
@@ -28,16 +28,22 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef BASICROUTINGINTERFACE_H_
 #define BASICROUTINGINTERFACE_H_
 
+#include "../DataStructures/PhantomNodes.h"
 #include "../DataStructures/RawRouteData.h"
+#include "../DataStructures/SearchGraph.h"
+#include "../DataStructures/TrafficOverlay.h"
 #include "../Util/ContainerUtils.h"
+#include "../Util/QueryMetrics.h"
 #include "../Util/SimpleLogger.h"
 
 #include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <cassert>
 #include <climits>
 
 #include <stack>
+#include <vector>
 
 template<class QueryDataT>
 class BasicRoutingInterface : boost::noncopyable{
@@ -47,7 +53,60 @@ public:
     BasicRoutingInterface(QueryDataT & qd) : _queryData(qd) { }
     virtual ~BasicRoutingInterface(){ };
 
-    inline void RoutingStep(typename QueryDataT::QueryHeap & _forwardHeap, typename QueryDataT::QueryHeap & _backwardHeap, NodeID *middle, int *_upperbound, const int edgeBasedOffset, const bool forwardDirection) const {
+    //a leg from one direction of the start phantom node to one direction of
+    //the target phantom node, directions are 0 for edgeBasedNode, 1 for +1
+    struct LegSearch {
+        LegSearch() : length(INT_MAX) { }
+        int length;
+        std::vector<NodeID> packedPath;
+        DeferredSearchStatistics statistics;
+    };
+
+    //Chains legs that were searched for all four combinations of start and
+    //target direction, the search of leg i at 4*i + 2*start + target, by
+    //picking for each direction at a via point the cheapest way to arrive
+    //there. Returns the length of the route, INT_MAX if there is none, and
+    //the search used for each leg.
+    inline int ChainLegSearches(const std::vector<PhantomNodes> & phantomNodesVector, const std::vector<LegSearch> & legSearches, std::vector<unsigned> & legIndices) const {
+        const int numberOfLegs = phantomNodesVector.size();
+        //distance to arrive at each direction of the current via point
+        int distance[2] = { 0, phantomNodesVector[0].startPhantom.isBidirected() ? 0 : INT_MAX };
+        std::vector<unsigned> previousDirection(2*numberOfLegs, 0);
+        for(int leg = 0; leg < numberOfLegs; ++leg) {
+            int nextDistance[2] = { INT_MAX, INT_MAX };
+            for(unsigned startDirection = 0; startDirection < 2; ++startDirection) {
+                for(unsigned targetDirection = 0; targetDirection < 2; ++targetDirection) {
+                    const int legLength = legSearches[4*leg + 2*startDirection + targetDirection].length;
+                    if(INT_MAX == distance[startDirection] || INT_MAX == legLength) {
+                        continue;
+                    }
+                    if(distance[startDirection] + legLength < nextDistance[targetDirection]) {
+                        nextDistance[targetDirection] = distance[startDirection] + legLength;
+                        previousDirection[2*leg + targetDirection] = startDirection;
+                    }
+                }
+            }
+            distance[0] = nextDistance[0];
+            distance[1] = nextDistance[1];
+        }
+        if(INT_MAX == distance[0] && INT_MAX == distance[1]) {
+            return INT_MAX;
+        }
+
+        unsigned direction = (distance[0] <= distance[1]) ? 0 : 1;
+        const int length = distance[direction];
+        legIndices.resize(numberOfLegs);
+        for(int leg = numberOfLegs-1; leg >= 0; --leg) {
+            const unsigned startDirection = previousDirection[2*leg + direction];
+            legIndices[leg] = 4*leg + 2*startDirection + direction;
+            direction = startDirection;
+        }
+        return length;
+    }
+
+    //the opposite heap may be const, e.g. a finished search shared by threads
+    template<class OppositeHeapT>
+    inline void RoutingStep(typename QueryDataT::QueryHeap & _forwardHeap, OppositeHeapT & _backwardHeap, NodeID *middle, int *_upperbound, const int edgeBasedOffset, const bool forwardDirection) const {
         const NodeID node = _forwardHeap.DeleteMin();
         const int distance = _forwardHeap.GetKey(node);
         //SimpleLogger().Write() << "Settled (" << _forwardHeap.GetData( node ).parent << "," << node << ")=" << distance;
@@ -110,8 +169,137 @@ public:
         }
     }
 
-    inline void UnpackPath(const std::vector<NodeID> & packedPath, std::vector<_PathData> & unpackedPath) const {
+    //Same search step on the SearchGraph layout. The stall check and the
+    //relaxation share one pass over the edges of the settled node, and a
+    //direction stops once its smallest key plus the smallest key the
+    //opposite search started with exceeds the upper bound.
+    inline void SearchGraphRoutingStep(const SearchGraph & searchGraph, typename QueryDataT::QueryHeap & _forwardHeap, typename QueryDataT::QueryHeap & _backwardHeap, NodeID *middle, int *_upperbound, const int backwardLowerBound, const bool forwardDirection) const {
+        const NodeID node = _forwardHeap.DeleteMin();
+        const int distance = _forwardHeap.GetKey(node);
+        if(_backwardHeap.WasInserted(node) ){
+            const int newDistance = _backwardHeap.GetKey(node) + distance;
+            if(newDistance < *_upperbound && newDistance >= 0) {
+                *middle = node;
+                *_upperbound = newDistance;
+            }
+        }
+
+        if(distance + backwardLowerBound > *_upperbound){
+            _forwardHeap.DeleteAll();
+            return;
+        }
+
+        //edges that only lead into the node are checked for stalling first,
+        //so the backward search walks the edge groups in reverse order
+        const SearchGraph::EdgeIterator bidirectionalEdges = searchGraph.BeginBidirectionalEdges(node);
+        const SearchGraph::EdgeIterator forwardOnlyEdges = searchGraph.BeginForwardOnlyEdges(node);
+        if(forwardDirection) {
+            const SearchGraph::EdgeIterator endEdges = searchGraph.EndEdges(node);
+            for(SearchGraph::EdgeIterator edge = searchGraph.BeginEdges(node); edge < bidirectionalEdges; ++edge) {
+                if(IsStalledBy(_forwardHeap, searchGraph.GetEdge(edge), distance)) {
+                    return;
+                }
+            }
+            for(SearchGraph::EdgeIterator edge = bidirectionalEdges; edge < forwardOnlyEdges; ++edge) {
+                if(IsStalledBy(_forwardHeap, searchGraph.GetEdge(edge), distance)) {
+                    return;
+                }
+                RelaxEdge(_forwardHeap, node, distance, searchGraph.GetEdge(edge));
+            }
+            for(SearchGraph::EdgeIterator edge = forwardOnlyEdges; edge < endEdges; ++edge) {
+                RelaxEdge(_forwardHeap, node, distance, searchGraph.GetEdge(edge));
+            }
+        } else {
+            const SearchGraph::EdgeIterator beginEdges = searchGraph.BeginEdges(node);
+            for(SearchGraph::EdgeIterator edge = searchGraph.EndEdges(node); edge > forwardOnlyEdges; --edge) {
+                if(IsStalledBy(_forwardHeap, searchGraph.GetEdge(edge-1), distance)) {
+                    return;
+                }
+            }
+            for(SearchGraph::EdgeIterator edge = forwardOnlyEdges; edge > bidirectionalEdges; --edge) {
+                if(IsStalledBy(_forwardHeap, searchGraph.GetEdge(edge-1), distance)) {
+                    return;
+                }
+                RelaxEdge(_forwardHeap, node, distance, searchGraph.GetEdge(edge-1));
+            }
+            for(SearchGraph::EdgeIterator edge = bidirectionalEdges; edge > beginEdges; --edge) {
+                RelaxEdge(_forwardHeap, node, distance, searchGraph.GetEdge(edge-1));
+            }
+        }
+    }
+
+    //Runs a bidirectional search from the nodes already inserted into both
+    //heaps until neither direction can improve the upper bound. Traffic
+    //searches run on the graph of the snapshot the request took.
+    inline void RunBidirectionalSearch(typename QueryDataT::QueryHeap & forwardHeap, typename QueryDataT::QueryHeap & backwardHeap, NodeID *middle, int *upperbound, const int forwardOffset, const int backwardOffset, const TrafficOverlay::Snapshot * traffic = NULL) const {
+        if(_queryData.use_classic_kernel && NULL == traffic) {
+            while(0 < (forwardHeap.Size() + backwardHeap.Size())) {
+                if(0 < forwardHeap.Size()) {
+                    RoutingStep(forwardHeap, backwardHeap, middle, upperbound, forwardOffset, true);
+                }
+                if(0 < backwardHeap.Size()) {
+                    RoutingStep(backwardHeap, forwardHeap, middle, upperbound, backwardOffset, false);
+                }
+            }
+            return;
+        }
+        //keys never drop below the smallest key a search starts with
+        const int forwardLowerBound = (0 < forwardHeap.Size()) ? forwardHeap.GetKey(forwardHeap.Min()) : 0;
+        const int backwardLowerBound = (0 < backwardHeap.Size()) ? backwardHeap.GetKey(backwardHeap.Min()) : 0;
+        const SearchGraph & searchGraph = (NULL != traffic) ? traffic->GetSearchGraph() : *_queryData.search_graph;
+        while(0 < (forwardHeap.Size() + backwardHeap.Size())) {
+            if(0 < forwardHeap.Size()) {
+                SearchGraphRoutingStep(searchGraph, forwardHeap, backwardHeap, middle, upperbound, backwardLowerBound, true);
+            }
+            if(0 < backwardHeap.Size()) {
+                SearchGraphRoutingStep(searchGraph, backwardHeap, forwardHeap, middle, upperbound, forwardLowerBound, false);
+            }
+        }
+    }
+
+    //adds the work done by a finished search to the statistics of the current request
+    inline void RecordSearchStatistics(const typename QueryDataT::QueryHeap & heap, const bool forwardDirection) const {
+        QueryMetrics::AddSearchStatistics(
+            forwardDirection,
+            heap.NumberOfDeletedNodes(),
+            heap.NumberOfInsertedNodes(),
+            heap.PeakSize()
+        );
+    }
+
+    //on helper threads the statistics are deferred, see DeferredSearchStatistics
+    inline void RecordSearchStatistics(const typename QueryDataT::QueryHeap & heap, const bool forwardDirection, DeferredSearchStatistics * deferredStatistics) const {
+        if(NULL == deferredStatistics) {
+            RecordSearchStatistics(heap, forwardDirection);
+            return;
+        }
+        deferredStatistics->AddSearch(
+            forwardDirection,
+            heap.NumberOfDeletedNodes(),
+            heap.NumberOfInsertedNodes(),
+            heap.PeakSize()
+        );
+    }
+
+    inline bool IsStalledBy(typename QueryDataT::QueryHeap & heap, const SearchGraph::SearchEdge & edge, const int distance) const {
+        return heap.WasInserted(edge.target) && (heap.GetKey(edge.target) + edge.weight < distance);
+    }
+
+    inline void RelaxEdge(typename QueryDataT::QueryHeap & heap, const NodeID node, const int distance, const SearchGraph::SearchEdge & edge) const {
+        const int toDistance = distance + edge.weight;
+        if(!heap.WasInserted(edge.target)) {
+            heap.Insert(edge.target, toDistance, node);
+        } else if(toDistance < heap.GetKey(edge.target)) {
+            heap.GetData(edge.target).parent = node;
+            heap.DecreaseKey(edge.target, toDistance);
+        }
+    }
+
+    //with a traffic snapshot, edges are chosen and timed by its weights
+    inline void UnpackPath(const std::vector<NodeID> & packedPath, std::vector<_PathData> & unpackedPath, const TrafficOverlay::Snapshot * traffic = NULL) const {
+        QueryStageTimer unpacking_timer(QUERY_STAGE_UNPACKING);
         const unsigned sizeOfPackedPath = packedPath.size();
+        const unsigned sizeOfUnpackedPathBefore = unpackedPath.size();
         std::stack<std::pair<NodeID, NodeID> > recursionStack;
 
         //We have to push the path in reverse order onto the stack because it's LIFO.
@@ -127,7 +315,7 @@ public:
             typename QueryDataT::Graph::EdgeIterator smallestEdge = SPECIAL_EDGEID;
             int smallestWeight = INT_MAX;
             for(typename QueryDataT::Graph::EdgeIterator eit = _queryData.graph->BeginEdges(edge.first);eit < _queryData.graph->EndEdges(edge.first);++eit){
-                const int weight = _queryData.graph->GetEdgeData(eit).distance;
+                const int weight = (NULL != traffic) ? traffic->GetWeight(eit, true) : _queryData.graph->GetEdgeData(eit).distance;
                 if(_queryData.graph->GetTarget(eit) == edge.second && weight < smallestWeight && _queryData.graph->GetEdgeData(eit).forward){
                     smallestEdge = eit;
                     smallestWeight = weight;
@@ -136,7 +324,7 @@ public:
 
             if(smallestEdge == SPECIAL_EDGEID){
                 for(typename QueryDataT::Graph::EdgeIterator eit = _queryData.graph->BeginEdges(edge.second);eit < _queryData.graph->EndEdges(edge.second);++eit){
-                    const int weight = _queryData.graph->GetEdgeData(eit).distance;
+                    const int weight = (NULL != traffic) ? traffic->GetWeight(eit, false) : _queryData.graph->GetEdgeData(eit).distance;
                     if(_queryData.graph->GetTarget(eit) == edge.first && weight < smallestWeight && _queryData.graph->GetEdgeData(eit).backward){
                         smallestEdge = eit;
                         smallestWeight = weight;
@@ -158,11 +346,12 @@ public:
                         ed.id,
                         _queryData.nodeHelpDesk->GetNameIndexFromEdgeID(ed.id),
                         _queryData.nodeHelpDesk->GetTurnInstructionForEdgeID(ed.id),
-                        ed.distance
+                        smallestWeight
                     )
                 );
             }
         }
+        QueryMetrics::AddToCounter(QUERY_COUNTER_UNPACKED_EDGES, unpackedPath.size() - sizeOfUnpackedPathBefore);
     }
 
     inline void UnpackEdge(const NodeID s, const NodeID t, std::vector<NodeID> & unpackedPath) const {
@@ -209,7 +398,7 @@ public:
         unpackedPath.push_back(t);
     }
 
-    inline void RetrievePackedPathFromHeap(typename QueryDataT::QueryHeap & _fHeap, typename QueryDataT::QueryHeap & _bHeap, const NodeID middle, std::vector<NodeID>& packedPath) const {
+    inline void RetrievePackedPathFromHeap(const typename QueryDataT::QueryHeap & _fHeap, const typename QueryDataT::QueryHeap & _bHeap, const NodeID middle, std::vector<NodeID>& packedPath) const {
         NodeID pathNode = middle;
         while(pathNode != _fHeap.GetData(pathNode).parent) {
             pathNode = _fHeap.GetData(pathNode).parent;
@@ -225,7 +414,7 @@ public:
     	}
     }
 
-    inline void RetrievePackedPathFromSingleHeap(typename QueryDataT::QueryHeap & search_heap, const NodeID middle, std::vector<NodeID>& packed_path) const {
+    inline void RetrievePackedPathFromSingleHeap(const typename QueryDataT::QueryHeap & search_heap, const NodeID middle, std::vector<NodeID>& packed_path) const {
         NodeID pathNode = middle;
         while(pathNode != search_heap.GetData(pathNode).parent) {
             pathNode = search_heap.GetData(pathNode).parent;
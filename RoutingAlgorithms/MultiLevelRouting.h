@@ -0,0 +1,253 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef MULTILEVELROUTING_H_
+#define MULTILEVELROUTING_H_
+
+#include "BasicRoutingInterface.h"
+#include "../DataStructures/MultiLevelGraph.h"
+#include "../DataStructures/SearchThreadBudget.h"
+#include "../Util/QueryMetrics.h"
+
+#include <boost/assert.hpp>
+#include <boost/foreach.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <climits>
+
+#include <stack>
+#include <vector>
+
+// Shortest paths on the overlays of the multi-level graph by bidirectional
+// Dijkstra. At every node a search relaxes the highest overlay on which
+// the node is in neither the cell of the start nor that of the target,
+// see MultiLevelGraph::GetQueryLevel. Legs are searched for each pair of
+// start and target direction in parallel, on the helpers that other
+// requests leave free, and chained exactly. A clique
+// edge is unpacked by searching its cell on the overlay below. Traffic
+// searches use the metric last customized by the traffic overlay.
+template<class QueryDataT>
+class MultiLevelRouting : public BasicRoutingInterface<QueryDataT> {
+    typedef BasicRoutingInterface<QueryDataT> super;
+    typedef typename QueryDataT::QueryHeap QueryHeap;
+    typedef typename super::LegSearch LegSearch;
+public:
+    MultiLevelRouting( QueryDataT & qd) : super(qd) {}
+
+    ~MultiLevelRouting() {}
+
+    void operator()(std::vector<PhantomNodes> & phantomNodesVector,  RawRouteData & rawRouteData) const {
+        BOOST_FOREACH(const PhantomNodes & phantomNodePair, phantomNodesVector) {
+            if(!phantomNodePair.AtLeastOnePhantomNodeIsUINTMAX()) {
+                rawRouteData.lengthOfShortestPath = INT_MAX;
+                return;
+            }
+        }
+        if(NULL == super::_queryData.multi_level_graph) {
+            rawRouteData.lengthOfShortestPath = INT_MAX;
+            return;
+        }
+        const bool useTraffic = super::_queryData.use_traffic && (NULL != super::_queryData.traffic_overlay);
+        const boost::shared_ptr<const MultiLevelGraph::Metric> metric = useTraffic ?
+            super::_queryData.multi_level_graph->GetLatestMetric() :
+            super::_queryData.multi_level_graph->GetStaticMetric();
+        if(useTraffic) {
+            const TrafficOverlay::Snapshot traffic = super::_queryData.traffic_overlay->GetSnapshot();
+            BOOST_FOREACH(PhantomNodes & phantomNodePair, phantomNodesVector) {
+                traffic.ScalePhantomNode(phantomNodePair.startPhantom);
+                traffic.ScalePhantomNode(phantomNodePair.targetPhantom);
+            }
+        }
+        const int numberOfLegs = phantomNodesVector.size();
+        std::vector<LegSearch> legSearches(4*numberOfLegs);
+        {
+            SearchThreadTeam team(QueryDataT::searchThreadBudget, 4*numberOfLegs);
+#pragma omp parallel for schedule ( guided ) num_threads( team.Size() ) if( 1 < team.Size() )
+            for(int i = 0; i < 4*numberOfLegs; ++i) {
+                SearchLeg(*metric, phantomNodesVector[i/4], (i/2)%2, i%2, legSearches[i]);
+            }
+        }
+        //heaps of other threads do not count towards this request otherwise
+        BOOST_FOREACH(const LegSearch & leg, legSearches) {
+            leg.statistics.AddToCurrentRequest();
+        }
+
+        std::vector<unsigned> legIndices;
+        rawRouteData.lengthOfShortestPath = super::ChainLegSearches(phantomNodesVector, legSearches, legIndices);
+        if(INT_MAX == rawRouteData.lengthOfShortestPath) {
+            return;
+        }
+        BOOST_FOREACH(const unsigned legIndex, legIndices) {
+            const std::vector<NodeID> & legPath = legSearches[legIndex].packedPath;
+            const NodeID endpoints[2] = { legPath.front(), legPath.back() };
+            UnpackLeg(*metric, legPath, endpoints, rawRouteData.computedShortestPath);
+        }
+    }
+
+private:
+    //an edge of a packed path, on the overlay of a level or of the base graph
+    struct OverlayEdge {
+        OverlayEdge(const NodeID source, const NodeID target, const unsigned level) :
+            source(source), target(target), level(level) { }
+        NodeID source;
+        NodeID target;
+        unsigned level;
+    };
+
+    inline void SearchLeg(const MultiLevelGraph::Metric & metric, const PhantomNodes & phantomNodePair, const unsigned startDirection, const unsigned targetDirection, LegSearch & leg) const {
+        const PhantomNode & start = phantomNodePair.startPhantom;
+        const PhantomNode & target = phantomNodePair.targetPhantom;
+        if((1 == startDirection && !start.isBidirected()) || (1 == targetDirection && !target.isBidirected())) {
+            return;
+        }
+        super::_queryData.InitializeOrClearFirstThreadLocalStorage();
+        QueryHeap & forward_heap = *(super::_queryData.forwardHeap);
+        QueryHeap & reverse_heap = *(super::_queryData.backwardHeap);
+
+        const NodeID endpoints[2] = { start.edgeBasedNode + startDirection, target.edgeBasedNode + targetDirection };
+        const int forwardLowerBound = -(0 == startDirection ? start.weight1 : start.weight2);
+        const int reverseLowerBound = (0 == targetDirection ? target.weight1 : target.weight2);
+        forward_heap.Insert(endpoints[0], forwardLowerBound, endpoints[0]);
+        reverse_heap.Insert(endpoints[1], reverseLowerBound, endpoints[1]);
+
+        NodeID middle = UINT_MAX;
+        while(0 < (forward_heap.Size() + reverse_heap.Size())) {
+            if(0 < forward_heap.Size()) {
+                MultiLevelRoutingStep(metric, forward_heap, reverse_heap, endpoints, &middle, &leg.length, reverseLowerBound, true);
+            }
+            if(0 < reverse_heap.Size()) {
+                MultiLevelRoutingStep(metric, reverse_heap, forward_heap, endpoints, &middle, &leg.length, forwardLowerBound, false);
+            }
+        }
+        if(INT_MAX != leg.length) {
+            super::RetrievePackedPathFromHeap(forward_heap, reverse_heap, middle, leg.packedPath);
+        }
+        super::RecordSearchStatistics(forward_heap, true, &leg.statistics);
+        super::RecordSearchStatistics(reverse_heap, false, &leg.statistics);
+    }
+
+    //same stopping criterion as SearchGraphRoutingStep, without stalling
+    inline void MultiLevelRoutingStep(const MultiLevelGraph::Metric & metric, QueryHeap & _forwardHeap, QueryHeap & _backwardHeap, const NodeID * endpoints, NodeID *middle, int *_upperbound, const int backwardLowerBound, const bool forwardDirection) const {
+        const NodeID node = _forwardHeap.DeleteMin();
+        const int distance = _forwardHeap.GetKey(node);
+        if(_backwardHeap.WasInserted(node) ){
+            const int newDistance = _backwardHeap.GetKey(node) + distance;
+            if(newDistance < *_upperbound && newDistance >= 0) {
+                *middle = node;
+                *_upperbound = newDistance;
+            }
+        }
+
+        if(distance + backwardLowerBound > *_upperbound){
+            _forwardHeap.DeleteAll();
+            return;
+        }
+
+        const MultiLevelGraph & graph = *super::_queryData.multi_level_graph;
+        graph.RelaxEdges(metric, _forwardHeap, node, distance, graph.GetQueryLevel(node, endpoints, 2), 0, forwardDirection);
+    }
+
+    // An edge of a packed path is a clique edge if both of its nodes were
+    // searched on the same overlay and lie in the same cell of it, edges
+    // between cells are those of the base graph.
+    inline void UnpackLeg(const MultiLevelGraph::Metric & metric, const std::vector<NodeID> & packedPath, const NodeID * endpoints, std::vector<_PathData> & unpackedPath) const {
+        QueryStageTimer unpacking_timer(QUERY_STAGE_UNPACKING);
+        const MultiLevelGraph & graph = *super::_queryData.multi_level_graph;
+        const unsigned sizeOfUnpackedPathBefore = unpackedPath.size();
+        std::stack<OverlayEdge> recursionStack;
+
+        //We have to push the path in reverse order onto the stack because it's LIFO.
+        for(unsigned i = packedPath.size()-1; i > 0; --i) {
+            const NodeID source = packedPath[i-1];
+            const NodeID target = packedPath[i];
+            const unsigned level = graph.GetQueryLevel(source, endpoints, 2);
+            const bool isCliqueEdge = (0 < level) &&
+                (level == graph.GetQueryLevel(target, endpoints, 2)) &&
+                (graph.GetCell(level, source) == graph.GetCell(level, target));
+            recursionStack.push(OverlayEdge(source, target, isCliqueEdge ? level : 0));
+        }
+
+        while(!recursionStack.empty()) {
+            const OverlayEdge edge = recursionStack.top();
+            recursionStack.pop();
+            if(0 == edge.level) {
+                AppendBaseEdge(metric, edge.source, edge.target, unpackedPath);
+                continue;
+            }
+
+            //the clique weight is the distance inside the cell on the overlay below
+            super::_queryData.InitializeOrClearThirdThreadLocalStorage();
+            QueryHeap & heap = *(super::_queryData.forwardHeap3);
+            heap.Insert(edge.source, 0, edge.source);
+            while(0 < heap.Size()) {
+                const NodeID node = heap.DeleteMin();
+                if(node == edge.target) {
+                    break;
+                }
+                graph.RelaxEdges(metric, heap, node, heap.GetKey(node), edge.level-1, edge.level, true);
+            }
+            BOOST_ASSERT(heap.WasInserted(edge.target));
+
+            const unsigned level = edge.level-1;
+            NodeID node = edge.target;
+            while(node != edge.source) {
+                const NodeID parent = heap.GetData(node).parent;
+                const bool isCliqueEdge = (0 < level) && (graph.GetCell(level, parent) == graph.GetCell(level, node));
+                recursionStack.push(OverlayEdge(parent, node, isCliqueEdge ? level : 0));
+                node = parent;
+            }
+        }
+        QueryMetrics::AddToCounter(QUERY_COUNTER_UNPACKED_EDGES, unpackedPath.size() - sizeOfUnpackedPathBefore);
+    }
+
+    inline void AppendBaseEdge(const MultiLevelGraph::Metric & metric, const NodeID source, const NodeID target, std::vector<_PathData> & unpackedPath) const {
+        const MultiLevelGraph::BaseGraph & baseGraph = super::_queryData.multi_level_graph->GetBaseGraph();
+        MultiLevelGraph::BaseGraph::EdgeIterator smallestEdge = SPECIAL_EDGEID;
+        int smallestWeight = INT_MAX;
+        for(MultiLevelGraph::BaseGraph::EdgeIterator edge = baseGraph.BeginEdges(source); edge < baseGraph.EndEdges(source); ++edge) {
+            const MultiLevelGraph::BaseGraph::EdgeData & data = baseGraph.GetEdgeData(edge);
+            if(baseGraph.GetTarget(edge) == target && data.forward && metric.edge_weights[edge] < smallestWeight) {
+                smallestEdge = edge;
+                smallestWeight = metric.edge_weights[edge];
+            }
+        }
+        BOOST_ASSERT(SPECIAL_EDGEID != smallestEdge);
+
+        const MultiLevelGraph::BaseGraph::EdgeData & ed = baseGraph.GetEdgeData(smallestEdge);
+        unpackedPath.push_back(
+            _PathData(
+                ed.id,
+                super::_queryData.nodeHelpDesk->GetNameIndexFromEdgeID(ed.id),
+                super::_queryData.nodeHelpDesk->GetTurnInstructionForEdgeID(ed.id),
+                smallestWeight
+            )
+        );
+    }
+};
+
+#endif /* MULTILEVELROUTING_H_ */
@@ -29,6 +29,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define SHORTESTPATHROUTING_H_
 
 #include "BasicRoutingInterface.h"
+#include "../DataStructures/SearchThreadBudget.h"
+
+#include <vector>
 
 template<class QueryDataT>
 class ShortestPathRouting : public BasicRoutingInterface<QueryDataT>{
@@ -42,10 +45,26 @@ public:
     void operator()(std::vector<PhantomNodes> & phantomNodesVector,  RawRouteData & rawRouteData) const {
         BOOST_FOREACH(const PhantomNodes & phantomNodePair, phantomNodesVector) {
             if(!phantomNodePair.AtLeastOnePhantomNodeIsUINTMAX()) {
-                rawRouteData.lengthOfShortestPath = rawRouteData.lengthOfAlternativePath = INT_MAX;
+                rawRouteData.lengthOfShortestPath = INT_MAX;
                 return;
             }
         }
+        //the search, the unpacking and the phantom nodes use the same feed
+        TrafficOverlay::Snapshot trafficSnapshot;
+        const TrafficOverlay::Snapshot * traffic = NULL;
+        if(super::_queryData.use_traffic && NULL != super::_queryData.traffic_overlay) {
+            trafficSnapshot = super::_queryData.traffic_overlay->GetSnapshot();
+            traffic = &trafficSnapshot;
+            BOOST_FOREACH(PhantomNodes & phantomNodePair, phantomNodesVector) {
+                traffic->ScalePhantomNode(phantomNodePair.startPhantom);
+                traffic->ScalePhantomNode(phantomNodePair.targetPhantom);
+            }
+        }
+        const unsigned parallelLegThreshold = super::_queryData.parallel_leg_threshold;
+        if(0 < parallelLegThreshold && parallelLegThreshold <= phantomNodesVector.size()) {
+            RunParallelLegSearches(phantomNodesVector, rawRouteData, traffic);
+            return;
+        }
         int distance1 = 0;
         int distance2 = 0;
 
@@ -100,28 +119,19 @@ public:
             const int reverse_offset = phantomNodePair.targetPhantom.weight1 + (phantomNodePair.targetPhantom.isBidirected() ? phantomNodePair.targetPhantom.weight2 : 0);
 
             //run two-Target Dijkstra routing step.
-            while(0 < (forward_heap1.Size() + reverse_heap1.Size() )){
-                if(0 < forward_heap1.Size()){
-                    super::RoutingStep(forward_heap1, reverse_heap1, &middle1, &_localUpperbound1, forward_offset, true);
-                }
-                if(0 < reverse_heap1.Size() ){
-                    super::RoutingStep(reverse_heap1, forward_heap1, &middle1, &_localUpperbound1, reverse_offset, false);
-                }
-            }
+            super::RunBidirectionalSearch(forward_heap1, reverse_heap1, &middle1, &_localUpperbound1, forward_offset, reverse_offset, traffic);
             if(0 < reverse_heap2.Size()) {
-                while(0 < (forward_heap2.Size() + reverse_heap2.Size() )){
-                    if(0 < forward_heap2.Size()){
-                        super::RoutingStep(forward_heap2, reverse_heap2, &middle2, &_localUpperbound2, forward_offset, true);
-                    }
-                    if(0 < reverse_heap2.Size()){
-                        super::RoutingStep(reverse_heap2, forward_heap2, &middle2, &_localUpperbound2, reverse_offset, false);
-                    }
-                }
+                super::RunBidirectionalSearch(forward_heap2, reverse_heap2, &middle2, &_localUpperbound2, forward_offset, reverse_offset, traffic);
             }
 
+            super::RecordSearchStatistics(forward_heap1, true);
+            super::RecordSearchStatistics(reverse_heap1, false);
+            super::RecordSearchStatistics(forward_heap2, true);
+            super::RecordSearchStatistics(reverse_heap2, false);
+
             //No path found for both target nodes?
             if((INT_MAX == _localUpperbound1) && (INT_MAX == _localUpperbound2)) {
-                rawRouteData.lengthOfShortestPath = rawRouteData.lengthOfAlternativePath = INT_MAX;
+                rawRouteData.lengthOfShortestPath = INT_MAX;
                 return;
             }
             if(UINT_MAX == middle1) {
@@ -195,10 +205,72 @@ public:
             std::swap(packedPath1, packedPath2);
         }
         remove_consecutive_duplicates_from_vector(packedPath1);
-        super::UnpackPath(packedPath1, rawRouteData.computedShortestPath);
+        super::UnpackPath(packedPath1, rawRouteData.computedShortestPath, traffic);
         rawRouteData.lengthOfShortestPath = std::min(distance1, distance2);
         return;
     }
+
+private:
+    typedef typename super::LegSearch LegSearch;
+
+    inline void SearchLeg(const PhantomNodes & phantomNodePair, const unsigned startDirection, const unsigned targetDirection, LegSearch & leg, const TrafficOverlay::Snapshot * traffic) const {
+        const PhantomNode & start = phantomNodePair.startPhantom;
+        const PhantomNode & target = phantomNodePair.targetPhantom;
+        if((1 == startDirection && !start.isBidirected()) || (1 == targetDirection && !target.isBidirected())) {
+            return;
+        }
+        super::_queryData.InitializeOrClearFirstThreadLocalStorage();
+        QueryHeap & forward_heap = *(super::_queryData.forwardHeap);
+        QueryHeap & reverse_heap = *(super::_queryData.backwardHeap);
+
+        const NodeID startNode = start.edgeBasedNode + startDirection;
+        const NodeID targetNode = target.edgeBasedNode + targetDirection;
+        forward_heap.Insert(startNode, -(0 == startDirection ? start.weight1 : start.weight2), startNode);
+        reverse_heap.Insert(targetNode, (0 == targetDirection ? target.weight1 : target.weight2), targetNode);
+        const int forward_offset = start.weight1 + (start.isBidirected() ? start.weight2 : 0);
+        const int reverse_offset = target.weight1 + (target.isBidirected() ? target.weight2 : 0);
+
+        NodeID middle = UINT_MAX;
+        super::RunBidirectionalSearch(forward_heap, reverse_heap, &middle, &leg.length, forward_offset, reverse_offset, traffic);
+        if(INT_MAX != leg.length) {
+            super::RetrievePackedPathFromHeap(forward_heap, reverse_heap, middle, leg.packedPath);
+        }
+        super::RecordSearchStatistics(forward_heap, true, &leg.statistics);
+        super::RecordSearchStatistics(reverse_heap, false, &leg.statistics);
+    }
+
+    //Searches every leg for all four combinations of start and target
+    //direction in parallel, each thread with its own heaps, and chains the
+    //legs afterwards. The team only gets the helpers that other requests
+    //do not currently use.
+    void RunParallelLegSearches(const std::vector<PhantomNodes> & phantomNodesVector,  RawRouteData & rawRouteData, const TrafficOverlay::Snapshot * traffic) const {
+        const int numberOfLegs = phantomNodesVector.size();
+        std::vector<LegSearch> legSearches(4*numberOfLegs);
+        {
+            SearchThreadTeam team(QueryDataT::searchThreadBudget, 4*numberOfLegs);
+#pragma omp parallel for schedule ( guided ) num_threads( team.Size() ) if( 1 < team.Size() )
+            for(int i = 0; i < 4*numberOfLegs; ++i) {
+                SearchLeg(phantomNodesVector[i/4], (i/2)%2, i%2, legSearches[i], traffic);
+            }
+        }
+        //heaps of other threads do not count towards this request otherwise
+        BOOST_FOREACH(const LegSearch & leg, legSearches) {
+            leg.statistics.AddToCurrentRequest();
+        }
+
+        std::vector<unsigned> legIndices;
+        rawRouteData.lengthOfShortestPath = super::ChainLegSearches(phantomNodesVector, legSearches, legIndices);
+        if(INT_MAX == rawRouteData.lengthOfShortestPath) {
+            return;
+        }
+        std::vector<NodeID> packedPath;
+        BOOST_FOREACH(const unsigned legIndex, legIndices) {
+            const std::vector<NodeID> & legPath = legSearches[legIndex].packedPath;
+            packedPath.insert(packedPath.end(), legPath.begin(), legPath.end());
+        }
+        remove_consecutive_duplicates_from_vector(packedPath);
+        super::UnpackPath(packedPath, rawRouteData.computedShortestPath, traffic);
+    }
 };
 
 #endif /* SHORTESTPATHROUTING_H_ */
@@ -38,7 +38,7 @@ template <typename Iterator, class HandlerT>
 struct APIGrammar : qi::grammar<Iterator> {
     APIGrammar(HandlerT * h) : APIGrammar::base_type(api_call), handler(h) {
         api_call = qi::lit('/') >> string[boost::bind(&HandlerT::setService, handler, ::_1)] >> *(query);
-        query    = ('?') >> (+(zoom | output | jsonp | checksum | location | hint | cmp | language | instruction | geometry | alt_route | old_API) ) ;
+        query    = ('?') >> (+(zoom | output | jsonp | checksum | location | hint | cmp | language | instruction | geometry | alt_route | alt_alpha | alt_epsilon | alt_gamma | alt_candidates | alt_count | alt_budget | alt_quality | trace | traffic | old_API) ) ;
 
         zoom        = (-qi::lit('&')) >> qi::lit('z')            >> '=' >> qi::short_[boost::bind(&HandlerT::setZoomLevel, handler, ::_1)];
         output      = (-qi::lit('&')) >> qi::lit("output")       >> '=' >> string[boost::bind(&HandlerT::setOutputFormat, handler, ::_1)];
@@ -51,6 +51,15 @@ struct APIGrammar : qi::grammar<Iterator> {
         hint        = (-qi::lit('&')) >> qi::lit("hint")         >> '=' >> stringwithDot[boost::bind(&HandlerT::addHint, handler, ::_1)];
         language    = (-qi::lit('&')) >> qi::lit("hl")           >> '=' >> string[boost::bind(&HandlerT::setLanguage, handler, ::_1)];
         alt_route   = (-qi::lit('&')) >> qi::lit("alt")          >> '=' >> qi::bool_[boost::bind(&HandlerT::setAlternateRouteFlag, handler, ::_1)];
+        alt_alpha   = (-qi::lit('&')) >> qi::lit("alt_alpha")    >> '=' >> qi::double_[boost::bind(&HandlerT::setAlternativeAlpha, handler, ::_1)];
+        alt_epsilon = (-qi::lit('&')) >> qi::lit("alt_epsilon")  >> '=' >> qi::double_[boost::bind(&HandlerT::setAlternativeEpsilon, handler, ::_1)];
+        alt_gamma   = (-qi::lit('&')) >> qi::lit("alt_gamma")    >> '=' >> qi::double_[boost::bind(&HandlerT::setAlternativeGamma, handler, ::_1)];
+        alt_candidates = (-qi::lit('&')) >> qi::lit("alt_candidates") >> '=' >> qi::uint_[boost::bind(&HandlerT::setAlternativeCandidates, handler, ::_1)];
+        alt_count   = (-qi::lit('&')) >> qi::lit("alt_count")    >> '=' >> qi::uint_[boost::bind(&HandlerT::setNumberOfAlternatives, handler, ::_1)];
+        alt_budget  = (-qi::lit('&')) >> qi::lit("alt_budget")   >> '=' >> qi::uint_[boost::bind(&HandlerT::setAlternativeSearchTimeBudget, handler, ::_1)];
+        alt_quality = (-qi::lit('&')) >> qi::lit("alt_quality")  >> '=' >> qi::double_[boost::bind(&HandlerT::setAlternativeQualityThreshold, handler, ::_1)];
+        trace       = (-qi::lit('&')) >> qi::lit("trace")        >> '=' >> qi::bool_[boost::bind(&HandlerT::setTraceFlag, handler, ::_1)];
+        traffic     = (-qi::lit('&')) >> qi::lit("traffic")      >> '=' >> qi::bool_[boost::bind(&HandlerT::setTrafficFlag, handler, ::_1)];
         old_API     = (-qi::lit('&')) >> qi::lit("geomformat")   >> '=' >> string[boost::bind(&HandlerT::setDeprecatedAPIFlag, handler, ::_1)];
 
         string        = +(qi::char_("a-zA-Z"));
@@ -59,7 +68,8 @@ struct APIGrammar : qi::grammar<Iterator> {
     qi::rule<Iterator> api_call, query;
     qi::rule<Iterator, std::string()> service, zoom, output, string, jsonp, checksum, location, hint,
                                       stringwithDot, language, instruction, geometry,
-                                      cmp, alt_route, old_API;
+                                      cmp, alt_route, alt_alpha, alt_epsilon, alt_gamma,
+                                      alt_candidates, alt_count, alt_budget, alt_quality, trace, traffic, old_API;
 
     HandlerT * handler;
 };
@@ -28,6 +28,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef BASIC_DATASTRUCTURES_H
 #define BASIC_DATASTRUCTURES_H
 
+#include "../DataStructures/OutputBuffer.h"
 #include "../Util/StringUtil.h"
 
 #include <boost/asio.hpp>
@@ -72,7 +73,7 @@ struct Request {
 };
 
 struct Reply {
-    Reply() : status(ok) { content.reserve(2 << 20); }
+    Reply() : status(ok) { }
 	enum status_type {
 		ok 					= 200,
 		badRequest 		    = 400,
@@ -83,7 +84,26 @@ struct Reply {
     std::vector<boost::asio::const_buffer> toBuffers();
     std::vector<boost::asio::const_buffer> HeaderstoBuffers();
 	std::string content;
+	//written after content, used by descriptors to avoid copying large responses
+	OutputBuffer chunked_content;
 	static Reply stockReply(status_type status);
+	std::size_t ContentSize() const {
+		return content.size() + chunked_content.size();
+	}
+	void ContentToBuffers(std::vector<boost::asio::const_buffer> & buffers) const {
+		if(!content.empty()) {
+			buffers.push_back(boost::asio::buffer(content));
+		}
+		for(unsigned i = 0; i < chunked_content.GetNumberOfChunks(); ++i) {
+			std::size_t length;
+			const char * chunk = chunked_content.GetChunk(i, length);
+			buffers.push_back(boost::asio::buffer(chunk, length));
+		}
+	}
+	void GetContent(std::string & output) const {
+		output = content;
+		chunked_content.AppendTo(output);
+	}
 	void setSize(const unsigned size) {
 		BOOST_FOREACH ( Header& h,  headers) {
 			if("Content-Length" == h.name) {
@@ -127,7 +147,7 @@ std::vector<boost::asio::const_buffer> Reply::toBuffers(){
 		buffers.push_back(boost::asio::buffer(crlf));
 	}
 	buffers.push_back(boost::asio::buffer(crlf));
-	buffers.push_back(boost::asio::buffer(content));
+	ContentToBuffers(buffers);
 	return buffers;
 }
 
@@ -31,6 +31,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "BasicDatastructures.h"
 #include "RequestHandler.h"
 #include "RequestParser.h"
+#include "ResponseCompressor.h"
+#include "../Util/QueryMetrics.h"
 
 #include <boost/array.hpp>
 #include <boost/asio.hpp>
@@ -40,8 +42,6 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
 
-#include <zlib.h>
-
 #include <vector>
 
 namespace http {
@@ -52,8 +52,14 @@ class Connection : 	public boost::enable_shared_from_this<Connection>,
 public:
 	explicit Connection(
 		boost::asio::io_service& io_service,
-		RequestHandler& handler
-	) : strand(io_service), TCP_socket(io_service), request_handler(handler) { }
+		RequestHandler& handler,
+		const CompressionSettings & compression_settings
+	) :
+		strand(io_service),
+		TCP_socket(io_service),
+		request_handler(handler),
+		compression_settings(compression_settings)
+	{ }
 
 	boost::asio::ip::tcp::socket& socket() {
 		return TCP_socket;
@@ -89,86 +95,59 @@ private:
 
 			if( result ) {
 				request.endpoint = TCP_socket.remote_endpoint().address();
+				QueryMetrics::BeginRequest();
 				request_handler.handle_request(request, reply);
 
-				Header compression_header;
-				std::vector<unsigned char> compressed_output;
+				if(
+					noCompression != compression_type &&
+					reply.ContentSize() < compression_settings.minimum_size
+				) {
+					compression_type = noCompression;
+				}
+
 				std::vector<boost::asio::const_buffer> output_buffer;
-				switch(compression_type) {
-				case deflateRFC1951:
+				if(noCompression == compression_type) {
+					output_buffer = reply.toBuffers();
+				} else {
+					Header compression_header;
 					compression_header.name = "Content-Encoding";
-					compression_header.value = "deflate";
+					compression_header.value = (gzipRFC1952 == compression_type) ? "gzip" : "deflate";
 					reply.headers.insert(
 						reply.headers.begin(),
 						compression_header
 					);
-					compressCharArray(
-						reply.content.c_str(),
-						reply.content.length(),
-						compressed_output,
-						compression_type
-					);
-					reply.setSize(compressed_output.size());
-					output_buffer = reply.HeaderstoBuffers();
-					output_buffer.push_back(
-						boost::asio::buffer(compressed_output)
-					);
-					boost::asio::async_write(
-						TCP_socket,
-						output_buffer,
-						strand.wrap(
-							boost::bind(
-								&Connection::handle_write,
-								this->shared_from_this(),
-								boost::asio::placeholders::error
-							)
-						)
-					);
-					break;
-				case gzipRFC1952:
-					compression_header.name = "Content-Encoding";
-					compression_header.value = "gzip";
-					reply.headers.insert(
-						reply.headers.begin(),
-						compression_header
-					);
-					compressCharArray(
-						reply.content.c_str(),
-						reply.content.length(),
-						compressed_output,
-						compression_type
-					);
-					reply.setSize(compressed_output.size());
-					output_buffer = reply.HeaderstoBuffers();
-					output_buffer.push_back(
-						boost::asio::buffer(compressed_output)
-					);
-					boost::asio::async_write(
-						TCP_socket,
-						output_buffer,
-						strand.wrap(
-							boost::bind(
-								&Connection::handle_write,
-								this->shared_from_this(),
-								boost::asio::placeholders::error
-							)
-						)
-					);
-					break;
-				case noCompression:
-					boost::asio::async_write(
-						TCP_socket,
-						reply.toBuffers(),
-						strand.wrap(
-							boost::bind(
-								&Connection::handle_write,
-								this->shared_from_this(),
-								boost::asio::placeholders::error
-								)
-							)
+					std::vector<boost::asio::const_buffer> content_buffers;
+					reply.ContentToBuffers(content_buffers);
+					compressed_content.Clear();
+					{
+						QueryStageTimer timer(QUERY_STAGE_COMPRESSION);
+						ResponseCompressor::GetInstance().Compress(
+							content_buffers,
+							compression_type,
+							compression_settings.level,
+							compressed_content
 						);
-					break;
+					}
+					reply.setSize(compressed_content.size());
+					output_buffer = reply.HeaderstoBuffers();
+					for(unsigned i = 0; i < compressed_content.GetNumberOfChunks(); ++i) {
+						std::size_t length;
+						const char * chunk = compressed_content.GetChunk(i, length);
+						output_buffer.push_back(boost::asio::buffer(chunk, length));
+					}
 				}
+				QueryMetrics::EndRequest();
+				boost::asio::async_write(
+					TCP_socket,
+					output_buffer,
+					strand.wrap(
+						boost::bind(
+							&Connection::handle_write,
+							this->shared_from_this(),
+							boost::asio::placeholders::error
+						)
+					)
+				);
 			} else if (!result) {
 				reply = Reply::stockReply(Reply::badRequest);
 				boost::asio::async_write(
@@ -210,79 +189,16 @@ private:
 		}
 	}
 
-	// Big thanks to deusty who explains how to use gzip compression by
-	// the right call to deflateInit2():
-	// http://deusty.blogspot.com/2007/07/gzip-compressiondecompression.html
-	void compressCharArray(
-		const char * in_data,
-		size_t in_data_size,
-		std::vector<unsigned char> & buffer,
-		CompressionType type
-	) {
-		const size_t BUFSIZE = 128 * 1024;
-		unsigned char temp_buffer[BUFSIZE];
-
-		z_stream strm;
-		strm.zalloc = Z_NULL;
-		strm.zfree = Z_NULL;
-		strm.opaque = Z_NULL;
-		strm.total_out = 0;
-		strm.next_in = (unsigned char *)(in_data);
-		strm.avail_in = in_data_size;
-		strm.next_out = temp_buffer;
-		strm.avail_out = BUFSIZE;
-		strm.data_type = Z_ASCII;
-
-		switch(type){
-		case deflateRFC1951:
-			deflateInit(&strm, Z_BEST_SPEED);
-			break;
-		case gzipRFC1952:
-			deflateInit2(
-				&strm,
-				Z_DEFAULT_COMPRESSION,
-				Z_DEFLATED,
-				(15+16),
-				9,
-				Z_DEFAULT_STRATEGY
-			);
-			break;
-		default:
-			BOOST_ASSERT_MSG(false, "should not happen");
-			break;
-		}
-
-		int deflate_res = Z_OK;
-		do {
-			if ( 0 == strm.avail_out ) {
-				buffer.insert(buffer.end(), temp_buffer, temp_buffer + BUFSIZE);
-				strm.next_out = temp_buffer;
-				strm.avail_out = BUFSIZE;
-			}
-			deflate_res = deflate(&strm, Z_FINISH);
-
-		} while (deflate_res == Z_OK);
-
-		BOOST_ASSERT_MSG(
-			deflate_res == Z_STREAM_END,
-			"compression not properly finished"
-		);
-
-		buffer.insert(
-			buffer.end(),
-			temp_buffer,
-			temp_buffer + BUFSIZE - strm.avail_out
-		);
-		deflateEnd(&strm);
-	}
-
 	boost::asio::io_service::strand strand;
 	boost::asio::ip::tcp::socket TCP_socket;
 	RequestHandler& request_handler;
+	const CompressionSettings compression_settings;
 	boost::array<char, 8192> incoming_data_buffer;
 	Request request;
 	RequestParser request_parser;
 	Reply reply;
+	// must outlive the asynchronous write
+	OutputBuffer compressed_content;
 };
 
 } // namespace http
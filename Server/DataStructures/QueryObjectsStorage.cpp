@@ -27,7 +27,81 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "QueryObjectsStorage.h"
 
-QueryObjectsStorage::QueryObjectsStorage( const ServerPaths & paths ) {
+// JSON and GPX responses need names in HTML-escaped form, so an escaped copy
+// of the name table is built once at load time instead of on every request.
+static void EscapeNames(
+	const std::vector<char> & names_char_list,
+	const std::vector<unsigned> & name_begin_indices,
+	std::vector<char> & escaped_char_list,
+	std::vector<unsigned> & escaped_begin_indices
+) {
+	const unsigned number_of_entities = sizeof(originals)/sizeof(std::string);
+	escaped_char_list.clear();
+	escaped_char_list.reserve(names_char_list.size());
+	escaped_begin_indices.resize(name_begin_indices.size());
+	for(unsigned i = 0; i+1 < name_begin_indices.size(); ++i) {
+		const unsigned begin_index = name_begin_indices[i];
+		const unsigned end_index = name_begin_indices[i+1];
+		escaped_begin_indices[i] = escaped_char_list.size();
+		for(unsigned j = begin_index; j < end_index; ++j) {
+			const char character = names_char_list[j];
+			unsigned entity = 0;
+			while(entity < number_of_entities && character != originals[entity][0]) {
+				++entity;
+			}
+			if(entity < number_of_entities) {
+				escaped_char_list.insert(
+					escaped_char_list.end(),
+					entities[entity].begin(),
+					entities[entity].end()
+				);
+			} else {
+				escaped_char_list.push_back(character);
+			}
+		}
+	}
+	if(!escaped_begin_indices.empty()) {
+		escaped_begin_indices.back() = escaped_char_list.size();
+	}
+	escaped_char_list.push_back(0); //sentinel/dummy element
+}
+
+static void GetNameFromList(
+	const std::vector<char> & names_char_list,
+	const std::vector<unsigned> & name_begin_indices,
+	const unsigned name_id,
+	const char *& name,
+	unsigned & length
+) {
+	if(UINT_MAX == name_id) {
+		name = "";
+		length = 0;
+		return;
+	}
+	BOOST_ASSERT_MSG(
+		name_id < name_begin_indices.size(),
+		"name id too high"
+	);
+	unsigned begin_index = name_begin_indices[name_id];
+	unsigned end_index = name_begin_indices[name_id+1];
+	BOOST_ASSERT_MSG(
+		begin_index < names_char_list.size(),
+		"begin index of name too high"
+	);
+	BOOST_ASSERT_MSG(
+		end_index < names_char_list.size(),
+		"end index of name too high"
+	);
+
+	BOOST_ASSERT_MSG(begin_index <= end_index, "string ends before begin");
+	name = &names_char_list[begin_index];
+	length = end_index - begin_index;
+}
+
+QueryObjectsStorage::QueryObjectsStorage( const ServerPaths & paths ) :
+	traffic_overlay(NULL),
+	multi_level_graph(NULL)
+{
 	if( paths.find("hsgrdata") == paths.end() ) {
 		throw OSRMException("no hsgr file given in ini file");
 	}
@@ -67,6 +141,7 @@ QueryObjectsStorage::QueryObjectsStorage( const ServerPaths & paths ) {
 	graph = new QueryGraph(node_list, edge_list);
 	BOOST_ASSERT(0 == node_list.size());
 	BOOST_ASSERT(0 == edge_list.size());
+	search_graph = new SearchGraph(*graph);
 
 	paths_iterator = paths.find("timestamp");
 
@@ -141,43 +216,57 @@ QueryObjectsStorage::QueryObjectsStorage( const ServerPaths & paths ) {
 	BOOST_ASSERT_MSG(0 != m_names_char_list.size(), "could not load any names");
 
 	name_stream.close();
+	EscapeNames(
+		m_names_char_list,
+		m_name_begin_indices,
+		m_escaped_names_char_list,
+		m_escaped_name_begin_indices
+	);
+	paths_iterator = paths.find("mlddata");
+	if(paths.end() != paths_iterator && !paths_iterator->second.empty()) {
+		SimpleLogger().Write() << "Loading multi-level graph";
+		multi_level_graph = new MultiLevelGraph(paths_iterator->second, check_sum);
+	}
+	//customizes the multi-level graph, so it comes after it
+	paths_iterator = paths.find("trafficdata");
+	if(paths.end() != paths_iterator && !paths_iterator->second.empty()) {
+		traffic_overlay = new TrafficOverlay(
+			*graph,
+			*search_graph,
+			nodeHelpDesk->GetNumberOfOriginalEdges(),
+			paths_iterator->second,
+			multi_level_graph
+		);
+	}
 	SimpleLogger().Write() << "All query data structures loaded";
 }
 
 void QueryObjectsStorage::GetName(
 	const unsigned name_id,
-	std::string & result
+	const char *& name,
+	unsigned & length
 ) const {
-	if(UINT_MAX == name_id) {
-		result = "";
-		return;
-	}
-	BOOST_ASSERT_MSG(
-		name_id < m_name_begin_indices.size(),
-		"name id too high"
-	);
-	unsigned begin_index = m_name_begin_indices[name_id];
-	unsigned end_index = m_name_begin_indices[name_id+1];
-	BOOST_ASSERT_MSG(
-		begin_index < m_names_char_list.size(),
-		"begin index of name too high"
-	);
-	BOOST_ASSERT_MSG(
-		end_index < m_names_char_list.size(),
-		"end index of name too high"
-	);
+	GetNameFromList(m_names_char_list, m_name_begin_indices, name_id, name, length);
+}
 
-	BOOST_ASSERT_MSG(begin_index <= end_index, "string ends before begin");
-	result.clear();
-	result.resize(end_index - begin_index);
-	std::copy(
-		m_names_char_list.begin() + begin_index,
-		m_names_char_list.begin() + end_index,
-		result.begin()
+void QueryObjectsStorage::GetEscapedName(
+	const unsigned name_id,
+	const char *& name,
+	unsigned & length
+) const {
+	GetNameFromList(
+		m_escaped_names_char_list,
+		m_escaped_name_begin_indices,
+		name_id,
+		name,
+		length
 	);
 }
 
 QueryObjectsStorage::~QueryObjectsStorage() {
+	delete traffic_overlay;
+	delete multi_level_graph;
+	delete search_graph;
 	delete graph;
 	delete nodeHelpDesk;
 }
@@ -32,9 +32,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../../Util/OSRMException.h"
 #include "../../Util/ProgramOptions.h"
 #include "../../Util/SimpleLogger.h"
+#include "../../DataStructures/MultiLevelGraph.h"
 #include "../../DataStructures/NodeInformationHelpDesk.h"
 #include "../../DataStructures/QueryEdge.h"
+#include "../../DataStructures/SearchGraph.h"
 #include "../../DataStructures/StaticGraph.h"
+#include "../../DataStructures/TrafficOverlay.h"
 
 #include <boost/assert.hpp>
 #include <boost/filesystem.hpp>
@@ -51,11 +54,29 @@ struct QueryObjectsStorage {
     NodeInformationHelpDesk                   * nodeHelpDesk;
     std::vector<char>                           m_names_char_list;
     std::vector<unsigned>                       m_name_begin_indices;
+    std::vector<char>                           m_escaped_names_char_list;
+    std::vector<unsigned>                       m_escaped_name_begin_indices;
     QueryGraph                                * graph;
+    SearchGraph                               * search_graph;
+    //NULL unless a traffic feed is given
+    TrafficOverlay                            * traffic_overlay;
+    //NULL unless multi-level routing is enabled
+    MultiLevelGraph                           * multi_level_graph;
     std::string                                 timestamp;
     unsigned                                    check_sum;
 
-    void GetName( const unsigned name_id, std::string & result ) const;
+    void GetName(
+        const unsigned name_id,
+        const char *& name,
+        unsigned & length
+    ) const;
+
+    //same name, HTML-escaped for JSON and GPX output
+    void GetEscapedName(
+        const unsigned name_id,
+        const char *& name,
+        unsigned & length
+    ) const;
 
     QueryObjectsStorage( const ServerPaths & paths );
     ~QueryObjectsStorage();
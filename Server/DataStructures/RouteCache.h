@@ -0,0 +1,153 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef ROUTE_CACHE_H
+#define ROUTE_CACHE_H
+
+#include "RouteParameters.h"
+#include "../../DataStructures/PhantomNodes.h"
+#include "../../DataStructures/ShardedLRUCache.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cstddef>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Caches serialized route responses keyed by the snapped phantom nodes and
+// the options that influence the output. Requests whose coordinates snap
+// to identical phantom nodes are answered without a search. A cache belongs
+// to the dataset it was created for, the checksum of that dataset is fixed
+// for the lifetime of the process.
+class RouteCache : boost::noncopyable {
+public:
+    typedef boost::shared_ptr<const std::string> Response;
+
+    RouteCache(const std::size_t capacity_in_bytes, const unsigned dataset_checksum) :
+        capacity_in_bytes(capacity_in_bytes),
+        dataset_checksum(dataset_checksum),
+        cache(capacity_in_bytes)
+    { }
+
+    // builds the lookup key, the JSONP wrapper is not part of the response
+    static void BuildKey(
+        const std::vector<PhantomNode> & phantom_nodes,
+        const RouteParameters & route_parameters,
+        const unsigned descriptor_type,
+        std::string & key
+    ) {
+        key.clear();
+        key.reserve(16 + phantom_nodes.size()*(5*sizeof(int)+sizeof(double)));
+        AppendToKey(key, descriptor_type);
+        AppendToKey(key, route_parameters.zoomLevel);
+        const char flags =
+            (route_parameters.printInstructions ? 1 : 0) |
+            (route_parameters.alternateRoute    ? 2 : 0) |
+            (route_parameters.geometry          ? 4 : 0) |
+            (route_parameters.compression       ? 8 : 0);
+        AppendToKey(key, flags);
+        if(route_parameters.alternateRoute) {
+            const AlternativeRouteParameters & alternative = route_parameters.alternativeParameters;
+            AppendToKey(key, alternative.alpha);
+            AppendToKey(key, alternative.epsilon);
+            AppendToKey(key, alternative.gamma);
+            AppendToKey(key, alternative.numberOfCandidates);
+            AppendToKey(key, alternative.numberOfAlternatives);
+            AppendToKey(key, alternative.searchTimeBudget);
+            AppendToKey(key, alternative.qualityThreshold);
+        }
+        for(unsigned i = 0; i < phantom_nodes.size(); ++i) {
+            const PhantomNode & phantom_node = phantom_nodes[i];
+            AppendToKey(key, phantom_node.edgeBasedNode);
+            AppendToKey(key, phantom_node.nodeBasedEdgeNameID);
+            AppendToKey(key, phantom_node.weight1);
+            AppendToKey(key, phantom_node.weight2);
+            AppendToKey(key, phantom_node.ratio);
+            AppendToKey(key, phantom_node.location.lat);
+            AppendToKey(key, phantom_node.location.lon);
+        }
+    }
+
+    // responses of another dataset are neither served nor stored, the
+    // checksum is immutable and compared without taking a lock
+    bool Fetch(const std::string & key, const unsigned current_checksum, Response & response) {
+        if(current_checksum != dataset_checksum) {
+            return false;
+        }
+        return cache.Fetch(key, response);
+    }
+
+    void Insert(const std::string & key, const unsigned current_checksum, const Response & response) {
+        if(current_checksum != dataset_checksum) {
+            return;
+        }
+        cache.Insert(key, response, key.size() + response->size() + ENTRY_OVERHEAD);
+    }
+
+    void WritePrometheus(std::string & output) {
+        const ShardedLRUCache<std::string, Response>::Statistics statistics = cache.GetStatistics();
+        std::ostringstream out;
+        out << "# HELP osrm_route_cache_hits_total Route requests answered from the cache.\n";
+        out << "# TYPE osrm_route_cache_hits_total counter\n";
+        out << "osrm_route_cache_hits_total " << statistics.number_of_hits << "\n";
+        out << "# HELP osrm_route_cache_misses_total Route requests not found in the cache.\n";
+        out << "# TYPE osrm_route_cache_misses_total counter\n";
+        out << "osrm_route_cache_misses_total " << statistics.number_of_misses << "\n";
+        out << "# HELP osrm_route_cache_evictions_total Responses evicted to stay within the memory budget.\n";
+        out << "# TYPE osrm_route_cache_evictions_total counter\n";
+        out << "osrm_route_cache_evictions_total " << statistics.number_of_evictions << "\n";
+        out << "# HELP osrm_route_cache_entries Responses held in the cache.\n";
+        out << "# TYPE osrm_route_cache_entries gauge\n";
+        out << "osrm_route_cache_entries " << statistics.number_of_entries << "\n";
+        out << "# HELP osrm_route_cache_bytes Approximate memory used by cached responses.\n";
+        out << "# TYPE osrm_route_cache_bytes gauge\n";
+        out << "osrm_route_cache_bytes " << statistics.total_cost << "\n";
+        out << "# HELP osrm_route_cache_capacity_bytes Memory budget of the route cache.\n";
+        out << "# TYPE osrm_route_cache_capacity_bytes gauge\n";
+        out << "osrm_route_cache_capacity_bytes " << capacity_in_bytes << "\n";
+        output += out.str();
+    }
+
+private:
+    // list node, hash bucket and shared_ptr control block per entry
+    static const std::size_t ENTRY_OVERHEAD = 128;
+
+    template<typename T>
+    static void AppendToKey(std::string & key, const T & value) {
+        key.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    const std::size_t capacity_in_bytes;
+    const unsigned dataset_checksum;
+    ShardedLRUCache<std::string, Response> cache;
+};
+
+#endif /* ROUTE_CACHE_H */
@@ -28,6 +28,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef ROUTE_PARAMETERS_H
 #define ROUTE_PARAMETERS_H
 
+#include "../../DataStructures/AlternativeRouteParameters.h"
 #include "../../DataStructures/Coordinate.h"
 #include "../../DataStructures/HashTable.h"
 
@@ -46,6 +47,8 @@ struct RouteParameters {
         geometry(true),
         compression(true),
         deprecatedAPI(false),
+        trace(false),
+        traffic(false),
         checkSum(-1) {}
     short zoomLevel;
     bool printInstructions;
@@ -53,7 +56,10 @@ struct RouteParameters {
     bool geometry;
     bool compression;
     bool deprecatedAPI;
+    bool trace;
+    bool traffic;
     unsigned checkSum;
+    AlternativeRouteParameters alternativeParameters;
     std::string service;
     std::string outputFormat;
     std::string jsonpParameter;
@@ -76,6 +82,52 @@ struct RouteParameters {
         deprecatedAPI = true;
     }
 
+    void setTraceFlag(const bool b) {
+        trace = b;
+    }
+
+    void setTrafficFlag(const bool b) {
+        traffic = b;
+    }
+
+    void setAlternativeAlpha(const double alpha) {
+        if(0. < alpha && 1. >= alpha) {
+            alternativeParameters.alpha = alpha;
+        }
+    }
+
+    void setAlternativeEpsilon(const double epsilon) {
+        if(0. < epsilon && 1. >= epsilon) {
+            alternativeParameters.epsilon = epsilon;
+        }
+    }
+
+    void setAlternativeGamma(const double gamma) {
+        if(0. <= gamma && 1. >= gamma) {
+            alternativeParameters.gamma = gamma;
+        }
+    }
+
+    void setAlternativeCandidates(const unsigned number_of_candidates) {
+        alternativeParameters.numberOfCandidates = number_of_candidates;
+    }
+
+    void setNumberOfAlternatives(const unsigned number_of_alternatives) {
+        if(0 < number_of_alternatives && VIAPATH_MAXIMUM_NUMBER_OF_ALTERNATIVES >= number_of_alternatives) {
+            alternativeParameters.numberOfAlternatives = number_of_alternatives;
+        }
+    }
+
+    void setAlternativeSearchTimeBudget(const unsigned milliseconds) {
+        alternativeParameters.searchTimeBudget = milliseconds;
+    }
+
+    void setAlternativeQualityThreshold(const double quality) {
+        if(0. <= quality && 1. >= quality) {
+            alternativeParameters.qualityThreshold = quality;
+        }
+    }
+
     void setChecksum(const unsigned c) {
         checkSum = c;
     }
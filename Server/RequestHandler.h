@@ -32,6 +32,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "BasicDatastructures.h"
 #include "DataStructures/RouteParameters.h"
 #include "../Library/OSRM.h"
+#include "../Util/AsyncLogger.h"
+#include "../Util/QueryMetrics.h"
 #include "../Util/SimpleLogger.h"
 #include "../Util/StringUtil.h"
 #include "../typedefs.h"
@@ -54,31 +56,32 @@ public:
         try {
             std::string request(req.uri);
 
-            time_t ltime;
-            struct tm *Tm;
-
-            ltime=time(NULL);
-            Tm=localtime(&ltime);
-
-            SimpleLogger().Write() <<
-                (Tm->tm_mday < 10 ? "0" : "" )  << Tm->tm_mday    << "-" <<
-                (Tm->tm_mon+1 < 10 ? "0" : "" ) << (Tm->tm_mon+1) << "-" <<
-                1900+Tm->tm_year << " " << (Tm->tm_hour < 10 ? "0" : "" ) <<
-                Tm->tm_hour << ":" << (Tm->tm_min < 10 ? "0" : "" ) <<
-                Tm->tm_min << ":" << (Tm->tm_sec < 10 ? "0" : "" ) <<
-                Tm->tm_sec << " " << req.endpoint.to_string() << " " <<
-                req.referrer << ( 0 == req.referrer.length() ? "- " :" ") <<
-                req.agent << ( 0 == req.agent.length() ? "- " :" ") << req.uri;
+            AsyncLogger & access_log = AsyncLogger::GetInstance();
+            if(access_log.IsSampled()) {
+                AsyncLogLine line;
+                line.Append(access_log.GetTimestamp());
+                line.Append(" ");
+                line.Append(req.endpoint.to_string());
+                line.Append(" ");
+                line.Append(req.referrer);
+                line.Append(0 == req.referrer.length() ? "- " : " ");
+                line.Append(req.agent);
+                line.Append(0 == req.agent.length() ? "- " : " ");
+                line.Append(req.uri);
+                access_log.Write(line);
+            }
 
             RouteParameters routeParameters;
             APIGrammarParser apiParser(&routeParameters);
 
             std::string::iterator it = request.begin();
+            QueryStageTimer parsing_timer(QUERY_STAGE_PARSING);
             const bool result = boost::spirit::qi::parse(
                 it,
                 request.end(),
                 apiParser
             );
+            parsing_timer.Stop();
 
             if ( !result || (it != request.end()) ) {
                 rep = http::Reply::stockReply(http::Reply::badRequest);
@@ -0,0 +1,166 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef RESPONSE_COMPRESSOR_H_
+#define RESPONSE_COMPRESSOR_H_
+
+#include "BasicDatastructures.h"
+#include "../DataStructures/OutputBuffer.h"
+#include "../Util/OSRMException.h"
+
+#include <boost/asio.hpp>
+#include <boost/assert.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+
+#include <zlib.h>
+
+#include <cstring>
+
+#include <vector>
+
+namespace http {
+
+struct CompressionSettings {
+    CompressionSettings() : level(Z_BEST_SPEED), minimum_size(0) { }
+    CompressionSettings(const int level, const unsigned minimum_size) :
+        level(level),
+        minimum_size(minimum_size)
+    { }
+    int level;
+    // responses smaller than this are sent uncompressed
+    unsigned minimum_size;
+};
+
+// Deflates responses with one z_stream per compression type and thread.
+// The streams are set up once and only reset between responses, which saves
+// the allocation and initialization of zlib's internal state per request.
+class ResponseCompressor : private boost::noncopyable {
+public:
+    static ResponseCompressor & GetInstance() {
+        static boost::thread_specific_ptr<ResponseCompressor> thread_local_compressor;
+        if(!thread_local_compressor.get()) {
+            thread_local_compressor.reset(new ResponseCompressor());
+        }
+        return *thread_local_compressor;
+    }
+
+    ~ResponseCompressor() {
+        for(unsigned i = 0; i < NUMBER_OF_STREAMS; ++i) {
+            if(stream_is_initialized[i]) {
+                deflateEnd(&streams[i]);
+            }
+        }
+    }
+
+    // Compresses the buffer sequence piece by piece into the pooled chunks
+    // of output, so the content is never copied into a contiguous block.
+    void Compress(
+        const std::vector<boost::asio::const_buffer> & input,
+        const CompressionType type,
+        const int level,
+        OutputBuffer & output
+    ) {
+        z_stream & stream = GetStream(type, level);
+
+        int deflate_result = Z_OK;
+        unsigned input_index = 0;
+        do {
+            stream.next_in = Z_NULL;
+            stream.avail_in = 0;
+            if(input_index < input.size()) {
+                stream.next_in = (unsigned char *)boost::asio::buffer_cast<const unsigned char *>(
+                    input[input_index]
+                );
+                stream.avail_in = boost::asio::buffer_size(input[input_index]);
+            }
+            ++input_index;
+            const int flush = (input_index < input.size()) ? Z_NO_FLUSH : Z_FINISH;
+            bool output_is_full;
+            do {
+                std::size_t free_bytes;
+                stream.next_out = (unsigned char *)output.GetWritableSpace(free_bytes);
+                stream.avail_out = free_bytes;
+                deflate_result = deflate(&stream, flush);
+                BOOST_ASSERT_MSG(Z_STREAM_ERROR != deflate_result, "zlib state clobbered");
+                output.CommitWrittenBytes(free_bytes - stream.avail_out);
+                output_is_full = (0 == stream.avail_out);
+            } while(
+                (Z_FINISH == flush) ?
+                    (Z_STREAM_END != deflate_result) :
+                    (output_is_full || 0 != stream.avail_in)
+            );
+        } while(input_index < input.size());
+    }
+
+private:
+    static const unsigned NUMBER_OF_STREAMS = 2;
+
+    ResponseCompressor() {
+        for(unsigned i = 0; i < NUMBER_OF_STREAMS; ++i) {
+            memset(&streams[i], 0, sizeof(z_stream));
+            stream_is_initialized[i] = false;
+            stream_level[i] = Z_DEFAULT_COMPRESSION;
+        }
+    }
+
+    z_stream & GetStream(const CompressionType type, const int level) {
+        BOOST_ASSERT_MSG(noCompression != type, "no compression requested");
+        const unsigned index = (gzipRFC1952 == type) ? 1 : 0;
+        z_stream & stream = streams[index];
+        if(!stream_is_initialized[index]) {
+            stream.zalloc = Z_NULL;
+            stream.zfree = Z_NULL;
+            stream.opaque = Z_NULL;
+            // Big thanks to deusty who explains how to use gzip compression by
+            // the right call to deflateInit2():
+            // http://deusty.blogspot.com/2007/07/gzip-compressiondecompression.html
+            const int window_bits = (gzipRFC1952 == type) ? (15+16) : 15;
+            if(Z_OK != deflateInit2(&stream, level, Z_DEFLATED, window_bits, 9, Z_DEFAULT_STRATEGY)) {
+                throw OSRMException("could not initialize zlib");
+            }
+            stream_is_initialized[index] = true;
+            stream_level[index] = level;
+        } else {
+            deflateReset(&stream);
+            if(level != stream_level[index]) {
+                deflateParams(&stream, level, Z_DEFAULT_STRATEGY);
+                stream_level[index] = level;
+            }
+        }
+        return stream;
+    }
+
+    z_stream streams[NUMBER_OF_STREAMS];
+    bool stream_is_initialized[NUMBER_OF_STREAMS];
+    int stream_level[NUMBER_OF_STREAMS];
+};
+
+} // namespace http
+
+#endif /* RESPONSE_COMPRESSOR_H_ */
@@ -44,11 +44,15 @@ public:
 	explicit Server(
 		const std::string& address,
 		const std::string& port,
-		unsigned thread_pool_size
+		unsigned thread_pool_size,
+		const http::CompressionSettings & compression_settings
 	) :
 		threadPoolSize(thread_pool_size),
+		compressionSettings(compression_settings),
 		acceptor(ioService),
-		newConnection(new http::Connection(ioService, requestHandler)),
+		newConnection(
+			new http::Connection(ioService, requestHandler, compressionSettings)
+		),
 		requestHandler()
 	{
 		boost::asio::ip::tcp::resolver resolver(ioService);
@@ -92,7 +96,7 @@ private:
 		if (!e) {
 			newConnection->start();
 			newConnection.reset(
-				new http::Connection(ioService, requestHandler)
+				new http::Connection(ioService, requestHandler, compressionSettings)
 			);
 			acceptor.async_accept(
 				newConnection->socket(),
@@ -106,6 +110,7 @@ private:
 	}
 
 	unsigned threadPoolSize;
+	http::CompressionSettings compressionSettings;
 	boost::asio::io_service ioService;
 	boost::asio::ip::tcp::acceptor acceptor;
 	boost::shared_ptr<http::Connection> newConnection;
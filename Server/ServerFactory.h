@@ -38,14 +38,25 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <sstream>
 
 struct ServerFactory : boost::noncopyable {
-	static Server * CreateServer(std::string& ip_address, int ip_port, int threads) {
+	static Server * CreateServer(
+		std::string& ip_address,
+		int ip_port,
+		int threads,
+		int compression_level,
+		int compression_threshold
+	) {
 
 		SimpleLogger().Write() <<
 			"http 1.1 compression handled by zlib version " << zlibVersion();
 
         std::stringstream   port_stream;
         port_stream << ip_port;
-        return new Server( ip_address, port_stream.str(), std::min( omp_get_num_procs(), threads) );
+        return new Server(
+            ip_address,
+            port_stream.str(),
+            std::min( omp_get_num_procs(), threads),
+            http::CompressionSettings(compression_level, compression_threshold)
+        );
 	}
 };
 
@@ -0,0 +1,290 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "../Descriptors/BinaryResponseFormat.h"
+#include "../Util/OSRMException.h"
+#include "../Util/SimpleLogger.h"
+#include "../Util/TimingUtil.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct DecodedRoute {
+    BinaryRoute summary;
+    std::vector<BinaryInstruction> instructions;
+    std::vector<FixedPointCoordinate> geometry;
+};
+
+struct DecodedResponse {
+    BinaryResponseHeader header;
+    BinaryNearest nearest;
+    std::vector<BinaryCoordinate> via_points;
+    std::vector<std::string> hints;
+    std::vector<DecodedRoute> routes;
+    std::vector<std::string> names;
+};
+
+// Reads POD records from a response and throws on truncated input
+class ResponseReader {
+public:
+    ResponseReader(const std::vector<char> & data) :
+        position((const unsigned char *)&data[0]),
+        end(position + data.size())
+    { }
+
+    template<class T>
+    void Read(T & record) {
+        Read((char*)&record, sizeof(T));
+    }
+
+    void Read(char * output, const unsigned size) {
+        if(end - position < size) {
+            throw OSRMException("response is truncated");
+        }
+        std::copy(position, position+size, output);
+        position += size;
+    }
+
+    void ReadString(std::string & output, const unsigned size) {
+        if(end - position < size) {
+            throw OSRMException("response is truncated");
+        }
+        output.assign((const char*)position, size);
+        position += size;
+    }
+
+    void ReadGeometry(
+        const unsigned size,
+        const unsigned number_of_coordinates,
+        std::vector<FixedPointCoordinate> & geometry
+    ) {
+        if(end - position < size) {
+            throw OSRMException("response is truncated");
+        }
+        if(!DecodeBinaryGeometry(position, position+size, number_of_coordinates, geometry)) {
+            throw OSRMException("geometry is broken");
+        }
+        position += size;
+    }
+
+    void SkipPadding(const unsigned size) {
+        position += std::min<std::ptrdiff_t>(BinaryPaddingBytes(size), end - position);
+    }
+
+private:
+    const unsigned char * position;
+    const unsigned char * end;
+};
+
+void DecodeResponse(const std::vector<char> & data, DecodedResponse & response) {
+    if(data.empty()) {
+        throw OSRMException("response is empty");
+    }
+    ResponseReader reader(data);
+    reader.Read(response.header);
+    if(!std::equal(BINARY_RESPONSE_MAGIC, BINARY_RESPONSE_MAGIC+4, response.header.magic)) {
+        throw OSRMException("not a binary OSRM response");
+    }
+    if(BINARY_RESPONSE_VERSION != response.header.version) {
+        throw OSRMException("unsupported response version");
+    }
+
+    if(BINARY_NEAREST_RESPONSE == response.header.type) {
+        reader.Read(response.nearest);
+        response.names.resize(1);
+        reader.ReadString(response.names[0], response.nearest.name_length);
+        return;
+    }
+    if(BINARY_ROUTE_RESPONSE != response.header.type) {
+        throw OSRMException("unknown response type");
+    }
+
+    BinaryRouteResponse route_response;
+    reader.Read(route_response);
+    response.via_points.resize(route_response.number_of_via_points);
+    for(unsigned i = 0; i < route_response.number_of_via_points; ++i) {
+        reader.Read(response.via_points[i]);
+    }
+    response.hints.resize(route_response.number_of_via_points);
+    for(unsigned i = 0; i < route_response.number_of_via_points; ++i) {
+        reader.ReadString(response.hints[i], route_response.hint_size);
+    }
+    reader.SkipPadding(route_response.number_of_via_points*route_response.hint_size);
+
+    response.routes.resize(route_response.number_of_routes);
+    for(unsigned i = 0; i < route_response.number_of_routes; ++i) {
+        DecodedRoute & route = response.routes[i];
+        reader.Read(route.summary);
+        route.instructions.resize(route.summary.number_of_instructions);
+        if(!route.instructions.empty()) {
+            reader.Read(
+                (char*)&route.instructions[0],
+                route.instructions.size()*sizeof(BinaryInstruction)
+            );
+        }
+        reader.ReadGeometry(
+            route.summary.geometry_bytes,
+            route.summary.number_of_coordinates,
+            route.geometry
+        );
+        reader.SkipPadding(route.summary.geometry_bytes);
+    }
+
+    std::vector<unsigned> name_offsets(route_response.number_of_names+1);
+    reader.Read((char*)&name_offsets[0], name_offsets.size()*sizeof(unsigned));
+    std::string name_bytes;
+    reader.ReadString(name_bytes, route_response.name_bytes);
+    response.names.resize(route_response.number_of_names);
+    for(unsigned i = 0; i < route_response.number_of_names; ++i) {
+        if(name_offsets[i] > name_offsets[i+1] || name_offsets[i+1] > name_bytes.size()) {
+            throw OSRMException("name table is broken");
+        }
+        response.names[i] = name_bytes.substr(
+            name_offsets[i],
+            name_offsets[i+1] - name_offsets[i]
+        );
+    }
+}
+
+const std::string & GetName(const DecodedResponse & response, const unsigned index) {
+    if(index >= response.names.size()) {
+        throw OSRMException("name index out of range");
+    }
+    return response.names[index];
+}
+
+std::ostream & operator<<(std::ostream & out, const BinaryCoordinate & coordinate) {
+    out << std::fixed << std::setprecision(6) <<
+        coordinate.lat/COORDINATE_PRECISION << "," <<
+        coordinate.lon/COORDINATE_PRECISION;
+    return out;
+}
+
+void PrintResponse(const DecodedResponse & response) {
+    std::cout << "status: " << response.header.status << std::endl;
+    std::cout << "checksum: " << response.header.check_sum << std::endl;
+    if(BINARY_NEAREST_RESPONSE == response.header.type) {
+        std::cout << "mapped_coordinate: " << response.nearest.mapped_coordinate << std::endl;
+        std::cout << "name: " << response.names[0] << std::endl;
+        return;
+    }
+    for(unsigned i = 0; i < response.via_points.size(); ++i) {
+        std::cout << "via_point " << i << ": " << response.via_points[i] << std::endl;
+    }
+    for(unsigned i = 0; i < response.routes.size(); ++i) {
+        const DecodedRoute & route = response.routes[i];
+        std::cout << (0 == i ? "route" : "alternative") << ": " <<
+            route.summary.total_distance << "m, " <<
+            route.summary.total_time << "s, from \"" <<
+            GetName(response, route.summary.start_name) << "\" to \"" <<
+            GetName(response, route.summary.end_name) << "\", " <<
+            route.geometry.size() << " coordinates" << std::endl;
+        for(unsigned j = 0; j < route.instructions.size(); ++j) {
+            const BinaryInstruction & instruction = route.instructions[j];
+            std::cout << "  [" << int(instruction.turn_instruction);
+            if(0 != instruction.roundabout_exit) {
+                std::cout << "-" << int(instruction.roundabout_exit);
+            }
+            std::cout << ", \"" << GetName(response, instruction.name) << "\", " <<
+                instruction.length << ", " << instruction.position << ", " <<
+                instruction.duration << ", " << instruction.bearing << "]" << std::endl;
+        }
+    }
+}
+
+void ReadFile(const std::string & file_name, std::vector<char> & data) {
+    boost::filesystem::path path(file_name);
+    if(!boost::filesystem::exists(path)) {
+        throw OSRMException("file does not exist: " + file_name);
+    }
+    data.resize(boost::filesystem::file_size(path));
+    boost::filesystem::ifstream input_stream(path, std::ios::binary);
+    if(!data.empty()) {
+        input_stream.read(&data[0], data.size());
+    }
+}
+
+int main (int argc, char * argv[]) {
+    LogPolicy::GetInstance().Unmute();
+    if( 2 > argc ) {
+        SimpleLogger().Write(logWARNING) <<
+            "usage: " << argv[0] << " response.osrb [response.json [iterations]]";
+        return -1;
+    }
+    try {
+        std::vector<char> binary_data;
+        ReadFile(argv[1], binary_data);
+        DecodedResponse response;
+        DecodeResponse(binary_data, response);
+        PrintResponse(response);
+
+        if(2 == argc) {
+            return 0;
+        }
+        //compare decoding cost against the JSON response for the same query
+        std::vector<char> json_data;
+        ReadFile(argv[2], json_data);
+        const std::string json_string(json_data.begin(), json_data.end());
+        const unsigned iterations = (3 < argc) ? boost::lexical_cast<unsigned>(argv[3]) : 1000;
+
+        double time1 = get_timestamp();
+        for(unsigned i = 0; i < iterations; ++i) {
+            DecodedResponse decoded;
+            DecodeResponse(binary_data, decoded);
+        }
+        double time2 = get_timestamp();
+        const double binary_time = (time2-time1)*1000/iterations;
+
+        time1 = get_timestamp();
+        for(unsigned i = 0; i < iterations; ++i) {
+            std::stringstream json_stream(json_string);
+            boost::property_tree::ptree tree;
+            boost::property_tree::read_json(json_stream, tree);
+        }
+        time2 = get_timestamp();
+        const double json_time = (time2-time1)*1000/iterations;
+
+        SimpleLogger().Write() << "binary: " << binary_data.size() << " bytes, " <<
+            std::setprecision(5) << std::fixed << binary_time << "ms per decode";
+        SimpleLogger().Write() << "json:   " << json_data.size() << " bytes, " <<
+            std::setprecision(5) << std::fixed << json_time << "ms per parse";
+    } catch (const std::exception & e) {
+        SimpleLogger().Write(logWARNING) << "caught exception: " << e.what();
+        return -1;
+    }
+    return 0;
+}
@@ -91,23 +91,19 @@ int main (int argc, char * argv[]) {
     );
     restriction_ifstream.close();
 
-    std::ifstream input_stream;
-    input_stream.open( argv[1], std::ifstream::in | std::ifstream::binary );
-
-    if (!input_stream.is_open()) {
+    if (!boost::filesystem::is_regular_file(argv[1])) {
         throw OSRMException("Cannot open osrm file");
     }
 
     std::vector<ImportEdge> edge_list;
-    NodeID node_based_node_count = readBinaryOSRMGraphFromStream(
-            input_stream,
+    NodeID node_based_node_count = readBinaryOSRMGraphFromFile(
+            argv[1],
             edge_list,
             bollard_node_IDs_vector,
             traffic_light_node_IDs_vector,
             &internal_to_external_node_map,
             restrictions_vector
     );
-    input_stream.close();
 
     BOOST_ASSERT_MSG(
         restrictions_vector.size() == usable_restriction_count,
@@ -0,0 +1,77 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "../Algorithms/CRC32.h"
+#include "../Util/SimpleLogger.h"
+
+#include <boost/crc.hpp>
+
+#include <cstdlib>
+
+#include <vector>
+
+// Checks that the CRC32 of a buffer does not depend on how it is fed to
+// the checksum, i.e. on chunks of unaligned length, and that it matches
+// boost's CRC-32C. Bytes with the high bit set are included on purpose.
+int main (int argc, const char * argv[]) {
+    LogPolicy::GetInstance().Unmute();
+    static const unsigned BUFFER_SIZE = 1031;
+    std::srand(42);
+    std::vector<char> buffer(BUFFER_SIZE);
+    for(unsigned i = 0; i < BUFFER_SIZE; ++i) {
+        buffer[i] = (char)(std::rand() % 256);
+    }
+
+    boost::crc_optimal<32, 0x1EDC6F41, 0x0, 0x0, true, true> reference;
+    reference.process_bytes(&buffer[0], BUFFER_SIZE);
+
+    CRC32 crc32;
+    const unsigned whole = crc32(&buffer[0], BUFFER_SIZE);
+    unsigned number_of_mismatches = 0;
+    if(reference.checksum() != whole) {
+        SimpleLogger().Write(logWARNING) << "checksum " << whole << " differs from CRC-32C " << reference.checksum();
+        ++number_of_mismatches;
+    }
+
+    //two and three chunks, split at every offset of the first 64 bytes
+    for(unsigned first = 1; first < 64; ++first) {
+        for(unsigned second = 0; second < 64; second += 7) {
+            crc32.Reset();
+            crc32(&buffer[0], first);
+            crc32(&buffer[first], second);
+            const unsigned chunked = crc32(&buffer[first+second], BUFFER_SIZE-first-second);
+            if(chunked != whole) {
+                SimpleLogger().Write(logWARNING) << "chunks of " << first << ", " << second <<
+                    " and " << BUFFER_SIZE-first-second << " bytes give " << chunked << " instead of " << whole;
+                ++number_of_mismatches;
+            }
+        }
+    }
+    SimpleLogger().Write() << number_of_mismatches << " mismatches";
+    return (0 == number_of_mismatches) ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "../DataStructures/PhantomNodes.h"
+#include "../DataStructures/RawRouteData.h"
+#include "../DataStructures/SearchEngine.h"
+#include "../Server/DataStructures/QueryObjectsStorage.h"
+#include "../Util/OSRMException.h"
+#include "../Util/SimpleLogger.h"
+#include "../Util/TimingUtil.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <climits>
+#include <cstdlib>
+
+#include <string>
+#include <vector>
+
+// Compares the classic and the SearchGraph CH query kernel on random
+// queries. Both must find routes of equal length, paths may differ on ties.
+// With --parallel-legs the new kernel also searches legs in parallel, which
+// chains legs exactly and may thus find shorter, but never longer routes.
+int main (int argc, const char * argv[]) {
+    LogPolicy::GetInstance().Unmute();
+    try {
+        std::string base_path;
+        unsigned number_of_queries, number_of_via_points, parallel_leg_threshold, seed;
+
+        boost::program_options::options_description options(
+            boost::filesystem::basename(argv[0]) + " <base.osrm> [<options>]"
+        );
+        options.add_options()
+            ("help,h", "Show this help message")
+            (
+                "base,b",
+                boost::program_options::value<std::string>(&base_path),
+                "Data set to compare the kernels on"
+            )
+            (
+                "queries,q",
+                boost::program_options::value<unsigned>(&number_of_queries)->default_value(1000),
+                "Number of random queries"
+            )
+            (
+                "via,v",
+                boost::program_options::value<unsigned>(&number_of_via_points)->default_value(0),
+                "Number of via points per query"
+            )
+            (
+                "parallel-legs",
+                boost::program_options::value<unsigned>(&parallel_leg_threshold)->default_value(0),
+                "Search legs in parallel for routes with at least this many legs"
+            )
+            (
+                "seed",
+                boost::program_options::value<unsigned>(&seed)->default_value(1337),
+                "Seed for random queries"
+            );
+
+        boost::program_options::positional_options_description positional_options;
+        positional_options.add("base", 1);
+        boost::program_options::variables_map option_variables;
+        boost::program_options::store(
+            boost::program_options::command_line_parser(argc, argv).options(options).positional(positional_options).run(),
+            option_variables
+        );
+        boost::program_options::notify(option_variables);
+        if(option_variables.count("help") || base_path.empty()) {
+            SimpleLogger().Write() << options;
+            return 0;
+        }
+
+        ServerPaths server_paths;
+        const char * extensions[][2] = {
+            { "hsgrdata", ".hsgr" }, { "nodesdata", ".nodes" }, { "edgesdata", ".edges" },
+            { "ramindex", ".ramIndex" }, { "fileindex", ".fileIndex" },
+            { "namesdata", ".names" }, { "timestamp", ".timestamp" }
+        };
+        for(unsigned i = 0; i < sizeof(extensions)/sizeof(extensions[0]); ++i) {
+            server_paths[extensions[i][0]] = base_path + extensions[i][1];
+        }
+        QueryObjectsStorage query_objects(server_paths);
+        SearchEngine classic_engine(&query_objects);
+        classic_engine.UseClassicKernel(true);
+        classic_engine.SetParallelLegThreshold(0);
+        SearchEngine search_graph_engine(&query_objects);
+        search_graph_engine.SetParallelLegThreshold(parallel_leg_threshold);
+
+        srand(seed);
+        const unsigned number_of_nodes = query_objects.nodeHelpDesk->GetNumberOfNodes();
+        unsigned number_of_mismatches = 0;
+        unsigned number_of_shorter_routes = 0;
+        unsigned number_of_unroutable_queries = 0;
+        double classic_time = 0.;
+        double search_graph_time = 0.;
+        for(unsigned i = 0; i < number_of_queries; ++i) {
+            std::vector<PhantomNode> phantom_nodes(number_of_via_points + 2);
+            for(unsigned j = 0; j < phantom_nodes.size(); ++j) {
+                FixedPointCoordinate coordinate;
+                classic_engine.GetCoordinatesForNodeID(rand() % number_of_nodes, coordinate);
+                classic_engine.FindPhantomNodeForCoordinate(coordinate, phantom_nodes[j], 18);
+            }
+            std::vector<PhantomNodes> segments(phantom_nodes.size()-1);
+            for(unsigned j = 0; j < segments.size(); ++j) {
+                segments[j].startPhantom = phantom_nodes[j];
+                segments[j].targetPhantom = phantom_nodes[j+1];
+            }
+
+            RawRouteData classic_route;
+            double time1 = get_timestamp();
+            classic_engine.shortestPath(segments, classic_route);
+            classic_time += get_timestamp() - time1;
+
+            RawRouteData search_graph_route;
+            time1 = get_timestamp();
+            search_graph_engine.shortestPath(segments, search_graph_route);
+            search_graph_time += get_timestamp() - time1;
+
+            const bool chains_legs_exactly = (0 < parallel_leg_threshold) && (parallel_leg_threshold <= segments.size());
+            if(chains_legs_exactly && search_graph_route.lengthOfShortestPath < classic_route.lengthOfShortestPath) {
+                ++number_of_shorter_routes;
+            } else if(classic_route.lengthOfShortestPath != search_graph_route.lengthOfShortestPath) {
+                ++number_of_mismatches;
+                SimpleLogger().Write(logWARNING) << "query " << i << ": classic kernel found " <<
+                    classic_route.lengthOfShortestPath << ", new kernel found " <<
+                    search_graph_route.lengthOfShortestPath;
+            }
+            number_of_unroutable_queries += (INT_MAX == classic_route.lengthOfShortestPath);
+        }
+
+        SimpleLogger().Write() << number_of_queries << " queries, " <<
+            number_of_unroutable_queries << " without route, " <<
+            number_of_mismatches << " mismatches, " <<
+            number_of_shorter_routes << " shorter routes from parallel legs";
+        SimpleLogger().Write() << "classic kernel: " <<
+            1000.*classic_time/number_of_queries << " ms per query";
+        SimpleLogger().Write() << "new kernel: " <<
+            1000.*search_graph_time/number_of_queries << " ms per query";
+        return (0 == number_of_mismatches) ? 0 : 1;
+    } catch (std::exception & e) {
+        SimpleLogger().Write(logWARNING) << "caught exception: " << e.what();
+        return -1;
+    }
+}
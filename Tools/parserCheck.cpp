@@ -0,0 +1,170 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "../Extractor/ExtractionContainers.h"
+#include "../Extractor/ExtractorCallbacks.h"
+#include "../Extractor/ParallelXMLParser.h"
+#include "../Extractor/ScriptingEnvironment.h"
+#include "../Extractor/XMLParser.h"
+#include "../Util/OSRMException.h"
+#include "../Util/SimpleLogger.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <string>
+
+// Parses an .osm or .osm.bz2 file with the libxml2 based XMLParser and with
+// ParallelXMLParser and compares everything both hand to ExtractorCallbacks.
+// test/data/parser-check.osm.bz2 is a small multi-block fixture with tagged
+// nodes, degenerate ways and restriction as well as non-restriction relations.
+
+static inline bool IsEqual(const _Node & a, const _Node & b) {
+    return a.id == b.id && a.lat == b.lat && a.lon == b.lon &&
+        a.bollard == b.bollard && a.trafficLight == b.trafficLight;
+}
+
+static inline bool IsEqual(const InternalExtractorEdge & a, const InternalExtractorEdge & b) {
+    return a.start == b.start && a.target == b.target && a.type == b.type &&
+        a.direction == b.direction && a.speed == b.speed && a.nameID == b.nameID &&
+        a.isRoundabout == b.isRoundabout && a.ignoreInGrid == b.ignoreInGrid &&
+        a.isDurationSet == b.isDurationSet && a.isAccessRestricted == b.isAccessRestricted &&
+        a.isContraFlow == b.isContraFlow;
+}
+
+static inline bool IsEqual(const _RawRestrictionContainer & a, const _RawRestrictionContainer & b) {
+    return a.fromWay == b.fromWay && a.toWay == b.toWay &&
+        a.restriction.viaNode == b.restriction.viaNode &&
+        a.restriction.flags.isOnly == b.restriction.flags.isOnly &&
+        a.relationID == b.relationID;
+}
+
+static inline bool IsEqual(const _WayIDStartAndEndEdge & a, const _WayIDStartAndEndEdge & b) {
+    return a.wayID == b.wayID && a.firstStart == b.firstStart && a.firstTarget == b.firstTarget &&
+        a.lastStart == b.lastStart && a.lastTarget == b.lastTarget;
+}
+
+static inline bool IsEqual(const NodeID a, const NodeID b) {
+    return a == b;
+}
+
+static inline bool IsEqual(const std::string & a, const std::string & b) {
+    return a == b;
+}
+
+template<class VectorT>
+static unsigned CountMismatches(
+    const std::string & name,
+    const VectorT & libxml_vector,
+    const VectorT & parallel_vector
+) {
+    SimpleLogger().Write() << name << ": " << libxml_vector.size() <<
+        " (libxml2), " << parallel_vector.size() << " (parallel)";
+    if(libxml_vector.size() != parallel_vector.size()) {
+        return 1;
+    }
+    for(uint64_t i = 0; i < libxml_vector.size(); ++i) {
+        if(!IsEqual(libxml_vector[i], parallel_vector[i])) {
+            SimpleLogger().Write(logWARNING) << name << " differ at index " << i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+template<class ParserT>
+static void ParseFile(
+    const std::string & input_path,
+    ScriptingEnvironment & scripting_environment,
+    ExtractionContainers & containers
+) {
+    StringMap string_map;
+    string_map[""] = 0;
+    ExtractorCallbacks callbacks(&containers, &string_map);
+    ParserT parser(input_path.c_str(), &callbacks, scripting_environment);
+    if(!parser.ReadHeader()) {
+        throw OSRMException("Parser not initialized!");
+    }
+    parser.Parse();
+}
+
+int main (int argc, char * argv[]) {
+    LogPolicy::GetInstance().Unmute();
+    try {
+        std::string input_path, profile_path;
+
+        boost::program_options::options_description options(
+            boost::filesystem::basename(argv[0]) + " <data.osm/.osm.bz2> [<options>]"
+        );
+        options.add_options()
+            ("help,h", "Show this help message")
+            (
+                "input,i",
+                boost::program_options::value<std::string>(&input_path),
+                "Input file in .osm or .osm.bz2 format"
+            )
+            (
+                "profile,p",
+                boost::program_options::value<std::string>(&profile_path)->default_value("profile.lua"),
+                "Path to LUA routing profile"
+            );
+
+        boost::program_options::positional_options_description positional_options;
+        positional_options.add("input", 1);
+        boost::program_options::variables_map option_variables;
+        boost::program_options::store(
+            boost::program_options::command_line_parser(argc, argv).options(options).positional(positional_options).run(),
+            option_variables
+        );
+        boost::program_options::notify(option_variables);
+        if(option_variables.count("help") || input_path.empty()) {
+            SimpleLogger().Write() << options;
+            return 0;
+        }
+
+        ScriptingEnvironment scripting_environment(profile_path.c_str());
+        ExtractionContainers libxml_containers;
+        ExtractionContainers parallel_containers;
+        ParseFile<XMLParser>(input_path, scripting_environment, libxml_containers);
+        ParseFile<ParallelXMLParser>(input_path, scripting_environment, parallel_containers);
+
+        unsigned number_of_mismatches = 0;
+        number_of_mismatches += CountMismatches("nodes", libxml_containers.allNodes, parallel_containers.allNodes);
+        number_of_mismatches += CountMismatches("used node ids", libxml_containers.usedNodeIDs, parallel_containers.usedNodeIDs);
+        number_of_mismatches += CountMismatches("edges", libxml_containers.allEdges, parallel_containers.allEdges);
+        number_of_mismatches += CountMismatches("names", libxml_containers.name_list, parallel_containers.name_list);
+        number_of_mismatches += CountMismatches("restrictions", libxml_containers.restrictionsVector, parallel_containers.restrictionsVector);
+        number_of_mismatches += CountMismatches("way ends", libxml_containers.wayStartEndVector, parallel_containers.wayStartEndVector);
+
+        SimpleLogger().Write() << (0 == number_of_mismatches ? "parsers agree" : "parsers differ");
+        return (0 == number_of_mismatches) ? 0 : 1;
+    } catch (std::exception & e) {
+        SimpleLogger().Write(logWARNING) << "caught exception: " << e.what();
+        return -1;
+    }
+}
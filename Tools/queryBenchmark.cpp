@@ -0,0 +1,456 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "../Library/OSRM.h"
+#include "../Server/APIGrammar.h"
+#include "../Util/OSRMException.h"
+#include "../Util/SimpleLogger.h"
+#include "../Util/TimingUtil.h"
+
+#include <boost/asio.hpp>
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/program_options.hpp>
+#include <boost/thread.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+struct Statistics { double min, max, med, p95, p99, mean, dev; };
+
+void RunStatistics(std::vector<double> & timings_vector, Statistics & stats) {
+    std::sort(timings_vector.begin(), timings_vector.end());
+    stats.min = timings_vector.front();
+    stats.max = timings_vector.back();
+    stats.med = timings_vector[timings_vector.size()/2];
+    stats.p95 = timings_vector[(timings_vector.size()*95)/100];
+    stats.p99 = timings_vector[(timings_vector.size()*99)/100];
+    double primary_sum =    std::accumulate(
+                                timings_vector.begin(),
+                                timings_vector.end(),
+                                0.0
+                            );
+    stats.mean = primary_sum / timings_vector.size();
+
+    double primary_sq_sum = std::inner_product( timings_vector.begin(),
+                                timings_vector.end(),
+                                timings_vector.begin(),
+                                0.0
+                            );
+     stats.dev = std::sqrt(
+        primary_sq_sum / timings_vector.size() - (stats.mean * stats.mean)
+    );
+}
+
+struct QueryResult {
+    QueryResult() : time(0.), bytes(0), is_ok(false) { }
+    double time;
+    unsigned bytes;
+    bool is_ok;
+};
+
+// Extracts the request URI from a line of a query log. Understands plain
+// URIs, access log lines, which end in the URI, and JSON lines with a
+// "uri" or "url" member.
+bool ExtractURI(const std::string & line, std::string & uri) {
+    if(!line.empty() && '{' == line[0]) {
+        const char * keys[] = { "\"uri\"", "\"url\"" };
+        for(unsigned i = 0; i < 2; ++i) {
+            std::string::size_type position = line.find(keys[i]);
+            if(std::string::npos == position) {
+                continue;
+            }
+            position = line.find('"', line.find(':', position)+1);
+            const std::string::size_type end = line.find('"', position+1);
+            if(std::string::npos == position || std::string::npos == end) {
+                return false;
+            }
+            uri = line.substr(position+1, end-position-1);
+            // keep only the path if the member holds a full URL
+            const std::string::size_type scheme = uri.find("://");
+            if(std::string::npos != scheme) {
+                const std::string::size_type path = uri.find('/', scheme+3);
+                uri = (std::string::npos == path) ? std::string("/") : uri.substr(path);
+            }
+            return !uri.empty() && '/' == uri[0];
+        }
+        return false;
+    }
+    std::string::size_type position = line.find_last_of(" \t");
+    position = (std::string::npos == position) ? 0 : position+1;
+    uri = line.substr(position);
+    return !uri.empty() && '/' == uri[0];
+}
+
+// the plugin name a URI addresses, used to break down the results
+std::string GetServiceName(const std::string & uri) {
+    const std::string::size_type end = uri.find('?');
+    return uri.substr(1, (std::string::npos == end) ? std::string::npos : end-1);
+}
+
+void GenerateRandomQueries(
+    const std::vector<double> & bounding_box,
+    const unsigned number_of_queries,
+    const std::string & query_suffix,
+    std::vector<std::string> & queries
+) {
+    const double min_lat = bounding_box[0], min_lon = bounding_box[1];
+    const double max_lat = bounding_box[2], max_lon = bounding_box[3];
+    for(unsigned i = 0; i < number_of_queries; ++i) {
+        std::ostringstream query;
+        query << std::setprecision(6) << std::fixed << "/viaroute";
+        for(unsigned j = 0; j < 2; ++j) {
+            const double lat = min_lat + (max_lat-min_lat)*(std::rand()/(RAND_MAX+1.));
+            const double lon = min_lon + (max_lon-min_lon)*(std::rand()/(RAND_MAX+1.));
+            query << (0 == j ? "?" : "&") << "loc=" << lat << "," << lon;
+        }
+        query << query_suffix;
+        queries.push_back(query.str());
+    }
+}
+
+// Runs a query through the routing machine, parsing it like the server.
+void RunInProcessQuery(OSRM & routing_machine, const std::string & uri, QueryResult & result) {
+    typedef APIGrammar<std::string::iterator, RouteParameters> APIGrammarParser;
+    const double time1 = get_timestamp();
+    std::string request(uri);
+    RouteParameters route_parameters;
+    APIGrammarParser api_parser(&route_parameters);
+    std::string::iterator it = request.begin();
+    const bool parsed = boost::spirit::qi::parse(it, request.end(), api_parser);
+    http::Reply reply;
+    if(parsed && it == request.end()) {
+        routing_machine.RunQuery(route_parameters, reply);
+    } else {
+        reply = http::Reply::stockReply(http::Reply::badRequest);
+    }
+    result.time = get_timestamp() - time1;
+    result.bytes = reply.ContentSize();
+    result.is_ok = (http::Reply::ok == reply.status);
+}
+
+// Sends a single GET request and reads the response until the server
+// closes the connection, just like osrm-routed does after each reply.
+void RunHTTPQuery(
+    const boost::asio::ip::tcp::endpoint & endpoint,
+    const std::string & host,
+    const bool accept_gzip,
+    const std::string & uri,
+    QueryResult & result
+) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::socket socket(io_service);
+    const double time1 = get_timestamp();
+
+    // failures are counted, not thrown, as this runs on a worker thread
+    boost::system::error_code error;
+    socket.connect(endpoint, error);
+    if(error) {
+        result.time = get_timestamp() - time1;
+        return;
+    }
+    std::string request = "GET " + uri + " HTTP/1.0\r\nHost: " + host + "\r\n";
+    if(accept_gzip) {
+        request += "Accept-Encoding: gzip\r\n";
+    }
+    request += "\r\n";
+    boost::asio::write(socket, boost::asio::buffer(request), error);
+
+    std::string response;
+    char buffer[8192];
+    std::size_t length;
+    while(0 < (length = socket.read_some(boost::asio::buffer(buffer), error))) {
+        response.append(buffer, length);
+    }
+    result.time = get_timestamp() - time1;
+
+    const std::string::size_type header_end = response.find("\r\n\r\n");
+    result.bytes = (std::string::npos == header_end) ? 0 : response.size()-header_end-4;
+    result.is_ok = (0 == response.compare(0, 12, "HTTP/1.0 200")) || (0 == response.compare(0, 12, "HTTP/1.1 200"));
+}
+
+struct BenchmarkSettings {
+    bool use_http;
+    bool accept_gzip;
+    unsigned number_of_requests;
+    unsigned concurrency;
+    boost::asio::ip::tcp::endpoint endpoint;
+    std::string host;
+};
+
+// Each worker replays every concurrency'th query, so no coordination
+// between the workers is needed while the clock is running.
+void RunWorker(
+    const BenchmarkSettings & settings,
+    OSRM * routing_machine,
+    const std::vector<std::string> & queries,
+    const unsigned worker_id,
+    std::vector<QueryResult> & results
+) {
+    for(unsigned i = worker_id; i < settings.number_of_requests; i += settings.concurrency) {
+        const std::string & uri = queries[i % queries.size()];
+        if(settings.use_http) {
+            RunHTTPQuery(settings.endpoint, settings.host, settings.accept_gzip, uri, results[i]);
+        } else {
+            RunInProcessQuery(*routing_machine, uri, results[i]);
+        }
+    }
+}
+
+void PrintStatistics(const std::string & label, std::vector<double> & timings, const double duration) {
+    Statistics stats;
+    RunStatistics(timings, stats);
+    SimpleLogger().Write() << label << ": " <<
+        std::setprecision(5) << std::fixed <<
+        timings.size() << " queries, " <<
+        timings.size()/duration << " qps, " <<
+        "min: "  << stats.min*1000. << "ms, " <<
+        "mean: " << stats.mean*1000. << "ms, " <<
+        "med: "  << stats.med*1000. << "ms, " <<
+        "p95: "  << stats.p95*1000. << "ms, " <<
+        "p99: "  << stats.p99*1000. << "ms, " <<
+        "max: "  << stats.max*1000. << "ms, " <<
+        "dev: "  << stats.dev*1000. << "ms";
+}
+
+int main (int argc, const char * argv[]) {
+    LogPolicy::GetInstance().Unmute();
+    try {
+        std::string base_path, query_file, bounding_box_string, query_suffix, server;
+        unsigned number_of_requests, number_of_random_queries, concurrency, seed;
+        unsigned route_cache_size;
+        bool accept_gzip = false;
+
+        boost::program_options::options_description options(
+            boost::filesystem::basename(argv[0]) + " [<base.osrm>] [<options>]"
+        );
+        options.add_options()
+            ("help,h", "Show this help message")
+            (
+                "base,b",
+                boost::program_options::value<std::string>(&base_path),
+                "Replay queries in-process against the data set at base.osrm"
+            )
+            (
+                "server,s",
+                boost::program_options::value<std::string>(&server),
+                "Replay queries against a running osrm-routed at host:port instead"
+            )
+            (
+                "queries,q",
+                boost::program_options::value<std::string>(&query_file),
+                "Query log: URIs, access log lines or JSON lines with a uri member"
+            )
+            (
+                "random,r",
+                boost::program_options::value<unsigned>(&number_of_random_queries)->default_value(1000),
+                "Number of random viaroute queries if no query log is given"
+            )
+            (
+                "bbox",
+                boost::program_options::value<std::string>(&bounding_box_string)->default_value("52.4,13.2,52.6,13.6"),
+                "Bounding box min_lat,min_lon,max_lat,max_lon for random queries"
+            )
+            (
+                "suffix",
+                boost::program_options::value<std::string>(&query_suffix)->default_value("&alt=false"),
+                "Parameters appended to every random query"
+            )
+            (
+                "seed",
+                boost::program_options::value<unsigned>(&seed)->default_value(1337),
+                "Seed for random queries"
+            )
+            (
+                "requests,n",
+                boost::program_options::value<unsigned>(&number_of_requests)->default_value(0),
+                "Number of requests to send, cycling through the queries. Default: one pass"
+            )
+            (
+                "concurrency,c",
+                boost::program_options::value<unsigned>(&concurrency)->default_value(1),
+                "Number of requests in flight"
+            )
+            (
+                "route-cache-size",
+                boost::program_options::value<unsigned>(&route_cache_size)->default_value(0),
+                "Memory budget in MB for cached route responses in-process"
+            )
+            ("gzip", "Ask the server for gzip compressed responses");
+
+        boost::program_options::positional_options_description positional_options;
+        positional_options.add("base", 1);
+        boost::program_options::variables_map option_variables;
+        boost::program_options::store(
+            boost::program_options::command_line_parser(argc, argv).options(options).positional(positional_options).run(),
+            option_variables
+        );
+        boost::program_options::notify(option_variables);
+        if(option_variables.count("help") || (base_path.empty() == server.empty())) {
+            SimpleLogger().Write() << options;
+            SimpleLogger().Write() << "Exactly one of <base.osrm> and --server is needed.";
+            return 0;
+        }
+        accept_gzip = option_variables.count("gzip");
+        if(0 == concurrency) {
+            throw OSRMException("concurrency must be positive");
+        }
+
+        std::vector<std::string> queries;
+        if(!query_file.empty()) {
+            boost::filesystem::ifstream query_stream(query_file);
+            if(!query_stream.is_open()) {
+                throw OSRMException("cannot open query log " + query_file);
+            }
+            std::string line, uri;
+            unsigned number_of_skipped_lines = 0;
+            while(std::getline(query_stream, line)) {
+                if(ExtractURI(line, uri)) {
+                    queries.push_back(uri);
+                } else {
+                    ++number_of_skipped_lines;
+                }
+            }
+            SimpleLogger().Write() << "read " << queries.size() << " queries, skipped " <<
+                number_of_skipped_lines << " lines without a URI";
+        } else {
+            std::vector<double> bounding_box;
+            std::stringstream bounding_box_stream(bounding_box_string);
+            std::string coordinate;
+            while(std::getline(bounding_box_stream, coordinate, ',')) {
+                bounding_box.push_back(boost::lexical_cast<double>(coordinate));
+            }
+            if(4 != bounding_box.size()) {
+                throw OSRMException("bounding box needs four coordinates");
+            }
+            std::srand(seed);
+            GenerateRandomQueries(bounding_box, number_of_random_queries, query_suffix, queries);
+            SimpleLogger().Write() << "generated " << queries.size() << " random queries";
+        }
+        if(queries.empty()) {
+            throw OSRMException("no queries to replay");
+        }
+
+        BenchmarkSettings settings;
+        settings.use_http = !server.empty();
+        settings.accept_gzip = accept_gzip;
+        settings.concurrency = concurrency;
+        settings.number_of_requests = (0 == number_of_requests) ? queries.size() : number_of_requests;
+
+        OSRM * routing_machine = NULL;
+        if(settings.use_http) {
+            const std::string::size_type colon = server.rfind(':');
+            settings.host = server.substr(0, colon);
+            const std::string port = (std::string::npos == colon) ? "5000" : server.substr(colon+1);
+            boost::asio::io_service io_service;
+            boost::asio::ip::tcp::resolver resolver(io_service);
+            boost::asio::ip::tcp::resolver::query query(settings.host, port);
+            settings.endpoint = *resolver.resolve(query);
+        } else {
+            ServerPaths server_paths;
+            const char * extensions[][2] = {
+                { "hsgrdata", ".hsgr" }, { "nodesdata", ".nodes" }, { "edgesdata", ".edges" },
+                { "ramindex", ".ramIndex" }, { "fileindex", ".fileIndex" },
+                { "namesdata", ".names" }, { "timestamp", ".timestamp" }
+            };
+            for(unsigned i = 0; i < sizeof(extensions)/sizeof(extensions[0]); ++i) {
+                server_paths[extensions[i][0]] = base_path + extensions[i][1];
+            }
+            //routes on the multi-level graph if osrm-prepare --mld wrote one
+            if(boost::filesystem::exists(base_path + ".mld")) {
+                server_paths["mlddata"] = base_path + ".mld";
+            }
+            routing_machine = new OSRM(server_paths, route_cache_size);
+        }
+
+        SimpleLogger().Write() << "replaying " << settings.number_of_requests << " requests " <<
+            (settings.use_http ? "against " + server : std::string("in-process")) <<
+            " with concurrency " << concurrency;
+        // the engine logs every query, which would dominate the measurement
+        LogPolicy::GetInstance().Mute();
+
+        std::vector<QueryResult> results(settings.number_of_requests);
+        const double time1 = get_timestamp();
+        boost::thread_group workers;
+        for(unsigned i = 0; i < concurrency; ++i) {
+            workers.create_thread(
+                boost::bind(
+                    RunWorker,
+                    boost::cref(settings),
+                    routing_machine,
+                    boost::cref(queries),
+                    i,
+                    boost::ref(results)
+                )
+            );
+        }
+        workers.join_all();
+        const double duration = get_timestamp() - time1;
+        LogPolicy::GetInstance().Unmute();
+        delete routing_machine;
+
+        std::vector<double> all_timings;
+        std::map<std::string, std::vector<double> > timings_per_service;
+        unsigned number_of_failures = 0;
+        double total_bytes = 0.;
+        for(unsigned i = 0; i < results.size(); ++i) {
+            all_timings.push_back(results[i].time);
+            timings_per_service[GetServiceName(queries[i % queries.size()])].push_back(results[i].time);
+            number_of_failures += !results[i].is_ok;
+            total_bytes += results[i].bytes;
+        }
+        SimpleLogger().Write() << "finished in " << std::setprecision(3) << std::fixed << duration << "s, " <<
+            number_of_failures << " failed requests, " <<
+            total_bytes/results.size() << " bytes per response";
+        PrintStatistics("all", all_timings, duration);
+        typedef std::map<std::string, std::vector<double> >::value_type ServiceTimings;
+        BOOST_FOREACH(ServiceTimings & service_timings, timings_per_service) {
+            PrintStatistics(service_timings.first, service_timings.second, duration);
+        }
+        // lets scripts and the test suite tell a broken setup from a slow one
+        if(0 < number_of_failures) {
+            return 1;
+        }
+    } catch (std::exception & e) {
+        LogPolicy::GetInstance().Unmute();
+        SimpleLogger().Write(logWARNING) << "caught exception: " << e.what();
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,190 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "../DataStructures/BinaryHeap.h"
+#include "../DataStructures/QueryEdge.h"
+#include "../DataStructures/StaticGraph.h"
+#include "../Util/GraphLoader.h"
+#include "../Util/OSRMException.h"
+#include "../Util/SimpleLogger.h"
+#include "../Util/TimingUtil.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/foreach.hpp>
+#include <boost/program_options.hpp>
+
+#include <climits>
+#include <cstdlib>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+typedef StaticGraph<QueryEdge::EdgeData> QueryGraph;
+
+struct SearchHeapData {
+    SearchHeapData(const NodeID p) : parent(p) { }
+    NodeID parent;
+};
+typedef BinaryHeap<NodeID, NodeID, int, SearchHeapData, ArrayStorage<NodeID, NodeID> > SearchHeap;
+
+// Settles the closest node of one direction and relaxes its upward edges
+void SettleNode(
+    const QueryGraph & graph,
+    SearchHeap & heap,
+    const SearchHeap & other_heap,
+    const bool forward_direction,
+    int & upper_bound
+) {
+    const NodeID node = heap.DeleteMin();
+    const int distance = heap.GetKey(node);
+    if(other_heap.WasInserted(node)) {
+        upper_bound = std::min(upper_bound, distance + other_heap.GetKey(node));
+    }
+    for(QueryGraph::EdgeIterator edge = graph.BeginEdges(node); edge < graph.EndEdges(node); ++edge) {
+        const QueryGraph::EdgeData & data = graph.GetEdgeData(edge);
+        if(forward_direction ? !data.forward : !data.backward) {
+            continue;
+        }
+        const NodeID target = graph.GetTarget(edge);
+        const int new_distance = distance + data.distance;
+        if(!heap.WasInserted(target)) {
+            heap.Insert(target, new_distance, SearchHeapData(node));
+        } else if(new_distance < heap.GetKey(target)) {
+            heap.GetData(target).parent = node;
+            heap.DecreaseKey(target, new_distance);
+        }
+    }
+}
+
+inline bool HasNodeBelow(const SearchHeap & heap, const int upper_bound) {
+    return 0 < heap.Size() && heap.GetKey(heap.Min()) < upper_bound;
+}
+
+// Measures the search spaces of contraction hierarchies. Every .hsgr file
+// gets the same random pairs of nodes, so the node orders of several runs
+// of osrm-prepare on one data set can be compared.
+int main (int argc, const char * argv[]) {
+    LogPolicy::GetInstance().Unmute();
+    try {
+        std::vector<std::string> hsgr_paths;
+        unsigned number_of_queries, seed;
+
+        boost::program_options::options_description options(
+            boost::filesystem::basename(argv[0]) + " <a.hsgr> [<b.hsgr> ...] [<options>]"
+        );
+        options.add_options()
+            ("help,h", "Show this help message")
+            (
+                "hsgr",
+                boost::program_options::value<std::vector<std::string> >(&hsgr_paths),
+                "Contracted graphs to measure"
+            )
+            (
+                "queries,q",
+                boost::program_options::value<unsigned>(&number_of_queries)->default_value(1000),
+                "Number of random queries"
+            )
+            (
+                "seed",
+                boost::program_options::value<unsigned>(&seed)->default_value(1337),
+                "Seed for random queries"
+            );
+
+        boost::program_options::positional_options_description positional_options;
+        positional_options.add("hsgr", -1);
+        boost::program_options::variables_map option_variables;
+        boost::program_options::store(
+            boost::program_options::command_line_parser(argc, argv).options(options).positional(positional_options).run(),
+            option_variables
+        );
+        boost::program_options::notify(option_variables);
+        if(option_variables.count("help") || hsgr_paths.empty() || 0 == number_of_queries) {
+            SimpleLogger().Write() << options;
+            return 0;
+        }
+
+        BOOST_FOREACH(const std::string & hsgr_path, hsgr_paths) {
+            std::vector<QueryGraph::_StrNode> node_list;
+            std::vector<QueryGraph::_StrEdge> edge_list;
+            unsigned check_sum = 0;
+            readHSGRFromStream(hsgr_path, node_list, edge_list, &check_sum);
+            const unsigned number_of_edges = edge_list.size();
+            QueryGraph graph(node_list, edge_list);
+            const unsigned number_of_nodes = graph.GetNumberOfNodes();
+
+            SearchHeap forward_heap(number_of_nodes);
+            SearchHeap backward_heap(number_of_nodes);
+            srand(seed);
+            unsigned number_of_unroutable_queries = 0;
+            std::vector<double> settled_nodes(number_of_queries);
+            const double time1 = get_timestamp();
+            for(unsigned i = 0; i < number_of_queries; ++i) {
+                const NodeID source = rand() % number_of_nodes;
+                const NodeID target = rand() % number_of_nodes;
+                forward_heap.Clear();
+                backward_heap.Clear();
+                forward_heap.Insert(source, 0, SearchHeapData(source));
+                backward_heap.Insert(target, 0, SearchHeapData(target));
+
+                int upper_bound = INT_MAX;
+                while(HasNodeBelow(forward_heap, upper_bound) || HasNodeBelow(backward_heap, upper_bound)) {
+                    if(HasNodeBelow(forward_heap, upper_bound)) {
+                        SettleNode(graph, forward_heap, backward_heap, true, upper_bound);
+                    }
+                    if(HasNodeBelow(backward_heap, upper_bound)) {
+                        SettleNode(graph, backward_heap, forward_heap, false, upper_bound);
+                    }
+                }
+                settled_nodes[i] = forward_heap.NumberOfDeletedNodes() + backward_heap.NumberOfDeletedNodes();
+                number_of_unroutable_queries += (INT_MAX == upper_bound);
+            }
+            const double duration = get_timestamp() - time1;
+
+            std::sort(settled_nodes.begin(), settled_nodes.end());
+            double sum_of_settled_nodes = 0.;
+            BOOST_FOREACH(const double settled, settled_nodes) {
+                sum_of_settled_nodes += settled;
+            }
+            SimpleLogger().Write() << hsgr_path << ": " <<
+                number_of_nodes << " nodes, " <<
+                number_of_edges << " edges, " <<
+                number_of_unroutable_queries << " of " << number_of_queries << " queries without route";
+            SimpleLogger().Write() << "settled nodes per query, mean: " <<
+                sum_of_settled_nodes/number_of_queries << ", med: " <<
+                settled_nodes[number_of_queries/2] << ", p99: " <<
+                settled_nodes[(number_of_queries*99)/100] << ", max: " <<
+                settled_nodes.back() << ", " <<
+                1000.*duration/number_of_queries << " ms per query";
+        }
+    } catch (std::exception & e) {
+        SimpleLogger().Write(logWARNING) << "caught exception: " << e.what();
+        return -1;
+    }
+    return 0;
+}
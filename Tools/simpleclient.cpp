@@ -55,6 +55,8 @@ int main (int argc, const char * argv[]) {
     try {
         std::string ip_address;
         int ip_port, requested_num_threads;
+        int compression_level, compression_threshold;
+        int access_log_sampling, route_cache_size;
 
         ServerPaths server_paths;
         if( !GenerateServerProgramOptions(
@@ -63,7 +65,11 @@ int main (int argc, const char * argv[]) {
                 server_paths,
                 ip_address,
                 ip_port,
-                requested_num_threads
+                requested_num_threads,
+                compression_level,
+                compression_threshold,
+                access_log_sampling,
+                route_cache_size
              )
         ) {
             return 0;
@@ -73,7 +79,7 @@ int main (int argc, const char * argv[]) {
             "starting up engines, " << g_GIT_DESCRIPTION << ", " <<
             "compiled at " << __DATE__ << ", " __TIME__;
 
-        OSRM routing_machine(server_paths);
+        OSRM routing_machine(server_paths, route_cache_size);
 
         RouteParameters route_parameters;
         route_parameters.zoomLevel = 18; //no generalization
@@ -97,12 +103,14 @@ int main (int argc, const char * argv[]) {
 
         routing_machine.RunQuery(route_parameters, osrm_reply);
 
-        std::cout << osrm_reply.content << std::endl;
+        std::string reply_content;
+        osrm_reply.GetContent(reply_content);
+        std::cout << reply_content << std::endl;
 
         //attention: super-inefficient hack below:
 
         std::stringstream ss;
-        ss << osrm_reply.content;
+        ss << reply_content;
 
         boost::property_tree::ptree pt;
         boost::property_tree::read_json(ss, pt);
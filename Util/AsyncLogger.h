@@ -0,0 +1,347 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef ASYNC_LOGGER_H_
+#define ASYNC_LOGGER_H_
+
+#include "OSRMException.h"
+#include "SimpleLogger.h"
+
+#include <boost/assert.hpp>
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/foreach.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <cstring>
+#include <ctime>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// A single log line of bounded length. Longer lines are truncated.
+class AsyncLogLine {
+public:
+    static const unsigned MAX_LENGTH = 504;
+
+    AsyncLogLine() : length(0) { }
+
+    void Append(const char * text, const unsigned text_length) {
+        const unsigned copied = std::min(text_length, MAX_LENGTH-length);
+        std::memcpy(buffer+length, text, copied);
+        length += copied;
+    }
+
+    void Append(const char * text) {
+        Append(text, std::strlen(text));
+    }
+
+    void Append(const std::string & text) {
+        Append(text.c_str(), text.length());
+    }
+
+    const char * GetText() const {
+        return buffer;
+    }
+
+    unsigned GetLength() const {
+        return length;
+    }
+
+private:
+    unsigned length;
+    char buffer[MAX_LENGTH];
+};
+
+// Hands log lines from request threads to a background writer thread.
+// Each thread owns a single-producer/single-consumer ring of fixed-size
+// slots, so producers never block on each other or on the output stream.
+// If a ring is full the line is dropped and counted instead of waiting.
+class AsyncLogger : private boost::noncopyable {
+public:
+    static AsyncLogger & GetInstance() {
+        static AsyncLogger runningInstance;
+        return runningInstance;
+    }
+
+    // Starts the writer thread. An empty path logs to stdout. Only every
+    // sampling_rate'th line per thread is logged, 0 disables logging.
+    void Start(
+        const boost::filesystem::path & path,
+        const unsigned sampling_rate
+    ) {
+        BOOST_ASSERT_MSG(!is_running, "logger already started");
+        this->sampling_rate = sampling_rate;
+        if(!path.empty()) {
+            file_stream.open(path, std::ios::app);
+            if(!file_stream.is_open()) {
+                throw OSRMException("cannot open log file " + path.string());
+            }
+            output = &file_stream;
+        }
+        is_running = true;
+        writer_thread = boost::thread(boost::bind(&AsyncLogger::Run, this));
+    }
+
+    // Writes out all pending lines and joins the writer thread.
+    void Stop() {
+        if(!is_running) {
+            return;
+        }
+        writer_thread.interrupt();
+        writer_thread.join();
+        boost::mutex::scoped_lock lock(buffers_mutex);
+        is_running = false;
+        Flush();
+    }
+
+    // Call once per line before formatting it to honor the sampling rate.
+    bool IsSampled() {
+        if(!is_running) {
+            return true;
+        }
+        if(0 == sampling_rate) {
+            return false;
+        }
+        ThreadBuffer & buffer = GetThreadBuffer();
+        return 0 == (buffer.sample_counter++ % sampling_rate);
+    }
+
+    // Copies the line into the ring of the calling thread, never blocks.
+    void Write(const AsyncLogLine & line) {
+        if(!is_running) {
+            SimpleLogger().Write() << std::string(line.GetText(), line.GetLength());
+            return;
+        }
+        ThreadBuffer & buffer = GetThreadBuffer();
+        const unsigned head = buffer.head;
+        if(head - buffer.tail >= NUMBER_OF_SLOTS) {
+            ++buffer.dropped_lines;
+            return;
+        }
+        Slot & slot = buffer.slots[head & (NUMBER_OF_SLOTS-1)];
+        slot.length = line.GetLength();
+        std::memcpy(slot.text, line.GetText(), slot.length);
+        // the slot must be visible before it is published to the writer
+        MemoryFence();
+        buffer.head = head+1;
+    }
+
+    // Returns "dd-mm-yyyy hh:mm:ss" in local time. It is formatted at most
+    // once per second and thread, as localtime() is surprisingly expensive.
+    const char * GetTimestamp() {
+        ThreadBuffer & buffer = GetThreadBuffer();
+        const time_t now = time(NULL);
+        if(now != buffer.timestamp_second) {
+            struct tm local_time;
+#ifdef _WIN32
+            localtime_s(&local_time, &now);
+#else
+            localtime_r(&now, &local_time);
+#endif
+            strftime(buffer.timestamp, sizeof(buffer.timestamp), "%d-%m-%Y %H:%M:%S", &local_time);
+            buffer.timestamp_second = now;
+        }
+        return buffer.timestamp;
+    }
+
+    // Appends the logger counters in the Prometheus text format.
+    void WritePrometheus(std::string & output) {
+        boost::uint64_t dropped_lines = 0;
+        boost::uint64_t written_lines = 0;
+        {
+            boost::mutex::scoped_lock lock(buffers_mutex);
+            BOOST_FOREACH(const ThreadBuffer * buffer, thread_buffers) {
+                dropped_lines += buffer->dropped_lines;
+            }
+            dropped_lines += retired_dropped_lines;
+            written_lines = this->written_lines;
+        }
+        std::ostringstream out;
+        out << "# HELP osrm_log_dropped_lines_total Log lines dropped because a log buffer was full.\n";
+        out << "# TYPE osrm_log_dropped_lines_total counter\n";
+        out << "osrm_log_dropped_lines_total " << dropped_lines << "\n";
+        out << "# HELP osrm_log_written_lines_total Log lines written by the background writer.\n";
+        out << "# TYPE osrm_log_written_lines_total counter\n";
+        out << "osrm_log_written_lines_total " << written_lines << "\n";
+        output += out.str();
+    }
+
+private:
+    // slots per thread, must be a power of two
+    static const unsigned NUMBER_OF_SLOTS = 1024;
+    static const unsigned FLUSH_INTERVAL_MS = 10;
+
+    struct Slot {
+        unsigned length;
+        char text[AsyncLogLine::MAX_LENGTH];
+    };
+
+    struct ThreadBuffer : private boost::noncopyable {
+        ThreadBuffer() :
+            head(0),
+            tail(0),
+            dropped_lines(0),
+            is_orphaned(false),
+            sample_counter(0),
+            timestamp_second(0)
+        {
+            timestamp[0] = '\0';
+        }
+        Slot slots[NUMBER_OF_SLOTS];
+        // only written by the producing thread
+        volatile unsigned head;
+        // only written by the writer thread
+        volatile unsigned tail;
+        volatile unsigned dropped_lines;
+        // the producing thread has exited, guarded by buffers_mutex
+        bool is_orphaned;
+        unsigned sample_counter;
+        time_t timestamp_second;
+        char timestamp[24];
+    };
+
+    AsyncLogger() :
+        is_running(false),
+        sampling_rate(1),
+        output(&std::cout),
+        written_lines(0),
+        retired_dropped_lines(0)
+    { }
+
+    ~AsyncLogger() {
+        Stop();
+    }
+
+    static inline void MemoryFence() {
+#ifdef _MSC_VER
+        _ReadWriteBarrier();
+        _mm_mfence();
+#else
+        __sync_synchronize();
+#endif
+    }
+
+    static void RetireThreadBuffer(ThreadBuffer * buffer) {
+        AsyncLogger & logger = GetInstance();
+        boost::mutex::scoped_lock lock(logger.buffers_mutex);
+        if(logger.is_running) {
+            // the writer drains it one last time
+            buffer->is_orphaned = true;
+            return;
+        }
+        logger.RemoveThreadBuffer(buffer);
+    }
+
+    ThreadBuffer & GetThreadBuffer() {
+        static boost::thread_specific_ptr<ThreadBuffer> thread_local_buffer(RetireThreadBuffer);
+        if(!thread_local_buffer.get()) {
+            ThreadBuffer * buffer = new ThreadBuffer();
+            boost::mutex::scoped_lock lock(buffers_mutex);
+            thread_buffers.push_back(buffer);
+            thread_local_buffer.reset(buffer);
+        }
+        return *thread_local_buffer;
+    }
+
+    // buffers_mutex must be held
+    void RemoveThreadBuffer(ThreadBuffer * buffer) {
+        retired_dropped_lines += buffer->dropped_lines;
+        thread_buffers.erase(
+            std::remove(thread_buffers.begin(), thread_buffers.end(), buffer),
+            thread_buffers.end()
+        );
+        delete buffer;
+    }
+
+    void Run() {
+        try {
+            while(true) {
+                boost::this_thread::sleep(boost::posix_time::milliseconds(FLUSH_INTERVAL_MS));
+                boost::mutex::scoped_lock lock(buffers_mutex);
+                Flush();
+            }
+        } catch(boost::thread_interrupted &) { }
+    }
+
+    // Moves all published lines into one batch and writes it at once.
+    // buffers_mutex must be held.
+    void Flush() {
+        batch.clear();
+        std::vector<ThreadBuffer *> orphaned_buffers;
+        BOOST_FOREACH(ThreadBuffer * buffer, thread_buffers) {
+            const unsigned head = buffer->head;
+            MemoryFence();
+            unsigned tail = buffer->tail;
+            for(; tail != head; ++tail) {
+                const Slot & slot = buffer->slots[tail & (NUMBER_OF_SLOTS-1)];
+                batch += "[info] ";
+                batch.append(slot.text, slot.length);
+                batch += '\n';
+                ++written_lines;
+            }
+            // slots must be read before they are handed back
+            MemoryFence();
+            buffer->tail = tail;
+            if(buffer->is_orphaned) {
+                orphaned_buffers.push_back(buffer);
+            }
+        }
+        BOOST_FOREACH(ThreadBuffer * buffer, orphaned_buffers) {
+            RemoveThreadBuffer(buffer);
+        }
+        if(!batch.empty() && !LogPolicy::GetInstance().IsMute()) {
+            output->write(batch.data(), batch.size());
+            output->flush();
+        }
+    }
+
+    volatile bool is_running;
+    unsigned sampling_rate;
+    std::ostream * output;
+    boost::filesystem::ofstream file_stream;
+    boost::thread writer_thread;
+    boost::mutex buffers_mutex;
+    std::vector<ThreadBuffer *> thread_buffers;
+    std::string batch;
+    boost::uint64_t written_lines;
+    boost::uint64_t retired_dropped_lines;
+};
+
+#endif /* ASYNC_LOGGER_H_ */
@@ -0,0 +1,329 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef GRAPH_FILE_FORMAT_H_
+#define GRAPH_FILE_FORMAT_H_
+
+#include "OSRMException.h"
+#include "UUID.h"
+#include "../Algorithms/CRC32.h"
+#include "../typedefs.h"
+
+#include <boost/assert.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/static_assert.hpp>
+
+#include <cstring>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Layout of the .osrm file written by the extractor:
+//
+//   GraphFileHeader | UUID | GraphFileSection[number_of_sections] | sections
+//
+// Every section starts at a multiple of GRAPH_FILE_ALIGNMENT and holds a
+// packed array of fixed-size records, so that a reader can map the file and
+// use the records in place. Node records are sorted by their OSM id, edge
+// records refer to their end points by index into the node section.
+
+static const char GRAPH_FILE_MAGIC[4] = { 'O', 'S', 'R', 'M' };
+static const unsigned GRAPH_FILE_VERSION = 1;
+static const boost::uint64_t GRAPH_FILE_ALIGNMENT = 4096;
+
+// The same layout is used for the checkpoints of osrm-prepare, the
+// edge-based graph (.ebg) and snapshots of the contractor (.ctr).
+enum GraphFileSectionID {
+    GRAPH_FILE_NODE_SECTION = 1,
+    GRAPH_FILE_EDGE_SECTION = 2,
+    GRAPH_FILE_CHECKPOINT_INFO_SECTION = 3,
+    GRAPH_FILE_EDGE_BASED_NODE_SECTION = 4,
+    GRAPH_FILE_EDGE_BASED_EDGE_SECTION = 5,
+    GRAPH_FILE_CONTRACTOR_NODE_SECTION = 6,
+    GRAPH_FILE_CONTRACTOR_PRIORITY_SECTION = 7,
+    GRAPH_FILE_CONTRACTOR_DEPTH_SECTION = 8,
+    GRAPH_FILE_CONTRACTOR_NODE_MAP_SECTION = 9,
+    GRAPH_FILE_CONTRACTOR_EDGE_SECTION = 10,
+    GRAPH_FILE_CONTRACTOR_RUN_SECTION = 11,
+    GRAPH_FILE_CONTRACTOR_RUN_DATA_SECTION = 12
+};
+
+struct GraphFileHeader {
+    char magic[4];
+    unsigned version;
+    unsigned number_of_sections;
+    unsigned reserved;
+};
+
+struct GraphFileSection {
+    unsigned id;
+    unsigned record_size;
+    boost::uint64_t offset;
+    boost::uint64_t number_of_records;
+    unsigned crc32;
+    unsigned reserved;
+};
+
+struct GraphFileNodeRecord {
+    int lat;
+    int lon;
+    NodeID id;
+    unsigned char bollard;
+    unsigned char traffic_light;
+    unsigned char padding[2];
+};
+
+struct GraphFileEdgeRecord {
+    NodeID source;
+    NodeID target;
+    int length;
+    int weight;
+    unsigned name_id;
+    short direction; // 0 = open, 1 = forward, 2 = backward
+    short type;
+    bool is_roundabout;
+    bool ignore_in_grid;
+    bool is_access_restricted;
+    bool is_contra_flow;
+};
+
+BOOST_STATIC_ASSERT(sizeof(GraphFileHeader) == 16);
+BOOST_STATIC_ASSERT(sizeof(GraphFileSection) == 32);
+BOOST_STATIC_ASSERT(sizeof(GraphFileNodeRecord) == 16);
+BOOST_STATIC_ASSERT(sizeof(GraphFileEdgeRecord) == 28);
+
+inline boost::uint64_t GraphFileTableOffset() {
+    return sizeof(GraphFileHeader) + sizeof(UUID);
+}
+
+inline boost::uint64_t AlignGraphFileOffset(const boost::uint64_t offset) {
+    return (offset + GRAPH_FILE_ALIGNMENT - 1) / GRAPH_FILE_ALIGNMENT * GRAPH_FILE_ALIGNMENT;
+}
+
+// Writes a sectioned graph file. Records are appended in blocks to the
+// currently open section, which checksums them on the fly. The header and
+// section table are written last, when all offsets and counts are known.
+class GraphFileWriter {
+public:
+    GraphFileWriter(
+        const std::string & file_name,
+        const UUID & uuid,
+        const unsigned number_of_sections
+    ) :
+        uuid(uuid),
+        sections(number_of_sections),
+        current_section(-1),
+        position(0)
+    {
+        memset(&sections[0], 0, number_of_sections*sizeof(GraphFileSection));
+        output_stream.open(file_name.c_str(), std::ios::binary);
+        if(!output_stream) {
+            throw OSRMException("cannot open graph file for writing");
+        }
+        // header and section table are filled in by Close()
+        position = GraphFileTableOffset() + number_of_sections*sizeof(GraphFileSection);
+        std::vector<char> placeholder(position, 0);
+        output_stream.write(&placeholder[0], position);
+    }
+
+    void BeginSection(const unsigned id, const unsigned record_size) {
+        if( (current_section+1) >= static_cast<int>(sections.size()) ) {
+            throw OSRMException("too many sections in graph file");
+        }
+        ++current_section;
+        PadToAlignment();
+        sections[current_section].id = id;
+        sections[current_section].record_size = record_size;
+        sections[current_section].offset = position;
+        crc32.Reset();
+    }
+
+    void WriteRecords(const char * records, const boost::uint64_t number_of_records) {
+        BOOST_ASSERT(0 <= current_section);
+        GraphFileSection & section = sections[current_section];
+        const boost::uint64_t number_of_bytes = number_of_records*section.record_size;
+        if(0 == number_of_bytes) {
+            return;
+        }
+        // CRC32 does not modify its input, but takes a non-const pointer
+        section.crc32 = crc32(
+            const_cast<char *>(records),
+            static_cast<unsigned>(number_of_bytes)
+        );
+        section.number_of_records += number_of_records;
+        output_stream.write(records, number_of_bytes);
+        position += number_of_bytes;
+    }
+
+    void Close() {
+        if( (current_section+1) != static_cast<int>(sections.size()) ) {
+            throw OSRMException("graph file has missing sections");
+        }
+        GraphFileHeader header;
+        memcpy(header.magic, GRAPH_FILE_MAGIC, sizeof(GRAPH_FILE_MAGIC));
+        header.version = GRAPH_FILE_VERSION;
+        header.number_of_sections = sections.size();
+        header.reserved = 0;
+
+        output_stream.seekp(0);
+        output_stream.write((char *)&header, sizeof(GraphFileHeader));
+        output_stream.write((char *)&uuid, sizeof(UUID));
+        output_stream.write(
+            (char *)&sections[0],
+            sections.size()*sizeof(GraphFileSection)
+        );
+        output_stream.close();
+        if(output_stream.fail()) {
+            throw OSRMException("writing graph file failed");
+        }
+    }
+
+    const GraphFileSection & GetSection(const unsigned index) const {
+        return sections[index];
+    }
+
+private:
+    void PadToAlignment() {
+        const boost::uint64_t aligned_position = AlignGraphFileOffset(position);
+        if(aligned_position != position) {
+            std::vector<char> padding(aligned_position - position, 0);
+            output_stream.write(&padding[0], padding.size());
+            position = aligned_position;
+        }
+    }
+
+    const UUID & uuid;
+    std::ofstream output_stream;
+    std::vector<GraphFileSection> sections;
+    int current_section;
+    boost::uint64_t position;
+    CRC32 crc32;
+};
+
+// Checks header, section bounds and checksums of a mapped graph file and
+// returns the section with the given id.
+inline const GraphFileSection & FindGraphFileSection(
+    const char * file_begin,
+    const boost::uint64_t file_size,
+    const unsigned section_id
+) {
+    if(file_size < GraphFileTableOffset()) {
+        throw OSRMException("graph file is truncated");
+    }
+    const GraphFileHeader * header = (const GraphFileHeader *)file_begin;
+    if(0 != memcmp(header->magic, GRAPH_FILE_MAGIC, sizeof(GRAPH_FILE_MAGIC))) {
+        throw OSRMException(".osrm file has an unknown format, rerun the extractor");
+    }
+    if(GRAPH_FILE_VERSION != header->version) {
+        throw OSRMException(".osrm file has an unsupported version, rerun the extractor");
+    }
+    const boost::uint64_t table_end = GraphFileTableOffset() +
+        header->number_of_sections*sizeof(GraphFileSection);
+    if(file_size < table_end) {
+        throw OSRMException("graph file is truncated");
+    }
+    const GraphFileSection * sections =
+        (const GraphFileSection *)(file_begin + GraphFileTableOffset());
+    for(unsigned i = 0; i < header->number_of_sections; ++i) {
+        const GraphFileSection & section = sections[i];
+        if(section_id != section.id) {
+            continue;
+        }
+        const boost::uint64_t section_size = section.number_of_records*section.record_size;
+        if(
+            0 != (section.offset % GRAPH_FILE_ALIGNMENT) ||
+            file_size < section.offset ||
+            file_size - section.offset < section_size
+        ) {
+            throw OSRMException("graph file section exceeds file bounds");
+        }
+        CRC32 crc32;
+        unsigned checksum = 0;
+        const boost::uint64_t chunk_size = 1 << 30;
+        for(boost::uint64_t done = 0; done < section_size; done += chunk_size) {
+            checksum = crc32(
+                const_cast<char *>(file_begin + section.offset + done),
+                static_cast<unsigned>(std::min(chunk_size, section_size - done))
+            );
+        }
+        if(checksum != section.crc32) {
+            throw OSRMException("graph file section is corrupt (crc32 mismatch)");
+        }
+        return section;
+    }
+    throw OSRMException("graph file section is missing");
+}
+
+// Maps a sectioned graph file read-only. Sections are verified on access.
+class GraphFileReader : boost::noncopyable {
+public:
+    explicit GraphFileReader(const std::string & file_name) :
+        graph_file(file_name.c_str(), boost::interprocess::read_only),
+        graph_region(graph_file, boost::interprocess::read_only),
+        file_begin((const char *)graph_region.get_address()),
+        file_size(graph_region.get_size())
+    {
+        if(file_size < GraphFileTableOffset()) {
+            throw OSRMException("graph file is truncated");
+        }
+    }
+
+    const UUID & GetUUID() const {
+        return *(const UUID *)(file_begin + sizeof(GraphFileHeader));
+    }
+
+    template<typename RecordT>
+    const RecordT * GetRecords(
+        const unsigned section_id,
+        boost::uint64_t & number_of_records
+    ) const {
+        const GraphFileSection & section = FindGraphFileSection(
+            file_begin,
+            file_size,
+            section_id
+        );
+        if(sizeof(RecordT) != section.record_size) {
+            throw OSRMException("graph file has unexpected record sizes");
+        }
+        number_of_records = section.number_of_records;
+        return (const RecordT *)(file_begin + section.offset);
+    }
+
+private:
+    boost::interprocess::file_mapping graph_file;
+    boost::interprocess::mapped_region graph_region;
+    const char * file_begin;
+    const boost::uint64_t file_size;
+};
+
+#endif /* GRAPH_FILE_FORMAT_H_ */
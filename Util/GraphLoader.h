@@ -28,6 +28,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef GRAPHLOADER_H
 #define GRAPHLOADER_H
 
+#include "GraphFileFormat.h"
 #include "OSRMException.h"
 #include "../DataStructures/ImportNode.h"
 #include "../DataStructures/ImportEdge.h"
@@ -40,6 +41,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/assert.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/unordered_map.hpp>
 
 #include <cassert>
@@ -60,40 +63,94 @@ struct _ExcessRemover {
     }
 };
 
+inline bool GraphFileNodeRecordIDLess(const GraphFileNodeRecord & node, const NodeID id) {
+    return node.id < id;
+}
+
+// Translates an external node id into its rank among the sorted node records
+inline bool LookupInternalNodeID(
+    const GraphFileNodeRecord * nodes_begin,
+    const GraphFileNodeRecord * nodes_end,
+    NodeID & id
+) {
+    const GraphFileNodeRecord * position = std::lower_bound(
+        nodes_begin,
+        nodes_end,
+        id,
+        GraphFileNodeRecordIDLess
+    );
+    if(position == nodes_end || position->id != id) {
+        return false;
+    }
+    id = position - nodes_begin;
+    return true;
+}
+
 template<typename EdgeT>
-NodeID readBinaryOSRMGraphFromStream(
-    std::istream &in,
+NodeID readBinaryOSRMGraphFromFile(
+    const std::string & file_name,
     std::vector<EdgeT>& edgeList,
     std::vector<NodeID> &bollardNodes,
     std::vector<NodeID> &trafficLightNodes,
     std::vector<NodeInfo> * int2ExtNodeMap,
     std::vector<TurnRestriction> & inputRestrictions
 ) {
-    const UUID uuid_orig;
-    UUID uuid_loaded;
-    in.read((char *) &uuid_loaded, sizeof(UUID));
+    boost::interprocess::file_mapping graph_file(
+        file_name.c_str(),
+        boost::interprocess::read_only
+    );
+    boost::interprocess::mapped_region graph_region(
+        graph_file,
+        boost::interprocess::read_only
+    );
+    const char * file_begin = (const char *)graph_region.get_address();
+    const boost::uint64_t file_size = graph_region.get_size();
 
-    if( !uuid_loaded.TestGraphUtil(uuid_orig) ) {
+    const GraphFileSection & node_section = FindGraphFileSection(
+        file_begin,
+        file_size,
+        GRAPH_FILE_NODE_SECTION
+    );
+    const GraphFileSection & edge_section = FindGraphFileSection(
+        file_begin,
+        file_size,
+        GRAPH_FILE_EDGE_SECTION
+    );
+    if(
+        sizeof(GraphFileNodeRecord) != node_section.record_size ||
+        sizeof(GraphFileEdgeRecord) != edge_section.record_size
+    ) {
+        throw OSRMException(".osrm file has unexpected record sizes");
+    }
+
+    const UUID uuid_orig;
+    const UUID * uuid_loaded = (const UUID *)(file_begin + sizeof(GraphFileHeader));
+    if( !uuid_loaded->TestGraphUtil(uuid_orig) ) {
         SimpleLogger().Write(logWARNING) <<
             ".osrm was prepared with different build."
             "Reprocess to get rid of this warning.";
     }
 
-    NodeID n, source, target;
-    EdgeID m;
-    short dir;// direction (0 = open, 1 = forward, 2+ = open)
-    ExternalNodeMap ext_to_int_id_map;
-    in.read((char*)&n, sizeof(NodeID));
+    const NodeID n = node_section.number_of_records;
+    const EdgeID m = edge_section.number_of_records;
+    const GraphFileNodeRecord * nodes_begin =
+        (const GraphFileNodeRecord *)(file_begin + node_section.offset);
+    const GraphFileNodeRecord * nodes_end = nodes_begin + n;
+    const GraphFileEdgeRecord * edges_begin =
+        (const GraphFileEdgeRecord *)(file_begin + edge_section.offset);
+
     SimpleLogger().Write() << "Importing n = " << n << " nodes ";
-    _Node node;
+    int2ExtNodeMap->reserve(n);
     for (NodeID i=0; i<n; ++i) {
-        in.read((char*)&node, sizeof(_Node));
+        const GraphFileNodeRecord & node = nodes_begin[i];
+        if(0 < i && node.id <= nodes_begin[i-1].id) {
+            throw OSRMException(".osrm nodes are not sorted by id");
+        }
         int2ExtNodeMap->push_back(NodeInfo(node.lat, node.lon, node.id));
-        ext_to_int_id_map.emplace(node.id, i);
         if(node.bollard) {
         	bollardNodes.push_back(i);
         }
-        if(node.trafficLight) {
+        if(node.traffic_light) {
         	trafficLightNodes.push_back(i);
         }
     }
@@ -102,54 +159,37 @@ NodeID readBinaryOSRMGraphFromStream(
     std::vector<NodeID>(bollardNodes).swap(bollardNodes);
     std::vector<NodeID>(trafficLightNodes).swap(trafficLightNodes);
 
-    in.read((char*)&m, sizeof(unsigned));
     SimpleLogger().Write() << " and " << m << " edges ";
-    // for(unsigned i = 0; i < inputRestrictions.size(); ++i) {
+    //restrictions with a node that is not in the graph keep external ids, drop them
+    std::vector<TurnRestriction>::iterator restrictions_out = inputRestrictions.begin();
     BOOST_FOREACH(TurnRestriction & current_restriction, inputRestrictions) {
-        ExternalNodeMap::iterator intNodeID = ext_to_int_id_map.find(current_restriction.fromNode);
-        if( intNodeID == ext_to_int_id_map.end()) {
+        if(!LookupInternalNodeID(nodes_begin, nodes_end, current_restriction.fromNode)) {
             SimpleLogger().Write(logDEBUG) << "Unmapped from Node of restriction";
             continue;
-
         }
-        current_restriction.fromNode = intNodeID->second;
-
-        intNodeID = ext_to_int_id_map.find(current_restriction.viaNode);
-        if( intNodeID == ext_to_int_id_map.end()) {
+        if(!LookupInternalNodeID(nodes_begin, nodes_end, current_restriction.viaNode)) {
             SimpleLogger().Write(logDEBUG) << "Unmapped via node of restriction";
             continue;
         }
-        current_restriction.viaNode = intNodeID->second;
-
-        intNodeID = ext_to_int_id_map.find(current_restriction.toNode);
-        if( intNodeID == ext_to_int_id_map.end()) {
+        if(!LookupInternalNodeID(nodes_begin, nodes_end, current_restriction.toNode)) {
             SimpleLogger().Write(logDEBUG) << "Unmapped to node of restriction";
             continue;
         }
-        current_restriction.toNode = intNodeID->second;
+        *restrictions_out = current_restriction;
+        ++restrictions_out;
     }
+    inputRestrictions.erase(restrictions_out, inputRestrictions.end());
 
     edgeList.reserve(m);
-    EdgeWeight weight;
-    short type;
-    NodeID nameID;
-    int length;
-    bool isRoundabout, ignoreInGrid, isAccessRestricted, isContraFlow;
-
     for (EdgeID i=0; i<m; ++i) {
-        in.read((char*)&source,             sizeof(unsigned));
-        in.read((char*)&target,             sizeof(unsigned));
-        in.read((char*)&length,             sizeof(int));
-        in.read((char*)&dir,                sizeof(short));
-        in.read((char*)&weight,             sizeof(int));
-        in.read((char*)&type,               sizeof(short));
-        in.read((char*)&nameID,             sizeof(unsigned));
-        in.read((char*)&isRoundabout,       sizeof(bool));
-        in.read((char*)&ignoreInGrid,       sizeof(bool));
-        in.read((char*)&isAccessRestricted, sizeof(bool));
-        in.read((char*)&isContraFlow,       sizeof(bool));
-
-        BOOST_ASSERT_MSG(length > 0, "loaded null length edge" );
+        const GraphFileEdgeRecord & edge = edges_begin[i];
+        NodeID source = edge.source;
+        NodeID target = edge.target;
+        const short dir = edge.direction;
+        const EdgeWeight weight = edge.weight;
+        const short type = edge.type;
+
+        BOOST_ASSERT_MSG(edge.length > 0, "loaded null length edge" );
         BOOST_ASSERT_MSG(weight > 0, "loaded null weight");
         BOOST_ASSERT_MSG(0<=dir && dir<=2, "loaded bogus direction");
 
@@ -160,35 +200,29 @@ NodeID readBinaryOSRMGraphFromStream(
 
         assert(type >= 0);
 
-        //         translate the external NodeIDs to internal IDs
-        ExternalNodeMap::iterator intNodeID = ext_to_int_id_map.find(source);
-        if( ext_to_int_id_map.find(source) == ext_to_int_id_map.end()) {
-#ifndef NDEBUG
-            SimpleLogger().Write(logWARNING) <<
-                " unresolved source NodeID: " << source;
-#endif
-            continue;
+        // end points are already stored as internal node ids
+        if(source >= n || target >= n) {
+            throw OSRMException(".osrm edge refers to a nonexisting node");
         }
-        source = intNodeID->second;
-        intNodeID = ext_to_int_id_map.find(target);
-        if(ext_to_int_id_map.find(target) == ext_to_int_id_map.end()) {
-#ifndef NDEBUG
-            SimpleLogger().Write(logWARNING) <<
-            "unresolved target NodeID : " << target;
-#endif
-            continue;
-        }
-        target = intNodeID->second;
-        BOOST_ASSERT_MSG(source != UINT_MAX && target != UINT_MAX,
-            "nonexisting source or target"
-        );
 
         if(source > target) {
             std::swap(source, target);
             std::swap(forward, backward);
         }
 
-        EdgeT inputEdge(source, target, nameID, weight, forward, backward, type, isRoundabout, ignoreInGrid, isAccessRestricted, isContraFlow );
+        EdgeT inputEdge(
+            source,
+            target,
+            edge.name_id,
+            weight,
+            forward,
+            backward,
+            type,
+            edge.is_roundabout,
+            edge.ignore_in_grid,
+            edge.is_access_restricted,
+            edge.is_contra_flow
+        );
         edgeList.push_back(inputEdge);
     }
     std::sort(edgeList.begin(), edgeList.end());
@@ -223,7 +257,6 @@ NodeID readBinaryOSRMGraphFromStream(
         }
     }
     typename std::vector<EdgeT>::iterator newEnd = std::remove_if(edgeList.begin(), edgeList.end(), _ExcessRemover<EdgeT>());
-    ext_to_int_id_map.clear();
     std::vector<EdgeT>(edgeList.begin(), newEnd).swap(edgeList); //remove excess candidates.
     SimpleLogger().Write() << "Graph loaded ok and has " << edgeList.size() << " edges";
     return n;
@@ -35,9 +35,11 @@ extern "C" {
 }
 
 #include <boost/filesystem/convenience.hpp>
+#include <boost/noncopyable.hpp>
 #include <luabind/luabind.hpp>
 #include <iostream>
 #include <string>
+#include <vector>
 
 template<typename T>
 void LUA_print(T number) {
@@ -61,4 +63,21 @@ inline void luaAddScriptFolderToLoadPath(lua_State* myLuaState, const char* file
     luaL_dostring( myLuaState, luaCode.c_str() );
 }
 
+// Closes all lua states of a list when it goes out of scope
+class LuaStateListCloser : boost::noncopyable {
+public:
+    explicit LuaStateListCloser(std::vector<lua_State*> & lua_state_list) :
+        lua_state_list(lua_state_list) { }
+
+    ~LuaStateListCloser() {
+        for(unsigned i = 0; i < lua_state_list.size(); ++i) {
+            lua_close(lua_state_list[i]);
+        }
+        lua_state_list.clear();
+    }
+
+private:
+    std::vector<lua_State*> & lua_state_list;
+};
+
 #endif /* LUAUTIL_H_ */
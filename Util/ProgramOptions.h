@@ -96,7 +96,11 @@ inline bool GenerateServerProgramOptions(
     ServerPaths & paths,
     std::string & ip_address,
     int & ip_port,
-    int & requested_num_threads
+    int & requested_num_threads,
+    int & compression_level,
+    int & compression_threshold,
+    int & access_log_sampling,
+    int & route_cache_size
 ) {
 
     // declare a group of options that will be allowed only on command line
@@ -112,6 +116,11 @@ inline bool GenerateServerProgramOptions(
             "Path to a configuration file"
         );
 
+    // the path validator insists on existing files, the log may not exist yet
+    std::string access_log_path;
+    // neither may the traffic feed
+    std::string traffic_feed_path;
+
     // declare a group of options that will be allowed both on command line
     // as well as in a config file
     boost::program_options::options_description config_options("Configuration");
@@ -160,6 +169,41 @@ inline bool GenerateServerProgramOptions(
             "threads,t",
             boost::program_options::value<int>(&requested_num_threads)->default_value(8),
             "Number of threads to use"
+        )
+        (
+            "compression-level",
+            boost::program_options::value<int>(&compression_level)->default_value(1),
+            "zlib level (0-9) for compressed responses"
+        )
+        (
+            "compression-threshold",
+            boost::program_options::value<int>(&compression_threshold)->default_value(0),
+            "Send responses smaller than this many bytes uncompressed"
+        )
+        (
+            "access-log",
+            boost::program_options::value<std::string>(&access_log_path),
+            "Append the access log to this file instead of stdout"
+        )
+        (
+            "access-log-sampling",
+            boost::program_options::value<int>(&access_log_sampling)->default_value(1),
+            "Log only every n-th request per thread, 0 disables the access log"
+        )
+        (
+            "route-cache-size",
+            boost::program_options::value<int>(&route_cache_size)->default_value(0),
+            "Memory budget in MB for cached route responses, 0 disables the cache"
+        )
+        (
+            "traffic-feed",
+            boost::program_options::value<std::string>(&traffic_feed_path),
+            "Speed factors per edge (.csv or binary), reloaded when the file changes"
+        )
+        (
+            "mlddata",
+            boost::program_options::value<boost::filesystem::path>(&paths["mlddata"]),
+            ".mld file, answers route queries on the multi-level graph, without alternatives"
         );
 
     // hidden options, will be allowed both on command line and in config
@@ -223,6 +267,14 @@ inline bool GenerateServerProgramOptions(
         boost::program_options::notify(option_variables);
     }
 
+    if(!access_log_path.empty()) {
+        paths["accesslog"] = access_log_path;
+    }
+
+    if(!traffic_feed_path.empty()) {
+        paths["trafficdata"] = traffic_feed_path;
+    }
+
     if(!option_variables.count("hsgrdata")) {
         if(!option_variables.count("base")) {
             throw OSRMException("hsgrdata (or base) must be specified");
@@ -275,6 +327,18 @@ inline bool GenerateServerProgramOptions(
     if(1 > requested_num_threads) {
         throw OSRMException("Number of threads must be a positive number");
     }
+    if(0 > compression_level || 9 < compression_level) {
+        throw OSRMException("Compression level must be between 0 and 9");
+    }
+    if(0 > compression_threshold) {
+        throw OSRMException("Compression threshold must not be negative");
+    }
+    if(0 > access_log_sampling) {
+        throw OSRMException("Access log sampling must not be negative");
+    }
+    if(0 > route_cache_size) {
+        throw OSRMException("Route cache size must not be negative");
+    }
     return true;
 }
 
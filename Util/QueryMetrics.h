@@ -0,0 +1,579 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef QUERY_METRICS_H_
+#define QUERY_METRICS_H_
+
+#include "TimingUtil.h"
+
+#include <boost/assert.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/foreach.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+
+#include <cstring>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Stages a query passes through. Time spent in a nested stage (e.g. path
+// unpacking inside the search) is only charged to the innermost stage.
+enum QueryStage {
+    QUERY_STAGE_PARSING = 0,
+    QUERY_STAGE_SNAPPING,
+    QUERY_STAGE_SEARCH,
+    QUERY_STAGE_UNPACKING,
+    QUERY_STAGE_DESCRIPTION,
+    QUERY_STAGE_COMPRESSION,
+    NUMBER_OF_QUERY_STAGES
+};
+
+enum QueryCounter {
+    QUERY_COUNTER_FORWARD_SETTLED_NODES = 0,
+    QUERY_COUNTER_REVERSE_SETTLED_NODES,
+    QUERY_COUNTER_HEAP_NODES,
+    QUERY_COUNTER_UNPACKED_EDGES,
+    QUERY_COUNTER_VIA_NODE_TESTS,
+    QUERY_COUNTER_RTREE_NODES,
+    QUERY_COUNTER_RTREE_LEAVES,
+    NUMBER_OF_QUERY_COUNTERS
+};
+
+static const char * query_stage_names[NUMBER_OF_QUERY_STAGES] = {
+    "parsing", "snapping", "search", "unpacking", "description", "compression"
+};
+
+// Log-linear histogram of microsecond latencies in the spirit of HdrHistogram.
+// Every power of two is split into 16 linear sub-buckets, which bounds the
+// relative error of any recorded value by 1/16. Values of 2^32us and more end
+// up in the last bucket. Not synchronized, owners serialize access.
+class LatencyHistogram : private boost::noncopyable {
+public:
+    static const unsigned SUB_BUCKET_BITS = 4;
+    static const unsigned SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static const unsigned MAXIMUM_EXPONENT = 32;
+    static const unsigned NUMBER_OF_BUCKETS = SUB_BUCKET_COUNT*(MAXIMUM_EXPONENT-SUB_BUCKET_BITS+1);
+
+    LatencyHistogram() : count(0), sum(0) {
+        std::fill(buckets, buckets+NUMBER_OF_BUCKETS, 0);
+    }
+
+    static unsigned GetBucketIndex(const boost::uint64_t value) {
+        if(value < SUB_BUCKET_COUNT) {
+            return value;
+        }
+        unsigned exponent = SUB_BUCKET_BITS;
+        while(value >> (exponent+1)) {
+            ++exponent;
+        }
+        if(exponent >= MAXIMUM_EXPONENT) {
+            return NUMBER_OF_BUCKETS-1;
+        }
+        const unsigned sub_bucket = (value >> (exponent-SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT-1);
+        return SUB_BUCKET_COUNT*(exponent-SUB_BUCKET_BITS+1) + sub_bucket;
+    }
+
+    // smallest value that does not fall into the bucket anymore
+    static boost::uint64_t GetBucketUpperBound(const unsigned index) {
+        if(index < SUB_BUCKET_COUNT) {
+            return index+1;
+        }
+        const unsigned shift = index/SUB_BUCKET_COUNT - 1;
+        const boost::uint64_t sub_bucket = index%SUB_BUCKET_COUNT;
+        return (SUB_BUCKET_COUNT + sub_bucket + 1) << shift;
+    }
+
+    void Record(const boost::uint64_t microseconds) {
+        ++buckets[GetBucketIndex(microseconds)];
+        ++count;
+        sum += microseconds;
+    }
+
+    void Merge(const LatencyHistogram & other) {
+        for(unsigned i = 0; i < NUMBER_OF_BUCKETS; ++i) {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        sum += other.sum;
+    }
+
+    boost::uint64_t GetBucketCount(const unsigned index) const {
+        return buckets[index];
+    }
+
+    boost::uint64_t GetCount() const {
+        return count;
+    }
+
+    boost::uint64_t GetSum() const {
+        return sum;
+    }
+
+    // number of recorded values that are guaranteed to be <= limit
+    boost::uint64_t GetCountAtOrBelow(const boost::uint64_t limit) const {
+        boost::uint64_t result = 0;
+        for(unsigned i = 0; i < NUMBER_OF_BUCKETS && GetBucketUpperBound(i) <= limit+1; ++i) {
+            result += GetBucketCount(i);
+        }
+        return result;
+    }
+
+    // highest value equivalent to the one at the given quantile
+    boost::uint64_t GetValueAtQuantile(const double quantile) const {
+        const boost::uint64_t total = GetCount();
+        if(0 == total) {
+            return 0;
+        }
+        const boost::uint64_t rank = std::max(boost::uint64_t(1), boost::uint64_t(quantile*total + 0.5));
+        boost::uint64_t seen = 0;
+        for(unsigned i = 0; i < NUMBER_OF_BUCKETS; ++i) {
+            seen += GetBucketCount(i);
+            if(seen >= rank) {
+                return GetBucketUpperBound(i)-1;
+            }
+        }
+        return GetBucketUpperBound(NUMBER_OF_BUCKETS-1)-1;
+    }
+
+private:
+    boost::uint64_t buckets[NUMBER_OF_BUCKETS];
+    boost::uint64_t count;
+    boost::uint64_t sum;
+};
+
+// Accumulates the statistics of the request currently handled by a thread.
+struct QueryStatistics {
+    QueryStatistics() : is_active(false) { }
+
+    void Begin(const boost::uint64_t now) {
+        is_active = true;
+        plugin = 0;
+        current_stage = -1;
+        request_start = stage_start = now;
+        std::fill(stage_microseconds, stage_microseconds+NUMBER_OF_QUERY_STAGES, 0);
+        std::fill(stage_was_entered, stage_was_entered+NUMBER_OF_QUERY_STAGES, false);
+        std::fill(counters, counters+NUMBER_OF_QUERY_COUNTERS, 0);
+        heap_peak[0] = heap_peak[1] = 0;
+    }
+
+    // charges the elapsed time to the current stage and switches stages
+    int SwitchStage(const int stage, const boost::uint64_t now) {
+        if(0 <= current_stage) {
+            stage_microseconds[current_stage] += now - stage_start;
+        }
+        const int previous_stage = current_stage;
+        current_stage = stage;
+        stage_start = now;
+        if(0 <= stage) {
+            stage_was_entered[stage] = true;
+        }
+        return previous_stage;
+    }
+
+    bool is_active;
+    unsigned plugin;
+    int current_stage;
+    boost::uint64_t request_start;
+    boost::uint64_t stage_start;
+    boost::uint64_t stage_microseconds[NUMBER_OF_QUERY_STAGES];
+    bool stage_was_entered[NUMBER_OF_QUERY_STAGES];
+    boost::uint64_t counters[NUMBER_OF_QUERY_COUNTERS];
+    // largest forward and reverse heap of any search, only used for traces
+    unsigned heap_peak[2];
+};
+
+// Process-wide query metrics. Each thread records into its own histograms and
+// counters once per request. Their mutex is only ever contended while the
+// metrics are scraped, which sums up all threads.
+class QueryMetrics : private boost::noncopyable {
+public:
+    // plugin id 0 collects requests that never reached a plugin
+    static const unsigned MAX_QUERY_PLUGINS = 16;
+
+    static void RegisterPlugin(const std::string & name) {
+        Registry & registry = GetRegistry();
+        boost::mutex::scoped_lock lock(registry.mutex);
+        if(
+            registry.plugin_names.size()+1 < MAX_QUERY_PLUGINS &&
+            registry.plugin_names.end() == std::find(
+                registry.plugin_names.begin(),
+                registry.plugin_names.end(),
+                name
+            )
+        ) {
+            registry.plugin_names.push_back(name);
+        }
+    }
+
+    static void BeginRequest() {
+        GetThreadState().statistics.Begin(get_monotonic_microseconds());
+    }
+
+    static void SetPlugin(const std::string & name) {
+        QueryStatistics & statistics = GetThreadState().statistics;
+        if(!statistics.is_active) {
+            return;
+        }
+        Registry & registry = GetRegistry();
+        boost::mutex::scoped_lock lock(registry.mutex);
+        const std::vector<std::string>::const_iterator iter = std::find(
+            registry.plugin_names.begin(),
+            registry.plugin_names.end(),
+            name
+        );
+        statistics.plugin = (registry.plugin_names.end() == iter) ? 0 : (1 + iter - registry.plugin_names.begin());
+    }
+
+    static void AddToCounter(const QueryCounter counter, const boost::uint64_t value) {
+        QueryStatistics & statistics = GetThreadState().statistics;
+        statistics.counters[counter] += value;
+    }
+
+    static void AddSearchStatistics(
+        const bool forward_direction,
+        const unsigned settled_nodes,
+        const unsigned inserted_nodes,
+        const unsigned heap_peak
+    ) {
+        QueryStatistics & statistics = GetThreadState().statistics;
+        statistics.counters[
+            forward_direction ? QUERY_COUNTER_FORWARD_SETTLED_NODES : QUERY_COUNTER_REVERSE_SETTLED_NODES
+        ] += settled_nodes;
+        statistics.counters[QUERY_COUNTER_HEAP_NODES] += inserted_nodes;
+        unsigned & peak = statistics.heap_peak[forward_direction ? 0 : 1];
+        peak = std::max(peak, heap_peak);
+    }
+
+    // Appends the statistics of the running request as a JSON object. Stage
+    // times only cover the request up to now, i.e. never compression.
+    static void AppendTraceAsJSON(std::string & output) {
+        const QueryStatistics & statistics = GetThreadState().statistics;
+        const boost::uint64_t now = get_monotonic_microseconds();
+        std::ostringstream out;
+        out << "{\"total_us\":" << (statistics.is_active ? now - statistics.request_start : 0);
+        out << ",\"stages_us\":{";
+        bool is_first_stage = true;
+        for(unsigned i = 0; i < NUMBER_OF_QUERY_STAGES; ++i) {
+            if(!statistics.is_active || !statistics.stage_was_entered[i]) {
+                continue;
+            }
+            boost::uint64_t microseconds = statistics.stage_microseconds[i];
+            if(int(i) == statistics.current_stage) {
+                microseconds += now - statistics.stage_start;
+            }
+            out << (is_first_stage ? "" : ",") << "\"" << query_stage_names[i] << "\":" << microseconds;
+            is_first_stage = false;
+        }
+        out << "}";
+        const boost::uint64_t * counters = statistics.counters;
+        out << ",\"settled_nodes\":{\"forward\":" << counters[QUERY_COUNTER_FORWARD_SETTLED_NODES] <<
+            ",\"reverse\":" << counters[QUERY_COUNTER_REVERSE_SETTLED_NODES] << "}";
+        out << ",\"heap_peak\":{\"forward\":" << statistics.heap_peak[0] <<
+            ",\"reverse\":" << statistics.heap_peak[1] << "}";
+        out << ",\"heap_nodes\":" << counters[QUERY_COUNTER_HEAP_NODES];
+        out << ",\"unpacked_edges\":" << counters[QUERY_COUNTER_UNPACKED_EDGES];
+        out << ",\"via_node_tests\":" << counters[QUERY_COUNTER_VIA_NODE_TESTS];
+        out << ",\"rtree\":{\"nodes_explored\":" << counters[QUERY_COUNTER_RTREE_NODES] <<
+            ",\"leaves_loaded\":" << counters[QUERY_COUNTER_RTREE_LEAVES] << "}";
+        out << "}";
+        output += out.str();
+    }
+
+    // Returns the statistics of the running request or NULL if there is none.
+    static QueryStatistics * GetCurrentStatistics() {
+        QueryStatistics & statistics = GetThreadState().statistics;
+        return statistics.is_active ? &statistics : NULL;
+    }
+
+    static void EndRequest() {
+        ThreadState & state = GetThreadState();
+        QueryStatistics & statistics = state.statistics;
+        if(!statistics.is_active) {
+            return;
+        }
+        const boost::uint64_t now = get_monotonic_microseconds();
+        statistics.SwitchStage(-1, now);
+        statistics.is_active = false;
+
+        boost::mutex::scoped_lock lock(state.mutex);
+        PluginMetrics & metrics = state.plugins[statistics.plugin];
+        for(unsigned i = 0; i < NUMBER_OF_QUERY_STAGES; ++i) {
+            if(statistics.stage_was_entered[i]) {
+                metrics.stage_durations[i].Record(statistics.stage_microseconds[i]);
+            }
+        }
+        metrics.request_duration.Record(now - statistics.request_start);
+        for(unsigned i = 0; i < NUMBER_OF_QUERY_COUNTERS; ++i) {
+            metrics.counters[i] += statistics.counters[i];
+        }
+    }
+
+    // Appends all metrics in the Prometheus text exposition format (0.0.4).
+    static void WritePrometheus(std::string & output) {
+        Registry & registry = GetRegistry();
+        boost::mutex::scoped_lock lock(registry.mutex);
+        std::vector<PluginMetrics *> totals(registry.plugin_names.size()+1);
+        for(unsigned plugin = 0; plugin < totals.size(); ++plugin) {
+            totals[plugin] = new PluginMetrics();
+            totals[plugin]->Merge(registry.retired.plugins[plugin]);
+        }
+        BOOST_FOREACH(ThreadState * state, registry.live_states) {
+            boost::mutex::scoped_lock state_lock(state->mutex);
+            for(unsigned plugin = 0; plugin < totals.size(); ++plugin) {
+                totals[plugin]->Merge(state->plugins[plugin]);
+            }
+        }
+
+        std::ostringstream out;
+        out << std::setprecision(12);
+        out << "# HELP osrm_request_duration_seconds Time from receiving a request until its response is ready.\n";
+        out << "# TYPE osrm_request_duration_seconds summary\n";
+        const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+        for(unsigned plugin = 0; plugin < totals.size(); ++plugin) {
+            const LatencyHistogram & histogram = totals[plugin]->request_duration;
+            if(0 == histogram.GetCount()) {
+                continue;
+            }
+            const std::string label = "plugin=\"" + GetPluginName(registry, plugin) + "\"";
+            for(unsigned i = 0; i < sizeof(quantiles)/sizeof(quantiles[0]); ++i) {
+                out << "osrm_request_duration_seconds{" << label << ",quantile=\"" << quantiles[i] << "\"} " <<
+                    histogram.GetValueAtQuantile(quantiles[i])/1000000. << "\n";
+            }
+            out << "osrm_request_duration_seconds_sum{" << label << "} " << histogram.GetSum()/1000000. << "\n";
+            out << "osrm_request_duration_seconds_count{" << label << "} " << histogram.GetCount() << "\n";
+        }
+
+        // bucket boundaries are only as exact as the underlying histogram
+        const double limits[] = {
+            0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10
+        };
+        out << "# HELP osrm_stage_duration_seconds Time spent in each stage of a request.\n";
+        out << "# TYPE osrm_stage_duration_seconds histogram\n";
+        for(unsigned plugin = 0; plugin < totals.size(); ++plugin) {
+            for(unsigned stage = 0; stage < NUMBER_OF_QUERY_STAGES; ++stage) {
+                const LatencyHistogram & histogram = totals[plugin]->stage_durations[stage];
+                if(0 == histogram.GetCount()) {
+                    continue;
+                }
+                const std::string label =
+                    "plugin=\"" + GetPluginName(registry, plugin) + "\",stage=\"" + query_stage_names[stage] + "\"";
+                for(unsigned i = 0; i < sizeof(limits)/sizeof(limits[0]); ++i) {
+                    out << "osrm_stage_duration_seconds_bucket{" << label << ",le=\"" << limits[i] << "\"} " <<
+                        histogram.GetCountAtOrBelow(boost::uint64_t(limits[i]*1000000. + 0.5)) << "\n";
+                }
+                out << "osrm_stage_duration_seconds_bucket{" << label << ",le=\"+Inf\"} " << histogram.GetCount() << "\n";
+                out << "osrm_stage_duration_seconds_sum{" << label << "} " << histogram.GetSum()/1000000. << "\n";
+                out << "osrm_stage_duration_seconds_count{" << label << "} " << histogram.GetCount() << "\n";
+            }
+        }
+
+        // counters sharing a name are written as one metric with extra labels
+        const char * counter_names[NUMBER_OF_QUERY_COUNTERS] = {
+            "osrm_settled_nodes_total",
+            "osrm_settled_nodes_total",
+            "osrm_heap_nodes_total",
+            "osrm_unpacked_edges_total",
+            "osrm_via_node_tests_total",
+            "osrm_rtree_nodes_explored_total",
+            "osrm_rtree_leaves_loaded_total"
+        };
+        const char * counter_labels[NUMBER_OF_QUERY_COUNTERS] = {
+            ",direction=\"forward\"", ",direction=\"reverse\"", "", "", "", "", ""
+        };
+        const char * counter_descriptions[NUMBER_OF_QUERY_COUNTERS] = {
+            "Nodes settled by all shortest path searches.",
+            "",
+            "Nodes inserted into the search heaps.",
+            "Edges of unpacked shortcut paths.",
+            "Via node candidates that had to pass a T-test.",
+            "R-tree nodes visited while snapping coordinates.",
+            "R-tree leaves read from disk while snapping coordinates."
+        };
+        for(unsigned counter = 0; counter < NUMBER_OF_QUERY_COUNTERS; ++counter) {
+            if(0 == counter || 0 != std::strcmp(counter_names[counter-1], counter_names[counter])) {
+                out << "# HELP " << counter_names[counter] << " " << counter_descriptions[counter] << "\n";
+                out << "# TYPE " << counter_names[counter] << " counter\n";
+            }
+            for(unsigned plugin = 0; plugin < totals.size(); ++plugin) {
+                if(0 == totals[plugin]->request_duration.GetCount()) {
+                    continue;
+                }
+                out << counter_names[counter] << "{plugin=\"" << GetPluginName(registry, plugin) << "\"" <<
+                    counter_labels[counter] << "} " << totals[plugin]->counters[counter] << "\n";
+            }
+        }
+
+        BOOST_FOREACH(PluginMetrics * metrics, totals) {
+            delete metrics;
+        }
+        output += out.str();
+    }
+
+private:
+    struct PluginMetrics : private boost::noncopyable {
+        PluginMetrics() {
+            std::fill(counters, counters+NUMBER_OF_QUERY_COUNTERS, 0);
+        }
+
+        void Merge(const PluginMetrics & other) {
+            request_duration.Merge(other.request_duration);
+            for(unsigned i = 0; i < NUMBER_OF_QUERY_STAGES; ++i) {
+                stage_durations[i].Merge(other.stage_durations[i]);
+            }
+            for(unsigned i = 0; i < NUMBER_OF_QUERY_COUNTERS; ++i) {
+                counters[i] += other.counters[i];
+            }
+        }
+
+        LatencyHistogram request_duration;
+        LatencyHistogram stage_durations[NUMBER_OF_QUERY_STAGES];
+        boost::uint64_t counters[NUMBER_OF_QUERY_COUNTERS];
+    };
+
+    struct ThreadState : private boost::noncopyable {
+        // guards plugins, statistics are private to the owning thread
+        boost::mutex mutex;
+        QueryStatistics statistics;
+        PluginMetrics plugins[MAX_QUERY_PLUGINS];
+    };
+
+    struct Registry {
+        boost::mutex mutex;
+        std::vector<std::string> plugin_names;
+        std::vector<ThreadState *> live_states;
+        // metrics of threads that have already terminated
+        ThreadState retired;
+    };
+
+    static Registry & GetRegistry() {
+        // never destroyed, threads may still retire during static destruction
+        static Registry * registry = new Registry();
+        return *registry;
+    }
+
+    static const std::string GetPluginName(const Registry & registry, const unsigned plugin) {
+        return (0 == plugin) ? std::string("unknown") : registry.plugin_names[plugin-1];
+    }
+
+    static void RetireThreadState(ThreadState * state) {
+        Registry & registry = GetRegistry();
+        boost::mutex::scoped_lock lock(registry.mutex);
+        for(unsigned i = 0; i < MAX_QUERY_PLUGINS; ++i) {
+            registry.retired.plugins[i].Merge(state->plugins[i]);
+        }
+        registry.live_states.erase(
+            std::remove(registry.live_states.begin(), registry.live_states.end(), state),
+            registry.live_states.end()
+        );
+        delete state;
+    }
+
+    static ThreadState & GetThreadState() {
+        static boost::thread_specific_ptr<ThreadState> thread_local_state(RetireThreadState);
+        if(!thread_local_state.get()) {
+            ThreadState * state = new ThreadState();
+            Registry & registry = GetRegistry();
+            boost::mutex::scoped_lock lock(registry.mutex);
+            registry.live_states.push_back(state);
+            thread_local_state.reset(state);
+        }
+        return *thread_local_state;
+    }
+};
+
+// Charges the time until it goes out of scope to a query stage and restores
+// the enclosing stage afterwards. Does nothing outside of a request.
+class QueryStageTimer : private boost::noncopyable {
+public:
+    explicit QueryStageTimer(const QueryStage stage) :
+        statistics(QueryMetrics::GetCurrentStatistics()),
+        previous_stage(-1)
+    {
+        if(statistics) {
+            previous_stage = statistics->SwitchStage(stage, get_monotonic_microseconds());
+        }
+    }
+
+    ~QueryStageTimer() {
+        Stop();
+    }
+
+    // ends the stage before the timer goes out of scope
+    void Stop() {
+        if(statistics) {
+            statistics->SwitchStage(previous_stage, get_monotonic_microseconds());
+            statistics = NULL;
+        }
+    }
+
+private:
+    QueryStatistics * statistics;
+    int previous_stage;
+};
+
+// Collects the search work of helper threads, which have no request of
+// their own, so that the requesting thread can add it afterwards.
+struct DeferredSearchStatistics {
+    DeferredSearchStatistics() : number_of_via_node_tests(0) {
+        for(unsigned i = 0; i < 2; ++i) {
+            settled_nodes[i] = 0;
+            inserted_nodes[i] = 0;
+            heap_peak[i] = 0;
+        }
+    }
+
+    void AddSearch(
+        const bool forward_direction,
+        const unsigned settled,
+        const unsigned inserted,
+        const unsigned peak
+    ) {
+        const unsigned direction = forward_direction ? 0 : 1;
+        settled_nodes[direction] += settled;
+        inserted_nodes[direction] += inserted;
+        heap_peak[direction] = std::max(heap_peak[direction], peak);
+    }
+
+    void AddToCurrentRequest() const {
+        for(unsigned i = 0; i < 2; ++i) {
+            QueryMetrics::AddSearchStatistics(0 == i, settled_nodes[i], inserted_nodes[i], heap_peak[i]);
+        }
+        QueryMetrics::AddToCounter(QUERY_COUNTER_VIA_NODE_TESTS, number_of_via_node_tests);
+    }
+
+    unsigned settled_nodes[2];
+    unsigned inserted_nodes[2];
+    unsigned heap_peak[2];
+    unsigned number_of_via_node_tests;
+};
+
+#endif /* QUERY_METRICS_H_ */
@@ -43,8 +43,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //     return duration.count();
 // }
 
+#include <boost/cstdint.hpp>
+
 #include <climits>
 #include <cstdlib>
+#include <ctime>
 
 
 #ifdef _WIN32
@@ -68,4 +71,17 @@ static inline double get_timestamp() {
     return double(tp.tv_sec) + tp.tv_usec / 1000000.;
 }
 
+/** Returns a monotonic timestamp in microseconds. Only useful for intervals. */
+static inline boost::uint64_t get_monotonic_microseconds() {
+#ifdef CLOCK_MONOTONIC
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return boost::uint64_t(tp.tv_sec)*1000000 + tp.tv_nsec/1000;
+#else
+    struct timeval tp;
+    gettimeofday(&tp, NULL);
+    return boost::uint64_t(tp.tv_sec)*1000000 + tp.tv_usec;
+#endif
+}
+
 #endif /* TIMINGUTIL_H_ */
@@ -28,6 +28,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Algorithms/IteratorBasedCRC32.h"
 #include "Contractor/Contractor.h"
 #include "Contractor/EdgeBasedGraphFactory.h"
+#include "Contractor/GraphPartitioner.h"
+#include "Contractor/PrepareCheckpoint.h"
 #include "DataStructures/BinaryHeap.h"
 #include "DataStructures/DeallocatingVector.h"
 #include "DataStructures/QueryEdge.h"
@@ -71,6 +73,11 @@ int main (int argc, char *argv[]) {
         double startupTime = get_timestamp();
         boost::filesystem::path config_file_path, input_path, restrictions_path, profile_path;
         int requested_num_threads;
+        unsigned memory_budget;
+        bool partition_graph = false;
+        bool write_checkpoints = false;
+        bool resume = false;
+        unsigned checkpoint_interval;
 
         // declare a group of options that will be allowed only on command line
         boost::program_options::options_description generic_options("Options");
@@ -88,7 +95,17 @@ int main (int argc, char *argv[]) {
             ("profile,p", boost::program_options::value<boost::filesystem::path>(&profile_path)->default_value("profile.lua"),
                 "Path to LUA routing profile")
             ("threads,t", boost::program_options::value<int>(&requested_num_threads)->default_value(8),
-                "Number of threads to use");
+                "Number of threads to use")
+            ("memory-budget,m", boost::program_options::value<unsigned>(&memory_budget)->default_value(0),
+                "Memory budget for contraction in MB, edges are spilled to disk beyond it (0 = unbounded)")
+            ("mld", boost::program_options::bool_switch(&partition_graph),
+                "Also partition the graph for multi-level routing (.mld)")
+            ("checkpoint", boost::program_options::bool_switch(&write_checkpoints),
+                "Write the edge-based graph (.ebg) and periodic contractor snapshots (.ctr)")
+            ("checkpoint-interval", boost::program_options::value<unsigned>(&checkpoint_interval)->default_value(30),
+                "Minutes between contractor snapshots")
+            ("resume", boost::program_options::bool_switch(&resume),
+                "Continue from the latest valid checkpoint, implies --checkpoint");
 
         // hidden options, will be allowed both on command line and in config file, but will not be shown to the user
         boost::program_options::options_description hidden_options("Hidden options");
@@ -179,131 +196,197 @@ int main (int argc, char *argv[]) {
         );
         restrictionsInstream.close();
 
-        std::ifstream in;
-        in.open (input_path.c_str(), std::ifstream::in | std::ifstream::binary);
-
         std::string nodeOut(input_path.c_str());		nodeOut += ".nodes";
         std::string edgeOut(input_path.c_str());		edgeOut += ".edges";
         std::string graphOut(input_path.c_str());		graphOut += ".hsgr";
         std::string rtree_nodes_path(input_path.c_str());  rtree_nodes_path += ".ramIndex";
         std::string rtree_leafs_path(input_path.c_str());  rtree_leafs_path += ".fileIndex";
+        std::string mldOut(input_path.c_str());		mldOut += ".mld";
+        std::string ebgOut(input_path.c_str());		ebgOut += ".ebg";
+        std::string ctrOut(input_path.c_str());		ctrOut += ".ctr";
 
-        /*** Setup Scripting Environment ***/
-
-        // Create a new lua state
-        lua_State *myLuaState = luaL_newstate();
-
-        // Connect LuaBind to this lua state
-        luabind::open(myLuaState);
+        /*** Resume after expansion if a checkpoint matches the input ***/
 
-        //open utility libraries string library;
-        luaL_openlibs(myLuaState);
-
-        //adjust lua load path
-        luaAddScriptFolderToLoadPath( myLuaState, profile_path.c_str() );
-
-        // Now call our function in a lua script
-        if(0 != luaL_dofile(myLuaState, profile_path.c_str() )) {
-            std::cerr <<
-                lua_tostring(myLuaState,-1)   <<
-                " occured in scripting block" <<
-                std::endl;
+        write_checkpoints = write_checkpoints || resume;
+        unsigned input_checksum = 0;
+        if(write_checkpoints) {
+            input_checksum = ComputePrepareInputChecksum(input_path.string(), inputRestrictions, profile_path.string());
         }
+        NodeID nodeBasedNodeNumber = 0;
+        NodeID edgeBasedNodeNumber = 0;
+        DeallocatingVector<EdgeBasedEdge> edgeBasedEdgeList;
+        std::vector<EdgeBasedGraphFactory::EdgeBasedNode> nodeBasedEdgeList;
+        double expansionHasFinishedTime = 0.;
+        EdgeBasedGraphCheckpointInfo checkpoint_info;
+        const bool resumed_after_expansion = resume && ReadEdgeBasedGraphCheckpoint(
+            ebgOut,
+            input_path.string(),
+            input_checksum,
+            checkpoint_info,
+            edgeBasedEdgeList,
+            nodeBasedEdgeList
+        );
+        if(resumed_after_expansion) {
+            SimpleLogger().Write() << "resuming from " << ebgOut << ", skipping expansion";
+            nodeBasedNodeNumber = checkpoint_info.number_of_node_based_nodes;
+            edgeBasedNodeNumber = checkpoint_info.number_of_edge_based_nodes;
+            expansionHasFinishedTime = get_timestamp() - startupTime;
+        } else {
+            /*** Setup Scripting Environment ***/
+
+            // Create one lua state per thread, turn penalties are computed in parallel
+            std::vector<lua_State *> lua_state_list;
+            LuaStateListCloser lua_state_list_closer(lua_state_list);
+            for(int i = 0; i < omp_get_max_threads(); ++i) {
+                lua_State *threadLuaState = luaL_newstate();
+
+                // Connect LuaBind to this lua state
+                luabind::open(threadLuaState);
+
+                //open utility libraries string library;
+                luaL_openlibs(threadLuaState);
+
+                //adjust lua load path
+                luaAddScriptFolderToLoadPath( threadLuaState, profile_path.c_str() );
+
+                // Now call our function in a lua script
+                if(0 != luaL_dofile(threadLuaState, profile_path.c_str() )) {
+                    std::cerr <<
+                        lua_tostring(threadLuaState,-1)   <<
+                        " occured in scripting block" <<
+                        std::endl;
+                }
+                lua_state_list.push_back(threadLuaState);
+            }
+            lua_State *myLuaState = lua_state_list[0];
 
-        EdgeBasedGraphFactory::SpeedProfileProperties speedProfile;
-
-        if(0 != luaL_dostring( myLuaState, "return traffic_signal_penalty\n")) {
-            std::cerr <<
-                lua_tostring(myLuaState,-1) <<
-                " occured in scripting block" <<
-                std::endl;
-                return -1;
-        }
-        speedProfile.trafficSignalPenalty = 10*lua_tointeger(myLuaState, -1);
+            EdgeBasedGraphFactory::SpeedProfileProperties speedProfile;
 
-        if(0 != luaL_dostring( myLuaState, "return u_turn_penalty\n")) {
-            std::cerr <<
-                lua_tostring(myLuaState,-1)   <<
-                " occured in scripting block" <<
-                std::endl;
-            return -1;
-        }
-        speedProfile.uTurnPenalty = 10*lua_tointeger(myLuaState, -1);
+            if(0 != luaL_dostring( myLuaState, "return traffic_signal_penalty\n")) {
+                std::cerr <<
+                    lua_tostring(myLuaState,-1) <<
+                    " occured in scripting block" <<
+                    std::endl;
+                    return -1;
+            }
+            speedProfile.trafficSignalPenalty = 10*lua_tointeger(myLuaState, -1);
 
-        speedProfile.has_turn_penalty_function = lua_function_exists( myLuaState, "turn_function" );
+            if(0 != luaL_dostring( myLuaState, "return u_turn_penalty\n")) {
+                std::cerr <<
+                    lua_tostring(myLuaState,-1)   <<
+                    " occured in scripting block" <<
+                    std::endl;
+                return -1;
+            }
+            speedProfile.uTurnPenalty = 10*lua_tointeger(myLuaState, -1);
+
+            speedProfile.has_turn_penalty_function = lua_function_exists( myLuaState, "turn_function" );
+
+            std::vector<ImportEdge> edgeList;
+            double graph_loading_start = get_timestamp();
+            nodeBasedNodeNumber = readBinaryOSRMGraphFromFile(input_path.string(), edgeList, bollardNodes, trafficLightNodes, &internalToExternalNodeMapping, inputRestrictions);
+            SimpleLogger().Write() << "Loading graph took " << (get_timestamp() - graph_loading_start) << " sec";
+            SimpleLogger().Write() <<
+                inputRestrictions.size() <<
+                " restrictions, " <<
+                bollardNodes.size() <<
+                " bollard nodes, " <<
+                trafficLightNodes.size() <<
+                " traffic lights";
+
+            if(0 == edgeList.size()) {
+                std::cerr <<
+                    "The input data is broken. "
+                    "It is impossible to do any turns in this graph" <<
+                    std::endl;
+                return -1;
+            }
 
-        std::vector<ImportEdge> edgeList;
-        NodeID nodeBasedNodeNumber = readBinaryOSRMGraphFromStream(in, edgeList, bollardNodes, trafficLightNodes, &internalToExternalNodeMapping, inputRestrictions);
-        in.close();
-        SimpleLogger().Write() <<
-            inputRestrictions.size() <<
-            " restrictions, " <<
-            bollardNodes.size() <<
-            " bollard nodes, " <<
-            trafficLightNodes.size() <<
-            " traffic lights";
-
-        if(0 == edgeList.size()) {
-            std::cerr <<
-                "The input data is broken. "
-                "It is impossible to do any turns in this graph" <<
-                std::endl;
-            return -1;
+            /***
+             * Building an edge-expanded graph from node-based input an turn restrictions
+             */
+
+            SimpleLogger().Write() << "Generating edge-expanded graph representation";
+            EdgeBasedGraphFactory * edgeBasedGraphFactory = new EdgeBasedGraphFactory (nodeBasedNodeNumber, edgeList, bollardNodes, trafficLightNodes, inputRestrictions, internalToExternalNodeMapping, speedProfile);
+            std::vector<ImportEdge>().swap(edgeList);
+            edgeBasedGraphFactory->Run(edgeOut.c_str(), lua_state_list);
+            std::vector<TurnRestriction>().swap(inputRestrictions);
+            std::vector<NodeID>().swap(bollardNodes);
+            std::vector<NodeID>().swap(trafficLightNodes);
+            edgeBasedNodeNumber = edgeBasedGraphFactory->GetNumberOfNodes();
+            edgeBasedGraphFactory->GetEdgeBasedEdges(edgeBasedEdgeList);
+            edgeBasedGraphFactory->GetEdgeBasedNodes(nodeBasedEdgeList);
+            delete edgeBasedGraphFactory;
+
+            /***
+             * Writing info on original (node-based) nodes
+             */
+
+            SimpleLogger().Write() << "writing node map ...";
+            std::ofstream mapOutFile(nodeOut.c_str(), std::ios::binary);
+            mapOutFile.write((char *)&(internalToExternalNodeMapping[0]), internalToExternalNodeMapping.size()*sizeof(NodeInfo));
+            mapOutFile.close();
+            std::vector<NodeInfo>().swap(internalToExternalNodeMapping);
+
+            expansionHasFinishedTime = get_timestamp() - startupTime;
+
+            /***
+             * Building grid-like nearest-neighbor data structure
+             */
+
+            SimpleLogger().Write() << "building r-tree ...";
+            StaticRTree<EdgeBasedGraphFactory::EdgeBasedNode> * rtree =
+                    new StaticRTree<EdgeBasedGraphFactory::EdgeBasedNode>(
+                            nodeBasedEdgeList,
+                            rtree_nodes_path.c_str(),
+                            rtree_leafs_path.c_str()
+                    );
+            delete rtree;
+
+            if(write_checkpoints) {
+                SimpleLogger().Write() << "writing checkpoint " << ebgOut;
+                checkpoint_info.input_checksum = input_checksum;
+                checkpoint_info.number_of_node_based_nodes = nodeBasedNodeNumber;
+                checkpoint_info.number_of_edge_based_nodes = edgeBasedNodeNumber;
+                checkpoint_info.reserved = 0;
+                ComputeExpansionOutputChecksums(input_path.string(), checkpoint_info.output_checksums);
+                WriteEdgeBasedGraphCheckpoint(ebgOut, uuid_orig, checkpoint_info, edgeBasedEdgeList, nodeBasedEdgeList);
+            }
         }
 
-        /***
-         * Building an edge-expanded graph from node-based input an turn restrictions
-         */
-
-        SimpleLogger().Write() << "Generating edge-expanded graph representation";
-        EdgeBasedGraphFactory * edgeBasedGraphFactory = new EdgeBasedGraphFactory (nodeBasedNodeNumber, edgeList, bollardNodes, trafficLightNodes, inputRestrictions, internalToExternalNodeMapping, speedProfile);
-        std::vector<ImportEdge>().swap(edgeList);
-        edgeBasedGraphFactory->Run(edgeOut.c_str(), myLuaState);
-        std::vector<TurnRestriction>().swap(inputRestrictions);
-        std::vector<NodeID>().swap(bollardNodes);
-        std::vector<NodeID>().swap(trafficLightNodes);
-        NodeID edgeBasedNodeNumber = edgeBasedGraphFactory->GetNumberOfNodes();
-        DeallocatingVector<EdgeBasedEdge> edgeBasedEdgeList;
-        edgeBasedGraphFactory->GetEdgeBasedEdges(edgeBasedEdgeList);
-        std::vector<EdgeBasedGraphFactory::EdgeBasedNode> nodeBasedEdgeList;
-        edgeBasedGraphFactory->GetEdgeBasedNodes(nodeBasedEdgeList);
-        delete edgeBasedGraphFactory;
-
-        /***
-         * Writing info on original (node-based) nodes
-         */
-
-        SimpleLogger().Write() << "writing node map ...";
-        std::ofstream mapOutFile(nodeOut.c_str(), std::ios::binary);
-        mapOutFile.write((char *)&(internalToExternalNodeMapping[0]), internalToExternalNodeMapping.size()*sizeof(NodeInfo));
-        mapOutFile.close();
-        std::vector<NodeInfo>().swap(internalToExternalNodeMapping);
-
-        double expansionHasFinishedTime = get_timestamp() - startupTime;
+        IteratorbasedCRC32<std::vector<EdgeBasedGraphFactory::EdgeBasedNode> > crc32;
+        unsigned crc32OfNodeBasedEdgeList = crc32(nodeBasedEdgeList.begin(), nodeBasedEdgeList.end() );
+        SimpleLogger().Write() << "CRC32: " << crc32OfNodeBasedEdgeList;
 
         /***
-         * Building grid-like nearest-neighbor data structure
+         * Partitioning the edge-expanded graph, the contractor consumes the edges
          */
 
-        SimpleLogger().Write() << "building r-tree ...";
-        StaticRTree<EdgeBasedGraphFactory::EdgeBasedNode> * rtree =
-                new StaticRTree<EdgeBasedGraphFactory::EdgeBasedNode>(
-                        nodeBasedEdgeList,
-                        rtree_nodes_path.c_str(),
-                        rtree_leafs_path.c_str()
-                );
-        delete rtree;
-        IteratorbasedCRC32<std::vector<EdgeBasedGraphFactory::EdgeBasedNode> > crc32;
-        unsigned crc32OfNodeBasedEdgeList = crc32(nodeBasedEdgeList.begin(), nodeBasedEdgeList.end() );
+        if(partition_graph) {
+            SimpleLogger().Write() << "partitioning graph for multi-level routing";
+            GraphPartitioner partitioner(edgeBasedNodeNumber, edgeBasedEdgeList, nodeBasedEdgeList);
+            partitioner.Run();
+            partitioner.Serialize(mldOut, crc32OfNodeBasedEdgeList);
+        }
         nodeBasedEdgeList.clear();
-        SimpleLogger().Write() << "CRC32: " << crc32OfNodeBasedEdgeList;
 
         /***
          * Contracting the edge-expanded graph
          */
 
         SimpleLogger().Write() << "initializing contractor";
-        Contractor* contractor = new Contractor( edgeBasedNodeNumber, edgeBasedEdgeList );
+        if(0 != memory_budget) {
+            SimpleLogger().Write() << "contraction memory budget: " << memory_budget << " MB";
+        }
+        Contractor* contractor = new Contractor( edgeBasedNodeNumber, edgeBasedEdgeList, memory_budget );
+        if(write_checkpoints) {
+            contractor->EnableCheckpoints(
+                ctrOut,
+                ComputeContractionChecksum(input_checksum, memory_budget),
+                60.*checkpoint_interval,
+                resume
+            );
+        }
         double contractionStartedTimestamp(get_timestamp());
         contractor->Run();
         const double contraction_duration = (get_timestamp() - contractionStartedTimestamp);
@@ -317,11 +400,10 @@ int main (int argc, char *argv[]) {
         delete contractor;
 
         /***
-         * Sorting contracted edges in a way that the static query graph can read some in in-place.
+         * Contracted edges come merged in (source,target) order, so the static query graph can read them in-place.
          */
 
         SimpleLogger().Write() << "Building Node Array";
-        std::sort(contractedEdgeList.begin(), contractedEdgeList.end());
         unsigned numberOfNodes = 0;
         unsigned numberOfEdges = contractedEdgeList.size();
         SimpleLogger().Write() <<
@@ -398,6 +480,10 @@ int main (int argc, char *argv[]) {
             usedEdgeCounter/contraction_duration << " edges/sec";
 
         hsgr_output_stream.close();
+        if(write_checkpoints) {
+            //the edge-based graph is kept to recontract with other parameters
+            boost::filesystem::remove(ctrOut);
+        }
         //cleanedEdgeList.clear();
         _nodes.clear();
         SimpleLogger().Write() << "finished preprocessing";
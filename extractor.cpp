@@ -27,7 +27,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Extractor/ExtractorCallbacks.h"
 #include "Extractor/ExtractionContainers.h"
+#include "Extractor/ExtractionStore.h"
+#include "Extractor/OSCParser.h"
 #include "Extractor/ScriptingEnvironment.h"
+#include "Extractor/ParallelXMLParser.h"
 #include "Extractor/PBFParser.h"
 #include "Extractor/XMLParser.h"
 #include "Util/GitDescription.h"
@@ -54,8 +57,9 @@ int main (int argc, char *argv[]) {
         LogPolicy::GetInstance().Unmute();
         double startup_time = get_timestamp();
 
-        boost::filesystem::path config_file_path, input_path, profile_path;
+        boost::filesystem::path config_file_path, input_path, profile_path, changes_path;
         int requested_num_threads;
+        bool use_libxml_parser, build_store;
 
         // declare a group of options that will be allowed only on command line
         boost::program_options::options_description generic_options("Options");
@@ -71,7 +75,14 @@ int main (int argc, char *argv[]) {
             ("profile,p", boost::program_options::value<boost::filesystem::path>(&profile_path)->default_value("profile.lua"),
                 "Path to LUA routing profile")
             ("threads,t", boost::program_options::value<int>(&requested_num_threads)->default_value(8),
-                "Number of threads to use");
+                "Number of threads to use")
+            ("libxml", boost::program_options::value<bool>(&use_libxml_parser)->implicit_value(true)->default_value(false),
+                "Parse .osm/.osm.bz2 input serially with libxml2")
+            ("build-store", boost::program_options::value<bool>(&build_store)->implicit_value(true)->default_value(false),
+                "Keep a store of the extracted data to apply change files to")
+            ("changes", boost::program_options::value<boost::filesystem::path>(&changes_path),
+                "Apply an .osc/.osc.gz change file to the store instead of parsing the input. "
+                "Skips parsing and the profile, the .osrm files are still rebuilt in full");
 
         // hidden options, will be allowed both on command line and in config file, but will not be shown to the user
         boost::program_options::options_description hidden_options("Hidden options");
@@ -125,6 +136,12 @@ int main (int argc, char *argv[]) {
             return -1;
         }
 
+        const bool apply_changes = option_variables.count("changes");
+        if(apply_changes && build_store) {
+            SimpleLogger().Write(logWARNING) << "--build-store and --changes are mutually exclusive";
+            return -1;
+        }
+
         if(1 > requested_num_threads) {
             SimpleLogger().Write(logWARNING) << "Number of threads must be 1 or larger";
             return -1;
@@ -179,12 +196,28 @@ int main (int argc, char *argv[]) {
         ExtractionContainers externalMemory;
 
         stringMap[""] = 0;
-        extractCallBacks = new ExtractorCallbacks(&externalMemory, &stringMap);
+        ExtractionStore extractionStore(output_file_name);
+        ExtractionChangeSet changeSet;
+        if(build_store) {
+            extractionStore.OpenForWriting();
+        }
+        extractCallBacks = new ExtractorCallbacks(
+            &externalMemory,
+            &stringMap,
+            (build_store ? &extractionStore : NULL)
+        );
         BaseParser* parser;
-        if(file_has_pbf_format) {
+        if(apply_changes) {
+            if(!extractionStore.Exists()) {
+                throw OSRMException("No extraction store found, extract with --build-store first");
+            }
+            parser = new OSCParser(changes_path.c_str(), extractCallBacks, scriptingEnvironment, changeSet);
+        } else if(file_has_pbf_format) {
             parser = new PBFParser(input_path.c_str(), extractCallBacks, scriptingEnvironment);
-        } else {
+        } else if(use_libxml_parser) {
             parser = new XMLParser(input_path.c_str(), extractCallBacks, scriptingEnvironment);
+        } else {
+            parser = new ParallelXMLParser(input_path.c_str(), extractCallBacks, scriptingEnvironment);
         }
 
         if(!parser->ReadHeader()) {
@@ -197,6 +230,16 @@ int main (int argc, char *argv[]) {
             (get_timestamp() - parsing_start_time) <<
             " seconds";
 
+        if(apply_changes) {
+            double update_start_time = get_timestamp();
+            extractionStore.ApplyChanges(changeSet);
+            extractionStore.Replay(*extractCallBacks);
+            SimpleLogger().Write() << "Updating store finished after " <<
+                (get_timestamp() - update_start_time) <<
+                " seconds";
+        }
+        extractionStore.CloseForWriting();
+
         externalMemory.PrepareData(output_file_name, restrictionsFileName, amountOfRAM);
 
         delete parser;
@@ -0,0 +1,34 @@
+When /^I route with alternatives I should get$/ do |table|
+  reprocess
+  actual = []
+  OSRMLauncher.new("#{@osm_file}.osrm") do
+    table.hashes.each_with_index do |row,ri|
+      waypoints, got = row_waypoints row
+
+      params = {'alt' => true}
+      row.each_pair do |k,v|
+        if k =~ /param:(.*)/
+          params[$1] = v
+          got[k] = v
+        end
+      end
+
+      response = request_route waypoints, params
+      if response.code == "200" && response.body.empty? == false
+        json = JSON.parse response.body
+        if json['status'] == 0
+          route = way_list json['route_instructions']
+          alternatives = json['alternative_instructions'].map { |instructions| way_list instructions }
+        end
+      end
+
+      got['route'] = (route || '').strip
+      #alternatives are separated by ';', in the order they are returned
+      got['alternatives'] = (alternatives || []).join(';')
+
+      match_row row, got, response
+      actual << got
+    end
+  end
+  table.routing_diff! actual
+end
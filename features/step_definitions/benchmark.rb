@@ -0,0 +1,31 @@
+QUERY_BENCHMARK_LOG_FILE = 'osrm-query-benchmark.log'
+
+Given /^the data is prepared for multi-level routing$/ do
+  @prepare_mld = true
+end
+
+When /^I replay in-process( with alternatives)?$/ do |alternatives, table|
+  pending "osrm-query-benchmark is only built with -DWITH_TOOLS=1" unless File.exist? "#{TEST_FOLDER}/#{BIN_PATH}/osrm-query-benchmark"
+  reprocess
+  Dir.chdir TEST_FOLDER do
+    queries = table.hashes.map do |row|
+      from_node = find_node_by_name row['from']
+      raise "*** unknown from-node '#{row['from']}" unless from_node
+      to_node = find_node_by_name row['to']
+      raise "*** unknown to-node '#{row['to']}" unless to_node
+      "/viaroute?loc=#{from_node.lat},#{from_node.lon}&loc=#{to_node.lat},#{to_node.lon}#{'&alt=false' unless alternatives}"
+    end
+    File.open( "#{@osm_file}.queries", 'w') {|f| f.puts queries }
+    @benchmark_ok = system "#{BIN_PATH}/osrm-query-benchmark #{@osm_file}.osrm --queries #{@osm_file}.queries 1>#{QUERY_BENCHMARK_LOG_FILE} 2>&1"
+    @benchmark_log = File.read QUERY_BENCHMARK_LOG_FILE
+  end
+end
+
+Then /^every replayed query should succeed$/ do
+  @benchmark_ok.should == true
+  @benchmark_log.should =~ / 0 failed requests/
+end
+
+Then /^the multi-level graph should be loaded$/ do
+  @benchmark_log.should =~ /Multi-level graph has/
+end
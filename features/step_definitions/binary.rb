@@ -0,0 +1,37 @@
+When /^I route with binary output I should get$/ do |table|
+  reprocess
+  actual = []
+  OSRMLauncher.new("#{@osm_file}.osrm") do
+    table.hashes.each_with_index do |row,ri|
+      waypoints, got = row_waypoints row
+
+      response = request_route waypoints, 'output' => 'binary'
+      json_response = request_route waypoints, 'compression' => false
+      if response.code == "200" && json_response.code == "200"
+        binary = decode_binary_route response.body
+        json = JSON.parse json_response.body
+        route = binary[:routes].first
+
+        if table.headers.include? 'route'
+          got['route'] = route ? binary_way_list(route, binary[:names]) : ''
+        end
+        if table.headers.include? 'distance'
+          got['distance'] = route ? "#{route[:total_distance]}m" : ''
+        end
+        if table.headers.include? 'time'
+          got['time'] = route ? "#{route[:total_time]}s" : ''
+        end
+        if table.headers.include? 'via points'
+          got['via points'] = binary[:via_points].size.to_s
+        end
+        if table.headers.include? 'json'
+          got['json'] = binary_json_differences binary, json
+        end
+      end
+
+      match_row row, got, response
+      actual << got
+    end
+  end
+  table.routing_diff! actual
+end
@@ -0,0 +1,30 @@
+When /^I route and scrape the metrics$/ do |table|
+  reprocess
+  OSRMLauncher.new("#{@osm_file}.osrm") do
+    @metrics_before = request_metrics
+    table.hashes.each do |row|
+      waypoints, got = row_waypoints row
+      response = request_route waypoints
+      raise "*** route request returned HTTP #{response.code}" unless response.code == "200"
+    end
+    @metrics_after = request_metrics
+  end
+end
+
+Then /^the metrics should have changed by$/ do |table|
+  actual = []
+  table.hashes.each do |row|
+    metric = row['metric']
+    change = (@metrics_after[metric] || 0) - (@metrics_before[metric] || 0)
+    got = { 'metric' => metric, 'change' => format_metric_value(change) }
+    if FuzzyMatch.match got['change'], row['change']
+      got['change'] = row['change']
+    end
+    actual << got
+  end
+  table.routing_diff! actual
+end
+
+Then /^every latency histogram should be cumulative$/ do
+  histogram_problems(@metrics_after).should == []
+end
@@ -0,0 +1,42 @@
+When /^I route with a trace I should get$/ do |table|
+  reprocess
+  actual = []
+  OSRMLauncher.new("#{@osm_file}.osrm") do
+    table.hashes.each_with_index do |row,ri|
+      waypoints, got = row_waypoints row
+
+      params = {'trace' => true}
+      row.each_pair do |k,v|
+        if k =~ /param:(.*)/
+          params[$1] = v
+          got[k] = v
+        end
+      end
+
+      response = request_route waypoints, params
+      if response.code == "200" && response.body.empty? == false
+        json = JSON.parse response.body
+        if json['status'] == 0
+          route = way_list json['route_instructions']
+        end
+        trace = json['trace']
+      end
+
+      got['route'] = (route || '').strip if table.headers.include? 'route'
+      got['trace'] = trace ? 'yes' : 'no' if table.headers.include? 'trace'
+      if trace
+        got['stages'] = trace['stages_us'].keys.join(',')
+        got['forward settled'] = trace['settled_nodes']['forward'].to_s
+        got['reverse settled'] = trace['settled_nodes']['reverse'].to_s
+        got['unpacked edges'] = trace['unpacked_edges'].to_s
+        got['via node tests'] = trace['via_node_tests'].to_s
+        got['rtree nodes'] = trace['rtree']['nodes_explored'].to_s
+      end
+      got.keep_if { |k,v| table.headers.include? k }
+
+      match_row row, got, response
+      actual << got
+    end
+  end
+  table.routing_diff! actual
+end
@@ -0,0 +1,49 @@
+When /^I route with live traffic I should get$/ do |table|
+  reprocess
+  osrm_file = "#{@osm_file}.osrm"
+  options = "--traffic-feed #{TRAFFIC_FEED_FILE}"
+  options << " --mlddata #{osrm_file}.mld" if @prepare_mld
+  Dir.chdir(TEST_FOLDER) { write_traffic_feed osrm_file, {} }
+  actual = []
+  OSRMLauncher.new(osrm_file, options) do
+    current_traffic = ''
+    table.hashes.each do |row|
+      waypoints, got = row_waypoints row
+
+      #rows are routed in order, the feed is only replaced when it changes
+      got['traffic'] = row['traffic']
+      if row['traffic'] != current_traffic
+        update_traffic_feed osrm_file, parse_traffic_factors(row['traffic'])
+        current_traffic = row['traffic']
+      end
+
+      params = {'traffic' => true}
+      row.each_pair do |k,v|
+        if k =~ /param:(.*)/
+          params[$1] = v
+          got[k] = v
+        end
+      end
+
+      response = request_route waypoints, params
+      if response.code == "200" && response.body.empty? == false
+        json = JSON.parse response.body
+        if json['status'] == 0
+          route = way_list json['route_instructions']
+          time = json['route_summary']['total_time']
+        end
+      end
+
+      got['route'] = (route || '').strip
+      got['time'] = time ? "#{time}s" : '' if table.headers.include? 'time'
+
+      match_row row, got, response
+      actual << got
+    end
+  end
+  table.routing_diff! actual
+end
+
+Then /^osrm-routed should have loaded the multi-level graph$/ do
+  File.read("#{TEST_FOLDER}/#{OSRM_ROUTED_LOG_FILE}").should =~ /Multi-level graph has/
+end
@@ -0,0 +1,104 @@
+#decodes output=binary responses, the layout is described in Descriptors/BinaryResponseFormat.h
+
+BINARY_RESPONSE_MAGIC = 'OSRB'
+BINARY_ROUTE_RESPONSE = 1
+
+def binary_padding size
+  (4 - (size & 3)) & 3
+end
+
+#returns the zig-zag decoded value and the position after it
+def read_binary_varint data, position
+  value = 0
+  shift = 0
+  while true
+    byte = data.getbyte position
+    raise "*** truncated geometry in binary response" unless byte
+    position += 1
+    value |= (byte & 0x7f) << shift
+    break if (byte & 0x80) == 0
+    shift += 7
+  end
+  [(value >> 1) ^ -(value & 1), position]
+end
+
+def decode_binary_route body
+  data = body.dup.force_encoding 'BINARY'
+  magic, version, type, status, checksum = data.unpack 'a4SSlL'
+  unless magic == BINARY_RESPONSE_MAGIC && type == BINARY_ROUTE_RESPONSE
+    raise "*** not a binary route response"
+  end
+  number_of_routes, number_of_via_points, hint_size, number_of_names = data.unpack '@16L4'
+  position = 40
+
+  via_points = (0...number_of_via_points).map { |i| data.unpack "@#{position+8*i}l2" }
+  position += 8*number_of_via_points
+  hint_bytes = hint_size*number_of_via_points
+  position += hint_bytes + binary_padding(hint_bytes)
+
+  routes = (0...number_of_routes).map do
+    distance, time, start_name, end_name, number_of_instructions, number_of_coordinates, geometry_bytes = data.unpack "@#{position}l2L5"
+    position += 32
+    instructions = (0...number_of_instructions).map do |i|
+      turn, exit, bearing, name, length, index, duration = data.unpack "@#{position+20*i}CCSLlLl"
+      { :turn => turn, :exit => exit, :bearing => bearing, :name => name, :length => length, :position => index, :duration => duration }
+    end
+    position += 20*number_of_instructions
+    geometry = []
+    lat = lon = 0
+    geometry_position = position
+    number_of_coordinates.times do
+      delta, geometry_position = read_binary_varint data, geometry_position
+      lat += delta
+      delta, geometry_position = read_binary_varint data, geometry_position
+      lon += delta
+      geometry << [lat,lon]
+    end
+    position += geometry_bytes + binary_padding(geometry_bytes)
+    { :total_distance => distance, :total_time => time, :start_name => start_name, :end_name => end_name,
+      :instructions => instructions, :geometry => geometry }
+  end
+
+  name_offsets = data.unpack "@#{position}L#{number_of_names+1}"
+  position += 4*(number_of_names+1)
+  names = (0...number_of_names).map do |i|
+    data[position+name_offsets[i], name_offsets[i+1]-name_offsets[i]].force_encoding 'UTF-8'
+  end
+
+  { :status => status, :checksum => checksum, :via_points => via_points, :routes => routes, :names => names }
+end
+
+#the same as way_list, for decoded binary instructions
+def binary_way_list route, names
+  route[:instructions].reject { |r| r[:turn] == DESTINATION_REACHED }.
+  map { |r| names[r[:name]] }.
+  map { |r| r=="" ? '""' : r }.
+  join(',')
+end
+
+#fixed point coordinates of a JSON response, as written to binary responses
+def json_fixed_point_coordinates coordinates
+  coordinates.map { |c| c.map { |v| (v*1000000).round } }
+end
+
+#names the parts of a binary route response that differ from the JSON
+#response (requested with compression=false) for the same query
+def binary_json_differences binary, json
+  differences = []
+  differences << 'status' unless binary[:status] == json['status']
+  differences << 'checksum' unless binary[:checksum] == json['hint_data']['checksum']
+  if json['status'] == 0
+    route = binary[:routes].first
+    summary = json['route_summary']
+    names = binary[:names]
+    differences << 'route' unless binary_way_list(route, names) == way_list(json['route_instructions'])
+    differences << 'instructions' unless route[:instructions].size == json['route_instructions'].size
+    differences << 'distance' unless route[:total_distance] == summary['total_distance']
+    differences << 'time' unless route[:total_time] == summary['total_time']
+    differences << 'start' unless names[route[:start_name]] == summary['start_point']
+    differences << 'end' unless names[route[:end_name]] == summary['end_point']
+    differences << 'via points' unless binary[:via_points] == json_fixed_point_coordinates(json['via_points'])
+    differences << 'geometry' unless route[:geometry] == json_fixed_point_coordinates(json['route_geometry'])
+  end
+  differences.empty? ? 'same' : differences.join(',')
+end
@@ -238,7 +238,7 @@ def extracted?
 end
 
 def prepared?
-  File.exist?("#{@osm_file}.osrm.hsgr")
+  File.exist?("#{@osm_file}.osrm.hsgr") && (!@prepare_mld || File.exist?("#{@osm_file}.osrm.mld"))
 end
 
 def write_timestamp
@@ -263,7 +263,7 @@ def reprocess
     unless prepared?
       log_preprocess_info
       log "== Preparing #{@osm_file}.osm...", :preprocess
-      unless system "#{BIN_PATH}/osrm-prepare #{@osm_file}.osrm  --profile #{PROFILES_PATH}/#{@profile}.lua 1>>#{PREPROCESS_LOG_FILE} 2>>#{PREPROCESS_LOG_FILE}"
+      unless system "#{BIN_PATH}/osrm-prepare #{@osm_file}.osrm  --profile #{PROFILES_PATH}/#{@profile}.lua#{' --mld' if @prepare_mld} 1>>#{PREPROCESS_LOG_FILE} 2>>#{PREPROCESS_LOG_FILE}"
         log "*** Exited with code #{$?.exitstatus}.", :preprocess
         raise PrepareError.new $?.exitstatus, "osrm-prepare exited with code #{$?.exitstatus}."
       end
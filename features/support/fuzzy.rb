@@ -17,6 +17,8 @@ class FuzzyMatch
       from = $1.to_f-margin
       to = $1.to_f+margin
       return got.to_f >= from && got.to_f <= to
+    elsif want.match /^(\d+)\.\.(\d+)$/     #inclusive range: 1..96
+      return got.to_f >= $1.to_f && got.to_f <= $2.to_f
     elsif want =~ /^\/(.*)\/$/             #regex: /a,b,.*/
       return got =~ /#{$1}/
     else
@@ -0,0 +1,40 @@
+#samples of the /metrics response, keyed by metric name and labels as written
+def request_metrics
+  response = request_path 'metrics'
+  raise "*** /metrics returned HTTP #{response.code}" unless response.code == "200"
+  parse_metrics response.body
+end
+
+def parse_metrics text
+  metrics = {}
+  text.each_line do |line|
+    line = line.strip
+    next if line.empty? || line.start_with?('#')
+    key, value = line.split ' '
+    metrics[key] = value.to_f
+  end
+  metrics
+end
+
+def format_metric_value value
+  value == value.round ? value.round.to_s : value.to_s
+end
+
+#the problems of each histogram: buckets must not decrease with their bound
+#and the +Inf bucket must hold as many values as the count
+def histogram_problems metrics
+  histograms = {}
+  metrics.each_pair do |key,value|
+    next unless key =~ /^(\w+)_bucket\{(.*),le="([^"]*)"\}$/
+    histograms["#{$1}{#{$2}}"] ||= []
+    histograms["#{$1}{#{$2}}"] << [$3 == '+Inf' ? Float::INFINITY : $3.to_f, value]
+  end
+  problems = []
+  histograms.each_pair do |histogram,buckets|
+    counts = buckets.sort.map { |bucket| bucket[1] }
+    problems << "#{histogram} decreases" unless counts.each_cons(2).all? { |a,b| a <= b }
+    count = metrics[histogram.sub(/\{/, '_count{')]
+    problems << "#{histogram} +Inf bucket is not the count" unless buckets.sort.last[0] == Float::INFINITY && counts.last == count
+  end
+  problems
+end
@@ -136,4 +136,40 @@ def mode_list instructions
   map { |r| r[8] }.
   map { |r| (r=="" || r==nil) ? '""' : r }.
   join(',')
-end
\ No newline at end of file
+end
+#the waypoints of a table row with from/to or waypoints columns, and the
+#columns that identify the row in the output table
+def row_waypoints row
+  if row['from'] and row['to']
+    names = [row['from'], row['to']]
+    got = {'from' => row['from'], 'to' => row['to'] }
+  elsif row['waypoints']
+    names = row['waypoints'].split(',').map { |n| n.strip }
+    got = {'waypoints' => row['waypoints'] }
+  else
+    raise "*** no waypoints"
+  end
+  waypoints = names.map do |n|
+    node = find_node_by_name n
+    raise "*** unknown waypoint node '#{n}" unless node
+    node
+  end
+  [waypoints, got]
+end
+
+#copies the values that match into got and logs a failure otherwise
+def match_row row, got, response
+  ok = true
+  row.keys.each do |key|
+    if FuzzyMatch.match got[key], row[key]
+      got[key] = row[key]
+    else
+      ok = false
+    end
+  end
+  unless ok
+    failed = { :attempt => 'route', :query => @query, :response => response }
+    log_fail row,got,[failed]
+  end
+  ok
+end
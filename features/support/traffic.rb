@@ -0,0 +1,71 @@
+#live traffic feeds for osrm-routed --traffic-feed, see DataStructures/TrafficOverlay.h
+
+TRAFFIC_FEED_FILE = 'traffic.csv'
+
+#street names by name id, in the layout written by the extractor
+def read_osrm_names osrm_file
+  data = File.binread "#{osrm_file}.names"
+  number_of_offsets = data.unpack('L').first
+  offsets = data.unpack "@4L#{number_of_offsets}"
+  chars = data[4*(number_of_offsets+2)..-1]
+  (0...number_of_offsets-1).map do |i|
+    chars[offsets[i], offsets[i+1]-offsets[i]].force_encoding 'UTF-8'
+  end
+end
+
+#name id of each original edge, i.e. of the way the edge turns into
+def read_osrm_edge_names osrm_file
+  data = File.binread "#{osrm_file}.edges"
+  number_of_edges = data.unpack('L').first
+  (0...number_of_edges).map { |i| data.unpack("@#{4+12*i}LL")[1] }
+end
+
+#one "<edge id>,<speed factor>" line for each original edge that enters one
+#of the named ways, which slows every segment leading onto and along them
+def traffic_feed_lines osrm_file, factors
+  names = read_osrm_names osrm_file
+  lines = []
+  read_osrm_edge_names(osrm_file).each_with_index do |name_id,edge|
+    factor = factors[names[name_id]]
+    lines << "#{edge},#{factor}" if factor
+  end
+  lines
+end
+
+#the feed is polled for changes of its time stamp and size, so it is
+#replaced by renaming a complete file that is padded to a new size
+def write_traffic_feed osrm_file, factors
+  lines = traffic_feed_lines osrm_file, factors
+  @traffic_feed_revision = (@traffic_feed_revision || 0) + 1
+  lines << "#" * @traffic_feed_revision
+  File.open("#{TRAFFIC_FEED_FILE}.tmp", 'w') { |f| f.puts lines }
+  File.rename "#{TRAFFIC_FEED_FILE}.tmp", TRAFFIC_FEED_FILE
+end
+
+TRAFFIC_UPDATE_TIMEOUT = 10
+
+def logged_traffic_updates
+  File.read(OSRM_ROUTED_LOG_FILE).scan(/Traffic update:/).size
+end
+
+#writes a new feed and waits until osrm-routed has published its weights,
+#only feeds that change the speed of some edge are logged
+def update_traffic_feed osrm_file, factors
+  updates = logged_traffic_updates
+  write_traffic_feed osrm_file, factors
+  Timeout.timeout(TRAFFIC_UPDATE_TIMEOUT) do
+    sleep 0.1 while logged_traffic_updates == updates
+  end
+rescue Timeout::Error
+  raise "*** osrm-routed did not apply the traffic feed within #{TRAFFIC_UPDATE_TIMEOUT}s"
+end
+
+#"axyb:0.25,bqt:0.5" gives the speed factor of each named way
+def parse_traffic_factors traffic
+  factors = {}
+  traffic.to_s.split(',').each do |entry|
+    name, factor = entry.split(':').map { |s| s.strip }
+    factors[name] = factor
+  end
+  factors
+end
@@ -0,0 +1,42 @@
+@routing @testbot @alternatives
+Feature: Limits of the alternative route search
+
+    Background:
+        Given the profile "testbot"
+        And the node map
+            | s | a | b | c | d | e | f | t |
+            |   | g | h | i | j | k | l |   |
+            |   | m | n | o | p | q | r |   |
+
+        And the ways
+            | nodes  |
+            | sa     |
+            | abcdef |
+            | ft     |
+            | ghijkl |
+            | mnopqr |
+            | agm    |
+            | flr    |
+
+    Scenario: The number of alternatives is limited by alt_count
+        When I route with alternatives I should get
+            | from | to | param:alt_epsilon | param:alt_count | route        | alternatives                                 |
+            | s    | t  | 1                 | 1               | sa,abcdef,ft | sa,agm,ghijkl,flr,ft                         |
+            | s    | t  | 1                 | 2               | sa,abcdef,ft | sa,agm,ghijkl,flr,ft;sa,agm,mnopqr,flr,ft    |
+            | s    | t  | 1                 | 3               | sa,abcdef,ft | sa,agm,ghijkl,flr,ft;sa,agm,mnopqr,flr,ft    |
+
+    # the detours are 9/7 and 11/7 times as long as the shortest path
+    Scenario: Alternatives are limited by their stretch
+        When I route with alternatives I should get
+            | from | to | param:alt_count | param:alt_epsilon | route        | alternatives                                 |
+            | s    | t  | 3               | 0.1               | sa,abcdef,ft |                                              |
+            | s    | t  | 3               | 0.4               | sa,abcdef,ft | sa,agm,ghijkl,flr,ft                         |
+            | s    | t  | 3               | 0.7               | sa,abcdef,ft | sa,agm,ghijkl,flr,ft;sa,agm,mnopqr,flr,ft    |
+
+    # the second detour shares sa, agm, flr and ft with the first one
+    Scenario: Alternatives are limited by what they share with each other
+        When I route with alternatives I should get
+            | from | to | param:alt_count | param:alt_epsilon | param:alt_gamma | route        | alternatives                                 |
+            | s    | t  | 3               | 1                 | 0.1             | sa,abcdef,ft | sa,agm,ghijkl,flr,ft                         |
+            | s    | t  | 3               | 1                 | 0.3             | sa,abcdef,ft | sa,agm,ghijkl,flr,ft;sa,agm,mnopqr,flr,ft    |
+            | s    | t  | 3               | 1                 | 0.75            | sa,abcdef,ft | sa,agm,ghijkl,flr,ft;sa,agm,mnopqr,flr,ft    |
@@ -0,0 +1,51 @@
+@routing @testbot @binary
+Feature: Binary output
+
+    Background:
+        Given the profile "testbot"
+
+    Scenario: Binary routes decode to the JSON route
+        Given the node map
+            | a | b | c |
+            |   | d |   |
+
+        And the ways
+            | nodes |
+            | abc   |
+            | bd    |
+
+        When I route with binary output I should get
+            | from | to | route  | distance | time    | via points | json |
+            | a    | c  | abc    | 200m +-2 | 20s +-1 | 2          | same |
+            | c    | a  | abc    | 200m +-2 | 20s +-1 | 2          | same |
+            | a    | d  | abc,bd | 200m +-2 | 20s +-1 | 2          | same |
+            | d    | c  | bd,abc | 200m +-2 | 20s +-1 | 2          | same |
+
+    Scenario: Binary via points match the JSON via points
+        Given the node map
+            | a | b | c |
+            |   | d |   |
+
+        And the ways
+            | nodes |
+            | abc   |
+            | bd    |
+
+        When I route with binary output I should get
+            | waypoints | route         | via points | json |
+            | a,d,c     | abc,bd,bd,abc | 3          | same |
+            | c,d,a     | abc,bd,bd,abc | 3          | same |
+            | a,b,c     | abc           | 3          | same |
+
+    Scenario: Binary output without a route
+        Given the node map
+            | a | b |   | c | d |
+
+        And the ways
+            | nodes |
+            | ab    |
+            | cd    |
+
+        When I route with binary output I should get
+            | from | to | route | via points | json |
+            | a    | d  |       | 2          | same |
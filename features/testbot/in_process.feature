@@ -0,0 +1,36 @@
+@routing @in_process
+Feature: In-process routing through the library
+
+    Background:
+        Given the profile "testbot"
+
+    Scenario: Replaying a query without a server
+        Given the node map
+            | a | b | c |
+
+        And the ways
+            | nodes |
+            | abc   |
+
+        When I replay in-process
+            | from | to |
+            | a    | c  |
+        Then every replayed query should succeed
+
+    Scenario: Routing on the multi-level graph when alternatives are requested
+        Given the data is prepared for multi-level routing
+        And the node map
+            | a | b | c | d |
+            |   |   | e |   |
+
+        And the ways
+            | nodes |
+            | abcd  |
+            | ce    |
+
+        When I replay in-process with alternatives
+            | from | to |
+            | a    | d  |
+            | e    | a  |
+        Then every replayed query should succeed
+        And the multi-level graph should be loaded
@@ -0,0 +1,38 @@
+@routing @testbot @metrics
+Feature: Query metrics
+
+    Background:
+        Given the profile "testbot"
+
+    Scenario: Route requests update the counters and latency histograms
+        Given the node map
+            | a | b | c |
+            |   | d |   |
+
+        And the ways
+            | nodes |
+            | abc   |
+            | bd    |
+
+        When I route and scrape the metrics
+            | from | to |
+            | a    | c  |
+            | a    | d  |
+        Then the metrics should have changed by
+            | metric                                                                          | change   |
+            | osrm_request_duration_seconds_count{plugin="viaroute"}                          | 2        |
+            | osrm_request_duration_seconds_count{plugin="metrics"}                           | 1        |
+            | osrm_stage_duration_seconds_count{plugin="viaroute",stage="parsing"}            | 2        |
+            | osrm_stage_duration_seconds_count{plugin="viaroute",stage="snapping"}           | 2        |
+            | osrm_stage_duration_seconds_count{plugin="viaroute",stage="search"}             | 2        |
+            | osrm_stage_duration_seconds_count{plugin="viaroute",stage="unpacking"}          | 2        |
+            | osrm_stage_duration_seconds_count{plugin="viaroute",stage="description"}        | 2        |
+            | osrm_stage_duration_seconds_bucket{plugin="viaroute",stage="search",le="+Inf"}  | 2        |
+            | osrm_stage_duration_seconds_bucket{plugin="viaroute",stage="search",le="10"}    | 2        |
+            | osrm_settled_nodes_total{plugin="viaroute",direction="forward"}                 | /^[1-9]/ |
+            | osrm_settled_nodes_total{plugin="viaroute",direction="reverse"}                 | /^[1-9]/ |
+            | osrm_unpacked_edges_total{plugin="viaroute"}                                    | /^[1-9]/ |
+            | osrm_via_node_tests_total{plugin="viaroute"}                                    | 0        |
+            | osrm_rtree_nodes_explored_total{plugin="viaroute"}                              | /^[1-9]/ |
+        And every latency histogram should be cumulative
+
@@ -0,0 +1,62 @@
+@routing @testbot @trace
+Feature: Tracing the search of a request
+
+    Background:
+        Given the profile "testbot"
+
+    Scenario: The trace reports the stages and search space of a route
+        Given the node map
+            | a | b | c |
+            | d | e | f |
+            | g | h | i |
+
+        And the ways
+            | nodes |
+            | abc   |
+            | def   |
+            | ghi   |
+            | adg   |
+            | beh   |
+            | cfi   |
+
+        # 12 segments give 24 edge-based nodes, a leg is searched at most four times
+        When I route with a trace I should get
+            | from | to | route | stages                                        | forward settled | reverse settled | unpacked edges | via node tests | rtree nodes |
+            | a    | c  | abc   | parsing,snapping,search,unpacking,description | 1..96           | 1..96           | /^[1-9]/       | 0              | /^[1-9]/    |
+            | c    | a  | abc   | parsing,snapping,search,unpacking,description | 1..96           | 1..96           | /^[1-9]/       | 0              | /^[1-9]/    |
+            | a    | g  | adg   | parsing,snapping,search,unpacking,description | 1..96           | 1..96           | /^[1-9]/       | 0              | /^[1-9]/    |
+            | d    | f  | def   | parsing,snapping,search,unpacking,description | 1..96           | 1..96           | /^[1-9]/       | 0              | /^[1-9]/    |
+            | b    | h  | beh   | parsing,snapping,search,unpacking,description | 1..96           | 1..96           | /^[1-9]/       | 0              | /^[1-9]/    |
+
+    Scenario: Via points add to the search space of the trace
+        Given the node map
+            | a | b | c |
+            | d | e | f |
+            | g | h | i |
+
+        And the ways
+            | nodes |
+            | abc   |
+            | def   |
+            | ghi   |
+            | adg   |
+            | beh   |
+            | cfi   |
+
+        When I route with a trace I should get
+            | waypoints | route           | forward settled | reverse settled | unpacked edges |
+            | a,c,i     | abc,cfi         | 2..192          | 2..192          | /^[1-9]/       |
+            | a,c,i,g   | abc,cfi,ghi     | 3..288          | 3..288          | /^[1-9]/       |
+
+    Scenario: Without trace=true there is no trace
+        Given the node map
+            | a | b | c |
+
+        And the ways
+            | nodes |
+            | abc   |
+
+        When I route with a trace I should get
+            | from | to | param:trace | route | trace |
+            | a    | c  | true        | abc   | yes   |
+            | a    | c  | false       | abc   | no    |
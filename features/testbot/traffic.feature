@@ -0,0 +1,38 @@
+@routing @testbot @traffic
+Feature: Live traffic updates
+
+    Background:
+        Given the profile "testbot"
+        And the node map
+            | s | p | a | x | y | b | q | t |
+            |   |   | c |   |   | d |   |   |
+
+        And the ways
+            | nodes |
+            | spa   |
+            | axyb  |
+            | acdb  |
+            | bqt   |
+
+    # the feed slows the edges entering axyb, those of pa, ax and xy
+    Scenario: A traffic update changes the duration and then the route
+        When I route with live traffic I should get
+            | from | to | traffic   | param:traffic | route        | time    |
+            | s    | t  |           | true          | spa,axyb,bqt | 71s +-1 |
+            | s    | t  | axyb:0.8  | true          | spa,axyb,bqt | 78s +-1 |
+            | s    | t  | axyb:0.25 | true          | spa,acdb,bqt | 91s +-1 |
+            | s    | t  | axyb:0.25 | false         | spa,axyb,bqt | 71s +-1 |
+            | t    | s  | axyb:0.25 | true          | bqt,acdb,spa | 91s +-1 |
+            | s    | t  |           | true          | spa,axyb,bqt | 71s +-1 |
+
+    Scenario: A traffic update changes the route on the multi-level graph
+        Given the data is prepared for multi-level routing
+        When I route with live traffic I should get
+            | from | to | traffic   | param:traffic | route        | time    |
+            | s    | t  |           | true          | spa,axyb,bqt | 71s +-1 |
+            | s    | t  | axyb:0.8  | true          | spa,axyb,bqt | 78s +-1 |
+            | s    | t  | axyb:0.25 | true          | spa,acdb,bqt | 91s +-1 |
+            | s    | t  | axyb:0.25 | false         | spa,axyb,bqt | 71s +-1 |
+            | t    | s  | axyb:0.25 | true          | bqt,acdb,spa | 91s +-1 |
+            | s    | t  |           | true          | spa,axyb,bqt | 71s +-1 |
+        And osrm-routed should have loaded the multi-level graph
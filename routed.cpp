@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Server/ServerFactory.h"
 
+#include "Util/AsyncLogger.h"
 #include "Util/GitDescription.h"
 #include "Util/InputFileUtil.h"
 #include "Util/OpenMPWrapper.h"
@@ -80,6 +81,8 @@ int main (int argc, const char * argv[]) {
 #endif
         std::string ip_address;
         int ip_port, requested_num_threads;
+        int compression_level, compression_threshold;
+        int access_log_sampling, route_cache_size;
 
         ServerPaths server_paths;
         if( !GenerateServerProgramOptions(
@@ -88,7 +91,11 @@ int main (int argc, const char * argv[]) {
                 server_paths,
                 ip_address,
                 ip_port,
-                requested_num_threads
+                requested_num_threads,
+                compression_level,
+                compression_threshold,
+                access_log_sampling,
+                route_cache_size
              )
         ) {
             return 0;
@@ -118,6 +125,24 @@ int main (int argc, const char * argv[]) {
             "IP address:\t" << ip_address;
         SimpleLogger().Write() <<
             "IP port:\t" << ip_port;
+        SimpleLogger().Write() <<
+            "Compression:\tlevel " << compression_level <<
+            ", threshold " << compression_threshold << " bytes";
+        SimpleLogger().Write() <<
+            "Access log:\t" << (
+                server_paths["accesslog"].empty() ?
+                    std::string("stdout") : server_paths["accesslog"].string()
+            ) << ", every " << access_log_sampling << ". request";
+        SimpleLogger().Write() <<
+            "Route cache:\t" << route_cache_size << " MB";
+        if(!server_paths["trafficdata"].empty()) {
+            SimpleLogger().Write() <<
+                "Traffic feed:\t" << server_paths["trafficdata"];
+        }
+        if(!server_paths["mlddata"].empty()) {
+            SimpleLogger().Write() <<
+                "MLD file:\t" << server_paths["mlddata"];
+        }
 
 #ifndef _WIN32
         int sig = 0;
@@ -127,11 +152,17 @@ int main (int argc, const char * argv[]) {
         pthread_sigmask(SIG_BLOCK, &new_mask, &old_mask);
 #endif
 
-        OSRM routing_machine(server_paths);
+        OSRM routing_machine(server_paths, route_cache_size);
+        AsyncLogger::GetInstance().Start(
+            server_paths["accesslog"],
+            access_log_sampling
+        );
         Server * s = ServerFactory::CreateServer(
                         ip_address,
                         ip_port,
-                        requested_num_threads
+                        requested_num_threads,
+                        compression_level,
+                        compression_threshold
                      );
         s->GetRequestHandlerPtr().RegisterRoutingMachine(&routing_machine);
 
@@ -162,6 +193,7 @@ int main (int argc, const char * argv[]) {
        	    SimpleLogger().Write(logDEBUG) << "Threads did not finish within 2 seconds. Hard abort!";
         }
 
+        AsyncLogger::GetInstance().Stop();
         std::cout << "[server] freeing objects" << std::endl;
         delete s;
         std::cout << "[server] shutdown completed" << std::endl;